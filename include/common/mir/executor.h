@@ -77,6 +77,16 @@ public:
      * Wait for all current work to finish and terminate all worker threads
      */
     static void quiesce();
+
+    /**
+     * Set the number of threads the ThreadPoolExecutor normally runs
+     *
+     * By default this is the number of CPUs (but at least 4). More threads are added, for a while, should
+     * all of them be blocked with work waiting.
+     *
+     * \param count [in]   The number of worker threads; at least 1
+     */
+    static void set_thread_count(unsigned count);
 protected:
     ThreadPoolExecutor() = default;
 };
@@ -0,0 +1,68 @@
+/*
+ * Copyright © 2022 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_LOGGING_ASYNC_LOGGER_H_
+#define MIR_LOGGING_ASYNC_LOGGER_H_
+
+#include "mir/logging/logger.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+
+namespace mir
+{
+namespace logging
+{
+/// Passes messages to another logger from a background thread, so that logging threads never wait for I/O
+/// Messages are copied into a bounded lock-free ring. If messages arrive faster than they can be written the ring
+/// fills, and further messages are dropped (and counted) until there is room; the number dropped is then logged.
+/// Messages longer than max_message_size are truncated. As the downstream logger timestamps messages when it writes
+/// them, timestamps may lag slightly behind the calls to log().
+class AsyncLogger : public mir::logging::Logger
+{
+public:
+    static size_t const max_message_size = 1024;
+
+    /// \param capacity the number of messages that can wait to be written (rounded up to a power of two)
+    AsyncLogger(std::shared_ptr<Logger> downstream, size_t capacity = 256);
+    ~AsyncLogger();
+
+    /// Formats into a buffer belonging to the calling thread, without allocating
+    void log(char const* component, Severity severity, char const* format, ...) override
+        __attribute__ ((format (printf, 4, 5)));
+
+    /// The total number of messages dropped because the ring was full
+    auto dropped() const -> uint64_t;
+
+protected:
+    void log(mir::logging::Severity severity, std::string const& message, std::string const& component) override;
+
+private:
+    struct Ring;
+
+    std::shared_ptr<Logger> const downstream;
+    std::unique_ptr<Ring> const ring;
+    std::thread writer;
+
+    void write_messages();
+};
+}
+}
+
+#endif // MIR_LOGGING_ASYNC_LOGGER_H_
@@ -0,0 +1,93 @@
+/*
+ * Copyright © 2022 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_GEOMETRY_REGION_H_
+#define MIR_GEOMETRY_REGION_H_
+
+#include "mir/geometry/displacement.h"
+#include "mir/geometry/point.h"
+#include "mir/geometry/rectangle.h"
+
+#include <initializer_list>
+#include <iosfwd>
+#include <vector>
+
+namespace mir
+{
+namespace geometry
+{
+class Rectangles;
+
+/**
+ * An arbitrary set of pixels, held as non-overlapping rectangles.
+ *
+ * The rectangles are kept in y-x banded order (as pixman and X11 regions are): they are grouped into horizontal
+ * bands, sorted top to bottom, in which every rectangle has the same top and bottom and which are sorted left to
+ * right without touching. Vertically adjacent bands with the same horizontal extents are merged. So each set of
+ * pixels has exactly one representation, and the boolean operations run in a single pass over both operands.
+ */
+class Region
+{
+public:
+    Region() = default;
+    Region(Rectangle const& rect);
+    Region(std::initializer_list<Rectangle> const& rects);
+    explicit Region(Rectangles const& rects);
+    /* We want to keep implicit copy and move methods */
+
+    bool empty() const;
+    Rectangle bounding_rectangle() const;
+
+    bool contains(Point const& point) const;
+    /// Whether every pixel of \a rect is in the region
+    bool contains(Rectangle const& rect) const;
+    /// Whether any pixel of \a rect is in the region
+    bool overlaps(Rectangle const& rect) const;
+
+    void translate(Displacement const& displacement);
+
+    /// The rectangles of the region, in y-x banded order
+    typedef Rectangle value_type;
+    typedef std::vector<Rectangle>::const_iterator const_iterator;
+    typedef std::vector<Rectangle>::size_type size_type;
+    const_iterator begin() const;
+    const_iterator end() const;
+    size_type size() const;
+
+    bool operator==(Region const& other) const;
+    bool operator!=(Region const& other) const;
+
+private:
+    friend Region union_of(Region const& a, Region const& b);
+    friend Region intersection_of(Region const& a, Region const& b);
+    friend Region difference_of(Region const& a, Region const& b);
+
+    /// The first rectangle of the first band below \a y or including it
+    auto first_band_reaching(Y y) const -> const_iterator;
+
+    std::vector<Rectangle> rectangles;
+};
+
+Region union_of(Region const& a, Region const& b);
+Region intersection_of(Region const& a, Region const& b);
+/// The pixels of \a a that are not in \a b
+Region difference_of(Region const& a, Region const& b);
+
+std::ostream& operator<<(std::ostream& out, Region const& value);
+}
+}
+
+#endif /* MIR_GEOMETRY_REGION_H_ */
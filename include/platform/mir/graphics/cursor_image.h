@@ -21,6 +21,10 @@
 #include "mir/geometry/size.h"
 #include "mir/geometry/displacement.h"
 
+#include <chrono>
+#include <memory>
+#include <vector>
+
 namespace mir
 {
 namespace graphics
@@ -44,6 +48,28 @@ protected:
     CursorImage(CursorImage const&) = delete;
     CursorImage& operator=(CursorImage const&) = delete;
 };
+
+/// A cursor image made of frames that are shown in turn. Used as a plain CursorImage, it is the first frame.
+class AnimatedCursorImage : public CursorImage
+{
+public:
+    struct Frame
+    {
+        std::shared_ptr<CursorImage> image;
+        /// How long the frame is shown before the next one
+        std::chrono::milliseconds delay;
+    };
+
+    /// The frames of the animation, of which there is at least one
+    virtual auto frames() const -> std::vector<Frame> const& = 0;
+
+    void const* as_argb_8888() const override { return frames().front().image->as_argb_8888(); }
+    geometry::Size size() const override { return frames().front().image->size(); }
+    geometry::Displacement hotspot() const override { return frames().front().image->hotspot(); }
+
+protected:
+    AnimatedCursorImage() = default;
+};
 }
 }
 
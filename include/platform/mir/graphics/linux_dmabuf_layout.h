@@ -0,0 +1,38 @@
+/*
+ * Copyright © 2022 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_GRAPHICS_LINUX_DMABUF_LAYOUT_H_
+#define MIR_GRAPHICS_LINUX_DMABUF_LAYOUT_H_
+
+#include "mir/graphics/texture.h"
+
+#include <cstdint>
+
+namespace mir
+{
+namespace graphics
+{
+/// The Texture::Layout of a dmabuf imported with the given zwp_linux_buffer_params_v1 flags
+auto layout_from_linux_dmabuf_flags(uint32_t flags) -> gl::Texture::Layout;
+
+/// The zwp_linux_buffer_params_v1 flags to pass on a dmabuf of the given Texture::Layout
+/// This is the inverse of layout_from_linux_dmabuf_flags(), so a buffer forwarded to another compositor
+/// is described exactly as our client described it to us.
+auto linux_dmabuf_flags_from_layout(gl::Texture::Layout layout) -> uint32_t;
+}
+}
+
+#endif //MIR_GRAPHICS_LINUX_DMABUF_LAYOUT_H_
@@ -0,0 +1,61 @@
+/*
+ * Copyright © 2022 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_GRAPHICS_OVERLAY_PLANES_H_
+#define MIR_GRAPHICS_OVERLAY_PLANES_H_
+
+#include <mir/graphics/renderable.h>
+
+namespace mir
+{
+namespace graphics
+{
+
+/**
+ * A display buffer that can scan some renderables out on hardware planes
+ * stacked above the rendered image, leaving the rest to be rendered.
+ *
+ * Display buffers supporting this implement it on the object returned by
+ * DisplayBuffer::native_display_buffer().
+ */
+class OverlayPlanes
+{
+public:
+    virtual ~OverlayPlanes() = default;
+
+    /**
+     * Place as many renderables as the hardware accepts on overlay planes.
+     *
+     * This is used when DisplayBuffer::overlay() has declined the whole
+     * list; the planes are presented along with the rendered image on the
+     * following post().
+     *
+     *  \param [in] renderlist  The renderables of the frame, bottom-most first
+     *  \returns                The renderables that still need to be rendered,
+     *                          bottom-most first
+     */
+    virtual auto assign_planes(RenderableList const& renderlist) -> RenderableList = 0;
+
+protected:
+    OverlayPlanes() = default;
+    OverlayPlanes(OverlayPlanes const&) = delete;
+    OverlayPlanes& operator=(OverlayPlanes const&) = delete;
+};
+
+}
+}
+
+#endif /* MIR_GRAPHICS_OVERLAY_PLANES_H_ */
@@ -0,0 +1,63 @@
+/*
+ * Copyright © 2022 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_GRAPHICS_SOLID_COLOR_BUFFER_H_
+#define MIR_GRAPHICS_SOLID_COLOR_BUFFER_H_
+
+#include "mir/graphics/buffer_basic.h"
+
+#include <glm/glm.hpp>
+
+namespace mir
+{
+namespace graphics
+{
+/**
+ * A buffer that is a single color throughout
+ *
+ * Nothing backs it but the color: renderers fill the area it covers rather than uploading and sampling a
+ * texture, and so a Renderable with one of these as its buffer is drawn without any pixel storage at all.
+ */
+class SolidColorBuffer : public BufferBasic, public NativeBufferBase
+{
+public:
+    /**
+     * \param [in] size     The size the buffer reports. Renderers stretch the color over the Renderable's
+     *                      screen_position() as they would the pixels of any other buffer.
+     * \param [in] color    Premultiplied RGBA, each component in the range [0, 1]
+     */
+    SolidColorBuffer(geometry::Size size, glm::vec4 const& color);
+
+    auto size() const -> geometry::Size override;
+
+    /// mir_pixel_format_xrgb_8888 if the color is opaque, mir_pixel_format_argb_8888 otherwise
+    auto pixel_format() const -> MirPixelFormat override;
+
+    auto native_buffer_base() -> NativeBufferBase* override;
+
+    auto color() const -> glm::vec4 const&;
+
+    /// Whether the color completely hides whatever is drawn below it
+    auto opaque() const -> bool;
+
+private:
+    geometry::Size const size_;
+    glm::vec4 const color_;
+};
+}
+}
+
+#endif // MIR_GRAPHICS_SOLID_COLOR_BUFFER_H_
@@ -46,6 +46,11 @@ extern char const* const wayland_extensions_opt;
 extern char const* const add_wayland_extensions_opt;
 extern char const* const drop_wayland_extensions_opt;
 extern char const* const idle_timeout_opt;
+extern char const* const rfb_port_opt;
+extern char const* const rfb_address_opt;
+extern char const* const thread_pool_size_opt;
+extern char const* const async_logging_opt;
+extern char const* const cache_platform_probe_opt;
 
 extern char const* const enable_key_repeat_opt;
 
@@ -19,6 +19,7 @@
 
 #include "buffer_render_target.h"
 
+#include <memory>
 #include <optional>
 #include <GLES2/gl2.h>
 
@@ -35,8 +36,11 @@ class BasicBufferRenderTarget: public BufferRenderTarget
 {
 public:
     BasicBufferRenderTarget(std::shared_ptr<Context> const& ctx);
+    ~BasicBufferRenderTarget();
 
     void set_buffer(std::shared_ptr<software::WriteMappableBuffer> const& buffer) override;
+    void set_damage(geometry::Rectangle const& damage) override;
+    auto take_pending_copy() -> std::function<void()> override;
 
     auto size() const -> geometry::Size override;
     void make_current() override;
@@ -50,7 +54,8 @@ private:
     public:
         Framebuffer(geometry::Size const& size);
         ~Framebuffer();
-        void copy_to(software::WriteMappableBuffer& buffer);
+        /// Synchronously copy \a area (in GL window coordinates) into the same rows and columns of \a buffer
+        void copy_to(software::WriteMappableBuffer& buffer, geometry::Rectangle const& area);
         void bind();
 
         geometry::Size const size;
@@ -63,10 +68,17 @@ private:
         GLuint fbo;
     };
 
+    /// Reads the framebuffer back through pixel pack buffers, so the GPU copies while the CPU gets on with other work
+    class AsyncReadback;
+
     std::shared_ptr<Context> const ctx;
 
     std::shared_ptr<software::WriteMappableBuffer> buffer{nullptr};
+    std::optional<geometry::Rectangle> damage;
     std::optional<Framebuffer> framebuffer;
+    bool readback_probed{false};
+    std::unique_ptr<AsyncReadback> readback;    ///< Null if the GL can't read back asynchronously
+    bool copy_pending{false};
 };
 
 }
@@ -18,8 +18,9 @@
 #define MIR_RENDERER_GL_BUFFER_RENDER_TARGET_H_
 
 #include "render_target.h"
-#include "mir/geometry/size.h"
+#include "mir/geometry/rectangle.h"
 
+#include <functional>
 #include <memory>
 
 namespace mir
@@ -38,6 +39,21 @@ class BufferRenderTarget: public RenderTarget
 {
 public:
     virtual void set_buffer(std::shared_ptr<software::WriteMappableBuffer> const& buffer) = 0;
+
+    /**
+     * Only copy \a damage of the next frame into the buffer; the rest of the buffer already holds the same pixels.
+     *
+     * \a damage is in buffer pixels, with the origin at the top-left of the rendered frame. It is forgotten by the
+     * next swap_buffers() or set_buffer().
+     */
+    virtual void set_damage(geometry::Rectangle const& damage) = 0;
+
+    /**
+     * swap_buffers() may only queue the copy of the frame into the buffer on the GPU. This takes the rest of the
+     * copy: a function that waits for the GPU and writes the pixels into the buffer, which must be called with the
+     * context current. It is empty if swap_buffers() already finished the copy.
+     */
+    virtual auto take_pending_copy() -> std::function<void()> = 0;
 };
 
 }
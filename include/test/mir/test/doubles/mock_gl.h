@@ -65,6 +65,7 @@ public:
     MOCK_METHOD1(glEnable, void(GLenum));
     MOCK_METHOD1(glEnableVertexAttribArray, void(GLuint));
     MOCK_METHOD0(glFinish, void());
+    MOCK_METHOD0(glFlush, void());
     MOCK_METHOD4(glFramebufferRenderbuffer,
                  void(GLenum, GLenum, GLenum, GLuint));
     MOCK_METHOD5(glFramebufferTexture2D,
@@ -99,6 +100,7 @@ public:
     MOCK_METHOD3(glTexParameteri, void(GLenum, GLenum, GLenum));
     MOCK_METHOD2(glUniform1f, void(GLint, GLfloat));
     MOCK_METHOD3(glUniform2f, void(GLint, GLfloat, GLfloat));
+    MOCK_METHOD5(glUniform4f, void(GLint, GLfloat, GLfloat, GLfloat, GLfloat));
     MOCK_METHOD2(glUniform1i, void(GLint, GLint));
     MOCK_METHOD4(glUniformMatrix4fv,
                  void(GLuint, GLsizei, GLboolean, const GLfloat *));
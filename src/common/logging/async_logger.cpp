@@ -0,0 +1,225 @@
+/*
+ * Copyright © 2022 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/logging/async_logger.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace ml = mir::logging;
+
+namespace
+{
+size_t const max_component_size = 64;
+
+/// Copies as much of \a from as fits into \a to, always leaving it nul terminated
+void copy_truncated(char* to, size_t size, std::string_view from)
+{
+    auto const length = std::min(from.size(), size - 1);
+    std::memcpy(to, from.data(), length);
+    to[length] = '\0';
+}
+
+auto round_up_to_power_of_two(size_t n) -> size_t
+{
+    size_t result = 1;
+    while (result < n)
+    {
+        result <<= 1;
+    }
+    return result;
+}
+}
+
+/// A bounded multi-producer, single-consumer queue of messages
+/// Each cell's sequence number says whether it is free for the producer claiming position n (sequence == n) or holds
+/// the message written at position n (sequence == n + 1), so producers only contend on claiming a position.
+struct ml::AsyncLogger::Ring
+{
+    struct Cell
+    {
+        std::atomic<size_t> sequence;
+        Severity severity;
+        char component[max_component_size];
+        char message[max_message_size];
+    };
+
+    explicit Ring(size_t capacity)
+        : cells(round_up_to_power_of_two(std::max<size_t>(capacity, 2))),
+          mask{cells.size() - 1}
+    {
+        for (size_t i = 0; i != cells.size(); ++i)
+        {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    /// \returns false if the ring is full
+    auto push(Severity severity, std::string_view component, std::string_view message) -> bool
+    {
+        auto position = enqueue_position.load(std::memory_order_relaxed);
+        Cell* cell;
+        for (;;)
+        {
+            cell = &cells[position & mask];
+            auto const sequence = cell->sequence.load(std::memory_order_acquire);
+            auto const difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+
+            if (difference == 0)
+            {
+                if (enqueue_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+            else if (difference < 0)
+            {
+                // The consumer has not yet freed the cell from the last time round
+                return false;
+            }
+            else
+            {
+                position = enqueue_position.load(std::memory_order_relaxed);
+            }
+        }
+
+        cell->severity = severity;
+        copy_truncated(cell->component, sizeof cell->component, component);
+        copy_truncated(cell->message, sizeof cell->message, message);
+        cell->sequence.store(position + 1, std::memory_order_release);
+
+        pushed.fetch_add(1, std::memory_order_release);
+        pushed.notify_one();
+        return true;
+    }
+
+    /// Calls \a consume with each message that has been completely pushed, in order. Only one thread may pop.
+    template<typename Consume>
+    void pop_all(Consume const& consume)
+    {
+        for (;;)
+        {
+            auto& cell = cells[dequeue_position & mask];
+            if (cell.sequence.load(std::memory_order_acquire) != dequeue_position + 1)
+            {
+                return;
+            }
+
+            // Copied out (as the downstream logger needs strings anyway) so the cell is free while it is written
+            auto const severity = cell.severity;
+            std::string const component{cell.component};
+            std::string const message{cell.message};
+
+            cell.sequence.store(dequeue_position + cells.size(), std::memory_order_release);
+            ++dequeue_position;
+
+            consume(severity, component, message);
+        }
+    }
+
+    std::vector<Cell> cells;
+    size_t const mask;
+    std::atomic<size_t> enqueue_position{0};
+    size_t dequeue_position{0};
+
+    /// Counts pushes (and the request to stop) for the consumer to wait on
+    std::atomic<uint32_t> pushed{0};
+    std::atomic<bool> stopping{false};
+    std::atomic<uint64_t> dropped{0};
+};
+
+ml::AsyncLogger::AsyncLogger(std::shared_ptr<Logger> downstream, size_t capacity)
+    : downstream{std::move(downstream)},
+      ring{std::make_unique<Ring>(capacity)},
+      writer{[this] { write_messages(); }}
+{
+}
+
+ml::AsyncLogger::~AsyncLogger()
+{
+    ring->stopping = true;
+    ring->pushed.fetch_add(1, std::memory_order_release);
+    ring->pushed.notify_one();
+    writer.join();
+}
+
+void ml::AsyncLogger::log(char const* component, Severity severity, char const* format, ...)
+{
+    thread_local char message[max_message_size];
+
+    va_list va;
+    va_start(va, format);
+    vsnprintf(message, sizeof message, format, va);
+    va_end(va);
+
+    if (!ring->push(severity, component, message))
+    {
+        ring->dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void ml::AsyncLogger::log(Severity severity, std::string const& message, std::string const& component)
+{
+    if (!ring->push(severity, component, message))
+    {
+        ring->dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+auto ml::AsyncLogger::dropped() const -> uint64_t
+{
+    return ring->dropped.load(std::memory_order_relaxed);
+}
+
+void ml::AsyncLogger::write_messages()
+{
+    uint64_t reported_dropped{0};
+
+    for (;;)
+    {
+        auto const seen = ring->pushed.load(std::memory_order_acquire);
+        // Once stopping has been requested nothing more is logged, so this pass writes everything that was
+        auto const stopping = ring->stopping.load();
+
+        ring->pop_all([this](Severity severity, std::string const& component, std::string const& message)
+            {
+                downstream->log(severity, message, component);
+            });
+
+        if (auto const dropped = ring->dropped.load(std::memory_order_relaxed); dropped != reported_dropped)
+        {
+            downstream->log(
+                Severity::warning,
+                std::to_string(dropped - reported_dropped) + " log messages dropped: they arrived faster than they "
+                "could be written",
+                "logging");
+            reported_dropped = dropped;
+        }
+
+        if (stopping)
+        {
+            return;
+        }
+
+        ring->pushed.wait(seen, std::memory_order_acquire);
+    }
+}
@@ -18,312 +18,376 @@
 
 #include "mir/thread_name.h"
 
-#include <thread>
-#include <memory>
+#include <algorithm>
 #include <atomic>
-#include <list>
-#include <future>
-
-#include <version>
-
-#ifdef __cpp_lib_semaphore
-#include <semaphore>
-#else
-// Hello, there! This version of libstdc++ doesn't support the C++20 feature std::binary_semaphore
-// We shall, instead, open-code the simplest possible implementation of what we use here.
-namespace std
-{
-class binary_semaphore
-{
-public:
-    binary_semaphore(int initial)
-        : raised{initial == 1}
-    {
-    }
-
-    void release()
-    {
-        {
-            std::lock_guard lock{mutex};
-            raised = true;
-        }
-        cv.notify_all();
-    }
-
-    void acquire()
-    {
-        std::unique_lock lock{mutex};
-        if (raised)
-        {
-            raised = false;
-            return;
-        }
-        cv.wait(lock, [this]() { return raised; });
-        raised = false;
-    }
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
 
-    bool try_acquire()
-    {
-        std::lock_guard lock{mutex};
-        if (raised)
-        {
-            raised = false;
-            return true;
-        }
-        return false;
-    }
-private:
-    std::mutex mutex;
-    std::condition_variable cv;
-    bool raised;
-};
-}
-#endif
+using namespace std::chrono_literals;
 
 namespace
 {
-constexpr int const min_threadpool_threads = 4;
+constexpr unsigned const min_threadpool_threads = 4;
+/// The most threads the pool will run, including those added while all the others are blocked
+constexpr unsigned const max_threadpool_threads = 256;
+/// How long queued work may go without any being started before another thread is added
+constexpr auto const starvation_interval = 10ms;
+/// How long a thread beyond the configured count waits for more work before exiting
+constexpr auto const surplus_idle_timeout = 1s;
 
 /* We use an atomic void(*)() rather than a std::function to avoid needing to take a mutex
  * in exception context, as taking a mutex can itself throw an exception!
  */
 std::atomic<void(*)()> exception_handler{[] { std::rethrow_exception(std::current_exception()); }};
 
-class Worker
+/**
+ * A work-stealing ThreadPool
+ *
+ * Theory of operation:
+ * The ThreadPool runs a fixed number of worker threads (by default, one per CPU but at least
+ * min_threadpool_threads), started as work arrives. Each call to spawn() is still guaranteed to be
+ * executed on a different thread to the caller.
+ *
+ * Each Worker has its own deque of work. Work spawned from a worker thread goes on the back of that
+ * worker's deque, and the worker takes its next work from the back too, so related work tends to run
+ * on the same (cache-warm) thread. Work spawned from any other thread goes on a shared queue. A worker
+ * with nothing of its own to do takes from the shared queue, and failing that steals from the front of
+ * the other workers' deques.
+ *
+ * Work may block waiting on other work, so a fixed number of threads could deadlock. A monitor thread
+ * watches for queued work that no worker has started for starvation_interval, and adds a thread when
+ * that happens (up to max_threadpool_threads). Threads beyond the configured count exit once they have
+ * been idle for surplus_idle_timeout.
+ */
+class ThreadPool : public mir::NonBlockingExecutor
 {
 public:
-    Worker()
-        : work{[](){}},
-          work_available{0}
+    ThreadPool() noexcept
     {
-        std::promise<std::atomic<bool>*> shutdown_channel;
-        auto resolved_shutdown_location = shutdown_channel.get_future();
-
-        thread = std::thread{
-            &work_loop,
-            this,
-            std::move(shutdown_channel)};
+        workers.reserve(max_threadpool_threads);
+    }
 
-        shutdown = resolved_shutdown_location.get();
+    ~ThreadPool() noexcept
+    {
+        quiesce();
     }
 
-    ~Worker() noexcept
+    void quiesce()
     {
-        if (thread.joinable())
+        wait_for_idle();
+
+        std::vector<std::thread> threads;
         {
-            /* Safety: stop() is the only other callsite of signal_work_thread_to_halt()
-             * If stop() has been called then it has already called thread.join(), so
-             * thread.joinable() will be false and we can't get here.
-             */
-            signal_work_thread_to_halt();
-            if (thread.get_id() == std::this_thread::get_id())
+            std::lock_guard lock{mutex};
+            stopping = true;
+            for (auto const& worker : workers)
             {
-                /* We're being destroyed from our own work thread.
-                 * This can only happen when destroying the work functor at me->work = [](){}
-                 * in work_loop results in destroying the last shared pointer to *this.
-                 *
-                 * At this point, work_loop will exit without touching anything
-                 */
-                thread.detach();
+                if (worker->thread.joinable())
+                {
+                    threads.push_back(std::move(worker->thread));
+                }
             }
-            else
+            if (monitor.joinable())
             {
-                thread.join();
+                threads.push_back(std::move(monitor));
             }
         }
+        work_available.notify_all();
+        starving.notify_all();
+
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+
+        std::lock_guard lock{mutex};
+        worker_count = 0;
+        workers.clear();
+        live_workers = 0;
+        stopping = false;
+        // Work may have been spawned by another thread while we were stopping
+        if (queued > 0)
+        {
+            start_worker();
+        }
     }
 
-    void set_work(std::function<void()>&& to_do)
+    void spawn(std::function<void()>&& work) override
     {
-        // Precondition: this Worker is idle (work_available is unraised, work = [](){})
-        work = std::move(to_do);
-        work_available.release();
+        // Count the work before queueing it, so it's never taken before being counted
+        ++queued;
+        if (current_worker && current_pool == this)
+        {
+            std::lock_guard lock{current_worker->mutex};
+            current_worker->work.push_back(std::move(work));
+        }
+        else
+        {
+            std::lock_guard lock{shared_mutex};
+            shared_work.push_back(std::move(work));
+        }
+
+        std::lock_guard lock{mutex};
+        if (idle_workers > 0)
+        {
+            work_available.notify_one();
+        }
+        else if (stopping)
+        {
+            // quiesce() will start a worker once it's done
+        }
+        else if (live_workers < thread_count)
+        {
+            start_worker();
+        }
+        else
+        {
+            // Every worker is busy; make sure someone notices if they stay that way
+            starving.notify_one();
+        }
     }
 
-    /**
-     * Halt the worker, dropping any work scheduled but not yet executing, and wait for completion.
-     */
-    void stop()
+    void set_thread_count(unsigned count)
     {
-        signal_work_thread_to_halt();
-        thread.join();
+        std::lock_guard lock{mutex};
+        thread_count = std::clamp(count, 1u, max_threadpool_threads);
+        // Surplus workers exit when next idle; missing ones are started as work arrives
+        work_available.notify_all();
     }
+
 private:
-    void signal_work_thread_to_halt()
+    struct Worker
     {
-        /* Precondition: *shutdown == false
-         * If *shutdown has become true, then we are unsynchronised with the termination of
-         * the worker thread, and so we can not guarantee that shutdown points to valid memory.
-         *
-         * This implies that signal_work_thread_to_halt() must be called exactly once.
-         */
-        *shutdown = true;
-        /* We need to release the workloop thread by raising the signal.
-         * However, it's UB to raise the semaphore if it's already raised.
-         * So, first, consume any pending signal…
-         */
-        work_available.try_acquire();
-        /* work_available is now guaranteed not-signalled, so it's OK to
-         * unconditionally raise the signal and so release the workloop thread.
-         */
-        work_available.release();
-    }
+        std::mutex mutex;
+        std::deque<std::function<void()>> work;     ///< The owner works from the back, thieves steal from the front
+        size_t index{0};                            ///< Our position in ThreadPool::workers
+        std::thread thread;
+        bool running{false};                        ///< Guarded by ThreadPool::mutex
+    };
 
-    static void work_loop(Worker* me, std::promise<std::atomic<bool>*>&& shutdown_channel)
+    void wait_for_idle()
     {
-        mir::set_thread_name("Mir/Workqueue");
+        std::unique_lock lock{mutex};
+        // Work counts as queued until it has been taken and as busy until it finishes, so
+        // there's no moment work is pending and both are zero.
+        workers_changed.wait(lock, [this] { return queued == 0 && busy == 0; });
+    }
 
-        std::atomic<bool> shutdown{false};
-        shutdown_channel.set_value(&shutdown);
+    /// Precondition: mutex is held and we're not stopping
+    void start_worker()
+    {
+        auto const spare = std::find_if(
+            workers.begin(), workers.end(),
+            [](auto const& worker) { return !worker->running; });
 
-        while (!shutdown)
+        Worker* worker;
+        if (spare != workers.end())
         {
-            me->work_available.acquire();
-            auto work = std::move(me->work);
-            me->work = [](){};
-            work();
+            worker = spare->get();
+            // The thread has marked itself not running, and so is exiting
+            if (worker->thread.joinable())
+            {
+                worker->thread.join();
+            }
+        }
+        else if (workers.size() < max_threadpool_threads)
+        {
+            // Never reallocates (we reserved max_threadpool_threads), so thieves can read it concurrently
+            worker = workers.emplace_back(std::make_unique<Worker>()).get();
+            worker->index = workers.size() - 1;
+            worker_count.store(workers.size(), std::memory_order_release);
+        }
+        else
+        {
+            return;
         }
-    }
 
-    std::function<void()> work;
-    /**
-     * Pointer to an atomic<bool> on the thread's stack (in work_loop).
-     *
-     * Being on the thread's stack means that the thread is allowed to outlive the Worker
-     * (as long as the thread does not access anything from the Worker), but also means that
-     * after setting *shutdown to true it is no longer safe to access.
-     */
-    std::atomic<bool>* shutdown;
-    std::binary_semaphore work_available;
-    std::thread thread;
-};
+        worker->running = true;
+        ++live_workers;
+        worker->thread = std::thread{[this, worker] { work_loop(*worker); }};
 
-/**
- * A self-managing ThreadPool
- *
- * Theory of operation:
- * The ThreadPool executes each item of work on an independent thread; each call to spawn() is
- * guaranteed to be on a different thread to the caller.
- *
- * To reduce the overhead of spawning threads, the ThreadPool attempts to maintain
- * min_threadpool_threads of free worker threads.
- *
- * The ThreadPool maintains two linked-lists of Worker threads; a list of all Workers, and a list of
- * (Worker, position-in-all-workers-list) containing idle Worker threads.
- *
- * When a work item is received through spawn() the ThreadPool first checks to see if there's a
- * free Worker thread in the idle list; if so, it takes it off the free list and dispatches the work.
- * If there are no free Workers, it creates a new Worker, adds it to the all-workers list, and dispatches
- * the work to the new Worker.
- *
- * When a Worker finishes an item of work, it calls recycle(). If there are fewer than
- * min_threadpool_threads in the free list, the Worker is added to the free list. Otherwise, the
- * Worker is removed from the all-workers list and is destroyed.
- */
-class ThreadPool : public mir::NonBlockingExecutor
-{
-public:
-    ThreadPool() noexcept
-    {
+        if (!monitor.joinable())
+        {
+            monitor = std::thread{[this] { monitor_loop(); }};
+        }
     }
 
-    ~ThreadPool() noexcept
+    void work_loop(Worker& me)
     {
-        wait_for_idle();
-    }
+        mir::set_thread_name("Mir/Workqueue");
+        current_worker = &me;
+        current_pool = this;
 
-    void quiesce()
-    {
-        wait_for_idle();
-        std::lock_guard lock{workers_mutex};
-        free_workers.clear();
-        workers.clear();
-        num_workers_free = 0;
+        while (auto work = next_work(me))
+        {
+            try
+            {
+                (*work)();
+            }
+            catch (...)
+            {
+                (*exception_handler)();
+            }
+            work.reset();
+
+            if (--busy == 0 && queued == 0)
+            {
+                { std::lock_guard lock{mutex}; }
+                workers_changed.notify_all();
+            }
+        }
     }
 
-    void spawn(std::function<void()>&& work)
+    /// The next work for \a me to do, waiting for some if need be, or nullopt once \a me should exit
+    auto next_work(Worker& me) -> std::optional<std::function<void()>>
     {
-        WorkerHandle worker;
+        for (;;)
         {
-            std::lock_guard lock{workers_mutex};
-            if (num_workers_free > 0)
+            if (auto work = take_work(me))
+            {
+                return work;
+            }
+
+            std::unique_lock lock{mutex};
+            if (stopping)
+            {
+                return std::nullopt;
+            }
+            if (queued > 0)
+            {
+                // Work was queued after we looked (or is being queued now); look again
+                lock.unlock();
+                std::this_thread::yield();
+                continue;
+            }
+
+            ++idle_workers;
+            auto const ready = [this] { return stopping || queued > 0 || live_workers > thread_count; };
+            bool woken{true};
+            if (live_workers > thread_count)
             {
-                worker = free_workers.front();
-                free_workers.pop_front();
-                num_workers_free--;
+                woken = work_available.wait_for(lock, surplus_idle_timeout, [this] { return stopping || queued > 0; });
             }
             else
             {
-                worker.worker = std::make_shared<Worker>();
-                worker.pos = workers.insert(workers.cend(), worker.worker);
+                work_available.wait(lock, ready);
             }
-        }
-        worker.worker->set_work(
-            [this, worker, work = std::move(work)]() mutable
+            --idle_workers;
+
+            if (idle_workers == 0 && queued > 0)
             {
-                try
-                {
-                    work();
-                }
-                catch (...)
-                {
-                    (*exception_handler)();
-                }
-                recycle(std::move(worker));
-            });
+                // We were the last idle worker; if we block too, the monitor needs to notice
+                starving.notify_one();
+            }
+            if (stopping)
+            {
+                return std::nullopt;
+            }
+            if (!woken && live_workers > thread_count)
+            {
+                me.running = false;
+                --live_workers;
+                return std::nullopt;
+            }
+        }
     }
-private:
-    struct WorkerHandle
-    {
-        std::list<std::shared_ptr<Worker>>::const_iterator pos;
-        std::shared_ptr<Worker> worker;
-    };
 
-    void wait_for_idle()
+    auto take_work(Worker& me) -> std::optional<std::function<void()>>
     {
-        std::unique_lock lock{workers_mutex};
-        // We need to wait for any active workers to finish.
-        bool idle = workers.size() == free_workers.size();
-        while (!idle)
+        auto const took = [this](std::function<void()>&& work)
+            {
+                // Count it busy before it stops being queued; see wait_for_idle()
+                ++busy;
+                --queued;
+                ++started;
+                return std::optional{std::move(work)};
+            };
+
         {
-            workers_changed.wait(lock);
-
-            /* When a worker finishes it either adds itself to the free_workers list
-             * or removes itself from the workers list.
-             *
-             * This means that we're idle once all the workers are free_workers
-             * - that is, the free_workers list is the same size as workers.
-             */
-            idle = workers.size() == free_workers.size();
+            std::lock_guard lock{me.mutex};
+            if (!me.work.empty())
+            {
+                auto work = std::move(me.work.back());
+                me.work.pop_back();
+                return took(std::move(work));
+            }
+        }
+        {
+            std::lock_guard lock{shared_mutex};
+            if (!shared_work.empty())
+            {
+                auto work = std::move(shared_work.front());
+                shared_work.pop_front();
+                return took(std::move(work));
+            }
         }
-    }
 
-    void recycle(WorkerHandle&& worker)
-    {
+        auto const count = worker_count.load(std::memory_order_acquire);
+        for (auto i = 1u; i < count; ++i)
         {
-            std::lock_guard lock{workers_mutex};
-            if (num_workers_free < min_threadpool_threads)
+            auto& victim = *workers[(me.index + i) % count];
+            std::lock_guard lock{victim.mutex};
+            if (!victim.work.empty())
             {
-                // If we're below our free-thread minimum, recycle this thread back into the pool…
-                free_workers.emplace_front(std::move(worker));
-                num_workers_free++;
+                auto work = std::move(victim.work.front());
+                victim.work.pop_front();
+                return took(std::move(work));
             }
-            else
+        }
+        return std::nullopt;
+    }
+
+    /// Adds a worker whenever queued work has waited starvation_interval with every worker busy
+    void monitor_loop()
+    {
+        mir::set_thread_name("Mir/Workqueue");
+
+        std::unique_lock lock{mutex};
+        while (!stopping)
+        {
+            starving.wait(lock, [this] { return stopping || (queued > 0 && idle_workers == 0); });
+
+            auto const started_before = started.load();
+            starving.wait_for(lock, starvation_interval, [this] { return stopping.load(); });
+
+            if (!stopping && queued > 0 && idle_workers == 0 && started == started_before)
             {
-                // …otherwise, let it die.
-                workers.erase(worker.pos);
+                start_worker();
             }
         }
-        workers_changed.notify_all();
     }
 
-    std::mutex workers_mutex;
+    static thread_local Worker* current_worker;
+    static thread_local ThreadPool* current_pool;
+
+    std::mutex mutex;
+    std::condition_variable work_available;
     std::condition_variable workers_changed;
-    int num_workers_free{0};
-    std::list<WorkerHandle> free_workers;
-    std::list<std::shared_ptr<Worker>> workers;
+    std::condition_variable starving;
+    std::atomic<bool> stopping{false};
+    unsigned thread_count{std::max(std::thread::hardware_concurrency(), min_threadpool_threads)};
+    unsigned live_workers{0};
+    unsigned idle_workers{0};
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::atomic<size_t> worker_count{0};
+    std::thread monitor;
+
+    std::mutex shared_mutex;
+    std::deque<std::function<void()>> shared_work;
+
+    std::atomic<size_t> queued{0};
+    std::atomic<size_t> busy{0};
+    std::atomic<uint64_t> started{0};
 };
 
+thread_local ThreadPool::Worker* ThreadPool::current_worker{nullptr};
+thread_local ThreadPool* ThreadPool::current_pool{nullptr};
+
 ThreadPool thread_pool;
 
 }
@@ -344,3 +408,8 @@ void mir::ThreadPoolExecutor::quiesce()
 {
     thread_pool.quiesce();
 }
+
+void mir::ThreadPoolExecutor::set_thread_count(unsigned count)
+{
+    thread_pool.set_thread_count(count);
+}
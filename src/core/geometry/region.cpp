@@ -0,0 +1,407 @@
+/*
+ * Copyright © 2022 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/geometry/region.h"
+#include "mir/geometry/rectangles.h"
+
+#include <algorithm>
+#include <limits>
+#include <ostream>
+
+namespace geom = mir::geometry;
+
+namespace
+{
+struct Span
+{
+    int left;
+    int right;
+};
+
+auto is_empty(geom::Rectangle const& rect) -> bool
+{
+    return rect.size.width <= geom::Width{0} || rect.size.height <= geom::Height{0};
+}
+
+/// The index one past the end of the band starting at \a begin
+auto band_end(std::vector<geom::Rectangle> const& rects, size_t begin) -> size_t
+{
+    auto const top = rects[begin].top();
+    auto end = begin + 1;
+    while (end != rects.size() && rects[end].top() == top)
+    {
+        ++end;
+    }
+    return end;
+}
+
+/// Builds a region one band at a time, merging each band into the one above where they have the same spans
+class BandWriter
+{
+public:
+    explicit BandWriter(std::vector<geom::Rectangle>& out)
+        : out{out}
+    {
+    }
+
+    void add_band(int top, int bottom, std::vector<Span> const& spans)
+    {
+        if (spans.empty() || top >= bottom)
+        {
+            return;
+        }
+
+        if (can_coalesce(top, spans))
+        {
+            for (auto i = last_band; i != out.size(); ++i)
+            {
+                out[i].size.height = geom::Height{bottom - out[i].top().as_int()};
+            }
+            return;
+        }
+
+        last_band = out.size();
+        for (auto const& span : spans)
+        {
+            out.push_back({{span.left, top}, {span.right - span.left, bottom - top}});
+        }
+    }
+
+private:
+    auto can_coalesce(int top, std::vector<Span> const& spans) const -> bool
+    {
+        if (last_band == out.size() || out[last_band].bottom().as_int() != top || out.size() - last_band != spans.size())
+        {
+            return false;
+        }
+
+        for (auto i = 0u; i != spans.size(); ++i)
+        {
+            auto const& rect = out[last_band + i];
+            if (rect.left().as_int() != spans[i].left || rect.right().as_int() != spans[i].right)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    std::vector<geom::Rectangle>& out;
+    size_t last_band{0};
+};
+
+/**
+ * Combine the spans of a band of each region, keeping each part that \a keep(in a, in b) accepts.
+ *
+ * Each list of spans is sorted and non-overlapping, so this is a single merge-like pass.
+ */
+template<typename Keep>
+void combine_spans(
+    geom::Rectangle const* a, geom::Rectangle const* a_end,
+    geom::Rectangle const* b, geom::Rectangle const* b_end,
+    Keep keep,
+    std::vector<Span>& out)
+{
+    bool in_a{false}, in_b{false}, kept{false};
+    int start{0};
+
+    while (a != a_end || b != b_end)
+    {
+        auto const next_a = a == a_end ? std::numeric_limits<int>::max() :
+            (in_a ? a->right() : a->left()).as_int();
+        auto const next_b = b == b_end ? std::numeric_limits<int>::max() :
+            (in_b ? b->right() : b->left()).as_int();
+        auto const x = std::min(next_a, next_b);
+
+        if (next_a == x)
+        {
+            if (in_a) ++a;
+            in_a = !in_a;
+        }
+        if (next_b == x)
+        {
+            if (in_b) ++b;
+            in_b = !in_b;
+        }
+
+        auto const keeping = keep(in_a, in_b);
+        if (keeping && !kept)
+        {
+            start = x;
+        }
+        else if (!keeping && kept)
+        {
+            // Spans that meet are joined, so a region's spans never touch
+            if (!out.empty() && out.back().right == start)
+            {
+                out.back().right = x;
+            }
+            else
+            {
+                out.push_back({start, x});
+            }
+        }
+        kept = keeping;
+    }
+}
+
+/**
+ * Combine two regions band by band.
+ *
+ * The rows are split wherever either region has the top or bottom of a band, and in each part the spans of the
+ * bands covering it are combined. So this takes time linear in the number of rectangles of both regions.
+ */
+template<typename Keep>
+auto combine(std::vector<geom::Rectangle> const& a, std::vector<geom::Rectangle> const& b, Keep keep)
+    -> std::vector<geom::Rectangle>
+{
+    std::vector<geom::Rectangle> result;
+    result.reserve(a.size() + b.size());
+    BandWriter writer{result};
+    std::vector<Span> spans;
+
+    size_t a_begin{0}, b_begin{0};
+    auto y = std::numeric_limits<int>::min();
+
+    while (a_begin != a.size() || b_begin != b.size())
+    {
+        auto const a_end = a_begin == a.size() ? a_begin : band_end(a, a_begin);
+        auto const b_end = b_begin == b.size() ? b_begin : band_end(b, b_begin);
+        auto const has_a = a_begin != a_end;
+        auto const has_b = b_begin != b_end;
+
+        // Where each band starts, not counting any part of it already combined
+        auto const a_top = has_a ? std::max(a[a_begin].top().as_int(), y) : std::numeric_limits<int>::max();
+        auto const b_top = has_b ? std::max(b[b_begin].top().as_int(), y) : std::numeric_limits<int>::max();
+        auto const top = std::min(a_top, b_top);
+
+        auto const use_a = has_a && a_top == top;
+        auto const use_b = has_b && b_top == top;
+        auto bottom = std::numeric_limits<int>::max();
+        if (use_a) bottom = std::min(bottom, a[a_begin].bottom().as_int());
+        else if (has_a) bottom = std::min(bottom, a_top);
+        if (use_b) bottom = std::min(bottom, b[b_begin].bottom().as_int());
+        else if (has_b) bottom = std::min(bottom, b_top);
+
+        spans.clear();
+        combine_spans(
+            a.data() + a_begin, a.data() + (use_a ? a_end : a_begin),
+            b.data() + b_begin, b.data() + (use_b ? b_end : b_begin),
+            keep,
+            spans);
+        writer.add_band(top, bottom, spans);
+
+        y = bottom;
+        if (use_a && a[a_begin].bottom().as_int() == bottom) a_begin = a_end;
+        if (use_b && b[b_begin].bottom().as_int() == bottom) b_begin = b_end;
+    }
+
+    return result;
+}
+
+/// The union of \a count rectangles from \a rects, merged in pairs to take O(n log n) time rather than O(n^2)
+auto union_of_rects(geom::Rectangle const* rects, size_t count) -> geom::Region
+{
+    if (count == 1)
+    {
+        return geom::Region(rects[0]);
+    }
+    if (count == 0)
+    {
+        return {};
+    }
+    auto const half = count / 2;
+    return union_of(union_of_rects(rects, half), union_of_rects(rects + half, count - half));
+}
+}
+
+geom::Region::Region(Rectangle const& rect)
+{
+    if (!is_empty(rect))
+    {
+        rectangles.push_back(rect);
+    }
+}
+
+geom::Region::Region(std::initializer_list<Rectangle> const& rects)
+    : Region(union_of_rects(rects.begin(), rects.size()))
+{
+}
+
+geom::Region::Region(Rectangles const& rects)
+{
+    std::vector<Rectangle> const list(rects.begin(), rects.end());
+    *this = union_of_rects(list.data(), list.size());
+}
+
+bool geom::Region::empty() const
+{
+    return rectangles.empty();
+}
+
+geom::Rectangle geom::Region::bounding_rectangle() const
+{
+    if (rectangles.empty())
+    {
+        return {};
+    }
+
+    auto left = rectangles.front().left();
+    auto right = rectangles.front().right();
+    for (auto const& rect : rectangles)
+    {
+        left = std::min(left, rect.left());
+        right = std::max(right, rect.right());
+    }
+
+    auto const top = rectangles.front().top();
+    auto const bottom = rectangles.back().bottom();
+    return {{left, top}, {as_width(right - left), as_height(bottom - top)}};
+}
+
+bool geom::Region::contains(Point const& point) const
+{
+    return contains(Rectangle{point, {1, 1}});
+}
+
+bool geom::Region::contains(Rectangle const& rect) const
+{
+    if (is_empty(rect))
+    {
+        return true;
+    }
+
+    // Every row of the rectangle must be in a band, and in each band a single span must cover it (as spans never
+    // touch)
+    auto band = first_band_reaching(rect.top());
+    auto y = rect.top();
+    while (y < rect.bottom())
+    {
+        if (band == rectangles.end() || y < band->top())
+        {
+            return false;
+        }
+
+        auto const top = band->top();
+        auto const bottom = band->bottom();
+        bool covered{false};
+        for (; band != rectangles.end() && band->top() == top; ++band)
+        {
+            covered = covered || (band->left() <= rect.left() && rect.right() <= band->right());
+        }
+        if (!covered)
+        {
+            return false;
+        }
+        y = bottom;
+    }
+    return true;
+}
+
+bool geom::Region::overlaps(Rectangle const& rect) const
+{
+    if (is_empty(rect))
+    {
+        return false;
+    }
+
+    for (auto r = first_band_reaching(rect.top()); r != rectangles.end() && r->top() < rect.bottom(); ++r)
+    {
+        if (r->overlaps(rect))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void geom::Region::translate(Displacement const& displacement)
+{
+    for (auto& rect : rectangles)
+    {
+        rect.top_left = rect.top_left + displacement;
+    }
+}
+
+geom::Region::const_iterator geom::Region::begin() const
+{
+    return rectangles.begin();
+}
+
+geom::Region::const_iterator geom::Region::end() const
+{
+    return rectangles.end();
+}
+
+geom::Region::size_type geom::Region::size() const
+{
+    return rectangles.size();
+}
+
+bool geom::Region::operator==(Region const& other) const
+{
+    // The banded form is canonical
+    return rectangles == other.rectangles;
+}
+
+bool geom::Region::operator!=(Region const& other) const
+{
+    return !(*this == other);
+}
+
+auto geom::Region::first_band_reaching(Y y) const -> const_iterator
+{
+    return std::upper_bound(
+        rectangles.begin(), rectangles.end(), y,
+        [](Y y, Rectangle const& rect) { return y < rect.bottom(); });
+}
+
+geom::Region geom::union_of(Region const& a, Region const& b)
+{
+    if (a.empty()) return b;
+    if (b.empty()) return a;
+
+    Region result;
+    result.rectangles = combine(a.rectangles, b.rectangles, [](bool in_a, bool in_b) { return in_a || in_b; });
+    return result;
+}
+
+geom::Region geom::intersection_of(Region const& a, Region const& b)
+{
+    if (a.empty() || b.empty()) return {};
+
+    Region result;
+    result.rectangles = combine(a.rectangles, b.rectangles, [](bool in_a, bool in_b) { return in_a && in_b; });
+    return result;
+}
+
+geom::Region geom::difference_of(Region const& a, Region const& b)
+{
+    if (a.empty() || b.empty()) return a;
+
+    Region result;
+    result.rectangles = combine(a.rectangles, b.rectangles, [](bool in_a, bool in_b) { return in_a && !in_b; });
+    return result;
+}
+
+std::ostream& geom::operator<<(std::ostream& out, Region const& value)
+{
+    out << '[';
+    for (auto const& rect : value)
+        out << rect << ", ";
+    out << ']';
+    return out;
+}
@@ -22,6 +22,7 @@
 #include "mir_toolkit/common.h"
 #include "mir/graphics/buffer_id.h"
 
+#include <functional>
 #include <memory>
 
 namespace mir
@@ -46,6 +47,15 @@ public:
     virtual void drop_old_buffers() = 0;
     virtual auto has_submitted_buffer() const -> bool = 0;
     virtual auto framedropping() const -> bool = 0;
+
+    /**
+     * Run \a callback (once) the next time a compositor takes a buffer from
+     * the stream, that is when an output showing the stream is repainted.
+     *
+     * Replaces any callback that has not run yet. The callback is run on the
+     * compositor's thread, so should do no more than hand work off.
+     */
+    virtual void on_next_repaint(std::function<void()> const& callback) = 0;
 };
 
 }
@@ -49,6 +49,17 @@ public:
         mir::geometry::Rectangle const& area,
         std::function<void(std::optional<time::Timestamp>)>&& callback) = 0;
 
+    /// As capture(), but \a buffer already holds the previous capture of \a area, so only \a damage (in buffer
+    /// pixels, from the top-left of the buffer) needs to be written to it. By default the whole buffer is written.
+    virtual void capture_damage(
+        std::shared_ptr<renderer::software::WriteMappableBuffer> const& buffer,
+        mir::geometry::Rectangle const& area,
+        mir::geometry::Rectangle const& /*damage*/,
+        std::function<void(std::optional<time::Timestamp>)>&& callback)
+    {
+        capture(buffer, area, std::move(callback));
+    }
+
 private:
     ScreenShooter(ScreenShooter const&) = delete;
     ScreenShooter& operator=(ScreenShooter const&) = delete;
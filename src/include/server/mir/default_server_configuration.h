@@ -165,6 +165,7 @@ public:
      *  @{ */
     std::shared_ptr<frontend::Connector>    the_wayland_connector() override;
     std::shared_ptr<frontend::Connector>    the_xwayland_connector() override;
+    std::shared_ptr<frontend::Connector>    the_rfb_connector() override;
     std::shared_ptr<graphics::Display>      the_display() override;
     std::shared_ptr<compositor::Compositor> the_compositor() override;
     std::shared_ptr<compositor::ScreenShooter> the_screen_shooter() override;
@@ -362,6 +363,7 @@ protected:
     CachedPtr<frontend::Connector>   connector;
     CachedPtr<frontend::Connector>   wayland_connector;
     CachedPtr<frontend::Connector>   xwayland_connector;
+    CachedPtr<frontend::Connector>   rfb_connector;
 
     CachedPtr<input::InputReport> input_report;
     CachedPtr<input::EventFilterChainDispatcher> event_filter_chain_dispatcher;
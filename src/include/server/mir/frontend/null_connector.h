@@ -0,0 +1,55 @@
+/*
+ * Copyright © 2022 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_FRONTEND_NULL_CONNECTOR_H_
+#define MIR_FRONTEND_NULL_CONNECTOR_H_
+
+#include "mir/frontend/connector.h"
+
+namespace mir
+{
+namespace frontend
+{
+/// A connector for a frontend that has not been enabled
+struct NullConnector : Connector
+{
+    void start() override
+    {
+    }
+
+    void stop() override
+    {
+    }
+
+    int client_socket_fd() const override
+    {
+        return 0;
+    }
+
+    int client_socket_fd(std::function<void(std::shared_ptr<scene::Session> const&)> const&) const override
+    {
+        return -1;
+    }
+
+    auto socket_name() const -> optional_value<std::string> override
+    {
+        return optional_value<std::string>();
+    }
+};
+}
+}
+
+#endif // MIR_FRONTEND_NULL_CONNECTOR_H_
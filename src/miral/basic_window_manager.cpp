@@ -102,7 +102,7 @@ miral::BasicWindowManager::~BasicWindowManager()
 void miral::BasicWindowManager::add_session(std::shared_ptr<scene::Session> const& session)
 {
     Locker lock{this};
-    policy->advise_new_app(app_info[session] = ApplicationInfo(session));
+    policy->advise_new_app(app_info.insert_or_assign(session, ApplicationInfo(session)));
 }
 
 void miral::BasicWindowManager::remove_session(std::shared_ptr<scene::Session> const& session)
@@ -117,7 +117,7 @@ void miral::BasicWindowManager::remove_session(std::shared_ptr<scene::Session> c
             session->process_id());
         return;
     }
-    policy->advise_delete_app(info->second);
+    policy->advise_delete_app(info->second.value);
     app_info.erase(session);
 }
 
@@ -137,7 +137,7 @@ auto miral::BasicWindowManager::add_surface(
 
     auto const surface = build(session, make_surface_spec(spec));
     Window const window{session, surface};
-    auto& window_info = this->window_info.emplace(window, WindowInfo{window, spec}).first->second;
+    auto& window_info = this->window_info.emplace(surface, WindowInfo{window, spec}).first->second.value;
 
     session_info.add_window(window);
 
@@ -200,7 +200,7 @@ void miral::BasicWindowManager::remove_surface(
     std::weak_ptr<scene::Surface> const& surface)
 {
     Locker lock{this};
-    if (app_info.find(session) == app_info.end())
+    if (!app_info.contains(session))
     {
         log_debug(
             "BasicWindowManager::remove_surface() called with unknown or already removed session %s (PID: %d)",
@@ -237,7 +237,10 @@ void miral::BasicWindowManager::remove_window(Application const& application, mi
     mru_active_windows.erase(info.window());
     fullscreen_surfaces.erase(info.window());
     for (auto& area : display_areas)
-        area->attached_windows.erase(info.window());
+    {
+        if (area->attached_windows.erase(info.window()))
+            area->needs_update = true;
+    }
     if (info.state() == mir_window_state_attached &&
         info.exclusive_rect().is_set())
     {
@@ -369,6 +372,10 @@ void miral::BasicWindowManager::handle_raise_surface(
     std::shared_ptr<scene::Surface> const& surface,
     uint64_t timestamp)
 {
+    // Input timestamps only increase, so a request older than the last input event stays stale
+    if (timestamp < last_input_event_timestamp)
+        return;
+
     Locker lock{this};
 
     if (!surface_known(surface, "raise"))
@@ -383,6 +390,9 @@ void miral::BasicWindowManager::handle_request_drag_and_drop(
     std::shared_ptr<mir::scene::Surface> const& surface,
     uint64_t timestamp)
 {
+    if (timestamp < last_input_event_timestamp)
+        return;
+
     Locker lock{this};
 
     if (!surface_known(surface, "drag-and-drop"))
@@ -397,6 +407,9 @@ void miral::BasicWindowManager::handle_request_move(
     std::shared_ptr<mir::scene::Surface> const& surface,
     uint64_t timestamp)
 {
+    if (timestamp < last_input_event_timestamp)
+        return;
+
     std::lock_guard lock(mutex);
 
     if (!surface_known(surface, "move"))
@@ -414,6 +427,9 @@ void miral::BasicWindowManager::handle_request_resize(
     uint64_t timestamp,
     MirResizeEdge edge)
 {
+    if (timestamp < last_input_event_timestamp)
+        return;
+
     std::lock_guard lock(mutex);
 
     if (!surface_known(surface, "resize"))
@@ -499,7 +515,7 @@ void miral::BasicWindowManager::for_each_application(std::function<void(Applicat
 {
     for(auto& info : app_info)
     {
-        functor(info.second);
+        functor(info.second.value);
     }
 }
 
@@ -508,9 +524,9 @@ auto miral::BasicWindowManager::find_application(std::function<bool(ApplicationI
 {
     for(auto& info : app_info)
     {
-        if (predicate(info.second))
+        if (predicate(info.second.value))
         {
-            return Application{info.first};
+            return Application{info.second.object};
         }
     }
 
@@ -1178,6 +1194,7 @@ void miral::BasicWindowManager::modify_window(WindowInfo& window_info, WindowSpe
 
     if (application_zones_need_update)
     {
+        display_area_for(window_info)->needs_update = true;
         update_application_zones_and_attached_windows();
     }
 
@@ -1409,7 +1426,10 @@ void miral::BasicWindowManager::update_attached_and_fullscreen_sets(WindowInfo c
     }
 
     for (auto& area : display_areas)
-        area->attached_windows.erase(window);
+    {
+        if (area->attached_windows.erase(window))
+            area->needs_update = true;
+    }
 
     switch (state)
     {
@@ -1420,6 +1440,7 @@ void miral::BasicWindowManager::update_attached_and_fullscreen_sets(WindowInfo c
     {
         auto area = display_area_for(window_info);
         area->attached_windows.insert(window);
+        area->needs_update = true;
         break;
     }
 
@@ -1721,7 +1742,7 @@ auto miral::BasicWindowManager::surface_known(
     std::weak_ptr<scene::Surface> const& surface,
     std::string const& action) -> bool
 {
-    if (window_info.find(surface) != window_info.end())
+    if (window_info.contains(surface))
     {
         return true;
     }
@@ -2575,6 +2596,7 @@ void miral::BasicWindowManager::add_output_to_display_areas(Locker const&, Outpu
         auto const area = matching_area->get();
         area->contained_outputs.push_back(output);
         area->area = area->bounding_rectangle_of_contained_outputs();
+        area->needs_update = true;
     }
     else
     {
@@ -2609,6 +2631,7 @@ void miral::BasicWindowManager::remove_output_from_display_areas(Locker const&,
         if (output_removed)
         {
             area->area = area->bounding_rectangle_of_contained_outputs();
+            area->needs_update = true;
         }
     }
 }
@@ -2647,6 +2670,7 @@ void miral::BasicWindowManager::advise_output_update(miral::Output const& update
             if (update_extents)
             {
                 area->area = area->bounding_rectangle_of_contained_outputs();
+                area->needs_update = true;
             }
         }
     }
@@ -2728,14 +2752,25 @@ void miral::BasicWindowManager::update_application_zones_and_attached_windows()
         if (window)
         {
             auto& info = info_for(window);
-            auto const rect =
-                policy->confirm_placement_on_display(info, mir_window_state_fullscreen, display_area_for(info)->area);
-            place_and_size(info, rect.top_left, rect.size);
+            auto const area = display_area_for(info);
+            // After an output change the area that fits best may be a different one
+            if (application_zones_need_update || area->needs_update)
+            {
+                auto const rect = policy->confirm_placement_on_display(info, mir_window_state_fullscreen, area->area);
+                place_and_size(info, rect.top_left, rect.size);
+            }
         }
     }
 
     for (auto& area : display_areas)
     {
+        // Windows attached to other areas, and the zones of other areas, are unaffected by what has changed
+        if (!area->needs_update)
+        {
+            continue;
+        }
+        area->needs_update = false;
+
         Rectangle zone_rect = area->area;
 
         /// The first pass will modify the application zone as it goes
@@ -27,6 +27,7 @@
 #include "miral/zone.h"
 #include "miral/output.h"
 #include "mru_window_list.h"
+#include "identity_map.h"
 
 #include <mir/geometry/rectangles.h>
 #include <mir/observer_registrar.h>
@@ -37,6 +38,7 @@
 #include <boost/bimap/multiset_of.hpp>
 #include <optional>
 
+#include <atomic>
 #include <map>
 #include <mutex>
 
@@ -231,10 +233,12 @@ private:
         /// Only set if this display area represents a logical group of multiple outputs
         std::optional<int> logical_output_group_id;
         std::set<Window> attached_windows; ///< Maximized/anchored/etc windows attached to this area
+        /// If the outputs or attached windows have changed since the application zone was last calculated
+        bool needs_update{true};
     };
 
-    using SurfaceInfoMap = std::map<std::weak_ptr<mir::scene::Surface>, WindowInfo, std::owner_less<std::weak_ptr<mir::scene::Surface>>>;
-    using SessionInfoMap = std::map<std::weak_ptr<mir::scene::Session>, ApplicationInfo, std::owner_less<std::weak_ptr<mir::scene::Session>>>;
+    using SurfaceInfoMap = IdentityMap<mir::scene::Surface, WindowInfo>;
+    using SessionInfoMap = IdentityMap<mir::scene::Session, ApplicationInfo>;
 
     mir::shell::FocusController* const focus_controller;
     std::shared_ptr<mir::shell::DisplayLayout> const display_layout;
@@ -256,7 +260,8 @@ private:
     SurfaceInfoMap window_info;
     mir::geometry::Rectangles outputs;
     mir::geometry::Point cursor;
-    uint64_t last_input_event_timestamp{0};
+    /// Written under the mutex, but read without it so that stale requests can be discarded without waiting for it
+    std::atomic<uint64_t> last_input_event_timestamp{0};
     MirEvent const* last_input_event{nullptr};
     miral::MRUWindowList mru_active_windows;
     bool allow_active_window = true;
@@ -327,7 +332,7 @@ private:
     void advise_output_update(Output const& updated, Output const& original) override;
     void advise_output_delete(Output const& output) override;
     void advise_output_end() override;
-    /// Updates the application zones of all display areas and moves attached windows as needed
+    /// Updates the application zones of display areas that need it and moves their attached windows as needed
     void update_application_zones_and_attached_windows();
 };
 }
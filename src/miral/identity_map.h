@@ -0,0 +1,156 @@
+/*
+ * Copyright © 2022 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIRAL_IDENTITY_MAP_H
+#define MIRAL_IDENTITY_MAP_H
+
+#include <memory>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+
+namespace miral
+{
+/// Associates a value with each of a set of shared objects, without keeping the objects alive
+/// Entries are hashed on the address of the object, which stays the same for as long as the object lives. The
+/// ownership of the weak_ptr is checked on every lookup, so an entry left behind by a destroyed object is never
+/// mistaken for a new object that happens to be allocated at the same address.
+/// As with std::map, references to values remain valid until the value is erased or replaced.
+template<typename Object, typename Value>
+class IdentityMap
+{
+public:
+    struct Entry
+    {
+        template<typename... Args>
+        Entry(std::weak_ptr<Object> object, Args&&... args)
+            : object{std::move(object)},
+              value(std::forward<Args>(args)...)
+        {
+        }
+
+        std::weak_ptr<Object> object;
+        Value value;
+    };
+
+    using Storage = std::unordered_map<Object const*, Entry>;
+    using iterator = typename Storage::iterator;
+    using const_iterator = typename Storage::const_iterator;
+
+    /// Constructs a value for \a object from \a args, unless there is already a value for it
+    template<typename... Args>
+    auto emplace(std::shared_ptr<Object> const& object, Args&&... args) -> std::pair<iterator, bool>
+    {
+        auto const existing = entries.find(object.get());
+        if (existing != entries.end())
+        {
+            if (same_owner(existing->second.object, object))
+            {
+                return {existing, false};
+            }
+
+            // Left behind by an object that has since been destroyed
+            entries.erase(existing);
+        }
+
+        return entries.try_emplace(object.get(), object, std::forward<Args>(args)...);
+    }
+
+    /// Sets the value for \a object, replacing any existing value
+    auto insert_or_assign(std::shared_ptr<Object> const& object, Value value) -> Value&
+    {
+        entries.erase(object.get());
+        return entries.try_emplace(object.get(), object, std::move(value)).first->second.value;
+    }
+
+    auto find(std::weak_ptr<Object> const& object) -> iterator
+    {
+        if (auto const live = object.lock())
+        {
+            auto const entry = entries.find(live.get());
+            if (entry != entries.end() && same_owner(entry->second.object, object))
+            {
+                return entry;
+            }
+            return entries.end();
+        }
+
+        // An object that is being destroyed can only be found by its ownership. This is rare (it happens as windows
+        // are removed) so a search is acceptable.
+        for (auto entry = entries.begin(); entry != entries.end(); ++entry)
+        {
+            if (same_owner(entry->second.object, object))
+            {
+                return entry;
+            }
+        }
+        return entries.end();
+    }
+
+    auto find(std::weak_ptr<Object> const& object) const -> const_iterator
+    {
+        return const_cast<IdentityMap*>(this)->find(object);
+    }
+
+    /// \throws std::out_of_range if there is no value for \a object
+    auto at(std::weak_ptr<Object> const& object) -> Value&
+    {
+        auto const entry = find(object);
+        if (entry == entries.end())
+        {
+            throw std::out_of_range{"IdentityMap::at: no value for object"};
+        }
+        return entry->second.value;
+    }
+
+    auto at(std::weak_ptr<Object> const& object) const -> Value const&
+    {
+        return const_cast<IdentityMap*>(this)->at(object);
+    }
+
+    auto contains(std::weak_ptr<Object> const& object) const -> bool
+    {
+        return find(object) != entries.end();
+    }
+
+    void erase(std::weak_ptr<Object> const& object)
+    {
+        auto const entry = find(object);
+        if (entry != entries.end())
+        {
+            entries.erase(entry);
+        }
+    }
+
+    auto size() const -> size_t { return entries.size(); }
+    auto empty() const -> bool { return entries.empty(); }
+
+    auto begin() -> iterator { return entries.begin(); }
+    auto end() -> iterator { return entries.end(); }
+    auto begin() const -> const_iterator { return entries.begin(); }
+    auto end() const -> const_iterator { return entries.end(); }
+
+private:
+    Storage entries;
+
+    static auto same_owner(std::weak_ptr<Object> const& lhs, std::weak_ptr<Object> const& rhs) -> bool
+    {
+        return !lhs.owner_before(rhs) && !rhs.owner_before(lhs);
+    }
+};
+}
+
+#endif //MIRAL_IDENTITY_MAP_H
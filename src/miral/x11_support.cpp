@@ -62,6 +62,12 @@ void miral::X11Support::operator()(mir::Server& server) const
         "xwayland-path",
         "Path to Xwayland executable", "/usr/bin/Xwayland");
 
+    server.add_configuration_option(
+        "xwayland-idle-timeout",
+        "Seconds without X11 clients after which Xwayland is stopped. It is restarted when an X11 client "
+        "connects. (By default Xwayland is not stopped)",
+        mir::OptionType::integer);
+
     server.add_configuration_option(
         x11_displayfd_opt,
         "file descriptor to write X11 DISPLAY number to when ready to connect", mir::OptionType::integer);
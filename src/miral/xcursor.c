@@ -25,6 +25,10 @@
 #include <stdlib.h>
 #include <string.h>
 #include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 /*
  * From libXcursor/include/X11/extensions/Xcursor.h
@@ -552,46 +556,108 @@ XcursorXcFileLoadImages (XcursorFile *file, int size)
     return images;
 }
 
+/*
+ * Cursor files are read from memory mapped files, so only the pages of
+ * the images that are wanted are read from disk.
+ */
+
+typedef struct _XcursorMemoryFile {
+    const unsigned char	*data;
+    long		size;
+    long		position;
+} XcursorMemoryFile;
+
 static int
-_XcursorStdioFileRead (XcursorFile *file, unsigned char *buf, int len)
+_XcursorMemoryFileRead (XcursorFile *file, unsigned char *buf, int len)
 {
-    FILE    *f = file->closure;
-    return fread (buf, 1, len, f);
+    XcursorMemoryFile	*f = file->closure;
+    long		available = f->size - f->position;
+
+    if (len > available)
+	len = available;
+    memcpy (buf, f->data + f->position, len);
+    f->position += len;
+    return len;
 }
 
 static int
-_XcursorStdioFileWrite (XcursorFile *file, unsigned char *buf, int len)
+_XcursorMemoryFileWrite (XcursorFile *file, unsigned char *buf, int len)
 {
-    FILE    *f = file->closure;
-    return fwrite (buf, 1, len, f);
+    (void) file;
+    (void) buf;
+    (void) len;
+    return -1;
 }
 
 static int
-_XcursorStdioFileSeek (XcursorFile *file, long offset, int whence)
+_XcursorMemoryFileSeek (XcursorFile *file, long offset, int whence)
 {
-    FILE    *f = file->closure;
-    return fseek (f, offset, whence);
-}
+    XcursorMemoryFile	*f = file->closure;
+    long		position;
 
-static void
-_XcursorStdioFileInitialize (FILE *stdfile, XcursorFile *file)
-{
-    file->closure = stdfile;
-    file->read = _XcursorStdioFileRead;
-    file->write = _XcursorStdioFileWrite;
-    file->seek = _XcursorStdioFileSeek;
+    switch (whence)
+    {
+    case SEEK_SET:
+	position = offset;
+	break;
+    case SEEK_CUR:
+	position = f->position + offset;
+	break;
+    case SEEK_END:
+	position = f->size + offset;
+	break;
+    default:
+	return EOF;
+    }
+    if (position < 0 || position > f->size)
+	return EOF;
+    f->position = position;
+    return 0;
 }
 
-static XcursorImages *
-XcursorFileLoadImages (FILE *file, int size)
+/** Load the images of the size nearest \a size from the cursor file at \a path
+ *
+ * \return The images, to be destroyed with XcursorImagesDestroy(), or
+ * NULL if the file cannot be read or is not a cursor file. The name of
+ * the images is not set.
+ */
+XcursorImages *
+xcursor_load_file(const char *path, int size)
 {
-    XcursorFile	f;
+	int fd;
+	struct stat st;
+	void *data;
+	XcursorMemoryFile memory;
+	XcursorFile file;
+	XcursorImages *images;
 
-    if (!file)
-        return NULL;
+	fd = open(path, O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+		return NULL;
 
-    _XcursorStdioFileInitialize (file, &f);
-    return XcursorXcFileLoadImages (&f, size);
+	if (fstat(fd, &st) < 0 || st.st_size == 0) {
+		close(fd);
+		return NULL;
+	}
+
+	data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED)
+		return NULL;
+
+	memory.data = data;
+	memory.size = st.st_size;
+	memory.position = 0;
+
+	file.closure = &memory;
+	file.read = _XcursorMemoryFileRead;
+	file.write = _XcursorMemoryFileWrite;
+	file.seek = _XcursorMemoryFileSeek;
+
+	images = XcursorXcFileLoadImages(&file, size);
+
+	munmap(data, st.st_size);
+	return images;
 }
 
 /*
@@ -785,15 +851,13 @@ _XcursorThemeInherits (const char *full)
 }
 
 static void
-load_all_cursors_from_dir(const char *path, int size,
-			  void (*load_callback)(XcursorImages *, void *),
-			  void *user_data)
+index_cursors_in_dir(const char *path,
+		     void (*index_callback)(const char *, const char *, void *),
+		     void *user_data)
 {
-	FILE *f;
 	DIR *dir = opendir(path);
 	struct dirent *ent;
 	char *full;
-	XcursorImages *images;
 
 	if (!dir)
 		return;
@@ -809,48 +873,31 @@ load_all_cursors_from_dir(const char *path, int size,
 		if (!full)
 			continue;
 
-		f = fopen(full, "r");
-		if (!f) {
-			free(full);
-			continue;
-		}
-
-		images = XcursorFileLoadImages(f, size);
-
-		if (images) {
-			XcursorImagesSetName(images, ent->d_name);
-			load_callback(images, user_data);
-		}
-
-		fclose (f);
+		index_callback(ent->d_name, full, user_data);
 		free(full);
 	}
 
 	closedir(dir);
 }
 
-/** Load all the cursor of a theme
+/** Find the cursors of a theme
  *
- * This function loads all the cursor images of a given theme and its
- * inherited themes. Each cursor is loaded into an XcursorImages object
- * which is passed to the caller's load callback. If a cursor appears
- * more than once across all the inherited themes, the load callback
- * will be called multiple times, with possibly different XcursorImages
- * object which have the same name. The user is expected to destroy the
- * XcursorImages objects passed to the callback with
- * XcursorImagesDestroy().
+ * This function lists the cursor files of a given theme and its
+ * inherited themes, without reading them. The files of the theme
+ * itself are listed before those of the themes it inherits, so if a
+ * cursor appears more than once the caller should use the first.
+ * The files can then be read with xcursor_load_file().
  *
- * \param theme The name of theme that should be loaded
- * \param size The desired size of the cursor images
- * \param load_callback A callback function that will be called
- * for each cursor loaded. The first parameter is the XcursorImages
- * object representing the loaded cursor and the second is a pointer
+ * \param theme The name of theme that should be indexed
+ * \param index_callback A callback function that will be called
+ * for each cursor file found. The first parameter is the name of the
+ * cursor, the second is the path of its file and the third is a pointer
  * to data provided by the user.
- * \param user_data The data that should be passed to the load callback
+ * \param user_data The data that should be passed to the index callback
  */
 void
-xcursor_load_theme(const char *theme, int size,
-		    void (*load_callback)(XcursorImages *, void *),
+xcursor_index_theme(const char *theme,
+		    void (*index_callback)(const char *, const char *, void *),
 		    void *user_data)
 {
 	char *full, *dir;
@@ -870,8 +917,7 @@ xcursor_load_theme(const char *theme, int size,
 		full = _XcursorBuildFullname(dir, "cursors", "");
 
 		if (full) {
-			load_all_cursors_from_dir(full, size, load_callback,
-						  user_data);
+			index_cursors_in_dir(full, index_callback, user_data);
 			free(full);
 		}
 
@@ -887,7 +933,7 @@ xcursor_load_theme(const char *theme, int size,
 	}
 
 	for (i = inherits; i; i = _XcursorNextPath(i))
-		xcursor_load_theme(i, size, load_callback, user_data);
+		xcursor_index_theme(i, index_callback, user_data);
 
 	if (inherits)
 		free(inherits);
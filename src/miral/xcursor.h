@@ -55,8 +55,11 @@ typedef struct _XcursorImages {
 void
 XcursorImagesDestroy (XcursorImages *images);
 
+XcursorImages *
+xcursor_load_file(const char *path, int size);
+
 void
-xcursor_load_theme(const char *theme, int size,
-		    void (*load_callback)(XcursorImages *, void *),
+xcursor_index_theme(const char *theme,
+		    void (*index_callback)(const char *, const char *, void *),
 		    void *user_data);
 #endif
@@ -19,6 +19,7 @@
 #include <mir/graphics/cursor_image.h>
 
 #include <stdexcept>
+#include <vector>
 
 #include <mir_toolkit/cursors.h>
 
@@ -67,6 +68,27 @@ private:
     std::shared_ptr<_XcursorImages> const save_resource;
 };
 
+/// The frames of an animated cursor, as XCursor themes store them: a run of images of the same size
+class XCursorAnimatedImage : public mg::AnimatedCursorImage
+{
+public:
+    explicit XCursorAnimatedImage(std::vector<Frame> frames)
+        : frames_{std::move(frames)}
+    {
+    }
+
+    auto frames() const -> std::vector<Frame> const& override
+    {
+        return frames_;
+    }
+
+private:
+    std::vector<Frame> const frames_;
+};
+
+/// Enough for the cursors in common use, while not keeping every image of a large theme
+size_t const max_loaded_images{16};
+
 std::string const
 xcursor_name_for_mir_cursor(std::string const& mir_cursor_name)
 {
@@ -135,25 +157,10 @@ xcursor_name_for_mir_cursor(std::string const& mir_cursor_name)
         return mir_cursor_name;
     }
 }
-}
-
-miral::XCursorLoader::XCursorLoader()
-{
-    load_cursor_theme("default");
-}
-
-miral::XCursorLoader::XCursorLoader(std::string const& theme)
-{
-    load_cursor_theme(theme);
-}
 
 // Each XcursorImages represents images for the different sizes of a given symbolic cursor.
-void miral::XCursorLoader::load_appropriately_sized_image(_XcursorImages *images)
+auto appropriately_sized_image(_XcursorImages *images) -> std::shared_ptr<mg::CursorImage>
 {
-    // We would rather take this lock in load_cursor_theme but the Xcursor lib style
-    // makes it difficult to use our standard 'pass the lg around to _locked members' pattern
-    std::lock_guard lg(guard);
-
     // We have to save all the images as XCursor expects us to free them.
     // This contains the actual image data though, so we need to ensure they stay alive
     // with the lifetime of the mg::CursorImage instance which refers to them.
@@ -162,33 +169,98 @@ void miral::XCursorLoader::load_appropriately_sized_image(_XcursorImages *images
             XcursorImagesDestroy(images);
         });
 
+    // Use the images of the default size if there are any, or else those of the first size
+    auto chosen_size = geom::Size{images->images[0]->width, images->images[0]->height};
     for (int i = 0; i < images->nimage; i++)
     {
         _XcursorImage *candidate = images->images[i];
         if (candidate->width == mi::default_cursor_size.width.as_uint32_t() &&
             candidate->height == mi::default_cursor_size.height.as_uint32_t())
         {
-            loaded_images[std::string(images->name)] = std::make_shared<XCursorImage>(candidate, saved_xcursor_library_resource);
-            return;
+            chosen_size = mi::default_cursor_size;
+            break;
+        }
+    }
+
+    // Animated cursors have several images of each size, which are the frames in order
+    std::vector<mg::AnimatedCursorImage::Frame> frames;
+    for (int i = 0; i < images->nimage; i++)
+    {
+        _XcursorImage *candidate = images->images[i];
+        if (geom::Size{candidate->width, candidate->height} == chosen_size)
+        {
+            frames.push_back({
+                std::make_shared<XCursorImage>(candidate, saved_xcursor_library_resource),
+                std::chrono::milliseconds{candidate->delay}});
         }
     }
 
-    loaded_images[std::string(images->name)] = std::make_shared<XCursorImage>(images->images[0], saved_xcursor_library_resource);
+    if (frames.size() == 1)
+    {
+        return frames.front().image;
+    }
+    return std::make_shared<XCursorAnimatedImage>(std::move(frames));
+}
 }
 
-void miral::XCursorLoader::load_cursor_theme(std::string const& theme_name)
+miral::XCursorLoader::XCursorLoader()
 {
-    // Cursors are named by their square dimension...called the nominal size in XCursor terminology, so we just look up by width.
-    // Later we verify the actual size.
-    xcursor_load_theme(theme_name.c_str(), mi::default_cursor_size.width.as_uint32_t(),
-        [](XcursorImages* images, void *this_ptr)  -> void
+    index_cursor_theme("default");
+}
+
+miral::XCursorLoader::XCursorLoader(std::string const& theme)
+{
+    index_cursor_theme(theme);
+}
+
+void miral::XCursorLoader::index_cursor_theme(std::string const& theme_name)
+{
+    xcursor_index_theme(theme_name.c_str(),
+        [](char const* name, char const* path, void *this_ptr)  -> void
         {
             // Can't use lambda capture as this lambda is thunked to a C function ptr
             auto p = static_cast<miral::XCursorLoader*>(this_ptr);
-            p->load_appropriately_sized_image(images);
+            // A theme's own cursors are listed before those it inherits, and take precedence
+            p->cursor_files.emplace(name, path);
         }, this);
 }
 
+auto miral::XCursorLoader::image_locked(std::string const& xcursor_name) -> std::shared_ptr<mg::CursorImage>
+{
+    for (auto loaded = loaded_images.begin(); loaded != loaded_images.end(); ++loaded)
+    {
+        if (loaded->first == xcursor_name)
+        {
+            loaded_images.splice(loaded_images.begin(), loaded_images, loaded);
+            return loaded->second;
+        }
+    }
+
+    auto const file = cursor_files.find(xcursor_name);
+    if (file == cursor_files.end())
+        return nullptr;
+
+    // Cursors are named by their square dimension...called the nominal size in XCursor terminology, so we just look
+    // up by width. Later we verify the actual size.
+    auto const images = xcursor_load_file(file->second.c_str(), mi::default_cursor_size.width.as_uint32_t());
+    if (!images || images->nimage == 0)
+    {
+        if (images)
+            XcursorImagesDestroy(images);
+
+        // Don't try to read a broken file again
+        cursor_files.erase(file);
+        return nullptr;
+    }
+
+    loaded_images.emplace_front(xcursor_name, appropriately_sized_image(images));
+    if (loaded_images.size() > max_loaded_images)
+    {
+        loaded_images.pop_back();
+    }
+    return loaded_images.front().second;
+}
+
 std::shared_ptr<mg::CursorImage> miral::XCursorLoader::image(
     std::string const& cursor_name,
     geom::Size const& /*size*/)
@@ -197,14 +269,9 @@ std::shared_ptr<mg::CursorImage> miral::XCursorLoader::image(
 
     std::lock_guard lg(guard);
 
-    auto it = loaded_images.find(xcursor_name);
-    if (it != loaded_images.end())
-        return it->second;
+    if (auto const image = image_locked(xcursor_name))
+        return image;
 
     // Fall back
-    it = loaded_images.find("arrow");
-    if (it != loaded_images.end())
-        return it->second;
-
-    return nullptr;
+    return image_locked("arrow");
 }
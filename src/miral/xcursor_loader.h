@@ -20,6 +20,7 @@
 
 #include "mir/input/cursor_images.h"
 
+#include <list>
 #include <memory>
 #include <string>
 #include <map>
@@ -53,10 +54,14 @@ protected:
 private:
     std::mutex guard;
 
-    std::map<std::string, std::shared_ptr<mir::graphics::CursorImage>> loaded_images;
+    /// The file of each cursor in the theme. The theme is indexed when the loader is created, but each cursor is only
+    /// read from its file when it is first asked for
+    std::map<std::string, std::string> cursor_files;
+    /// The cursors read most recently, most recent first
+    std::list<std::pair<std::string, std::shared_ptr<mir::graphics::CursorImage>>> loaded_images;
 
-    void load_cursor_theme(std::string const& theme_name);
-    void load_appropriately_sized_image(_XcursorImages *images);
+    void index_cursor_theme(std::string const& theme_name);
+    auto image_locked(std::string const& xcursor_name) -> std::shared_ptr<mir::graphics::CursorImage>;
 };
 }
 
@@ -17,6 +17,7 @@
 #include "miroil/mirbuffer.h"
 
 #include <mir/graphics/buffer.h>
+#include <mir/graphics/solid_color_buffer.h>
 #include <mir/graphics/texture.h>
 
 #if MIR_SERVER_VERSION < MIR_VERSION_NUMBER(2, 3, 0)
@@ -120,6 +121,25 @@ void miroil::GLBuffer::bind()
     {
         texture->bind();
     }
+    else if (auto const solid = dynamic_cast<mir::graphics::SolidColorBuffer*>(wrapped->native_buffer_base()))
+    {
+        // Nothing backs a solid color, so give the caller a single (premultiplied) texel to stretch over the quad
+        auto const& color = solid->color();
+        GLubyte const texel[]{
+            static_cast<GLubyte>(color.r * 255.0f + 0.5f),
+            static_cast<GLubyte>(color.g * 255.0f + 0.5f),
+            static_cast<GLubyte>(color.b * 255.0f + 0.5f),
+            static_cast<GLubyte>(color.a * 255.0f + 0.5f)};
+
+        if (!m_textureId)
+        {
+            glGenTextures(1, &m_textureId);
+        }
+        glBindTexture(GL_TEXTURE_2D, m_textureId);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, texel);
+    }
     else
     {
         throw std::logic_error("Buffer does not support GL rendering");
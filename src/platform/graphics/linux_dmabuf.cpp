@@ -16,6 +16,7 @@
 
 
 #include "mir/graphics/linux_dmabuf.h"
+#include "mir/graphics/linux_dmabuf_layout.h"
 #include "mir/graphics/drm_formats.h"
 
 #include "wayland_wrapper.h"
@@ -281,14 +282,7 @@ public:
 
     auto layout() -> mg::gl::Texture::Layout
     {
-        if (flags & mw::LinuxBufferParamsV1::Flags::y_invert)
-        {
-            return mg::gl::Texture::Layout::TopRowFirst;
-        }
-        else
-        {
-            return mg::gl::Texture::Layout::GL;
-        }
+        return mg::layout_from_linux_dmabuf_flags(flags);
     }
 
     auto format() -> uint32_t
@@ -930,6 +924,30 @@ private:
     std::shared_ptr<DmaBufFormatDescriptors const> const formats;
 };
 
+auto mg::layout_from_linux_dmabuf_flags(uint32_t flags) -> gl::Texture::Layout
+{
+    if (flags & mw::LinuxBufferParamsV1::Flags::y_invert)
+    {
+        return gl::Texture::Layout::TopRowFirst;
+    }
+    else
+    {
+        return gl::Texture::Layout::GL;
+    }
+}
+
+auto mg::linux_dmabuf_flags_from_layout(gl::Texture::Layout layout) -> uint32_t
+{
+    switch (layout)
+    {
+    case gl::Texture::Layout::TopRowFirst:
+        return mw::LinuxBufferParamsV1::Flags::y_invert;
+    case gl::Texture::Layout::GL:
+        return 0;
+    }
+    return 0;
+}
+
 mg::LinuxDmaBufUnstable::LinuxDmaBufUnstable(
     wl_display* display,
     EGLDisplay dpy,
@@ -0,0 +1,51 @@
+/*
+ * Copyright © 2022 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/graphics/solid_color_buffer.h"
+
+namespace mg = mir::graphics;
+namespace geom = mir::geometry;
+
+mg::SolidColorBuffer::SolidColorBuffer(geom::Size size, glm::vec4 const& color)
+    : size_{size},
+      color_{color}
+{
+}
+
+auto mg::SolidColorBuffer::size() const -> geom::Size
+{
+    return size_;
+}
+
+auto mg::SolidColorBuffer::pixel_format() const -> MirPixelFormat
+{
+    return opaque() ? mir_pixel_format_xrgb_8888 : mir_pixel_format_argb_8888;
+}
+
+auto mg::SolidColorBuffer::native_buffer_base() -> NativeBufferBase*
+{
+    return this;
+}
+
+auto mg::SolidColorBuffer::color() const -> glm::vec4 const&
+{
+    return color_;
+}
+
+auto mg::SolidColorBuffer::opaque() const -> bool
+{
+    return color_.a >= 1.0f;
+}
@@ -44,6 +44,11 @@ char const* const mo::wayland_extensions_opt      = "wayland-extensions";
 char const* const mo::add_wayland_extensions_opt  = "add-wayland-extensions";
 char const* const mo::drop_wayland_extensions_opt = "drop-wayland-extensions";
 char const* const mo::idle_timeout_opt            = "idle-timeout";
+char const* const mo::rfb_port_opt                = "rfb-port";
+char const* const mo::rfb_address_opt             = "rfb-address";
+char const* const mo::thread_pool_size_opt         = "thread-pool-size";
+char const* const mo::async_logging_opt           = "async-logging";
+char const* const mo::cache_platform_probe_opt    = "cache-platform-probe";
 
 char const* const mo::off_opt_value = "off";
 char const* const mo::log_opt_value = "log";
@@ -146,6 +151,9 @@ mo::DefaultConfiguration::DefaultConfiguration(
             "Libraries to use for platform rendering support (default: autodetect)")
         (platform_input_lib, po::value<std::string>(),
             "Library to use for platform input support (default: input-stub.so)")
+        (cache_platform_probe_opt,
+            "Remember the platforms chosen by autodetection, and on later starts with the same platform modules "
+            "and DRM devices probe only those. Only use this if the choice does not depend on other options.")
         (platform_path, po::value<std::string>()->default_value(MIR_SERVER_PLATFORM_PATH),
             "Directory to look for platform libraries (default: " MIR_SERVER_PLATFORM_PATH ")")
         (enable_input_opt, po::value<bool>()->default_value(enable_input_default),
@@ -179,6 +187,17 @@ mo::DefaultConfiguration::DefaultConfiguration(
         (idle_timeout_opt, po::value<int>()->default_value(0),
             "Time (in seconds) Mir will remain idle before turning off the display, "
             "or 0 to keep display on forever.")
+        (rfb_port_opt, po::value<int>(),
+            "Serve the screen to RFB (VNC) viewers on this TCP port. "
+            "WARNING: there is no authentication, so any local user can connect, see the screen and send input.")
+        (rfb_address_opt, po::value<std::string>()->default_value("127.0.0.1"),
+            "[requires --rfb-port] Loopback address to serve RFB viewers on. "
+            "Other addresses are refused; reach the server from other machines through an SSH tunnel.")
+        (thread_pool_size_opt, po::value<int>(),
+            "Number of threads to run background work on. [int:default=number of CPUs, but at least 4]")
+        (async_logging_opt,
+            "Write log messages from a background thread, so that logging never waits for output. "
+            "Messages that arrive faster than they can be written are dropped (and counted).")
         (fatal_except_opt, "On \"fatal error\" conditions [e.g. drivers behaving "
             "in unexpected ways] throw an exception (instead of a core dump)")
         (debug_opt, "Enable extra development debugging. "
@@ -0,0 +1,212 @@
+/*
+ * Copyright © 2022 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "frame_damage.h"
+
+#include "mir/graphics/buffer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace mg = mir::graphics;
+namespace mgc = mir::graphics::common;
+namespace geom = mir::geometry;
+
+auto mgc::FrameDamage::update(RenderableList const& renderables, geom::Rectangle const& view_area)
+    -> std::optional<geom::Rectangles>
+{
+    std::vector<Snapshot> current;
+    current.reserve(renderables.size());
+    for (auto const& renderable : renderables)
+    {
+        auto const buffer = renderable->buffer();
+        current.push_back(Snapshot{
+            renderable->id(),
+            buffer.get(),
+            buffer ? buffer->id() : BufferID{},
+            renderable->screen_position(),
+            renderable->clip_area(),
+            renderable->alpha(),
+            renderable->transformation(),
+            renderable->shaped()});
+    }
+
+    auto const first_frame = previous_view_area != view_area;
+    auto const last = std::move(previous);
+    previous = std::move(current);
+    previous_view_area = view_area;
+
+    if (first_frame)
+    {
+        return std::nullopt;
+    }
+
+    geom::Rectangles damage;
+    auto const add_damage = [&](Snapshot const& snapshot)
+        {
+            auto area = intersection_of(snapshot.position, view_area);
+            if (snapshot.clip_area)
+            {
+                area = intersection_of(area, snapshot.clip_area.value());
+            }
+            if (area.size.width > geom::Width{0} && area.size.height > geom::Height{0})
+            {
+                damage.add(area);
+            }
+        };
+
+    auto const unchanged = [](Snapshot const& a, Snapshot const& b)
+        {
+            return a.buffer == b.buffer &&
+                   a.buffer_id == b.buffer_id &&
+                   a.position == b.position &&
+                   a.clip_area == b.clip_area &&
+                   a.alpha == b.alpha &&
+                   a.transformation == b.transformation &&
+                   a.shaped == b.shaped;
+        };
+
+    std::vector<bool> still_present(last.size(), false);
+    std::optional<size_t> topmost_matched;
+    for (auto const& now : previous)
+    {
+        auto const before = std::find_if(last.begin(), last.end(), [&](auto const& s) { return s.id == now.id; });
+        if (before == last.end())
+        {
+            add_damage(now);
+            continue;
+        }
+
+        size_t const index = before - last.begin();
+        still_present[index] = true;
+
+        // A renderable that was below one we've already seen has been raised over it
+        auto const restacked = topmost_matched && index < topmost_matched.value();
+        topmost_matched = std::max(index, topmost_matched.value_or(0));
+
+        if (restacked || !unchanged(now, *before))
+        {
+            add_damage(*before);
+            if (now.position != before->position || now.clip_area != before->clip_area)
+            {
+                add_damage(now);
+            }
+        }
+    }
+
+    for (size_t i = 0; i != last.size(); ++i)
+    {
+        if (!still_present[i])
+        {
+            add_damage(last[i]);
+        }
+    }
+
+    return damage;
+}
+
+void mgc::FrameDamage::invalidate()
+{
+    previous.clear();
+    previous_view_area.reset();
+}
+
+auto mgc::egl_damage_rects(
+    geom::Rectangles const& damage,
+    geom::Rectangle const& view_area,
+    geom::Size const& buffer_size) -> std::vector<EGLint>
+{
+    auto const x_scale = buffer_size.width.as_int() / static_cast<float>(view_area.size.width.as_int());
+    auto const y_scale = buffer_size.height.as_int() / static_cast<float>(view_area.size.height.as_int());
+
+    std::vector<EGLint> rects;
+    rects.reserve(damage.size() * 4);
+    for (auto const& rect : damage)
+    {
+        auto const local = rect.top_left - view_area.top_left;
+        auto const left = static_cast<EGLint>(local.dx.as_int() * x_scale);
+        auto const top = static_cast<EGLint>(local.dy.as_int() * y_scale);
+        auto const right = static_cast<EGLint>(std::ceil((local.dx.as_int() + rect.size.width.as_int()) * x_scale));
+        auto const bottom = static_cast<EGLint>(std::ceil((local.dy.as_int() + rect.size.height.as_int()) * y_scale));
+
+        rects.push_back(left);
+        rects.push_back(buffer_size.height.as_int() - bottom);
+        rects.push_back(right - left);
+        rects.push_back(bottom - top);
+    }
+    return rects;
+}
+
+namespace
+{
+auto has_extension(EGLDisplay dpy, char const* extension) -> bool
+{
+    auto const extensions = eglQueryString(dpy, EGL_EXTENSIONS);
+    if (!extensions)
+    {
+        return false;
+    }
+
+    auto const length = strlen(extension);
+    for (auto found = strstr(extensions, extension); found; found = strstr(found + length, extension))
+    {
+        if ((found == extensions || found[-1] == ' ') && (found[length] == '\0' || found[length] == ' '))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+auto lookup_swap_with_damage(EGLDisplay dpy) -> PFNEGLSWAPBUFFERSWITHDAMAGEKHRPROC
+{
+    // The KHR and EXT variants have identical signatures and semantics
+    if (has_extension(dpy, "EGL_KHR_swap_buffers_with_damage"))
+    {
+        return reinterpret_cast<PFNEGLSWAPBUFFERSWITHDAMAGEKHRPROC>(
+            eglGetProcAddress("eglSwapBuffersWithDamageKHR"));
+    }
+    if (has_extension(dpy, "EGL_EXT_swap_buffers_with_damage"))
+    {
+        return reinterpret_cast<PFNEGLSWAPBUFFERSWITHDAMAGEKHRPROC>(
+            eglGetProcAddress("eglSwapBuffersWithDamageEXT"));
+    }
+    return nullptr;
+}
+}
+
+mgc::SwapBuffersWithDamage::SwapBuffersWithDamage(EGLDisplay dpy) :
+    swap_with_damage{lookup_swap_with_damage(dpy)}
+{
+}
+
+auto mgc::SwapBuffersWithDamage::operator()(
+    EGLDisplay dpy,
+    EGLSurface surface,
+    std::optional<std::vector<EGLint>> const& rects) const -> EGLBoolean
+{
+    if (swap_with_damage && rects)
+    {
+        // An empty damage list would be read as "everything changed", so pass a degenerate rect instead
+        static EGLint const nothing[] = {0, 0, 0, 0};
+        return rects->empty() ?
+            swap_with_damage(dpy, surface, const_cast<EGLint*>(nothing), 1) :
+            swap_with_damage(dpy, surface, const_cast<EGLint*>(rects->data()), static_cast<EGLint>(rects->size() / 4));
+    }
+
+    return eglSwapBuffers(dpy, surface);
+}
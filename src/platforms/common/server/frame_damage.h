@@ -0,0 +1,106 @@
+/*
+ * Copyright © 2022 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_PLATFORMS_COMMON_FRAME_DAMAGE_H_
+#define MIR_PLATFORMS_COMMON_FRAME_DAMAGE_H_
+
+#include "mir/graphics/renderable.h"
+#include "mir/graphics/buffer_id.h"
+#include "mir/geometry/rectangles.h"
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include <optional>
+#include <vector>
+
+namespace mir
+{
+namespace graphics
+{
+namespace common
+{
+/**
+ * Works out which parts of an output changed since the last frame, by comparing the renderables
+ * that make up each frame.
+ *
+ * Renderers redraw the whole output every frame, so this doesn't save any rendering. It lets
+ * platforms presenting to a host (X11 or Wayland) tell it which parts of the surface changed,
+ * so the host doesn't have to recomposite the whole window.
+ */
+class FrameDamage
+{
+public:
+    /**
+     * Record the renderables of a new frame.
+     *
+     * \param [in] renderables  The renderables of the frame, bottom-most first
+     * \param [in] view_area    The area of the scene shown on the output
+     * \return                  The changed areas, clipped to view_area and in scene coordinates,
+     *                          or an empty optional if the whole output must be considered damaged
+     */
+    auto update(RenderableList const& renderables, geometry::Rectangle const& view_area)
+        -> std::optional<geometry::Rectangles>;
+
+    /// Consider the whole output damaged in the next frame (e.g. if it was presented by other means)
+    void invalidate();
+
+private:
+    struct Snapshot
+    {
+        Renderable::ID id;
+        Buffer const* buffer;
+        BufferID buffer_id;
+        geometry::Rectangle position;
+        std::optional<geometry::Rectangle> clip_area;
+        float alpha;
+        glm::mat4 transformation;
+        bool shaped;
+    };
+
+    std::vector<Snapshot> previous;
+    std::optional<geometry::Rectangle> previous_view_area;
+};
+
+/**
+ * Convert damage in scene coordinates to the rectangles expected by eglSwapBuffersWithDamage:
+ * flattened {x, y, width, height} in buffer pixels with the origin at the bottom-left.
+ */
+auto egl_damage_rects(
+    geometry::Rectangles const& damage,
+    geometry::Rectangle const& view_area,
+    geometry::Size const& buffer_size) -> std::vector<EGLint>;
+
+/**
+ * eglSwapBuffersWithDamageKHR or eglSwapBuffersWithDamageEXT, falling back to eglSwapBuffers
+ * when neither is available or the damage is unknown.
+ */
+class SwapBuffersWithDamage
+{
+public:
+    explicit SwapBuffersWithDamage(EGLDisplay dpy);
+
+    auto operator()(EGLDisplay dpy, EGLSurface surface, std::optional<std::vector<EGLint>> const& rects) const
+        -> EGLBoolean;
+
+private:
+    PFNEGLSWAPBUFFERSWITHDAMAGEKHRPROC const swap_with_damage;
+};
+}
+}
+}
+
+#endif /* MIR_PLATFORMS_COMMON_FRAME_DAMAGE_H_ */
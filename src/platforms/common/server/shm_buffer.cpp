@@ -220,6 +220,16 @@ public:
     {
     }
 
+    ~Mapping()
+    {
+        if constexpr (!std::is_const_v<T>)
+        {
+            // The pixels may have been written, so the texture is stale
+            std::lock_guard lock{buffer->uploaded_mutex};
+            buffer->uploaded = false;
+        }
+    }
+
     auto format() const -> MirPixelFormat override
     {
         return buffer->pixel_format();
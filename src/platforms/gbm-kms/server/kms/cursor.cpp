@@ -27,6 +27,7 @@
 #include <boost/exception/errinfo_errno.hpp>
 
 #include <stdexcept>
+#include <string_view>
 #include <vector>
 
 namespace mg = mir::graphics;
@@ -36,6 +37,8 @@ namespace geom = mir::geometry;
 namespace
 {
 const uint64_t fallback_cursor_size = 64;
+/// Enough for every frame of the animated cursors in common themes
+size_t const max_recent_images = 32;
 char const* const mir_drm_cursor_64x64 = "MIR_DRM_CURSOR_64x64";
 
 // Transforms a relative position within the display bounds described by \a rect which is rotated with \a orientation
@@ -97,6 +100,17 @@ gbm_device* gbm_create_device_checked(int fd)
 }
 }
 
+/// An image as shown, with its data padded to the buffer size and rotated for each orientation it has been shown in
+struct mgg::Cursor::Image
+{
+    uint64_t id;
+    geom::Size size;
+    size_t hash;
+    std::vector<uint8_t> argb8888;
+    /// Keyed by orientation, buffer stride and buffer height
+    std::map<std::tuple<MirOrientation, uint32_t, uint32_t>, std::vector<uint8_t>> padded;
+};
+
 mgg::Cursor::GBMBOWrapper::GBMBOWrapper(int fd, MirOrientation orientation) :
     device{gbm_create_device_checked(fd)},
     buffer{
@@ -127,7 +141,9 @@ inline mgg::Cursor::GBMBOWrapper::~GBMBOWrapper()
 mgg::Cursor::GBMBOWrapper::GBMBOWrapper(GBMBOWrapper&& from)
     : device{from.device},
       buffer{from.buffer},
-      current_orientation{from.current_orientation}
+      current_orientation{from.current_orientation},
+      written_image{from.written_image},
+      written_orientation{from.written_orientation}
 {
     from.buffer = nullptr;
     from.device = nullptr;
@@ -142,6 +158,17 @@ auto mir::graphics::gbm::Cursor::GBMBOWrapper::change_orientation(MirOrientation
     return true;
 }
 
+auto mgg::Cursor::GBMBOWrapper::holds(uint64_t image_id) const -> bool
+{
+    return written_image == image_id && written_orientation == current_orientation;
+}
+
+void mgg::Cursor::GBMBOWrapper::written(uint64_t image_id)
+{
+    written_image = image_id;
+    written_orientation = current_orientation;
+}
+
 mgg::Cursor::Cursor(
     KMSOutputContainer& output_container,
     std::shared_ptr<CurrentConfiguration> const& current_configuration) :
@@ -193,25 +220,39 @@ void mgg::Cursor::pad_and_write_image_data_locked(
     GBMBOWrapper& buffer)
 {
     auto const orientation = buffer.orientation();
+    if (buffer.holds(image->id))
+    {
+        return;
+    }
+
     bool const sideways = orientation == mir_orientation_left || orientation == mir_orientation_right;
 
     auto const min_width  = sideways ? min_buffer_width : min_buffer_height;
     auto const min_height = sideways ? min_buffer_height : min_buffer_width;
 
-    auto const image_width = std::min(min_width, size.width.as_uint32_t());
-    auto const image_height = std::min(min_height, size.height.as_uint32_t());
-    auto const image_stride = size.width.as_uint32_t() * 4;
+    auto const image_width = std::min(min_width, image->size.width.as_uint32_t());
+    auto const image_height = std::min(min_height, image->size.height.as_uint32_t());
+    auto const image_stride = image->size.width.as_uint32_t() * 4;
 
     auto const buffer_stride = std::max(min_width*4, gbm_bo_get_stride(buffer));  // in bytes
     auto const buffer_height = std::max(min_height, gbm_bo_get_height(buffer));
     size_t const padded_size = buffer_stride * buffer_height;
 
-    auto padded = std::unique_ptr<uint8_t[]>(new uint8_t[padded_size]);
+    // Padding and rotating is done once for each orientation an image is shown in
+    auto& padded = image->padded[{orientation, buffer_stride, buffer_height}];
+    if (padded.size() == padded_size)
+    {
+        write_buffer_data_locked(lg, buffer, padded.data(), padded.size());
+        buffer.written(image->id);
+        return;
+    }
+
+    padded.resize(padded_size);
     size_t rhs_padding = buffer_stride - 4*image_width;
 
     auto const filler = 0; // 0x3f; is useful to make buffer visible for debugging
-    uint8_t const* src = argb8888.data();
-    uint8_t* dest = &padded[0];
+    uint8_t const* src = image->argb8888.data();
+    uint8_t* dest = padded.data();
 
     switch (orientation)
     {
@@ -270,7 +311,8 @@ void mgg::Cursor::pad_and_write_image_data_locked(
         break;
     }
 
-    write_buffer_data_locked(lg, buffer, &padded[0], padded_size);
+    write_buffer_data_locked(lg, buffer, padded.data(), padded_size);
+    buffer.written(image->id);
 }
 
 void mgg::Cursor::show(CursorImage const& cursor_image)
@@ -278,9 +320,7 @@ void mgg::Cursor::show(CursorImage const& cursor_image)
     std::lock_guard lg(guard);
 
     size = cursor_image.size();
-
-    argb8888.resize(size.width.as_uint32_t() * size.height.as_uint32_t() * 4);
-    memcpy(argb8888.data(), cursor_image.as_argb_8888(), argb8888.size());
+    image = image_for_locked(lg, cursor_image);
 
     hotspot = cursor_image.hotspot();
     {
@@ -407,8 +447,8 @@ void mgg::Cursor::place_cursor_at_locked(
 
             auto const changed_orientation = buffer.change_orientation(orientation);
 
-            if (changed_orientation)
-                pad_and_write_image_data_locked(lg, buffer);
+            // Only writes if the buffer doesn't already hold the image in this orientation
+            pad_and_write_image_data_locked(lg, buffer);
 
             if (force_state || !output.has_cursor() || changed_orientation)
             {
@@ -428,6 +468,39 @@ void mgg::Cursor::place_cursor_at_locked(
     last_set_failed = !set_on_all_outputs;
 }
 
+auto mgg::Cursor::image_for_locked(std::lock_guard<std::mutex> const&, CursorImage const& cursor_image)
+    -> std::shared_ptr<Image>
+{
+    // Images are matched by content, as the same CursorImage may be shown again with new content
+    std::string_view const pixels{
+        static_cast<char const*>(cursor_image.as_argb_8888()),
+        cursor_image.size().width.as_uint32_t() * cursor_image.size().height.as_uint32_t() * 4};
+    auto const hash = std::hash<std::string_view>{}(pixels);
+
+    for (auto recent = recent_images.begin(); recent != recent_images.end(); ++recent)
+    {
+        auto const& candidate = **recent;
+        if (candidate.hash == hash && candidate.size == cursor_image.size() &&
+            std::string_view{reinterpret_cast<char const*>(candidate.argb8888.data()), candidate.argb8888.size()} == pixels)
+        {
+            recent_images.splice(recent_images.begin(), recent_images, recent);
+            return recent_images.front();
+        }
+    }
+
+    recent_images.push_front(std::make_shared<Image>(Image{
+        next_image_id++,
+        cursor_image.size(),
+        hash,
+        std::vector<uint8_t>(pixels.begin(), pixels.end()),
+        {}}));
+    if (recent_images.size() > max_recent_images)
+    {
+        recent_images.pop_back();
+    }
+    return recent_images.front();
+}
+
 mgg::Cursor::GBMBOWrapper& mgg::Cursor::buffer_for_output(KMSOutput const& output)
 {
     auto const drm_fd = output.drm_fd();
@@ -444,13 +517,29 @@ mgg::Cursor::GBMBOWrapper& mgg::Cursor::buffer_for_output(KMSOutput const& outpu
     locked_buffers->push_back(image_buffer{id, drm_fd, GBMBOWrapper{drm_fd, mir_orientation_normal}});
 
     GBMBOWrapper& bo = std::get<2>(locked_buffers->back());
+    bool shrunk{false};
     if (gbm_bo_get_width(bo) < min_buffer_width)
     {
         min_buffer_width = gbm_bo_get_width(bo);
+        shrunk = true;
     }
     if (gbm_bo_get_height(bo) < min_buffer_height)
     {
         min_buffer_height = gbm_bo_get_height(bo);
+        shrunk = true;
+    }
+
+    // The images are padded to the smallest buffer, so what has been padded or written no longer fits
+    if (shrunk)
+    {
+        for (auto& recent : recent_images)
+        {
+            recent->padded.clear();
+        }
+        for (auto& other : *locked_buffers)
+        {
+            std::get<2>(other).forget_contents();
+        }
     }
 
     return bo;
@@ -28,8 +28,11 @@
 #include <gbm.h>
 
 #include <functional>
+#include <list>
+#include <map>
 #include <memory>
 #include <mutex>
+#include <tuple>
 #include <vector>
 
 namespace mir
@@ -80,6 +83,7 @@ public:
 private:
     enum ForceCursorState { UpdateState, ForceState };
     struct GBMBOWrapper;
+    struct Image;
     void for_each_used_output(std::function<void(KMSOutput& output, DisplayConfigurationOutput const& conf)> const& f);
     void place_cursor_at(geometry::Point position, ForceCursorState force_state);
     void place_cursor_at_locked(std::lock_guard<std::mutex> const&, geometry::Point position, ForceCursorState force_state);
@@ -92,6 +96,9 @@ private:
         std::lock_guard<std::mutex> const&,
         GBMBOWrapper& buffer);
     void clear(std::lock_guard<std::mutex> const&);
+    /// The recent image with the content of \a cursor_image, or a new one if there is none
+    auto image_for_locked(std::lock_guard<std::mutex> const&, CursorImage const& cursor_image)
+        -> std::shared_ptr<Image>;
 
     GBMBOWrapper& buffer_for_output(KMSOutput const& output);
     
@@ -101,7 +108,11 @@ private:
     geometry::Point current_position;
     geometry::Displacement hotspot;
     geometry::Size size;
-    std::vector<uint8_t> argb8888;
+    /// The image being shown
+    std::shared_ptr<Image> image;
+    /// The images shown most recently, most recent first, so that showing them again reuses their padded data
+    std::list<std::shared_ptr<Image>> recent_images;
+    uint64_t next_image_id{1};
 
     bool visible;
     bool last_set_failed;
@@ -114,6 +125,11 @@ private:
         auto orientation() const -> MirOrientation { return current_orientation; }
         auto change_orientation(MirOrientation new_orientation) -> bool;
 
+        /// Whether the buffer already holds the image with \a image_id, as written for its current orientation
+        auto holds(uint64_t image_id) const -> bool;
+        void written(uint64_t image_id);
+        void forget_contents() { written_image = 0; }
+
         ~GBMBOWrapper();
 
         GBMBOWrapper(GBMBOWrapper&& from);
@@ -121,6 +137,8 @@ private:
         gbm_device* device;
         gbm_bo* buffer;
         MirOrientation current_orientation;
+        uint64_t written_image{0};
+        MirOrientation written_orientation{mir_orientation_normal};
         GBMBOWrapper(GBMBOWrapper const&) = delete;
         GBMBOWrapper& operator=(GBMBOWrapper const&) = delete;
     };
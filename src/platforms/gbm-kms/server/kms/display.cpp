@@ -22,6 +22,7 @@
 #include "kms_display_configuration.h"
 #include "kms_output.h"
 #include "kms_page_flipper.h"
+#include "threaded_page_flipper.h"
 #include "mir/console_services.h"
 #include "mir/graphics/overlapping_output_grouping.h"
 #include "mir/graphics/event_handler_register.h"
@@ -189,13 +190,21 @@ mgg::Display::Display(std::vector<std::shared_ptr<helpers::DRMHelper>> const& dr
               drm_fds_from_drm_helpers(drm),
               [
                   listener,
-                  flippers = std::unordered_map<int, std::shared_ptr<KMSPageFlipper>>{}
+                  flippers = std::unordered_map<int, std::shared_ptr<PageFlipper>>{}
               ](int drm_fd) mutable
               {
                   auto& flipper = flippers[drm_fd];
                   if (!flipper)
                   {
-                      flipper = std::make_shared<KMSPageFlipper>(drm_fd, listener);
+                      // Queued (non-blocking) flips need atomic commits, and an event thread to submit them
+                      if (drmSetClientCap(drm_fd, DRM_CLIENT_CAP_ATOMIC, 1) == 0)
+                      {
+                          flipper = std::make_shared<ThreadedPageFlipper>(drm_fd, listener);
+                      }
+                      else
+                      {
+                          flipper = std::make_shared<KMSPageFlipper>(drm_fd, listener);
+                      }
                   }
                   return flipper;
               })},
@@ -436,7 +436,8 @@ mgg::DisplayBuffer::DisplayBuffer(
       area(area),
       transform{transformation},
       needs_set_crtc{false},
-      page_flips_pending{false}
+      page_flips_pending{false},
+      overlay_planes_failed{false}
 {
     listener->report_successful_setup_of_native_resources();
 
@@ -502,6 +503,8 @@ mgg::DisplayBuffer::DisplayBuffer(
 
 mgg::DisplayBuffer::~DisplayBuffer()
 {
+    // Queued flips still refer to our framebuffers
+    settle_queued_frames();
 }
 
 geom::Rectangle mgg::DisplayBuffer::view_area() const
@@ -522,6 +525,8 @@ void mgg::DisplayBuffer::set_transformation(glm::mat2 const& t, geometry::Rectan
 
 bool mgg::DisplayBuffer::overlay(RenderableList const& renderable_list)
 {
+    assigned_overlays = {};
+
     glm::mat2 static const no_transformation(1);
     if (transform == no_transformation &&
        (bypass_option == mgg::BypassOption::allowed))
@@ -550,6 +555,108 @@ bool mgg::DisplayBuffer::overlay(RenderableList const& renderable_list)
     return false;
 }
 
+auto mgg::DisplayBuffer::assign_planes(RenderableList const& renderable_list) -> RenderableList
+{
+    assigned_overlays = {};
+
+    /*
+     * The overlays are tested against the frame currently on screen, as the
+     * one they'll be shown with hasn't been rendered yet. Clone mode would
+     * need the planes of every output, so isn't attempted.
+     */
+    glm::mat2 static const no_transformation(1);
+    if (transform != no_transformation ||
+        bypass_option != mgg::BypassOption::allowed ||
+        outputs.size() != 1 ||
+        overlay_planes_failed ||
+        !(queued_frames.empty() ? visible_fb : queued_frames.back().fb))
+    {
+        return renderable_list;
+    }
+
+    auto const& output = outputs.front();
+    auto const& latest_fb = queued_frames.empty() ? visible_fb : queued_frames.back().fb;
+
+    // Planes stack in an order we don't control, so nothing may overlap an overlay from above
+    std::vector<geom::Rectangle> above;
+    std::vector<bool> on_plane(renderable_list.size(), false);
+
+    for (auto i = renderable_list.size(); i-- != 0;)
+    {
+        auto const& renderable = renderable_list[i];
+        auto const position = renderable->screen_position();
+
+        auto const overlapped = std::any_of(
+            above.begin(),
+            above.end(),
+            [&position](auto const& rect) { return rect.overlaps(position); });
+        above.push_back(position);
+
+        if (overlapped)
+        {
+            continue;
+        }
+
+        if (auto const plane = overlay_plane_for(*renderable))
+        {
+            auto planes = assigned_overlays.planes;
+            planes.push_back(plane.value());
+
+            if (output->test_overlays(*latest_fb, planes))
+            {
+                assigned_overlays.planes = std::move(planes);
+                assigned_overlays.buffers.push_back(renderable->buffer());
+                on_plane[i] = true;
+            }
+        }
+    }
+
+    RenderableList to_render;
+    to_render.reserve(renderable_list.size() - assigned_overlays.buffers.size());
+    for (auto i = 0u; i != renderable_list.size(); ++i)
+    {
+        if (!on_plane[i])
+        {
+            to_render.push_back(renderable_list[i]);
+        }
+    }
+    return to_render;
+}
+
+auto mgg::DisplayBuffer::overlay_plane_for(Renderable const& renderable) const -> std::optional<OverlayPlane>
+{
+    auto const position = renderable.screen_position();
+    auto const clip = renderable.clip_area();
+
+    if (renderable.alpha() < 1.0f ||
+        renderable.shaped() ||
+        renderable.transformation() != glm::mat4(1) ||
+        (clip && !clip.value().contains(position)) ||
+        !area.contains(position))
+    {
+        return std::nullopt;
+    }
+
+    auto const buffer = renderable.buffer();
+    auto const dmabuf_image = dynamic_cast<mg::DMABufBuffer*>(buffer->native_buffer_base());
+    if (!dmabuf_image)
+    {
+        return std::nullopt;
+    }
+
+    auto fb = outputs.front()->fb_for(*dmabuf_image);
+    if (!fb)
+    {
+        return std::nullopt;
+    }
+
+    return OverlayPlane{
+        std::move(fb),
+        dmabuf_image->drm_fourcc(),
+        {geom::Point{}, buffer->size()},
+        {geom::Point{} + (position.top_left - area.top_left), position.size}};
+}
+
 void mgg::DisplayBuffer::for_each_display_buffer(
     std::function<void(graphics::DisplayBuffer&)> const& f)
 {
@@ -583,6 +690,33 @@ void mgg::DisplayBuffer::set_crtc(FBHandle const& forced_frame)
 
 void mgg::DisplayBuffer::post()
 {
+    QueuedFrame frame;
+    if (bypass_buf)
+    {
+        frame.fb = bypass_bufobj;
+        frame.bypass_frame = bypass_buf;
+    }
+    else
+    {
+        frame.composite_frame = get_front_buffer(surface.lock_front());
+        frame.fb = outputs.front()->fb_for(frame.composite_frame);
+        if (!frame.fb)
+            fatal_error("Failed to get front buffer object");
+        frame.overlays = std::move(assigned_overlays);
+    }
+    assigned_overlays = {};
+
+    /*
+     * Not in clone mode? If the page flipper can queue flips we can hand the
+     * frame over and carry on without waiting for any flip at all.
+     */
+    if (outputs.size() == 1 && !needs_set_crtc && queue_page_flip(frame))
+    {
+        bypass_buf = nullptr;
+        bypass_bufobj = nullptr;
+        return;
+    }
+
     /*
      * We might not have waited for the previous frame to page flip yet.
      * This is good because it maximizes the time available to spend rendering
@@ -591,20 +725,12 @@ void mgg::DisplayBuffer::post()
      */
     wait_for_page_flip();
 
-    std::shared_ptr<mgg::FBHandle const> bufobj;
-    if (bypass_buf)
+    if (!bypass_buf)
     {
-        bufobj = bypass_bufobj;
-    }
-    else
-    {
-        scheduled_composite_frame = get_front_buffer(surface.lock_front());
-        bufobj = outputs.front()->fb_for(scheduled_composite_frame);
-        if (!bufobj)
-            fatal_error("Failed to get front buffer object");
+        scheduled_composite_frame = std::move(frame.composite_frame);
+        scheduled_overlays = std::move(frame.overlays);
     }
-
-    scheduled_fb = std::move(bufobj);
+    scheduled_fb = std::move(frame.fb);
     /*
      * Try to schedule a page flip as first preference to avoid tearing.
      * [will complete in a background thread]
@@ -687,6 +813,102 @@ std::chrono::milliseconds mgg::DisplayBuffer::recommended_sleep() const
     return recommend_sleep;
 }
 
+bool mgg::DisplayBuffer::queue_page_flip(QueuedFrame& frame)
+{
+    using namespace std::chrono_literals;  // For operator""ms()
+
+    auto const& output = outputs.front();
+
+    // Queued flips aren't ordered against legacy ones, so let those finish first
+    if (page_flips_pending)
+        wait_for_page_flip();
+
+    auto const queued = output->queue_page_flip(*frame.fb, frame.overlays.planes);
+    if (!queued.id)
+    {
+        return false;
+    }
+
+    auto const presented = output->presented_flip();
+    if (queued_frames.empty())
+    {
+        /*
+         * The frame that was on screen stays there until a queued flip
+         * replaces it. Until then presented_flip() still refers to whatever
+         * was queued last (if anything), so that's the id it goes by.
+         */
+        QueuedFrame visible;
+        visible.flip_id = std::min(presented, queued.id.value() - 1);
+        visible.fb = std::move(visible_fb);
+        visible.composite_frame = std::move(visible_composite_frame);
+        visible.bypass_frame = std::move(visible_bypass_frame);
+        visible.overlays = std::move(visible_overlays);
+        queued_frames.push_back(std::move(visible));
+
+        visible_fb = nullptr;
+        visible_bypass_frame = nullptr;
+        visible_overlays = {};
+    }
+
+    frame.flip_id = queued.id.value();
+    queued_frames.push_back(std::move(frame));
+
+    // Anything older than the frame on screen, or dropped from the queue, is done with
+    std::erase_if(
+        queued_frames,
+        [&](QueuedFrame const& queued_frame)
+        {
+            return queued_frame.flip_id < presented ||
+                std::find(queued.discarded.begin(), queued.discarded.end(), queued_frame.flip_id) !=
+                    queued.discarded.end();
+        });
+
+    /*
+     * With one flip pending and another queued behind it, a frame rendered
+     * now would only replace the queued one; better to wait for the next
+     * vblank than burn the GPU.
+     */
+    auto const in_flight = std::count_if(
+        queued_frames.begin(),
+        queued_frames.end(),
+        [presented](QueuedFrame const& queued_frame) { return queued_frame.flip_id > presented; });
+
+    recommend_sleep = 0ms;
+    auto const rate = output->max_refresh_rate();
+    if (in_flight > 1 && rate > 0)
+    {
+        auto const frame_interval = std::chrono::nanoseconds{1s} / rate;
+        auto const last_flip = output->last_frame().ust;
+        auto const since_last_flip = Frame::Timestamp::now(last_flip.clock_id) - last_flip;
+        recommend_sleep = std::chrono::duration_cast<std::chrono::milliseconds>(
+            frame_interval - since_last_flip % frame_interval);
+    }
+
+    return true;
+}
+
+void mgg::DisplayBuffer::settle_queued_frames()
+{
+    if (queued_frames.empty())
+        return;
+
+    auto const& output = outputs.front();
+    output->wait_for_page_flip();
+    auto const presented = output->presented_flip();
+
+    for (auto& frame : queued_frames)
+    {
+        if (frame.flip_id == presented)
+        {
+            visible_fb = std::move(frame.fb);
+            visible_composite_frame = std::move(frame.composite_frame);
+            visible_bypass_frame = std::move(frame.bypass_frame);
+            visible_overlays = std::move(frame.overlays);
+        }
+    }
+    queued_frames.clear();
+}
+
 bool mgg::DisplayBuffer::schedule_page_flip(FBHandle const& bufobj)
 {
     /*
@@ -695,8 +917,20 @@ bool mgg::DisplayBuffer::schedule_page_flip(FBHandle const& bufobj)
      */
     for (auto& output : outputs)
     {
-        if (output->schedule_page_flip(bufobj))
+        auto const scheduled = scheduled_overlays.planes.empty() ?
+            output->schedule_page_flip(bufobj) :
+            output->schedule_page_flip(bufobj, scheduled_overlays.planes);
+
+        if (scheduled)
+        {
             page_flips_pending = true;
+        }
+        else if (!scheduled_overlays.planes.empty())
+        {
+            // The set_crtc() fallback can't show the overlays, so stop using them
+            mir::log_warning("Failed to flip with overlay planes; compositing everything from now on");
+            overlay_planes_failed = true;
+        }
     }
 
     return page_flips_pending;
@@ -704,6 +938,8 @@ bool mgg::DisplayBuffer::schedule_page_flip(FBHandle const& bufobj)
 
 void mgg::DisplayBuffer::wait_for_page_flip()
 {
+    settle_queued_frames();
+
     if (page_flips_pending)
     {
         for (auto& output : outputs)
@@ -726,6 +962,9 @@ void mgg::DisplayBuffer::wait_for_page_flip()
 
         visible_composite_frame = std::move(scheduled_composite_frame);
         scheduled_composite_frame = nullptr;
+
+        visible_overlays = std::move(scheduled_overlays);
+        scheduled_overlays = {};
     }
 }
 
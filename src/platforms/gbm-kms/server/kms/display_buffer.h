@@ -19,14 +19,18 @@
 
 #include "mir/graphics/display_buffer.h"
 #include "mir/graphics/display.h"
+#include "mir/graphics/overlay_planes.h"
 #include "mir/renderer/gl/render_target.h"
 #include "display_helpers.h"
 #include "egl_helper.h"
 #include "platform_common.h"
+#include "kms_output.h"
 
 #include <vector>
+#include <deque>
 #include <memory>
 #include <atomic>
+#include <optional>
 
 namespace mir
 {
@@ -94,6 +98,7 @@ private:
 class DisplayBuffer : public graphics::DisplayBuffer,
                       public graphics::DisplaySyncGroup,
                       public graphics::NativeDisplayBuffer,
+                      public graphics::OverlayPlanes,
                       public renderer::gl::RenderTarget
 {
 public:
@@ -111,6 +116,7 @@ public:
     void release_current() override;
     void swap_buffers() override;
     bool overlay(RenderableList const& renderlist) override;
+    auto assign_planes(RenderableList const& renderlist) -> RenderableList override;
     void bind() override;
 
     void for_each_display_buffer(
@@ -128,6 +134,28 @@ public:
 private:
     bool schedule_page_flip(FBHandle const& bufobj);
     void set_crtc(FBHandle const&);
+    auto overlay_plane_for(Renderable const& renderable) const -> std::optional<OverlayPlane>;
+
+    /// Client buffers shown on overlay planes, and the framebuffers made from them
+    struct Overlays
+    {
+        std::vector<OverlayPlane> planes;
+        std::vector<std::shared_ptr<Buffer>> buffers;
+    };
+    Overlays assigned_overlays, scheduled_overlays, visible_overlays;
+
+    /// A frame handed to the page flipper, kept until it's off the screen
+    struct QueuedFrame
+    {
+        uint64_t flip_id{0};
+        std::shared_ptr<FBHandle const> fb;
+        GBMOutputSurface::FrontBuffer composite_frame;
+        std::shared_ptr<graphics::Buffer> bypass_frame;
+        Overlays overlays;
+    };
+    bool queue_page_flip(QueuedFrame& frame);
+    /// Wait for queued flips to land, leaving the frame on screen as the visible one
+    void settle_queued_frames();
 
     std::shared_ptr<graphics::Buffer> visible_bypass_frame, scheduled_bypass_frame;
     std::shared_ptr<Buffer> bypass_buf{nullptr};
@@ -148,6 +176,7 @@ private:
 
     GBMOutputSurface::FrontBuffer visible_composite_frame;
     GBMOutputSurface::FrontBuffer scheduled_composite_frame;
+    std::deque<QueuedFrame> queued_frames;   // Oldest first
 
     std::shared_ptr<FBHandle const> scheduled_fb{nullptr};
     std::shared_ptr<FBHandle const> visible_fb{nullptr};
@@ -157,6 +186,7 @@ private:
     std::atomic<bool> needs_set_crtc;
     std::chrono::milliseconds recommend_sleep{0};
     bool page_flips_pending;
+    bool overlay_planes_failed;
 };
 
 }
@@ -20,15 +20,20 @@
 #include "mir/geometry/size.h"
 #include "mir/geometry/point.h"
 #include "mir/geometry/displacement.h"
+#include "mir/geometry/rectangle.h"
 #include "mir/graphics/display_configuration.h"
 #include "mir/graphics/frame.h"
 #include "mir/graphics/dmabuf_buffer.h"
 #include "mir_toolkit/common.h"
 
 #include "kms-utils/drm_mode_resources.h"
+#include "page_flipper.h"
 
 #include <gbm.h>
 
+#include <memory>
+#include <vector>
+
 namespace mir
 {
 namespace graphics
@@ -40,6 +45,15 @@ namespace gbm
 
 class FBHandle;
 
+/// A framebuffer to show on an overlay plane, above the primary framebuffer
+struct OverlayPlane
+{
+    std::shared_ptr<FBHandle const> fb;
+    uint32_t format;                    ///< DRM fourcc of the framebuffer
+    geometry::Rectangle source;         ///< The part of the framebuffer to show, in buffer pixels
+    geometry::Rectangle destination;    ///< Where to show it, in output pixels
+};
+
 class KMSOutput
 {
 public:
@@ -68,6 +82,35 @@ public:
     virtual bool schedule_page_flip(FBHandle const& fb) = 0;
     virtual void wait_for_page_flip() = 0;
 
+    /**
+     * Check whether the hardware can show overlays on planes above fb.
+     *
+     * This is an atomic DRM_MODE_ATOMIC_TEST_ONLY commit; nothing is shown.
+     *
+     * \return  False if the configuration is rejected, including when this
+     *          output has no overlay planes to offer.
+     */
+    virtual bool test_overlays(FBHandle const& fb, std::vector<OverlayPlane> const& overlays) = 0;
+    /**
+     * As schedule_page_flip(fb), additionally showing overlays on planes above
+     * fb as part of the same flip.
+     */
+    virtual bool schedule_page_flip(FBHandle const& fb, std::vector<OverlayPlane> const& overlays) = 0;
+    /**
+     * Flip to fb and overlays in an atomic commit without waiting for earlier
+     * flips; if one is still pending this flip is submitted after it,
+     * replacing any flip queued before.
+     *
+     * The framebuffers must be kept until presented_flip() moves past the
+     * returned id, or the id is reported as discarded.
+     *
+     * \return  No id if the flip couldn't be queued, in which case
+     *          schedule_page_flip() is the way to show fb.
+     */
+    virtual auto queue_page_flip(FBHandle const& fb, std::vector<OverlayPlane> const& overlays) -> QueuedFlip = 0;
+    /// The id of the last queued flip to reach the screen, also updating last_frame()
+    virtual auto presented_flip() -> uint64_t = 0;
+
     virtual bool set_cursor(gbm_bo* buffer) = 0;
     virtual void move_cursor(geometry::Point destination) = 0;
     virtual bool clear_cursor() = 0;
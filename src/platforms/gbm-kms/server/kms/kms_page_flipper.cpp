@@ -62,6 +62,51 @@ mgg::KMSPageFlipper::KMSPageFlipper(
 bool mgg::KMSPageFlipper::schedule_flip(uint32_t crtc_id,
                                         uint32_t fb_id,
                                         uint32_t connector_id)
+{
+    /*
+     * It appears we can't tell the difference between flipping being
+     * unsupported or failing for other reasons. On VirtualBox this always
+     * fails with -22 (Invalid argument) despite the arguments being
+     * apparently valid.
+     */
+    return schedule(
+        crtc_id,
+        connector_id,
+        [this, crtc_id, fb_id](void* event_data)
+        {
+            return drmModePageFlip(drm_fd, crtc_id, fb_id, DRM_MODE_PAGE_FLIP_EVENT, event_data);
+        });
+}
+
+bool mgg::KMSPageFlipper::schedule_atomic_flip(
+    uint32_t crtc_id,
+    uint32_t connector_id,
+    std::function<int(void* event_data)> const& commit)
+{
+    // Atomic commits deliver their flip events through the same page_flip_handler
+    return schedule(crtc_id, connector_id, commit);
+}
+
+auto mgg::KMSPageFlipper::queue_atomic_flip(
+    uint32_t /*crtc_id*/,
+    uint32_t /*connector_id*/,
+    std::function<int(void* event_data)> /*commit*/) -> QueuedFlip
+{
+    // Flip events are only handled while someone waits for them, so there's nobody to submit a queued flip
+    return {};
+}
+
+auto mgg::KMSPageFlipper::presented_flip(uint32_t crtc_id) -> PresentedFlip
+{
+    std::unique_lock lock{pf_mutex};
+
+    return {0, completed_page_flips[crtc_id]};
+}
+
+bool mgg::KMSPageFlipper::schedule(
+    uint32_t crtc_id,
+    uint32_t connector_id,
+    std::function<int(void* event_data)> const& submit)
 {
     std::unique_lock lock{pf_mutex};
 
@@ -70,15 +115,7 @@ bool mgg::KMSPageFlipper::schedule_flip(uint32_t crtc_id,
 
     pending_page_flips[crtc_id] = PageFlipEventData{crtc_id, connector_id, this};
 
-    /*
-     * It appears we can't tell the difference between flipping being
-     * unsupported or failing for other reasons. On VirtualBox this always
-     * fails with -22 (Invalid argument) despite the arguments being
-     * apparently valid.
-     */
-    auto ret = drmModePageFlip(drm_fd, crtc_id, fb_id,
-                               DRM_MODE_PAGE_FLIP_EVENT,
-                               &pending_page_flips[crtc_id]);
+    auto ret = submit(&pending_page_flips[crtc_id]);
 
     if (ret)
         pending_page_flips.erase(crtc_id);
@@ -51,12 +51,22 @@ public:
     KMSPageFlipper(int drm_fd, std::shared_ptr<DisplayReport> const& report);
 
     bool schedule_flip(uint32_t crtc_id, uint32_t fb_id, uint32_t connector_id) override;
+    bool schedule_atomic_flip(
+        uint32_t crtc_id,
+        uint32_t connector_id,
+        std::function<int(void* event_data)> const& commit) override;
+    auto queue_atomic_flip(
+        uint32_t crtc_id,
+        uint32_t connector_id,
+        std::function<int(void* event_data)> commit) -> QueuedFlip override;
+    auto presented_flip(uint32_t crtc_id) -> PresentedFlip override;
     Frame wait_for_flip(uint32_t crtc_id) override;
 
     std::thread::id debug_get_worker_tid();
 
     void notify_page_flip(uint32_t crtc_id, int64_t msc, std::chrono::nanoseconds ust);
 private:
+    bool schedule(uint32_t crtc_id, uint32_t connector_id, std::function<int(void* event_data)> const& submit);
     bool page_flip_is_done(uint32_t crtc_id);
 
     int const drm_fd;
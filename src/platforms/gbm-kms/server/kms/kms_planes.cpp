@@ -0,0 +1,416 @@
+/*
+ * Copyright © 2022 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "kms_planes.h"
+#include "mir/log.h"
+
+#include <boost/throw_exception.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <system_error>
+#include <xf86drm.h>
+
+namespace mgg = mir::graphics::gbm;
+namespace mgk = mir::graphics::kms;
+
+namespace
+{
+auto crtc_index_of(int drm_fd, uint32_t crtc_id) -> int
+{
+    mgk::DRMModeResources resources{drm_fd};
+
+    int index{0};
+    for (auto const& crtc : resources.crtcs())
+    {
+        if (crtc->crtc_id == crtc_id)
+        {
+            return index;
+        }
+        ++index;
+    }
+
+    BOOST_THROW_EXCEPTION(std::runtime_error{"Failed to find index of CRTC?!"});
+}
+
+auto has_position_properties(mgk::ObjectProperties const& properties) -> bool
+{
+    for (auto const name : {
+        "FB_ID", "CRTC_ID",
+        "SRC_X", "SRC_Y", "SRC_W", "SRC_H",
+        "CRTC_X", "CRTC_Y", "CRTC_W", "CRTC_H"})
+    {
+        if (!properties.has_property(name))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+auto atomic_crtc_properties(int drm_fd, uint32_t crtc_id) -> mgk::ObjectProperties
+{
+    // Enabling atomic modesetting also exposes the primary and cursor planes, and the CRTC's MODE_ID and ACTIVE
+    if (drmSetClientCap(drm_fd, DRM_CLIENT_CAP_ATOMIC, 1))
+    {
+        BOOST_THROW_EXCEPTION((
+            std::system_error{errno, std::system_category(), "Request for Atomic Modesetting support failed"}));
+    }
+
+    return mgk::ObjectProperties{drm_fd, crtc_id, DRM_MODE_OBJECT_CRTC};
+}
+}
+
+mgg::KMSPlanes::PropertyBlob::PropertyBlob(int drm_fd, uint32_t id)
+    : id{id},
+      drm_fd{drm_fd}
+{
+}
+
+mgg::KMSPlanes::PropertyBlob::~PropertyBlob()
+{
+    drmModeDestroyPropertyBlob(drm_fd, id);
+}
+
+mgg::KMSPlanes::KMSPlanes(int drm_fd, uint32_t crtc_id)
+    : drm_fd{drm_fd},
+      crtc_id_{crtc_id},
+      crtc_properties{atomic_crtc_properties(drm_fd, crtc_id)}
+{
+    auto const crtc_mask = 1u << crtc_index_of(drm_fd, crtc_id);
+
+    std::vector<Plane> candidates;
+    mgk::PlaneResources plane_res{drm_fd};
+    for (auto& plane : plane_res.planes())
+    {
+        if (!(plane->possible_crtcs & crtc_mask))
+        {
+            continue;
+        }
+
+        mgk::ObjectProperties properties{drm_fd, plane->plane_id, DRM_MODE_OBJECT_PLANE};
+        if (!properties.has_property("type") || !has_position_properties(properties))
+        {
+            continue;
+        }
+
+        auto const type = properties["type"];
+        if (type == DRM_PLANE_TYPE_PRIMARY)
+        {
+            // Prefer the primary plane already scanning out on this CRTC
+            if (!primary || plane->crtc_id == crtc_id)
+            {
+                primary = std::make_unique<Plane>(Plane{plane->plane_id, std::move(properties), {}, true});
+            }
+        }
+        else if (type == DRM_PLANE_TYPE_OVERLAY && plane->possible_crtcs == crtc_mask)
+        {
+            /*
+             * Nothing arbitrates between outputs, so planes that could be
+             * claimed by another CRTC are left alone.
+             */
+            candidates.push_back(Plane{
+                plane->plane_id,
+                std::move(properties),
+                {plane->formats, plane->formats + plane->count_formats},
+                false});
+        }
+    }
+
+    if (!primary)
+    {
+        BOOST_THROW_EXCEPTION(std::runtime_error{"Could not find primary plane for CRTC"});
+    }
+
+    for (auto const& plane : candidates)
+    {
+        /*
+         * Planes stacked below the primary plane would only show through holes
+         * in the composited frame, which our renderer doesn't leave.
+         */
+        if (primary->properties.has_property("zpos") &&
+            plane.properties.has_property("zpos") &&
+            plane.properties["zpos"] <= primary->properties["zpos"])
+        {
+            continue;
+        }
+
+        overlays.push_back(plane);
+    }
+
+    mir::log_info("CRTC %u has %zu overlay planes available", crtc_id, overlays.size());
+}
+
+mgg::KMSPlanes::~KMSPlanes() = default;
+
+auto mgg::KMSPlanes::crtc_id() const -> uint32_t
+{
+    return crtc_id_;
+}
+
+auto mgg::KMSPlanes::overlay_count() const -> size_t
+{
+    return overlays.size();
+}
+
+auto mgg::KMSPlanes::test(Content const& primary, std::vector<Content> const& overlays) const -> bool
+{
+    std::lock_guard lock{mutex};
+
+    auto const request = request_for(primary, overlays).first;
+    if (!request)
+    {
+        return false;
+    }
+
+    return drmModeAtomicCommit(drm_fd, request.get(), DRM_MODE_ATOMIC_TEST_ONLY, nullptr) == 0;
+}
+
+auto mgg::KMSPlanes::commit(
+    Content const& primary,
+    std::vector<Content> const& overlays,
+    uint32_t flags,
+    void* user_data) -> int
+{
+    std::lock_guard lock{mutex};
+
+    auto const [request, used] = request_for(primary, overlays);
+    if (!request)
+    {
+        return -EINVAL;
+    }
+    add_pending_gamma(request.get());
+
+    auto const result = drmModeAtomicCommit(drm_fd, request.get(), flags, user_data);
+    if (result == 0)
+    {
+        committed(used);
+    }
+    return result;
+}
+
+auto mgg::KMSPlanes::modeset(uint32_t connector_id, drmModeModeInfo const& mode, Content const& primary_content) -> int
+{
+    if (!crtc_properties.has_property("MODE_ID") || !crtc_properties.has_property("ACTIVE"))
+    {
+        return -ENOTSUP;
+    }
+
+    mgk::ObjectProperties const connector_properties{drm_fd, connector_id, DRM_MODE_OBJECT_CONNECTOR};
+    if (!connector_properties.has_property("CRTC_ID"))
+    {
+        return -ENOTSUP;
+    }
+
+    std::lock_guard lock{mutex};
+
+    uint32_t mode_blob_id{0};
+    if (auto const result = drmModeCreatePropertyBlob(drm_fd, &mode, sizeof(mode), &mode_blob_id))
+    {
+        return result;
+    }
+    PropertyBlob const mode_blob{drm_fd, mode_blob_id};
+
+    AtomicRequest request{drmModeAtomicAlloc(), &drmModeAtomicFree};
+    drmModeAtomicAddProperty(request.get(), crtc_id_, crtc_properties.id_for("MODE_ID"), mode_blob.id);
+    drmModeAtomicAddProperty(request.get(), crtc_id_, crtc_properties.id_for("ACTIVE"), 1);
+    drmModeAtomicAddProperty(request.get(), connector_id, connector_properties.id_for("CRTC_ID"), crtc_id_);
+    add_plane(request.get(), *primary, primary_content);
+    for (auto const& plane : overlays)
+    {
+        if (plane.in_use)
+        {
+            add_disabled_plane(request.get(), plane);
+        }
+    }
+    add_pending_gamma(request.get());
+
+    auto const result = drmModeAtomicCommit(drm_fd, request.get(), DRM_MODE_ATOMIC_ALLOW_MODESET, nullptr);
+    if (result == 0)
+    {
+        committed(std::vector<bool>(overlays.size(), false));
+    }
+    return result;
+}
+
+bool mgg::KMSPlanes::set_gamma(GammaCurves const& gamma)
+{
+    auto const size = gamma.red.size();
+    if (!crtc_properties.has_property("GAMMA_LUT") ||
+        !crtc_properties.has_property("GAMMA_LUT_SIZE") ||
+        crtc_properties["GAMMA_LUT_SIZE"] != size ||
+        gamma.green.size() != size ||
+        gamma.blue.size() != size)
+    {
+        return false;
+    }
+
+    std::vector<drm_color_lut> lut(size);
+    for (auto i = 0u; i != size; ++i)
+    {
+        lut[i] = drm_color_lut{gamma.red[i], gamma.green[i], gamma.blue[i], 0};
+    }
+
+    uint32_t blob_id{0};
+    if (auto const result = drmModeCreatePropertyBlob(drm_fd, lut.data(), lut.size() * sizeof(lut[0]), &blob_id))
+    {
+        mir::log_warning("Failed to create gamma LUT for CRTC %u: %s", crtc_id_, strerror(-result));
+        return false;
+    }
+
+    std::lock_guard lock{mutex};
+    pending_gamma = std::make_unique<PropertyBlob>(drm_fd, blob_id);
+    return true;
+}
+
+auto mgg::KMSPlanes::overlays_active() const -> bool
+{
+    std::lock_guard lock{mutex};
+
+    return overlays_in_use();
+}
+
+auto mgg::KMSPlanes::needs_atomic_commit() const -> bool
+{
+    std::lock_guard lock{mutex};
+
+    return pending_gamma || overlays_in_use();
+}
+
+void mgg::KMSPlanes::disable_overlays()
+{
+    std::lock_guard lock{mutex};
+
+    if (!overlays_in_use())
+    {
+        return;
+    }
+
+    AtomicRequest request{drmModeAtomicAlloc(), &drmModeAtomicFree};
+    for (auto const& plane : overlays)
+    {
+        if (plane.in_use)
+        {
+            add_disabled_plane(request.get(), plane);
+        }
+    }
+
+    if (auto const result = drmModeAtomicCommit(drm_fd, request.get(), 0, nullptr))
+    {
+        mir::log_warning("Failed to disable overlay planes on CRTC %u: %s", crtc_id_, strerror(-result));
+        return;
+    }
+
+    for (auto& plane : overlays)
+    {
+        plane.in_use = false;
+    }
+}
+
+auto mgg::KMSPlanes::request_for(Content const& primary_content, std::vector<Content> const& overlay_contents) const
+    -> std::pair<AtomicRequest, std::vector<bool>>
+{
+    std::vector<bool> used(overlays.size(), false);
+    if (overlay_contents.size() > overlays.size())
+    {
+        return {AtomicRequest{nullptr, &drmModeAtomicFree}, std::move(used)};
+    }
+
+    AtomicRequest request{drmModeAtomicAlloc(), &drmModeAtomicFree};
+    add_plane(request.get(), *primary, primary_content);
+
+    for (auto const& content : overlay_contents)
+    {
+        // Use the first free plane that can scan out this format
+        auto const plane = std::find_if(
+            overlays.begin(),
+            overlays.end(),
+            [&](Plane const& plane)
+            {
+                return !used[&plane - overlays.data()] &&
+                    std::find(plane.formats.begin(), plane.formats.end(), content.format) != plane.formats.end();
+            });
+
+        if (plane == overlays.end())
+        {
+            return {AtomicRequest{nullptr, &drmModeAtomicFree}, std::move(used)};
+        }
+
+        used[plane - overlays.begin()] = true;
+        add_plane(request.get(), *plane, content);
+    }
+
+    for (auto i = 0u; i != overlays.size(); ++i)
+    {
+        if (overlays[i].in_use && !used[i])
+        {
+            add_disabled_plane(request.get(), overlays[i]);
+        }
+    }
+
+    return {std::move(request), std::move(used)};
+}
+
+void mgg::KMSPlanes::add_plane(drmModeAtomicReq* request, Plane const& plane, Content const& content) const
+{
+    auto const& props = plane.properties;
+    auto const& src = content.source;
+    auto const& dest = content.destination;
+
+    drmModeAtomicAddProperty(request, plane.id, props.id_for("FB_ID"), content.fb_id);
+    drmModeAtomicAddProperty(request, plane.id, props.id_for("CRTC_ID"), crtc_id_);
+
+    /* Source viewport. Coordinates are 16.16 fixed point */
+    drmModeAtomicAddProperty(request, plane.id, props.id_for("SRC_X"), uint64_t{src.top_left.x.as_uint32_t()} << 16);
+    drmModeAtomicAddProperty(request, plane.id, props.id_for("SRC_Y"), uint64_t{src.top_left.y.as_uint32_t()} << 16);
+    drmModeAtomicAddProperty(request, plane.id, props.id_for("SRC_W"), uint64_t{src.size.width.as_uint32_t()} << 16);
+    drmModeAtomicAddProperty(request, plane.id, props.id_for("SRC_H"), uint64_t{src.size.height.as_uint32_t()} << 16);
+
+    /* Destination viewport. Coordinates are *not* 16.16 */
+    drmModeAtomicAddProperty(request, plane.id, props.id_for("CRTC_X"), dest.top_left.x.as_int());
+    drmModeAtomicAddProperty(request, plane.id, props.id_for("CRTC_Y"), dest.top_left.y.as_int());
+    drmModeAtomicAddProperty(request, plane.id, props.id_for("CRTC_W"), dest.size.width.as_uint32_t());
+    drmModeAtomicAddProperty(request, plane.id, props.id_for("CRTC_H"), dest.size.height.as_uint32_t());
+}
+
+void mgg::KMSPlanes::add_disabled_plane(drmModeAtomicReq* request, Plane const& plane) const
+{
+    drmModeAtomicAddProperty(request, plane.id, plane.properties.id_for("FB_ID"), 0);
+    drmModeAtomicAddProperty(request, plane.id, plane.properties.id_for("CRTC_ID"), 0);
+}
+
+auto mgg::KMSPlanes::overlays_in_use() const -> bool
+{
+    return std::any_of(overlays.begin(), overlays.end(), [](Plane const& plane) { return plane.in_use; });
+}
+
+void mgg::KMSPlanes::add_pending_gamma(drmModeAtomicReq* request) const
+{
+    if (pending_gamma)
+    {
+        drmModeAtomicAddProperty(request, crtc_id_, crtc_properties.id_for("GAMMA_LUT"), pending_gamma->id);
+    }
+}
+
+void mgg::KMSPlanes::committed(std::vector<bool> const& used)
+{
+    for (auto i = 0u; i != overlays.size(); ++i)
+    {
+        overlays[i].in_use = used[i];
+    }
+    pending_gamma = nullptr;
+}
@@ -0,0 +1,168 @@
+/*
+ * Copyright © 2022 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_GRAPHICS_GBM_KMS_PLANES_H_
+#define MIR_GRAPHICS_GBM_KMS_PLANES_H_
+
+#include "mir/geometry/rectangle.h"
+#include "mir/graphics/gamma_curves.h"
+#include "kms-utils/drm_mode_resources.h"
+
+#include <xf86drmMode.h>
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace mir
+{
+namespace graphics
+{
+namespace gbm
+{
+
+/**
+ * The planes a CRTC scans out from, driven through atomic KMS.
+ *
+ * The primary plane shows the composited frame; overlay planes stacked
+ * above it can show client buffers without them being composited. Mode and
+ * gamma changes go out in the same commits as the planes.
+ *
+ * Commits may be submitted from the DRM event thread while the compositor
+ * tests the next frame, so the plane state is guarded internally.
+ */
+class KMSPlanes
+{
+public:
+    /// A framebuffer to show on a plane
+    struct Content
+    {
+        uint32_t fb_id;
+        uint32_t format;                    ///< DRM fourcc of the framebuffer
+        geometry::Rectangle source;         ///< The part of the framebuffer to show, in buffer pixels
+        geometry::Rectangle destination;    ///< Where to show it, in CRTC pixels
+    };
+
+    /**
+     * \throws std::system_error    if the device doesn't support atomic modesetting
+     * \throws std::runtime_error   if the CRTC has no primary plane
+     */
+    KMSPlanes(int drm_fd, uint32_t crtc_id);
+    ~KMSPlanes();
+
+    auto crtc_id() const -> uint32_t;
+
+    /// The number of overlay planes stacked above the primary plane
+    auto overlay_count() const -> size_t;
+
+    /**
+     * Check with a DRM_MODE_ATOMIC_TEST_ONLY commit whether the hardware
+     * accepts \a primary on the primary plane and \a overlays above it.
+     */
+    auto test(Content const& primary, std::vector<Content> const& overlays) const -> bool;
+
+    /**
+     * Show \a primary and \a overlays, disabling any overlay plane left over
+     * from the previous commit.
+     *
+     * \param [in] flags, user_data As for drmModeAtomicCommit()
+     * \return  0 on success, or a negative errno
+     */
+    auto commit(Content const& primary, std::vector<Content> const& overlays, uint32_t flags, void* user_data) -> int;
+
+    /**
+     * Light up the CRTC for connector_id in mode, showing primary with no
+     * overlays, in a single blocking commit that also applies any gamma set
+     * since the last commit.
+     *
+     * \return  0 on success, or a negative errno; -ENOTSUP if the CRTC or
+     *          connector lack the atomic modesetting properties
+     */
+    auto modeset(uint32_t connector_id, drmModeModeInfo const& mode, Content const& primary) -> int;
+
+    /**
+     * Set the gamma ramps the next commit applies.
+     *
+     * \return  False if the CRTC has no GAMMA_LUT of the ramps' size, so
+     *          the legacy gamma ioctl is needed instead
+     */
+    bool set_gamma(GammaCurves const& gamma);
+
+    /// Whether the last commit left any overlay plane showing
+    auto overlays_active() const -> bool;
+
+    /**
+     * Whether the next frame needs an atomic commit rather than a legacy page
+     * flip, to clear overlays or apply gamma
+     */
+    auto needs_atomic_commit() const -> bool;
+
+    /// Disable any overlay planes left showing (e.g. before a legacy modeset)
+    void disable_overlays();
+
+private:
+    struct Plane
+    {
+        uint32_t id;
+        kms::ObjectProperties properties;
+        std::vector<uint32_t> formats;
+        bool in_use;
+    };
+
+    using AtomicRequest = std::unique_ptr<drmModeAtomicReq, void(*)(drmModeAtomicReqPtr)>;
+
+    /// A property blob we created, destroyed once committed (the kernel keeps its own reference)
+    class PropertyBlob
+    {
+    public:
+        PropertyBlob(int drm_fd, uint32_t id);
+        ~PropertyBlob();
+
+        uint32_t const id;
+
+    private:
+        PropertyBlob(PropertyBlob const&) = delete;
+        PropertyBlob& operator=(PropertyBlob const&) = delete;
+
+        int const drm_fd;
+    };
+
+    /// Build a request for the given planes, or nullptr if they can't be mapped onto the hardware
+    auto request_for(Content const& primary, std::vector<Content> const& overlays) const
+        -> std::pair<AtomicRequest, std::vector<bool>>;
+    void add_plane(drmModeAtomicReq* request, Plane const& plane, Content const& content) const;
+    void add_disabled_plane(drmModeAtomicReq* request, Plane const& plane) const;
+
+    /* These are called with the mutex held */
+    auto overlays_in_use() const -> bool;
+    void add_pending_gamma(drmModeAtomicReq* request) const;
+    void committed(std::vector<bool> const& used);
+
+    int const drm_fd;
+    uint32_t const crtc_id_;
+    kms::ObjectProperties const crtc_properties;
+    std::unique_ptr<Plane> primary;
+    std::vector<Plane> overlays;
+
+    std::mutex mutable mutex;
+    std::unique_ptr<PropertyBlob> pending_gamma;
+};
+
+}
+}
+}
+
+#endif /* MIR_GRAPHICS_GBM_KMS_PLANES_H_ */
@@ -19,6 +19,9 @@
 
 #include "mir/graphics/frame.h"
 #include <cstdint>
+#include <functional>
+#include <optional>
+#include <vector>
 
 namespace mir
 {
@@ -27,12 +30,56 @@ namespace graphics
 namespace gbm
 {
 
+/// The outcome of PageFlipper::queue_atomic_flip()
+struct QueuedFlip
+{
+    /// Identifies the flip in PageFlipper::presented_flip(), or nullopt if it wasn't queued
+    std::optional<uint64_t> id;
+    /// Flips queued earlier that were dropped without reaching the screen
+    std::vector<uint64_t> discarded;
+};
+
+/// The last queued flip to reach the screen
+struct PresentedFlip
+{
+    uint64_t id;    ///< 0 if no queued flip has completed
+    Frame frame;
+};
+
 class PageFlipper
 {
 public:
     virtual ~PageFlipper() {}
 
     virtual bool schedule_flip(uint32_t crtc_id, uint32_t fb_id, uint32_t connector_id) = 0;
+    /**
+     * Schedule a flip submitted by an atomic commit rather than a legacy page flip.
+     *
+     * \param [in] commit  Submits the commit, requesting a DRM_MODE_PAGE_FLIP_EVENT
+     *                      with the event data it's passed. Returns 0 on success.
+     */
+    virtual bool schedule_atomic_flip(
+        uint32_t crtc_id,
+        uint32_t connector_id,
+        std::function<int(void* event_data)> const& commit) = 0;
+    /**
+     * Submit an atomic flip as soon as no flip is pending on crtc_id, without
+     * waiting for it.
+     *
+     * If a flip is pending the commit is held back and submitted once that
+     * flip completes, replacing any commit already held back. Resources used
+     * by a queued flip must be kept until presented_flip() moves past its id
+     * or it's reported as discarded.
+     *
+     * \param [in] commit  As for schedule_atomic_flip()
+     * \return  No id if this flipper can't queue flips or the commit failed
+     */
+    virtual auto queue_atomic_flip(
+        uint32_t crtc_id,
+        uint32_t connector_id,
+        std::function<int(void* event_data)> commit) -> QueuedFlip = 0;
+    virtual auto presented_flip(uint32_t crtc_id) -> PresentedFlip = 0;
+    /// Wait until no flip is pending or queued on crtc_id
     virtual Frame wait_for_flip(uint32_t crtc_id) = 0;
 
 protected:
@@ -25,6 +25,7 @@
 #include <boost/throw_exception.hpp>
 #include <system_error>
 #include <xf86drm.h>
+#include <drm_fourcc.h>
 
 namespace mg = mir::graphics;
 namespace mgg = mg::gbm;
@@ -65,6 +66,7 @@ mgg::RealKMSOutput::RealKMSOutput(
       connector{std::move(connector)},
       mode_index{0},
       current_crtc(),
+      planes_unavailable{false},
       saved_crtc(),
       using_saved_crtc{true},
       has_cursor_{false},
@@ -157,6 +159,26 @@ bool mgg::RealKMSOutput::set_crtc(FBHandle const& fb)
         return false;
     }
 
+    if (auto const kms_planes = ensure_planes())
+    {
+        // Mode, primary plane, overlays and any new gamma all change in one commit
+        auto const result = kms_planes->modeset(
+            connector->connector_id,
+            connector->modes[mode_index],
+            plane_contents(fb, {}).first);
+        if (result == 0)
+        {
+            using_saved_crtc = false;
+            return true;
+        }
+
+        if (result != -ENOTSUP)
+        {
+            mir::log_warning("Atomic modeset of output %s failed (%s); falling back to drmModeSetCrtc",
+                             mgk::connector_name(connector).c_str(), strerror(-result));
+        }
+    }
+
     auto ret = drmModeSetCrtc(drm_fd_, current_crtc->crtc_id,
                               fb.get_drm_fb_id(), fb_offset.dx.as_int(), fb_offset.dy.as_int(),
                               &connector->connector_id, 1,
@@ -167,6 +189,10 @@ bool mgg::RealKMSOutput::set_crtc(FBHandle const& fb)
         return false;
     }
 
+    // A legacy modeset only replaces the primary plane
+    if (planes)
+        planes->disable_overlays();
+
     using_saved_crtc = false;
     return true;
 }
@@ -213,12 +239,22 @@ void mgg::RealKMSOutput::clear_crtc()
         }
     }
 
+    // Disabling the CRTC disabled all its planes
+    planes = nullptr;
     current_crtc = nullptr;
 }
 
 bool mgg::RealKMSOutput::schedule_page_flip(FBHandle const& fb)
 {
     std::unique_lock lg(power_mutex);
+
+    // Overlay planes left showing from the previous frame, or new gamma, need an atomic commit
+    if (planes && planes->needs_atomic_commit())
+    {
+        lg.unlock();
+        return schedule_page_flip(fb, {});
+    }
+
     if (power_mode != mir_power_mode_on)
         return true;
     if (!current_crtc)
@@ -233,6 +269,81 @@ bool mgg::RealKMSOutput::schedule_page_flip(FBHandle const& fb)
         connector->connector_id);
 }
 
+bool mgg::RealKMSOutput::test_overlays(FBHandle const& fb, std::vector<OverlayPlane> const& overlays)
+{
+    std::unique_lock lg(power_mutex);
+    if (power_mode != mir_power_mode_on)
+        return false;
+
+    auto const kms_planes = ensure_planes();
+    if (!kms_planes || overlays.size() > kms_planes->overlay_count())
+        return false;
+
+    auto const contents = plane_contents(fb, overlays);
+    return kms_planes->test(contents.first, contents.second);
+}
+
+bool mgg::RealKMSOutput::schedule_page_flip(FBHandle const& fb, std::vector<OverlayPlane> const& overlays)
+{
+    std::unique_lock lg(power_mutex);
+    if (power_mode != mir_power_mode_on)
+        return true;
+
+    auto const kms_planes = ensure_planes();
+    if (!kms_planes)
+    {
+        mir::log_error("Output %s has no overlay planes to schedule page flips on",
+                       mgk::connector_name(connector).c_str());
+        return false;
+    }
+
+    auto const contents = plane_contents(fb, overlays);
+    return page_flipper->schedule_atomic_flip(
+        kms_planes->crtc_id(),
+        connector->connector_id,
+        [&](void* event_data)
+        {
+            return kms_planes->commit(
+                contents.first,
+                contents.second,
+                DRM_MODE_ATOMIC_NONBLOCK | DRM_MODE_PAGE_FLIP_EVENT,
+                event_data);
+        });
+}
+
+auto mgg::RealKMSOutput::queue_page_flip(FBHandle const& fb, std::vector<OverlayPlane> const& overlays) -> QueuedFlip
+{
+    std::unique_lock lg(power_mutex);
+    if (power_mode != mir_power_mode_on)
+        return {};
+
+    if (!ensure_planes())
+        return {};
+
+    // The commit may be submitted from the DRM event thread, so it holds its own copies of what it needs
+    return page_flipper->queue_atomic_flip(
+        planes->crtc_id(),
+        connector->connector_id,
+        [kms_planes = planes, contents = plane_contents(fb, overlays)](void* event_data)
+        {
+            return kms_planes->commit(
+                contents.first,
+                contents.second,
+                DRM_MODE_ATOMIC_NONBLOCK | DRM_MODE_PAGE_FLIP_EVENT,
+                event_data);
+        });
+}
+
+auto mgg::RealKMSOutput::presented_flip() -> uint64_t
+{
+    if (!current_crtc)
+        return 0;
+
+    auto const presented = page_flipper->presented_flip(current_crtc->crtc_id);
+    last_frame_.store(presented.frame);
+    return presented.id;
+}
+
 void mgg::RealKMSOutput::wait_for_page_flip()
 {
     std::unique_lock lg(power_mutex);
@@ -327,6 +438,59 @@ bool mgg::RealKMSOutput::ensure_crtc()
     return (current_crtc != nullptr);
 }
 
+auto mgg::RealKMSOutput::ensure_planes() -> KMSPlanes*
+{
+    if (!current_crtc || planes_unavailable)
+        return nullptr;
+
+    if (planes && planes->crtc_id() != current_crtc->crtc_id)
+    {
+        planes->disable_overlays();
+        planes = nullptr;
+    }
+
+    if (!planes)
+    {
+        try
+        {
+            planes = std::make_shared<KMSPlanes>(drm_fd_, current_crtc->crtc_id);
+        }
+        catch (std::exception const& error)
+        {
+            // Don't retry every frame; the driver isn't going to change its mind
+            mir::log_info("Output %s can't use atomic modesetting: %s",
+                          mgk::connector_name(connector).c_str(), error.what());
+            planes_unavailable = true;
+            return nullptr;
+        }
+    }
+
+    return planes.get();
+}
+
+auto mgg::RealKMSOutput::plane_contents(FBHandle const& fb, std::vector<OverlayPlane> const& overlays) const
+    -> std::pair<KMSPlanes::Content, std::vector<KMSPlanes::Content>>
+{
+    KMSPlanes::Content const primary{
+        fb.get_drm_fb_id(),
+        DRM_FORMAT_XRGB8888,
+        {geom::Point{} + fb_offset, size()},
+        {geom::Point{}, size()}};
+
+    std::vector<KMSPlanes::Content> overlay_contents;
+    overlay_contents.reserve(overlays.size());
+    for (auto const& overlay : overlays)
+    {
+        overlay_contents.push_back(KMSPlanes::Content{
+            overlay.fb->get_drm_fb_id(),
+            overlay.format,
+            overlay.source,
+            overlay.destination});
+    }
+
+    return {primary, std::move(overlay_contents)};
+}
+
 void mgg::RealKMSOutput::restore_saved_crtc()
 {
     if (!using_saved_crtc)
@@ -370,6 +534,10 @@ void mgg::RealKMSOutput::set_gamma(mg::GammaCurves const& gamma)
             std::invalid_argument("set_gamma: mismatch gamma LUT sizes"));
     }
 
+    // Applied by the next commit, along with the mode or frame
+    if (auto const kms_planes = ensure_planes(); kms_planes && kms_planes->set_gamma(gamma))
+        return;
+
     int ret = drmModeCrtcSetGamma(
         drm_fd_,
         current_crtc->crtc_id,
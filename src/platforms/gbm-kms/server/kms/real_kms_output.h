@@ -19,6 +19,7 @@
 
 #include "mir/graphics/atomic_frame.h"
 #include "kms_output.h"
+#include "kms_planes.h"
 #include "kms-utils/drm_mode_resources.h"
 
 #include <memory>
@@ -54,6 +55,11 @@ public:
     bool schedule_page_flip(FBHandle const& fb) override;
     void wait_for_page_flip() override;
 
+    bool test_overlays(FBHandle const& fb, std::vector<OverlayPlane> const& overlays) override;
+    bool schedule_page_flip(FBHandle const& fb, std::vector<OverlayPlane> const& overlays) override;
+    auto queue_page_flip(FBHandle const& fb, std::vector<OverlayPlane> const& overlays) -> QueuedFlip override;
+    auto presented_flip() -> uint64_t override;
+
     bool set_cursor(gbm_bo* buffer) override;
     void move_cursor(geometry::Point destination) override;
     bool clear_cursor() override;
@@ -76,6 +82,10 @@ public:
 private:
     bool ensure_crtc();
     void restore_saved_crtc();
+    /// The planes of the current CRTC, or nullptr if they can't be driven
+    auto ensure_planes() -> KMSPlanes*;
+    auto plane_contents(FBHandle const& fb, std::vector<OverlayPlane> const& overlays) const
+        -> std::pair<KMSPlanes::Content, std::vector<KMSPlanes::Content>>;
 
     int const drm_fd_;
     std::shared_ptr<PageFlipper> const page_flipper;
@@ -99,6 +109,8 @@ private:
     size_t mode_index;
     geometry::Displacement fb_offset;
     kms::DRMModeCrtcUPtr current_crtc;
+    std::shared_ptr<KMSPlanes> planes;  // Shared with flips queued on the DRM event thread
+    bool planes_unavailable;
     drmModeCrtc saved_crtc;
     bool using_saved_crtc;
     bool has_cursor_;
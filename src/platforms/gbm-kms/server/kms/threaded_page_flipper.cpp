@@ -0,0 +1,316 @@
+/*
+ * Copyright © 2022 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "threaded_page_flipper.h"
+#include "mir/graphics/display_report.h"
+#include "mir/log.h"
+
+#include <boost/throw_exception.hpp>
+
+#include <xf86drm.h>
+#include <xf86drmMode.h>
+#include <sys/eventfd.h>
+#include <poll.h>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+
+namespace mg = mir::graphics;
+namespace mgg = mir::graphics::gbm;
+
+namespace
+{
+auto make_wakeup_fd() -> mir::Fd
+{
+    mir::Fd fd{eventfd(0, EFD_CLOEXEC)};
+    if (fd < 0)
+    {
+        BOOST_THROW_EXCEPTION((
+            std::system_error{errno, std::system_category(), "Failed to create page flipper wakeup eventfd"}));
+    }
+    return fd;
+}
+
+auto timestamp_clock(int drm_fd) -> clockid_t
+{
+    uint64_t mono = 0;
+    if (drmGetCap(drm_fd, DRM_CAP_TIMESTAMP_MONOTONIC, &mono) || !mono)
+        return CLOCK_REALTIME;
+    else
+        return CLOCK_MONOTONIC;
+}
+}
+
+mgg::ThreadedPageFlipper::ThreadedPageFlipper(
+    int drm_fd,
+    std::shared_ptr<DisplayReport> const& report) :
+    drm_fd{drm_fd},
+    report{report},
+    clock_id{timestamp_clock(drm_fd)},
+    wakeup{make_wakeup_fd()},
+    event_thread{[this]() { event_loop(); }}
+{
+}
+
+mgg::ThreadedPageFlipper::~ThreadedPageFlipper()
+{
+    {
+        std::lock_guard lock{mutex};
+        shutdown = true;
+    }
+    flips_changed.notify_all();
+    eventfd_write(wakeup, 1);
+
+    if (event_thread.joinable())
+    {
+        event_thread.join();
+    }
+}
+
+bool mgg::ThreadedPageFlipper::schedule_flip(uint32_t crtc_id, uint32_t fb_id, uint32_t connector_id)
+{
+    return schedule(
+        crtc_id,
+        connector_id,
+        [this, crtc_id, fb_id](void* event_data)
+        {
+            return drmModePageFlip(drm_fd, crtc_id, fb_id, DRM_MODE_PAGE_FLIP_EVENT, event_data);
+        });
+}
+
+bool mgg::ThreadedPageFlipper::schedule_atomic_flip(
+    uint32_t crtc_id,
+    uint32_t connector_id,
+    std::function<int(void* event_data)> const& commit)
+{
+    return schedule(crtc_id, connector_id, commit);
+}
+
+auto mgg::ThreadedPageFlipper::queue_atomic_flip(
+    uint32_t crtc_id,
+    uint32_t connector_id,
+    std::function<int(void* event_data)> commit) -> QueuedFlip
+{
+    std::lock_guard lock{mutex};
+
+    auto& crtc = crtc_for(crtc_id);
+    QueuedFlip result;
+    result.discarded.swap(crtc.discarded);
+
+    if (failed)
+    {
+        return result;
+    }
+
+    auto const id = next_id++;
+    if (crtc.pending)
+    {
+        if (crtc.held)
+        {
+            result.discarded.push_back(crtc.held->id);
+        }
+        crtc.held = HeldFlip{connector_id, id, std::move(commit)};
+        result.id = id;
+    }
+    else if (submit(crtc, connector_id, id, commit) == 0)
+    {
+        result.id = id;
+    }
+
+    return result;
+}
+
+auto mgg::ThreadedPageFlipper::presented_flip(uint32_t crtc_id) -> PresentedFlip
+{
+    std::lock_guard lock{mutex};
+
+    auto const& crtc = crtc_for(crtc_id);
+    return {crtc.presented, crtc.last_frame};
+}
+
+mg::Frame mgg::ThreadedPageFlipper::wait_for_flip(uint32_t crtc_id)
+{
+    std::unique_lock lock{mutex};
+
+    auto const& crtc = crtc_for(crtc_id);
+    flips_changed.wait(lock, [this, &crtc]() { return failed || (!crtc.pending && !crtc.held); });
+    return crtc.last_frame;
+}
+
+void mgg::ThreadedPageFlipper::event_loop() noexcept
+{
+    drmEventContext evctx;
+    memset(&evctx, 0, sizeof evctx);
+    evctx.version = 2;  // We only need the old v2 page_flip_handler
+    evctx.page_flip_handler = &page_flip_handler;
+
+    std::unique_lock lock{mutex};
+    while (!shutdown)
+    {
+        // Flip events only arrive while flips are pending, so only listen for them then
+        if (failed || !any_pending())
+        {
+            flips_changed.wait(lock);
+            continue;
+        }
+
+        lock.unlock();
+        pollfd fds[] = {{drm_fd, POLLIN, 0}, {wakeup, POLLIN, 0}};
+        auto const result = ::poll(fds, 2, -1);
+        auto const error = errno;
+        lock.lock();
+
+        if ((result < 0 && error != EINTR) || (result > 0 && (fds[0].revents & (POLLERR | POLLHUP | POLLNVAL))))
+        {
+            mir::log_error(
+                "Error waiting for page flip events; abandoning pending flips: %s",
+                result < 0 ? strerror(error) : "DRM fd error");
+            failed = true;
+            abandon_flips();
+        }
+        else if (result > 0 && (fds[0].revents & POLLIN))
+        {
+            // page_flip_handler() is called from here, with the lock held
+            drmHandleEvent(drm_fd, &evctx);
+        }
+        // The wakeup eventfd is only written to on shutdown, which the loop checks for
+    }
+}
+
+void mgg::ThreadedPageFlipper::page_flip_handler(
+    int /*drm_fd*/,
+    unsigned int seq,
+    unsigned int sec,
+    unsigned int usec,
+    void* data)
+{
+    auto const event_data = static_cast<EventData*>(data);
+    std::chrono::nanoseconds const ns{sec*1000000000LL + usec*1000LL};
+    event_data->flipper->notify_page_flip(event_data->crtc_id, seq, ns);
+}
+
+auto mgg::ThreadedPageFlipper::crtc_for(uint32_t crtc_id) -> Crtc&
+{
+    auto const [crtc, inserted] = crtcs.try_emplace(crtc_id);
+    if (inserted)
+    {
+        crtc->second.event_data = EventData{crtc_id, this};
+    }
+    return crtc->second;
+}
+
+bool mgg::ThreadedPageFlipper::any_pending() const
+{
+    for (auto const& crtc : crtcs)
+    {
+        if (crtc.second.pending)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+auto mgg::ThreadedPageFlipper::submit(
+    Crtc& crtc,
+    uint32_t connector_id,
+    uint64_t id,
+    std::function<int(void*)> const& commit) -> int
+{
+    crtc.pending = id;
+    crtc.pending_connector_id = connector_id;
+
+    auto const result = commit(&crtc.event_data);
+    if (result)
+    {
+        crtc.pending.reset();
+    }
+    else
+    {
+        // Wake the event thread to listen for the flip event
+        flips_changed.notify_all();
+    }
+    return result;
+}
+
+bool mgg::ThreadedPageFlipper::schedule(
+    uint32_t crtc_id,
+    uint32_t connector_id,
+    std::function<int(void*)> const& commit)
+{
+    std::lock_guard lock{mutex};
+
+    auto& crtc = crtc_for(crtc_id);
+    if (crtc.pending || crtc.held)
+        BOOST_THROW_EXCEPTION(std::logic_error("Page flip for crtc_id is already scheduled"));
+
+    if (failed)
+    {
+        return false;
+    }
+
+    return submit(crtc, connector_id, 0, commit) == 0;
+}
+
+void mgg::ThreadedPageFlipper::notify_page_flip(uint32_t crtc_id, int64_t msc, std::chrono::nanoseconds ust)
+{
+    auto const found = crtcs.find(crtc_id);
+    if (found == crtcs.end() || !found->second.pending)
+    {
+        return;
+    }
+
+    auto& crtc = found->second;
+    crtc.last_frame.msc = msc;
+    crtc.last_frame.ust = {clock_id, ust};
+    report->report_vsync(crtc.pending_connector_id, crtc.last_frame);
+
+    if (auto const id = crtc.pending.value())
+    {
+        crtc.presented = id;
+    }
+    crtc.pending.reset();
+
+    if (crtc.held)
+    {
+        auto const next = std::move(crtc.held.value());
+        crtc.held.reset();
+
+        if (auto const result = submit(crtc, next.connector_id, next.id, next.commit))
+        {
+            mir::log_warning("Failed to submit queued page flip on CRTC %u: %s", crtc_id, strerror(-result));
+            crtc.discarded.push_back(next.id);
+        }
+    }
+
+    flips_changed.notify_all();
+}
+
+void mgg::ThreadedPageFlipper::abandon_flips()
+{
+    for (auto& [id, crtc] : crtcs)
+    {
+        if (crtc.held)
+        {
+            crtc.discarded.push_back(crtc.held->id);
+            crtc.held.reset();
+        }
+        crtc.pending.reset();
+    }
+
+    flips_changed.notify_all();
+}
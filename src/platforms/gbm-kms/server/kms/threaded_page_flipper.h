@@ -0,0 +1,123 @@
+/*
+ * Copyright © 2022 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_GRAPHICS_GBM_THREADED_PAGE_FLIPPER_H_
+#define MIR_GRAPHICS_GBM_THREADED_PAGE_FLIPPER_H_
+
+#include "page_flipper.h"
+
+#include "mir/fd.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <unordered_map>
+
+namespace mir
+{
+namespace graphics
+{
+
+class DisplayReport;
+
+namespace gbm
+{
+
+/**
+ * A PageFlipper handling DRM events on a dedicated thread.
+ *
+ * Nobody has to wait for a flip for its event to be handled, so flips can
+ * be queued: the event thread submits the next queued commit as soon as the
+ * previous flip on the CRTC completes.
+ */
+class ThreadedPageFlipper : public PageFlipper
+{
+public:
+    ThreadedPageFlipper(int drm_fd, std::shared_ptr<DisplayReport> const& report);
+    ~ThreadedPageFlipper() override;
+
+    bool schedule_flip(uint32_t crtc_id, uint32_t fb_id, uint32_t connector_id) override;
+    bool schedule_atomic_flip(
+        uint32_t crtc_id,
+        uint32_t connector_id,
+        std::function<int(void* event_data)> const& commit) override;
+    auto queue_atomic_flip(
+        uint32_t crtc_id,
+        uint32_t connector_id,
+        std::function<int(void* event_data)> commit) -> QueuedFlip override;
+    auto presented_flip(uint32_t crtc_id) -> PresentedFlip override;
+    Frame wait_for_flip(uint32_t crtc_id) override;
+
+private:
+    struct EventData
+    {
+        uint32_t crtc_id;
+        ThreadedPageFlipper* flipper;
+    };
+
+    struct HeldFlip
+    {
+        uint32_t connector_id;
+        uint64_t id;
+        std::function<int(void* event_data)> commit;
+    };
+
+    struct Crtc
+    {
+        EventData event_data;
+        std::optional<uint64_t> pending;    ///< The id of the flip submitted (0 if it wasn't queued)
+        uint32_t pending_connector_id{0};
+        std::optional<HeldFlip> held;       ///< The flip to submit when the pending one completes
+        std::vector<uint64_t> discarded;
+        uint64_t presented{0};
+        Frame last_frame;
+    };
+
+    void event_loop() noexcept;
+    static void page_flip_handler(int drm_fd, unsigned int seq, unsigned int sec, unsigned int usec, void* data);
+
+    /* These are called with the mutex held */
+    auto crtc_for(uint32_t crtc_id) -> Crtc&;
+    bool any_pending() const;
+    auto submit(Crtc& crtc, uint32_t connector_id, uint64_t id, std::function<int(void*)> const& commit) -> int;
+    bool schedule(uint32_t crtc_id, uint32_t connector_id, std::function<int(void*)> const& commit);
+    void notify_page_flip(uint32_t crtc_id, int64_t msc, std::chrono::nanoseconds ust);
+    void abandon_flips();
+
+    int const drm_fd;
+    std::shared_ptr<DisplayReport> const report;
+    clockid_t const clock_id;
+    mir::Fd const wakeup;
+
+    std::mutex mutex;
+    std::condition_variable flips_changed;
+    std::unordered_map<uint32_t, Crtc> crtcs;   // Node-based, so EventData addresses are stable
+    uint64_t next_id{1};
+    bool failed{false};
+    bool shutdown{false};
+
+    std::thread event_thread;
+};
+
+}
+}
+}
+
+#endif /* MIR_GRAPHICS_GBM_THREADED_PAGE_FLIPPER_H_ */
@@ -0,0 +1,223 @@
+/*
+ * Copyright © 2022 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "display.h"
+#include "display_buffer.h"
+#include "display_configuration.h"
+#include "platform.h"
+
+#include "mir/graphics/display_report.h"
+#include "mir/graphics/display_configuration_policy.h"
+#include "mir/graphics/atomic_frame.h"
+#include "mir/graphics/gl_config.h"
+#include "mir/renderer/gl/context.h"
+
+#include <boost/throw_exception.hpp>
+
+#include <unistd.h>
+
+#define MIR_LOG_COMPONENT "virtual-display"
+#include "mir/log.h"
+
+namespace mg = mir::graphics;
+namespace mgv = mg::virt;
+namespace geom = mir::geometry;
+
+namespace
+{
+// Virtual outputs have no physical size; pretend to be a 96 DPI monitor
+float const mm_per_pixel = 25.4f / 96.0f;
+
+class VirtualGLContext : public mir::renderer::gl::Context
+{
+public:
+    VirtualGLContext(mg::GLConfig const& gl_config, mgv::helpers::EGLHelper const& shared)
+        : egl{gl_config, shared}
+    {
+    }
+
+    void make_current() const override
+    {
+        egl.make_current();
+    }
+
+    void release_current() const override
+    {
+        egl.release_current();
+    }
+
+private:
+    mgv::helpers::EGLHelper const egl;
+};
+}
+
+mgv::Display::Display(
+    std::vector<VirtualOutputConfig> const& requested_outputs,
+    std::shared_ptr<DisplayConfigurationPolicy> const& initial_conf_policy,
+    std::shared_ptr<GLConfig> const& gl_config,
+    std::shared_ptr<DisplayReport> const& report)
+    : shared_egl{*gl_config},
+      gl_config{gl_config},
+      report{report}
+{
+    geom::Point top_left{0, 0};
+
+    for (auto const& requested : requested_outputs)
+    {
+        auto configuration = DisplayConfiguration::build_output(
+            mir_pixel_format_argb_8888,
+            requested.size,
+            top_left,
+            geom::Size{
+                requested.size.width * mm_per_pixel,
+                requested.size.height * mm_per_pixel},
+            requested.refresh_rate,
+            requested.scale,
+            mir_orientation_normal);
+        auto last_frame = std::make_shared<AtomicFrame>();
+        auto display_buffer = std::make_unique<DisplayBuffer>(
+            configuration->id,
+            configuration->extents(),
+            requested.size,
+            requested.refresh_rate,
+            shared_egl,
+            last_frame,
+            report,
+            *gl_config);
+
+        mir::log_info(
+            "Virtual output %d: %dx%d@%.2fHz, framebuffer at /proc/%d/fd/%d (stride %d)",
+            configuration->id.as_value(),
+            requested.size.width.as_int(),
+            requested.size.height.as_int(),
+            requested.refresh_rate,
+            getpid(),
+            display_buffer->framebuffer_fd(),
+            display_buffer->framebuffer_stride().as_int());
+
+        top_left.x += as_delta(configuration->extents().size.width);
+        outputs.push_back(OutputInfo{std::move(configuration), std::move(last_frame), std::move(display_buffer)});
+    }
+
+    auto const display_config = configuration();
+    initial_conf_policy->apply_to(*display_config);
+    configure(*display_config);
+    report->report_successful_display_construction();
+}
+
+mgv::Display::~Display() noexcept
+{
+}
+
+void mgv::Display::for_each_display_sync_group(std::function<void(mg::DisplaySyncGroup&)> const& f)
+{
+    std::lock_guard lock{mutex};
+    for (auto const& output : outputs)
+    {
+        if (output.config->used && output.config->power_mode == mir_power_mode_on)
+        {
+            f(*output.display_buffer);
+        }
+    }
+}
+
+std::unique_ptr<mg::DisplayConfiguration> mgv::Display::configuration() const
+{
+    std::lock_guard lock{mutex};
+    std::vector<DisplayConfigurationOutput> output_configurations;
+    for (auto const& output : outputs)
+    {
+        output_configurations.push_back(*output.config);
+    }
+    return std::make_unique<mgv::DisplayConfiguration>(output_configurations);
+}
+
+void mgv::Display::configure(mg::DisplayConfiguration const& new_configuration)
+{
+    std::lock_guard lock{mutex};
+
+    if (!new_configuration.valid())
+    {
+        BOOST_THROW_EXCEPTION(
+            std::logic_error("Invalid or inconsistent display configuration"));
+    }
+
+    new_configuration.for_each_output([&](DisplayConfigurationOutput const& conf_output)
+    {
+        for (auto& output : outputs)
+        {
+            if (output.config->id == conf_output.id)
+            {
+                *output.config = conf_output;
+                output.display_buffer->set_view_area(output.config->extents());
+                output.display_buffer->set_transformation(output.config->transformation());
+                return;
+            }
+        }
+
+        mir::log_error("Could not find info for output %d", conf_output.id.as_value());
+    });
+}
+
+bool mgv::Display::apply_if_configuration_preserves_display_buffers(
+    mg::DisplayConfiguration const& /*conf*/)
+{
+    return false;
+}
+
+void mgv::Display::register_configuration_change_handler(
+    EventHandlerRegister& /*handlers*/,
+    DisplayConfigurationChangeHandler const& /*conf_change_handler*/)
+{
+}
+
+void mgv::Display::register_pause_resume_handlers(
+    EventHandlerRegister& /*handlers*/,
+    DisplayPauseHandler const& /*pause_handler*/,
+    DisplayResumeHandler const& /*resume_handler*/)
+{
+}
+
+void mgv::Display::pause()
+{
+}
+
+void mgv::Display::resume()
+{
+}
+
+auto mgv::Display::create_hardware_cursor() -> std::shared_ptr<Cursor>
+{
+    return nullptr;
+}
+
+std::unique_ptr<mir::renderer::gl::Context> mgv::Display::create_gl_context() const
+{
+    return std::make_unique<VirtualGLContext>(*gl_config, shared_egl);
+}
+
+mg::Frame mgv::Display::last_frame_on(unsigned output_id) const
+{
+    std::lock_guard lock{mutex};
+    for (auto const& output : outputs)
+    {
+        if (output.config->id.as_value() == static_cast<int>(output_id))
+        {
+            return output.last_frame->load();
+        }
+    }
+    return {};
+}
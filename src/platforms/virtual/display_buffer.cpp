@@ -0,0 +1,233 @@
+/*
+ * Copyright © 2022 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "display_buffer.h"
+#include "mir/graphics/atomic_frame.h"
+#include "mir/graphics/display_report.h"
+#include "mir/graphics/egl_error.h"
+#include "mir/fatal.h"
+
+#include <boost/throw_exception.hpp>
+#include <GLES2/gl2ext.h>
+
+#include <sys/timerfd.h>
+#include <unistd.h>
+#include <cmath>
+#include <system_error>
+
+namespace mg = mir::graphics;
+namespace mgv = mg::virt;
+namespace geom = mir::geometry;
+
+namespace
+{
+auto period_for(double refresh_rate) -> std::chrono::nanoseconds
+{
+    return std::chrono::nanoseconds{static_cast<int64_t>(std::llround(1e9 / refresh_rate))};
+}
+
+auto to_timespec(std::chrono::nanoseconds ns) -> timespec
+{
+    return timespec{
+        static_cast<time_t>(ns.count() / 1000000000),
+        static_cast<long>(ns.count() % 1000000000)};
+}
+
+auto create_vblank_timer(mg::Frame::Timestamp first_vblank, std::chrono::nanoseconds period) -> mir::Fd
+{
+    mir::Fd timer{timerfd_create(first_vblank.clock_id, TFD_CLOEXEC)};
+    if (timer < 0)
+    {
+        BOOST_THROW_EXCEPTION((std::system_error{errno, std::system_category(), "Failed to create vblank timer"}));
+    }
+
+    itimerspec const spec{to_timespec(period), to_timespec(first_vblank.nanoseconds)};
+    if (timerfd_settime(timer, TFD_TIMER_ABSTIME, &spec, nullptr) < 0)
+    {
+        BOOST_THROW_EXCEPTION((std::system_error{errno, std::system_category(), "Failed to arm vblank timer"}));
+    }
+    return timer;
+}
+}
+
+mgv::DisplayBuffer::DisplayBuffer(
+    DisplayConfigurationOutputId output_id,
+    geom::Rectangle const& view_area,
+    geom::Size const& pixel_size,
+    double refresh_rate,
+    helpers::EGLHelper const& shared_egl,
+    std::shared_ptr<AtomicFrame> const& last_frame,
+    std::shared_ptr<DisplayReport> const& report,
+    GLConfig const& gl_config)
+    : report{report},
+      output_id{output_id},
+      area{view_area},
+      pixel_size{pixel_size},
+      stride{pixel_size.width.as_int() * 4},
+      transform(1),
+      egl{gl_config, shared_egl},
+      last_frame{last_frame},
+      framebuffer{static_cast<size_t>(stride.as_int()) * pixel_size.height.as_int()},
+      frame_period{period_for(refresh_rate)},
+      first_vblank{Frame::Timestamp::now(CLOCK_MONOTONIC) + frame_period},
+      vblank_timer{create_vblank_timer(first_vblank, frame_period)}
+{
+    egl.report_egl_configuration(
+        [&report] (EGLDisplay disp, EGLConfig cfg)
+        {
+            report->report_egl_configuration(disp, cfg);
+        });
+}
+
+mgv::DisplayBuffer::~DisplayBuffer()
+{
+    if (fbo_created && egl.make_current())
+    {
+        glDeleteFramebuffers(1, &fbo);
+        glDeleteRenderbuffers(1, &colour_buffer);
+        egl.release_current();
+    }
+}
+
+geom::Rectangle mgv::DisplayBuffer::view_area() const
+{
+    return area;
+}
+
+auto mgv::DisplayBuffer::size() const -> geom::Size
+{
+    return pixel_size;
+}
+
+void mgv::DisplayBuffer::make_current()
+{
+    if (!egl.make_current())
+        fatal_error("Failed to make EGL context current");
+}
+
+void mgv::DisplayBuffer::release_current()
+{
+    egl.release_current();
+}
+
+void mgv::DisplayBuffer::bind()
+{
+    if (!fbo_created)
+    {
+        glGenRenderbuffers(1, &colour_buffer);
+        glGenFramebuffers(1, &fbo);
+
+        glBindRenderbuffer(GL_RENDERBUFFER, colour_buffer);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8_OES, pixel_size.width.as_int(), pixel_size.height.as_int());
+
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colour_buffer);
+
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        {
+            BOOST_THROW_EXCEPTION((mg::gl_error("Failed to create virtual output framebuffer")));
+        }
+        fbo_created = true;
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+
+    // There is no EGL surface for gl::Renderer to take the viewport from, so we set it ourselves
+    glViewport(0, 0, pixel_size.width.as_int(), pixel_size.height.as_int());
+}
+
+bool mgv::DisplayBuffer::overlay(RenderableList const& /*renderlist*/)
+{
+    return false;
+}
+
+void mgv::DisplayBuffer::swap_buffers()
+{
+    std::lock_guard lock{framebuffer_mutex};
+
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glReadPixels(
+        0, 0,
+        pixel_size.width.as_int(), pixel_size.height.as_int(),
+        GL_BGRA_EXT, GL_UNSIGNED_BYTE, framebuffer.base_ptr());
+}
+
+glm::mat2 mgv::DisplayBuffer::transformation() const
+{
+    return transform;
+}
+
+void mgv::DisplayBuffer::set_view_area(geom::Rectangle const& a)
+{
+    area = a;
+}
+
+void mgv::DisplayBuffer::set_transformation(glm::mat2 const& t)
+{
+    transform = t;
+}
+
+mg::NativeDisplayBuffer* mgv::DisplayBuffer::native_display_buffer()
+{
+    return this;
+}
+
+void mgv::DisplayBuffer::for_each_display_buffer(
+    std::function<void(graphics::DisplayBuffer&)> const& f)
+{
+    f(*this);
+}
+
+void mgv::DisplayBuffer::post()
+{
+    uint64_t expirations{0};
+    if (read(vblank_timer, &expirations, sizeof expirations) != sizeof expirations)
+    {
+        if (errno == EINTR)
+            return;
+        BOOST_THROW_EXCEPTION((std::system_error{errno, std::system_category(), "Failed to wait for virtual vblank"}));
+    }
+
+    // Derive the timestamp from the tick count rather than the wakeup time, so frame times are
+    // exact multiples of the period regardless of scheduling jitter.
+    auto frame = last_frame->load();
+    frame.msc += expirations;
+    frame.ust = first_vblank + frame_period * (frame.msc - 1);
+    last_frame->store(frame);
+
+    report->report_vsync(output_id.as_value(), frame);
+}
+
+std::chrono::milliseconds mgv::DisplayBuffer::recommended_sleep() const
+{
+    return std::chrono::milliseconds::zero();
+}
+
+auto mgv::DisplayBuffer::framebuffer_fd() const -> int
+{
+    return framebuffer.fd();
+}
+
+auto mgv::DisplayBuffer::framebuffer_stride() const -> geom::Stride
+{
+    return stride;
+}
+
+void mgv::DisplayBuffer::with_framebuffer(std::function<void(void const* pixels)> const& f) const
+{
+    std::lock_guard lock{framebuffer_mutex};
+    f(framebuffer.base_ptr());
+}
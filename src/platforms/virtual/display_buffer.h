@@ -0,0 +1,119 @@
+/*
+ * Copyright © 2022 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_GRAPHICS_VIRTUAL_DISPLAY_BUFFER_H_
+#define MIR_GRAPHICS_VIRTUAL_DISPLAY_BUFFER_H_
+
+#include "mir/graphics/display_buffer.h"
+#include "mir/graphics/display_configuration.h"
+#include "mir/graphics/display.h"
+#include "mir/graphics/frame.h"
+#include "mir/renderer/gl/render_target.h"
+#include "mir/anonymous_shm_file.h"
+#include "mir/fd.h"
+#include "egl_helper.h"
+
+#include <GLES2/gl2.h>
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+
+namespace mir
+{
+namespace graphics
+{
+class AtomicFrame;
+class GLConfig;
+class DisplayReport;
+
+namespace virt
+{
+/**
+ * A virtual output.
+ *
+ * Rendering goes to an offscreen FBO which is read back into a memfd-backed,
+ * CPU-mappable framebuffer on every swap_buffers(). Vblank is simulated by a
+ * timerfd ticking at the output's refresh rate; post() blocks until the next
+ * tick, as a page flip on real hardware would.
+ */
+class DisplayBuffer : public graphics::DisplayBuffer,
+                      public graphics::DisplaySyncGroup,
+                      public graphics::NativeDisplayBuffer,
+                      public renderer::gl::RenderTarget
+{
+public:
+    DisplayBuffer(
+        DisplayConfigurationOutputId output_id,
+        geometry::Rectangle const& view_area,
+        geometry::Size const& pixel_size,
+        double refresh_rate,
+        helpers::EGLHelper const& shared_egl,
+        std::shared_ptr<AtomicFrame> const& last_frame,
+        std::shared_ptr<DisplayReport> const& report,
+        GLConfig const& gl_config);
+    ~DisplayBuffer();
+
+    geometry::Rectangle view_area() const override;
+    auto size() const -> geometry::Size override;
+    void make_current() override;
+    void release_current() override;
+    void swap_buffers() override;
+    void bind() override;
+    bool overlay(RenderableList const& renderlist) override;
+    void set_view_area(geometry::Rectangle const& a);
+    void set_transformation(glm::mat2 const& t);
+
+    void for_each_display_buffer(
+        std::function<void(graphics::DisplayBuffer&)> const& f) override;
+    void post() override;
+    std::chrono::milliseconds recommended_sleep() const override;
+
+    glm::mat2 transformation() const override;
+    NativeDisplayBuffer* native_display_buffer() override;
+
+    /// The memfd holding the most recently presented frame, in ARGB8888
+    auto framebuffer_fd() const -> int;
+    auto framebuffer_stride() const -> geometry::Stride;
+    /// Runs f with the contents of the most recently presented frame
+    void with_framebuffer(std::function<void(void const* pixels)> const& f) const;
+
+private:
+    std::shared_ptr<DisplayReport> const report;
+    DisplayConfigurationOutputId const output_id;
+    geometry::Rectangle area;
+    geometry::Size const pixel_size;
+    geometry::Stride const stride;
+    glm::mat2 transform;
+    helpers::EGLHelper const egl;
+    std::shared_ptr<AtomicFrame> const last_frame;
+
+    std::mutex mutable framebuffer_mutex;
+    AnonymousShmFile const framebuffer;
+
+    std::chrono::nanoseconds const frame_period;
+    Frame::Timestamp const first_vblank;
+    Fd const vblank_timer;
+
+    bool fbo_created{false};
+    GLuint colour_buffer{0};
+    GLuint fbo{0};
+};
+}
+}
+}
+
+#endif /* MIR_GRAPHICS_VIRTUAL_DISPLAY_BUFFER_H_ */
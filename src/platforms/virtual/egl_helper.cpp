@@ -0,0 +1,155 @@
+/*
+ * Copyright © 2022 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "egl_helper.h"
+
+#include "mir/graphics/gl_config.h"
+#include "mir/graphics/egl_error.h"
+#include "mir/graphics/egl_extensions.h"
+
+#include <boost/throw_exception.hpp>
+
+#include <cstring>
+
+#ifndef EGL_MESA_platform_surfaceless
+#define EGL_MESA_platform_surfaceless 1
+#define EGL_PLATFORM_SURFACELESS_MESA 0x31DD
+#endif
+
+namespace mg = mir::graphics;
+namespace mgv = mg::virt;
+namespace mgvh = mgv::helpers;
+
+namespace
+{
+auto surfaceless_display() -> EGLDisplay
+{
+    auto const* client_extensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    if (!client_extensions || !strstr(client_extensions, "EGL_MESA_platform_surfaceless"))
+    {
+        BOOST_THROW_EXCEPTION((std::runtime_error{"EGL implementation doesn't support EGL_MESA_platform_surfaceless"}));
+    }
+
+    mg::EGLExtensions::PlatformBaseEXT const platform_base;
+    auto const egl_display = platform_base.eglGetPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+    if (egl_display == EGL_NO_DISPLAY)
+        BOOST_THROW_EXCEPTION(mg::egl_error("Failed to get surfaceless EGL display"));
+
+    EGLint major, minor;
+    if (eglInitialize(egl_display, &major, &minor) == EGL_FALSE)
+        BOOST_THROW_EXCEPTION(mg::egl_error("Failed to initialize EGL display"));
+
+    if ((major < 1) || (major == 1 && minor < 4))
+    {
+        BOOST_THROW_EXCEPTION(std::runtime_error("Incompatible EGL version"));
+    }
+
+    auto const* display_extensions = eglQueryString(egl_display, EGL_EXTENSIONS);
+    if (!display_extensions || !strstr(display_extensions, "EGL_KHR_surfaceless_context"))
+    {
+        BOOST_THROW_EXCEPTION((std::runtime_error{"EGL display doesn't support EGL_KHR_surfaceless_context"}));
+    }
+
+    return egl_display;
+}
+}
+
+mgvh::EGLHelper::EGLHelper(GLConfig const& gl_config)
+    : egl_display{surfaceless_display()},
+      egl_config{0},
+      egl_context{EGL_NO_CONTEXT},
+      should_terminate_egl{true}
+{
+    choose_config(gl_config);
+    create_context(EGL_NO_CONTEXT);
+}
+
+mgvh::EGLHelper::EGLHelper(GLConfig const& gl_config, EGLHelper const& shared)
+    : egl_display{shared.egl_display},
+      egl_config{0},
+      egl_context{EGL_NO_CONTEXT},
+      should_terminate_egl{false}
+{
+    choose_config(gl_config);
+    create_context(shared.egl_context);
+}
+
+mgvh::EGLHelper::~EGLHelper() noexcept
+{
+    if (egl_context != EGL_NO_CONTEXT)
+    {
+        eglBindAPI(EGL_OPENGL_ES_API);
+        if (eglGetCurrentContext() == egl_context)
+            eglMakeCurrent(egl_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        eglDestroyContext(egl_display, egl_context);
+    }
+    if (should_terminate_egl)
+        eglTerminate(egl_display);
+}
+
+bool mgvh::EGLHelper::make_current() const
+{
+    auto ret = eglMakeCurrent(egl_display, EGL_NO_SURFACE, EGL_NO_SURFACE, egl_context);
+    eglBindAPI(EGL_OPENGL_ES_API);
+    return (ret == EGL_TRUE);
+}
+
+bool mgvh::EGLHelper::release_current() const
+{
+    auto ret = eglMakeCurrent(egl_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    return (ret == EGL_TRUE);
+}
+
+void mgvh::EGLHelper::choose_config(GLConfig const& gl_config)
+{
+    EGLint const config_attr[] = {
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+        EGL_RED_SIZE, 8,
+        EGL_GREEN_SIZE, 8,
+        EGL_BLUE_SIZE, 8,
+        EGL_ALPHA_SIZE, 8,
+        EGL_DEPTH_SIZE, gl_config.depth_buffer_bits(),
+        EGL_STENCIL_SIZE, gl_config.stencil_buffer_bits(),
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_ES2_BIT,
+        EGL_NONE
+    };
+
+    EGLint num_egl_configs;
+    if (eglChooseConfig(egl_display, config_attr, &egl_config, 1, &num_egl_configs) == EGL_FALSE ||
+        num_egl_configs != 1)
+    {
+        BOOST_THROW_EXCEPTION(mg::egl_error("Failed to choose ARGB EGL config"));
+    }
+}
+
+void mgvh::EGLHelper::create_context(EGLContext shared_context)
+{
+    eglBindAPI(EGL_OPENGL_ES_API);
+
+    static const EGLint context_attr[] = {
+        EGL_CONTEXT_CLIENT_VERSION, 2,
+        EGL_NONE
+    };
+
+    egl_context = eglCreateContext(egl_display, egl_config, shared_context, context_attr);
+    if (egl_context == EGL_NO_CONTEXT)
+        BOOST_THROW_EXCEPTION(mg::egl_error("Failed to create EGL context"));
+}
+
+void mgvh::EGLHelper::report_egl_configuration(std::function<void(EGLDisplay, EGLConfig)> f) const
+{
+    f(egl_display, egl_config);
+}
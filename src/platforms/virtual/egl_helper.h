@@ -0,0 +1,74 @@
+/*
+ * Copyright © 2022 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_GRAPHICS_VIRTUAL_EGL_HELPER_H_
+#define MIR_GRAPHICS_VIRTUAL_EGL_HELPER_H_
+
+#include <functional>
+
+#include <EGL/egl.h>
+
+namespace mir
+{
+namespace graphics
+{
+class GLConfig;
+
+namespace virt
+{
+namespace helpers
+{
+/**
+ * EGL display and context with no window system behind them.
+ *
+ * The display comes from EGL_MESA_platform_surfaceless, so no GPU, DRM node or
+ * window system is needed; Mesa falls back to a software rasteriser when no
+ * render node is available. All rendering goes to FBOs.
+ */
+class EGLHelper
+{
+public:
+    EGLHelper(const EGLHelper&) = delete;
+    EGLHelper& operator=(const EGLHelper&) = delete;
+
+    explicit EGLHelper(GLConfig const& gl_config);
+    EGLHelper(GLConfig const& gl_config, EGLHelper const& shared);
+    ~EGLHelper() noexcept;
+
+    bool make_current() const;
+    bool release_current() const;
+
+    EGLContext context() const { return egl_context; }
+    EGLDisplay display() const { return egl_display; }
+    EGLConfig config() const { return egl_config; }
+
+    void report_egl_configuration(std::function<void(EGLDisplay, EGLConfig)>) const;
+
+private:
+    void choose_config(GLConfig const& gl_config);
+    void create_context(EGLContext shared_context);
+
+    EGLDisplay egl_display;
+    EGLConfig egl_config;
+    EGLContext egl_context;
+    bool const should_terminate_egl;
+};
+}
+}
+}
+}
+
+#endif /* MIR_GRAPHICS_VIRTUAL_EGL_HELPER_H_ */
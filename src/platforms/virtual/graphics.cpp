@@ -0,0 +1,136 @@
+/*
+ * Copyright © 2022 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/graphics/display_report.h"
+#include "mir/graphics/platform.h"
+#include "mir/graphics/egl_logger.h"
+#include "mir/options/option.h"
+#include "mir/options/program_option.h"
+#include "mir/options/configuration.h"
+#include "mir/module_deleter.h"
+#include "mir/assert_module_entry_point.h"
+#include "mir/libname.h"
+#include "platform.h"
+
+#include <boost/throw_exception.hpp>
+
+namespace mo = mir::options;
+namespace mg = mir::graphics;
+namespace mgv = mg::virt;
+
+namespace
+{
+char const* virtual_outputs_option_name{"virtual-output"};
+char const* virtual_refresh_rate_option_name{"virtual-refresh-rate"};
+
+auto outputs_requested(mo::ProgramOption const& options) -> bool
+{
+    return options.is_set(virtual_outputs_option_name);
+}
+}
+
+mir::UniqueModulePtr<mg::DisplayPlatform> create_display_platform(
+    mg::SupportedDevice const&,
+    std::shared_ptr<mo::Option> const& options,
+    std::shared_ptr<mir::EmergencyCleanupRegistry> const&,
+    std::shared_ptr<mir::ConsoleServices> const&,
+    std::shared_ptr<mg::DisplayReport> const& report)
+{
+    mir::assert_entry_point_signature<mg::CreateDisplayPlatform>(&create_display_platform);
+
+    if (options->is_set(mir::options::debug_opt))
+    {
+        mg::initialise_egl_logger();
+    }
+
+    auto outputs = mgv::Platform::parse_output_configs(
+        options->get<std::string>(virtual_outputs_option_name),
+        options->get<double>(virtual_refresh_rate_option_name));
+
+    return mir::make_module_ptr<mgv::Platform>(std::move(outputs), report);
+}
+
+auto create_rendering_platform(
+    mg::SupportedDevice const&,
+    std::vector<std::shared_ptr<mg::DisplayPlatform>> const&,
+    mo::Option const&,
+    mir::EmergencyCleanupRegistry&) -> mir::UniqueModulePtr<mg::RenderingPlatform>
+{
+    mir::assert_entry_point_signature<mg::CreateRenderPlatform>(&create_rendering_platform);
+
+    return mir::make_module_ptr<mgv::RenderingPlatform>();
+}
+
+void add_graphics_platform_options(boost::program_options::options_description& config)
+{
+    mir::assert_entry_point_signature<mg::AddPlatformOptions>(&add_graphics_platform_options);
+    config.add_options()
+        (virtual_outputs_option_name,
+         boost::program_options::value<std::string>(),
+         "[mir-on-virtual specific] Colon separated list of WIDTHxHEIGHT sizes for virtual outputs."
+         " @HZ may be appended to set a per-output refresh rate and ^SCALE to set a scale."
+         " The virtual platform is only used when this is set");
+
+    config.add_options()
+        (virtual_refresh_rate_option_name,
+         boost::program_options::value<double>()->default_value(60.0),
+         "[mir-on-virtual specific] Default refresh rate (in Hz) of the simulated vblank");
+}
+
+auto probe_display_platform(
+    std::shared_ptr<mir::ConsoleServices> const&,
+    std::shared_ptr<mir::udev::Context> const&,
+    mo::ProgramOption const& options) -> std::vector<mg::SupportedDevice>
+{
+    mir::assert_entry_point_signature<mg::PlatformProbe>(&probe_display_platform);
+    std::vector<mg::SupportedDevice> result;
+    if (outputs_requested(options))
+    {
+        result.emplace_back(mg::SupportedDevice{nullptr, mg::PlatformPriority::supported, {}});
+    }
+    return result;
+}
+
+auto probe_rendering_platform(
+    std::shared_ptr<mir::ConsoleServices> const&,
+    std::shared_ptr<mir::udev::Context> const&,
+    mo::ProgramOption const& options) -> std::vector<mg::SupportedDevice>
+{
+    mir::assert_entry_point_signature<mg::PlatformProbe>(&probe_rendering_platform);
+    std::vector<mg::SupportedDevice> result;
+    if (outputs_requested(options))
+    {
+        result.emplace_back(mg::SupportedDevice{nullptr, mg::PlatformPriority::supported, {}});
+    }
+    return result;
+}
+
+namespace
+{
+mir::ModuleProperties const description = {
+    "mir:virtual",
+    MIR_VERSION_MAJOR,
+    MIR_VERSION_MINOR,
+    MIR_VERSION_MICRO,
+    mir::libname()
+};
+}
+
+mir::ModuleProperties const* describe_graphics_module()
+{
+    mir::assert_entry_point_signature<mg::DescribeModule>(&describe_graphics_module);
+    return &description;
+}
@@ -0,0 +1,156 @@
+/*
+ * Copyright © 2022 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "platform.h"
+#include "display.h"
+#include "buffer_allocator.h"
+
+#include <boost/throw_exception.hpp>
+
+#include <stdexcept>
+
+namespace mg = mir::graphics;
+namespace mgv = mg::virt;
+namespace geom = mir::geometry;
+
+namespace
+{
+auto parse_size_dimension(std::string const& str) -> int
+{
+    try
+    {
+        size_t num_end = 0;
+        int const value = std::stoi(str, &num_end);
+        if (num_end != str.size())
+            BOOST_THROW_EXCEPTION(std::runtime_error("Output dimension \"" + str + "\" is not a valid number"));
+        if (value <= 0)
+            BOOST_THROW_EXCEPTION(std::runtime_error("Output dimensions must be greater than zero"));
+        return value;
+    }
+    catch (std::invalid_argument const&)
+    {
+        BOOST_THROW_EXCEPTION(std::runtime_error("Output dimension \"" + str + "\" is not a valid number"));
+    }
+    catch (std::out_of_range const&)
+    {
+        BOOST_THROW_EXCEPTION(std::runtime_error("Output dimension \"" + str + "\" is out of range"));
+    }
+}
+
+template<typename T>
+auto parse_positive(std::string const& str, char const* what, T (*convert)(std::string const&, size_t*)) -> T
+{
+    try
+    {
+        size_t num_end = 0;
+        T const value = convert(str, &num_end);
+        if (num_end != str.size())
+            BOOST_THROW_EXCEPTION(std::runtime_error(std::string{what} + " \"" + str + "\" is not a valid number"));
+        if (value <= 0.000001)
+            BOOST_THROW_EXCEPTION(std::runtime_error(std::string{what} + " must be greater than zero"));
+        return value;
+    }
+    catch (std::invalid_argument const&)
+    {
+        BOOST_THROW_EXCEPTION(std::runtime_error(std::string{what} + " \"" + str + "\" is not a valid number"));
+    }
+    catch (std::out_of_range const&)
+    {
+        BOOST_THROW_EXCEPTION(std::runtime_error(std::string{what} + " \"" + str + "\" is out of range"));
+    }
+}
+
+auto to_float(std::string const& str, size_t* end) -> float { return std::stof(str, end); }
+auto to_double(std::string const& str, size_t* end) -> double { return std::stod(str, end); }
+
+auto parse_output(std::string const& str, double default_refresh_rate) -> mgv::VirtualOutputConfig
+{
+    auto spec = str;
+
+    float scale = 1.0f;
+    auto const scale_start = spec.find('^');
+    if (scale_start != std::string::npos)
+    {
+        if (scale_start >= spec.size() - 1)
+            BOOST_THROW_EXCEPTION(std::runtime_error("In \"" + str + "\", '^' is not followed by a scale"));
+        scale = parse_positive<float>(spec.substr(scale_start + 1), "Scale", &to_float);
+        spec.erase(scale_start);
+    }
+
+    double refresh_rate = default_refresh_rate;
+    auto const rate_start = spec.find('@');
+    if (rate_start != std::string::npos)
+    {
+        if (rate_start >= spec.size() - 1)
+            BOOST_THROW_EXCEPTION(std::runtime_error("In \"" + str + "\", '@' is not followed by a refresh rate"));
+        refresh_rate = parse_positive<double>(spec.substr(rate_start + 1), "Refresh rate", &to_double);
+        spec.erase(rate_start);
+    }
+
+    auto const x = spec.find('x'); // "x" between width and height
+    if (x == std::string::npos || x == 0 || x >= spec.size() - 1)
+        BOOST_THROW_EXCEPTION(std::runtime_error("Output size \"" + str + "\" does not have two dimensions"));
+
+    return mgv::VirtualOutputConfig{
+        geom::Size{
+            parse_size_dimension(spec.substr(0, x)),
+            parse_size_dimension(spec.substr(x + 1))},
+        refresh_rate,
+        scale};
+}
+}
+
+auto mgv::Platform::parse_output_configs(std::string const& outputs, double default_refresh_rate)
+    -> std::vector<VirtualOutputConfig>
+{
+    if (default_refresh_rate <= 0)
+        BOOST_THROW_EXCEPTION(std::runtime_error("Refresh rate must be greater than zero"));
+
+    std::vector<VirtualOutputConfig> configs;
+    std::string::size_type start = 0;
+    for (;;)
+    {
+        auto const end = outputs.find(':', start);
+        configs.push_back(parse_output(outputs.substr(start, end - start), default_refresh_rate));
+        if (end == std::string::npos)
+            break;
+        start = end + 1;
+    }
+    return configs;
+}
+
+mgv::Platform::Platform(
+    std::vector<VirtualOutputConfig> outputs,
+    std::shared_ptr<mg::DisplayReport> const& report)
+    : outputs{std::move(outputs)},
+      report{report}
+{
+    if (this->outputs.empty())
+        BOOST_THROW_EXCEPTION(std::runtime_error("Virtual platform requires at least one output"));
+}
+
+mir::UniqueModulePtr<mg::Display> mgv::Platform::create_display(
+    std::shared_ptr<DisplayConfigurationPolicy> const& initial_conf_policy,
+    std::shared_ptr<GLConfig> const& gl_config)
+{
+    return make_module_ptr<mgv::Display>(outputs, initial_conf_policy, gl_config, report);
+}
+
+mir::UniqueModulePtr<mg::GraphicBufferAllocator> mgv::RenderingPlatform::create_buffer_allocator(
+    mg::Display const& output)
+{
+    return make_module_ptr<mgv::BufferAllocator>(output);
+}
@@ -0,0 +1,78 @@
+/*
+ * Copyright © 2022 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_GRAPHICS_VIRTUAL_PLATFORM_H_
+#define MIR_GRAPHICS_VIRTUAL_PLATFORM_H_
+
+#include "mir/graphics/display_report.h"
+#include "mir/graphics/platform.h"
+#include "mir/geometry/size.h"
+
+#include <string>
+#include <vector>
+
+namespace mir
+{
+namespace graphics
+{
+namespace virt
+{
+struct VirtualOutputConfig
+{
+    VirtualOutputConfig(geometry::Size const& size, double refresh_rate, float scale)
+        : size{size},
+          refresh_rate{refresh_rate},
+          scale{scale}
+    {
+    }
+
+    geometry::Size size;
+    double refresh_rate;
+    float scale;
+};
+
+class Platform : public graphics::DisplayPlatform
+{
+public:
+    /// Parses a colon separated list of outputs in the form WIDTHxHEIGHT[@HZ][^SCALE]
+    /// Outputs without an explicit refresh rate use default_refresh_rate
+    static auto parse_output_configs(std::string const& outputs, double default_refresh_rate)
+        -> std::vector<VirtualOutputConfig>;
+
+    Platform(
+        std::vector<VirtualOutputConfig> outputs,
+        std::shared_ptr<DisplayReport> const& report);
+    ~Platform() = default;
+
+    /* From Platform */
+    UniqueModulePtr<graphics::Display> create_display(
+        std::shared_ptr<DisplayConfigurationPolicy> const& initial_conf_policy,
+        std::shared_ptr<GLConfig> const& gl_config) override;
+
+private:
+    std::vector<VirtualOutputConfig> const outputs;
+    std::shared_ptr<DisplayReport> const report;
+};
+
+class RenderingPlatform : public graphics::RenderingPlatform
+{
+    auto create_buffer_allocator(graphics::Display const& output) -> UniqueModulePtr<graphics::GraphicBufferAllocator> override;
+};
+}
+}
+}
+
+#endif // MIR_GRAPHICS_VIRTUAL_PLATFORM_H_
@@ -16,12 +16,21 @@
  */
 
 #include "displayclient.h"
+#include "frame_damage.h"
+#include "host_passthrough.h"
 #include "mir/graphics/egl_error.h"
 #include <mir/graphics/pixel_format_utils.h>
+#include <mir/graphics/buffer.h>
+#include <mir/graphics/dmabuf_buffer.h>
+#include <mir/graphics/linux_dmabuf_layout.h>
+#include <mir/graphics/renderable.h>
+#include <mir/graphics/texture.h>
+#include <mir/log.h>
 
 #include <wayland-client.h>
 #include <wayland-egl.h>
 
+#include <drm_fourcc.h>
 #include <fcntl.h>
 #include <sys/mman.h>
 #include <xkbcommon/xkbcommon.h>
@@ -29,14 +38,21 @@
 #include <boost/throw_exception.hpp>
 
 #include <algorithm>
+#include <cinttypes>
 #include <condition_variable>
 #include <cstring>
 #include <stdlib.h>
 #include <system_error>
 
+namespace mg = mir::graphics;
 namespace mgw = mir::graphics::wayland;
 namespace geom = mir::geometry;
 
+namespace
+{
+struct FrameSync;
+}
+
 class mgw::DisplayClient::Output  :
     public DisplaySyncGroup,
     public renderer::gl::RenderTarget,
@@ -74,6 +90,18 @@ public:
     bool has_initialized{false};
     std::function<void()> on_change;
 
+    // A client buffer selected by overlay() to be attached directly to our surface in post()
+    std::shared_ptr<Buffer> passthrough_buffer;
+
+    common::SwapBuffersWithDamage const swap_buffers_with_damage;
+    common::FrameDamage damage_tracker;
+    std::optional<geometry::Rectangles> frame_damage;
+
+    // The frame callback for our last commit; we wait for it before presenting the next frame
+    // rather than blocking the compositor straight after presenting
+    std::shared_ptr<FrameSync> pending_frame;
+    void wait_for_pending_frame();
+
     // wl_output events
     void geometry(
         int32_t x,
@@ -118,6 +146,152 @@ static EGLint const ctxattribs[] =
         EGL_CONTEXT_CLIENT_VERSION, 2,
         EGL_NONE
     };
+
+struct FrameSync
+{
+    explicit FrameSync(wl_surface* surface):
+        surface{surface}
+    {
+    }
+
+    void init()
+    {
+        callback = wl_surface_frame(surface);
+        static struct wl_callback_listener const frame_listener =
+            {
+                [](void* data, auto... args)
+                    { static_cast<FrameSync*>(data)->frame_done(args...); },
+            };
+        wl_callback_add_listener(callback, &frame_listener, this);
+    }
+
+    ~FrameSync()
+    {
+        if (callback)
+        {
+            wl_callback_destroy(callback);
+        }
+    }
+
+    void frame_done(wl_callback*, uint32_t)
+    {
+        {
+            std::lock_guard lock{mutex};
+            posted = true;
+        }
+        cv.notify_one();
+    }
+
+    void wait_for_done()
+    {
+        std::unique_lock lock{mutex};
+        cv.wait_for(lock, std::chrono::milliseconds{100}, [this]{ return posted; });
+    }
+
+    wl_surface* const surface;
+
+    wl_callback* callback{nullptr};
+    std::mutex mutex;
+    bool posted = false;
+    std::condition_variable cv;
+};
+
+/// A host wl_buffer importing the dmabuf of one of our clients' buffers.
+/// The client buffer is held until the host releases the wl_buffer, at which point both are freed.
+class HostBuffer
+{
+public:
+    /// Asks the host to import the dmabuf. Exactly one of on_created() and on_failed() is later called on the Wayland
+    /// thread.
+    ///
+    /// This uses create rather than create_immed: the host may not be able to import a buffer even in a format and
+    /// modifier it advertises (for example if it is on a different GPU), and create_immed lets it treat that as a
+    /// protocol error, which would disconnect us.
+    static void import(
+        zwp_linux_dmabuf_v1* linux_dmabuf,
+        std::shared_ptr<mg::Buffer> const& buffer,
+        mg::DMABufBuffer const& dmabuf,
+        std::function<void(wl_buffer*)> on_created,
+        std::function<void()> on_failed)
+    {
+        auto const params = zwp_linux_dmabuf_v1_create_params(linux_dmabuf);
+        auto const modifier = dmabuf.modifier().value_or(DRM_FORMAT_MOD_INVALID);
+
+        uint32_t plane_idx{0};
+        for (auto const& plane : dmabuf.planes())
+        {
+            zwp_linux_buffer_params_v1_add(
+                params,
+                plane.dma_buf,
+                plane_idx++,
+                plane.offset,
+                plane.stride,
+                modifier >> 32,
+                modifier & 0xffffffff);
+        }
+
+        uint32_t flags{0};
+        if (auto const tex = dynamic_cast<mg::gl::Texture*>(buffer->native_buffer_base()))
+        {
+            flags = mg::linux_dmabuf_flags_from_layout(tex->layout());
+        }
+
+        static zwp_linux_buffer_params_v1_listener const params_listener{
+            [](void* data, zwp_linux_buffer_params_v1* params, wl_buffer* host_buffer)
+            {
+                std::unique_ptr<Import> const import{static_cast<Import*>(data)};
+                zwp_linux_buffer_params_v1_destroy(params);
+
+                static wl_buffer_listener const buffer_listener{
+                    [](void* self, wl_buffer*) { delete static_cast<HostBuffer*>(self); },
+                };
+                wl_buffer_add_listener(host_buffer, &buffer_listener, new HostBuffer{host_buffer, import->buffer});
+
+                import->on_created(host_buffer);
+            },
+            [](void* data, zwp_linux_buffer_params_v1* params)
+            {
+                std::unique_ptr<Import> const import{static_cast<Import*>(data)};
+                zwp_linux_buffer_params_v1_destroy(params);
+
+                import->on_failed();
+            },
+        };
+        zwp_linux_buffer_params_v1_add_listener(
+            params,
+            &params_listener,
+            new Import{buffer, std::move(on_created), std::move(on_failed)});
+
+        zwp_linux_buffer_params_v1_create(
+            params,
+            dmabuf.size().width.as_int(),
+            dmabuf.size().height.as_int(),
+            dmabuf.drm_fourcc(),
+            flags);
+    }
+
+    ~HostBuffer()
+    {
+        wl_buffer_destroy(host_buffer);
+    }
+
+private:
+    struct Import
+    {
+        std::shared_ptr<mg::Buffer> const buffer;
+        std::function<void(wl_buffer*)> const on_created;
+        std::function<void()> const on_failed;
+    };
+
+    HostBuffer(wl_buffer* host_buffer, std::shared_ptr<mg::Buffer> const& buffer) :
+        host_buffer{host_buffer},
+        buffer{buffer}
+    {
+    }
+
+    wl_buffer* const host_buffer;
+    std::shared_ptr<mg::Buffer> const buffer;
+};
 }
 
 mgw::DisplayClient::Output::Output(
@@ -127,7 +301,8 @@ mgw::DisplayClient::Output::Output(
     output{output},
     owner{owner},
     surface{wl_compositor_create_surface(owner->compositor)},
-    on_change{std::move(on_change)}
+    on_change{std::move(on_change)},
+    swap_buffers_with_damage{owner->egldisplay}
 {
     // If building against newer Wayland protocol definitions we may miss trailing fields
     #pragma GCC diagnostic push
@@ -355,6 +530,56 @@ void mgw::DisplayClient::Output::for_each_display_buffer(std::function<void(Disp
 
 void mgw::DisplayClient::Output::post()
 {
+    if (!passthrough_buffer)
+    {
+        return;
+    }
+
+    wait_for_pending_frame();
+
+    auto const buffer = std::move(passthrough_buffer);
+    auto const frame_sync = std::make_shared<FrameSync>(surface);
+    owner->spawn([owner = owner, surface = surface, buffer, frame_sync]()
+        {
+            auto const dmabuf = dynamic_cast<DMABufBuffer*>(buffer->native_buffer_base());
+            HostBuffer::import(
+                owner->linux_dmabuf,
+                buffer,
+                *dmabuf,
+                [surface, frame_sync](wl_buffer* host_buffer)
+                {
+                    wl_surface_attach(surface, host_buffer, 0, 0);
+                    if (wl_surface_get_version(surface) >= WL_SURFACE_DAMAGE_BUFFER_SINCE_VERSION)
+                    {
+                        wl_surface_damage_buffer(surface, 0, 0, INT32_MAX, INT32_MAX);
+                    }
+                    else
+                    {
+                        wl_surface_damage(surface, 0, 0, INT32_MAX, INT32_MAX);
+                    }
+                    frame_sync->init();
+                    wl_surface_commit(surface);
+                },
+                [owner, frame_sync, format = dmabuf->drm_fourcc(), modifier = dmabuf->modifier()]()
+                {
+                    // Composite this format ourselves from now on. The host keeps showing our previous frame until we
+                    // next composite.
+                    owner->host_rejected_dmabuf(format, modifier.value_or(DRM_FORMAT_MOD_INVALID));
+                    // Nothing was committed, so there will be no frame callback to wait for
+                    frame_sync->frame_done(nullptr, 0);
+                });
+        });
+
+    pending_frame = frame_sync;
+}
+
+void mgw::DisplayClient::Output::wait_for_pending_frame()
+{
+    if (pending_frame)
+    {
+        pending_frame->wait_for_done();
+        pending_frame.reset();
+    }
 }
 
 auto mgw::DisplayClient::Output::recommended_sleep() const -> std::chrono::milliseconds
@@ -367,9 +592,29 @@ auto mgw::DisplayClient::Output::view_area() const -> geometry::Rectangle
     return dcout.extents();
 }
 
-bool mgw::DisplayClient::Output::overlay(mir::graphics::RenderableList const&)
+bool mgw::DisplayClient::Output::overlay(mir::graphics::RenderableList const& renderlist)
 {
-    return false;
+    passthrough_buffer = nullptr;
+    frame_damage = damage_tracker.update(renderlist, view_area());
+
+    if (!owner->linux_dmabuf)
+    {
+        return false;
+    }
+
+    passthrough_buffer = host_passthrough_buffer(
+        renderlist,
+        view_area(),
+        output_size,
+        [this](uint32_t format, uint64_t modifier) { return owner->host_supports_dmabuf(format, modifier); });
+    if (!passthrough_buffer)
+    {
+        return false;
+    }
+
+    // The host will have seen the client's buffer, not our last render
+    damage_tracker.invalidate();
+    return true;
 }
 
 auto mgw::DisplayClient::Output::transformation() const -> glm::mat2
@@ -403,51 +648,9 @@ void mgw::DisplayClient::Output::release_current()
 
 void mgw::DisplayClient::Output::swap_buffers()
 {
-    struct FrameSync
-    {
-        explicit FrameSync(wl_surface* surface):
-            surface{surface}
-        {
-        }
-
-        void init()
-        {
-            callback = wl_surface_frame(surface);
-            static struct wl_callback_listener const frame_listener =
-                {
-                    [](void* data, auto... args)
-                        { static_cast<FrameSync*>(data)->frame_done(args...); },
-                };
-            wl_callback_add_listener(callback, &frame_listener, this);
-        }
-
-        ~FrameSync()
-        {
-            wl_callback_destroy(callback);
-        }
-
-        void frame_done(wl_callback*, uint32_t)
-        {
-            {
-                std::lock_guard lock{mutex};
-                posted = true;
-            }
-            cv.notify_one();
-        }
-
-        void wait_for_done()
-        {
-            std::unique_lock lock{mutex};
-            cv.wait_for(lock, std::chrono::milliseconds{100}, [this]{ return posted; });
-        }
-
-        wl_surface* const surface;
-
-        wl_callback* callback;
-        std::mutex mutex;
-        bool posted = false;
-        std::condition_variable cv;
-    };
+    // Only wait on the host once we have the next frame ready, so rendering overlaps with the host
+    // compositing our previous one
+    wait_for_pending_frame();
 
     auto const frame_sync = std::make_shared<FrameSync>(surface);
     owner->spawn([frame_sync]()
@@ -459,10 +662,18 @@ void mgw::DisplayClient::Output::swap_buffers()
     // Instead we use the frame "done" notification.
     eglSwapInterval(owner->egldisplay, 0);
 
-    if (eglSwapBuffers(owner->egldisplay, eglsurface) != EGL_TRUE)
+    // With a wl_surface of version 4+ Mesa passes this on to the host as wl_surface.damage_buffer
+    std::optional<std::vector<EGLint>> damage_rects;
+    if (frame_damage)
+    {
+        damage_rects = common::egl_damage_rects(frame_damage.value(), view_area(), output_size);
+    }
+    frame_damage.reset();
+
+    if (swap_buffers_with_damage(owner->egldisplay, eglsurface, damage_rects) != EGL_TRUE)
         BOOST_THROW_EXCEPTION(egl_error("Failed to perform buffer swap"));
 
-    frame_sync->wait_for_done();
+    pending_frame = frame_sync;
 }
 
 void mgw::DisplayClient::Output::bind()
@@ -575,6 +786,10 @@ mgw::DisplayClient::~DisplayClient()
         std::lock_guard lock{outputs_mutex};
         bound_outputs.clear();
     }
+    if (linux_dmabuf)
+    {
+        zwp_linux_dmabuf_v1_destroy(linux_dmabuf);
+    }
     registry.reset();
 
     eglDestroyContext(egldisplay, eglctx);
@@ -594,7 +809,7 @@ void mgw::DisplayClient::new_global(
     if (strcmp(interface, "wl_compositor") == 0)
     {
         self->compositor =
-            static_cast<decltype(self->compositor)>(wl_registry_bind(registry, id, &wl_compositor_interface, std::min(version, 3u)));
+            static_cast<decltype(self->compositor)>(wl_registry_bind(registry, id, &wl_compositor_interface, std::min(version, 4u)));
     }
     else if (strcmp(interface, "wl_shm") == 0)
     {
@@ -623,6 +838,13 @@ void mgw::DisplayClient::new_global(
                     self,
                     [self]() { self->on_display_config_changed(); })));
     }
+    else if (strcmp(interface, zwp_linux_dmabuf_v1_interface.name) == 0 && version >= 2)
+    {
+        // We need create_immed (v2) and modifiers (v3) but not the feedback of later versions
+        self->linux_dmabuf = static_cast<decltype(self->linux_dmabuf)>(
+            wl_registry_bind(registry, id, &zwp_linux_dmabuf_v1_interface, std::min(version, 3u)));
+        add_linux_dmabuf_listener(self, self->linux_dmabuf);
+    }
     else if (strcmp(interface, xdg_wm_base_interface.name) == 0)
     {
         static xdg_wm_base_listener const shell_listener{
@@ -933,6 +1155,55 @@ void mir::graphics::wayland::DisplayClient::shm_format(wl_shm* /*wl_shm*/, uint3
     }
 }
 
+void mgw::DisplayClient::add_linux_dmabuf_listener(DisplayClient* self, zwp_linux_dmabuf_v1* linux_dmabuf)
+{
+    static struct zwp_linux_dmabuf_v1_listener linux_dmabuf_listener =
+        {
+            [](void* self, auto... args) { static_cast<DisplayClient*>(self)->linux_dmabuf_format(args...); },
+            [](void* self, auto... args) { static_cast<DisplayClient*>(self)->linux_dmabuf_modifier(args...); },
+        };
+
+    zwp_linux_dmabuf_v1_add_listener(linux_dmabuf, &linux_dmabuf_listener, self);
+}
+
+void mgw::DisplayClient::linux_dmabuf_format(zwp_linux_dmabuf_v1* /*linux_dmabuf*/, uint32_t format)
+{
+    std::lock_guard lock{linux_dmabuf_formats_mutex};
+    linux_dmabuf_formats.insert({format, DRM_FORMAT_MOD_INVALID});
+}
+
+void mgw::DisplayClient::linux_dmabuf_modifier(
+    zwp_linux_dmabuf_v1* /*linux_dmabuf*/,
+    uint32_t format,
+    uint32_t hi,
+    uint32_t lo)
+{
+    std::lock_guard lock{linux_dmabuf_formats_mutex};
+    linux_dmabuf_formats.insert({format, (static_cast<uint64_t>(hi) << 32) | lo});
+}
+
+auto mgw::DisplayClient::host_supports_dmabuf(uint32_t format, uint64_t modifier) const -> bool
+{
+    std::lock_guard lock{linux_dmabuf_formats_mutex};
+    return linux_dmabuf_formats.count({format, modifier}) > 0;
+}
+
+void mgw::DisplayClient::host_rejected_dmabuf(uint32_t format, uint64_t modifier)
+{
+    {
+        std::lock_guard lock{linux_dmabuf_formats_mutex};
+        if (!linux_dmabuf_formats.erase({format, modifier}))
+        {
+            return;
+        }
+    }
+
+    mir::log_warning(
+        "Host compositor failed to import a dmabuf (format 0x%x, modifier 0x%" PRIx64 "), compositing it instead",
+        format,
+        modifier);
+}
+
 namespace mir
 {
 namespace graphics
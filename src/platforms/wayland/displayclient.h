@@ -27,6 +27,7 @@
 #include <mir/executor.h>
 
 #include "protocol/xdg-shell-client.h"
+#include "protocol/linux-dmabuf-unstable-v1-client.h"
 #include <wayland-client.h>
 #include <EGL/egl.h>
 
@@ -34,6 +35,7 @@
 #include <unordered_map>
 #include <memory>
 #include <mutex>
+#include <set>
 #include <mir/geometry/displacement.h>
 
 struct xkb_context;
@@ -155,6 +157,18 @@ protected:
     void shm_format(wl_shm *wl_shm, uint32_t format);
     MirPixelFormat shm_pixel_format{mir_pixel_format_invalid};
 
+    static void add_linux_dmabuf_listener(DisplayClient* self, zwp_linux_dmabuf_v1* linux_dmabuf);
+    void linux_dmabuf_format(zwp_linux_dmabuf_v1* linux_dmabuf, uint32_t format);
+    void linux_dmabuf_modifier(zwp_linux_dmabuf_v1* linux_dmabuf, uint32_t format, uint32_t hi, uint32_t lo);
+    auto host_supports_dmabuf(uint32_t format, uint64_t modifier) const -> bool;
+    /// Stops offering the host buffers it has failed to import
+    void host_rejected_dmabuf(uint32_t format, uint64_t modifier);
+
+    zwp_linux_dmabuf_v1* linux_dmabuf = nullptr;
+    std::mutex mutable linux_dmabuf_formats_mutex;
+    // (DRM fourcc, modifier) pairs the host can import; implicit modifiers are DRM_FORMAT_MOD_INVALID
+    std::set<std::pair<uint32_t, uint64_t>> linux_dmabuf_formats;
+
     xkb_context* keyboard_context_;
     xkb_keymap* keyboard_map_ = nullptr;
     xkb_state* keyboard_state_ = nullptr;
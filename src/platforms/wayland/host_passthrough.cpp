@@ -0,0 +1,64 @@
+/*
+ * Copyright © 2022 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "host_passthrough.h"
+
+#include <mir/graphics/buffer.h>
+#include <mir/graphics/dmabuf_buffer.h>
+
+#include <drm_fourcc.h>
+
+#include <algorithm>
+
+namespace mg = mir::graphics;
+namespace geom = mir::geometry;
+
+auto mg::wayland::host_passthrough_buffer(
+    RenderableList const& renderlist,
+    geom::Rectangle const& view_area,
+    geom::Size const& output_size,
+    std::function<bool(uint32_t format, uint64_t modifier)> const& host_supports_dmabuf) -> std::shared_ptr<Buffer>
+{
+    glm::mat4 const identity{1};
+    auto const topmost = std::find_if(renderlist.rbegin(), renderlist.rend(),
+        [&](auto const& renderable) { return view_area.overlaps(renderable->screen_position()); });
+
+    if (topmost == renderlist.rend())
+    {
+        return nullptr;
+    }
+
+    auto const& renderable = *topmost;
+    if (renderable->alpha() != 1.0f ||
+        renderable->shaped() ||
+        renderable->screen_position() != view_area ||
+        (renderable->clip_area() && !renderable->clip_area()->contains(view_area)) ||
+        renderable->transformation() != identity)
+    {
+        return nullptr;
+    }
+
+    auto buffer = renderable->buffer();
+    auto const dmabuf = dynamic_cast<DMABufBuffer*>(buffer->native_buffer_base());
+    if (!dmabuf ||
+        buffer->size() != output_size ||
+        !host_supports_dmabuf(dmabuf->drm_fourcc(), dmabuf->modifier().value_or(DRM_FORMAT_MOD_INVALID)))
+    {
+        return nullptr;
+    }
+
+    return buffer;
+}
@@ -0,0 +1,51 @@
+/*
+ * Copyright © 2022 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_PLATFORM_WAYLAND_HOST_PASSTHROUGH_H_
+#define MIR_PLATFORM_WAYLAND_HOST_PASSTHROUGH_H_
+
+#include <mir/graphics/renderable.h>
+#include <mir/geometry/rectangle.h>
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+namespace mir
+{
+namespace graphics
+{
+class Buffer;
+
+namespace wayland
+{
+/// Picks a client buffer the host compositor can show in place of our composited frame for an output.
+/// The topmost renderable on the output qualifies if it exactly covers the output and nothing beneath it shows through
+/// (it is opaque, unshaped, unclipped and untransformed), and its buffer is a dmabuf of the output's size in a format
+/// and modifier the host can import.
+/// \param host_supports_dmabuf whether the host can import a DRM fourcc with a modifier (DRM_FORMAT_MOD_INVALID if
+///                             implicit)
+/// \returns the buffer to hand to the host, or nullptr if the output must be composited
+auto host_passthrough_buffer(
+    RenderableList const& renderlist,
+    geometry::Rectangle const& view_area,
+    geometry::Size const& output_size,
+    std::function<bool(uint32_t format, uint64_t modifier)> const& host_supports_dmabuf) -> std::shared_ptr<Buffer>;
+}
+}
+}
+
+#endif //MIR_PLATFORM_WAYLAND_HOST_PASSTHROUGH_H_
@@ -24,6 +24,7 @@
 
 namespace mg=mir::graphics;
 namespace mgx=mg::X;
+namespace mgc=mg::common;
 namespace geom=mir::geometry;
 
 mgx::DisplayBuffer::DisplayBuffer(::Display* const x_dpy,
@@ -40,6 +41,7 @@ mgx::DisplayBuffer::DisplayBuffer(::Display* const x_dpy,
                                     window_size{window_size},
                                     transform(1),
                                     egl{gl_config, x_dpy, win, shared_context},
+                                    swap_buffers_with_damage{egl.display()},
                                     last_frame{f},
                                     output_id{output_id},
                                     eglGetSyncValues{nullptr}
@@ -102,14 +104,23 @@ void mgx::DisplayBuffer::release_current()
     egl.release_current();
 }
 
-bool mgx::DisplayBuffer::overlay(RenderableList const& /*renderlist*/)
+bool mgx::DisplayBuffer::overlay(RenderableList const& renderlist)
 {
+    // We never overlay, but this is where we get to see what the next frame contains
+    frame_damage = damage_tracker.update(renderlist, area);
     return false;
 }
 
 void mgx::DisplayBuffer::swap_buffers()
 {
-    if (!egl.swap_buffers())
+    std::optional<std::vector<EGLint>> damage_rects;
+    if (frame_damage && transform == glm::mat2{1})
+    {
+        damage_rects = mgc::egl_damage_rects(frame_damage.value(), area, window_size);
+    }
+    frame_damage.reset();
+
+    if (swap_buffers_with_damage(egl.display(), egl.surface(), damage_rects) != EGL_TRUE)
         fatal_error("Failed to perform buffer swap");
 
     /*
@@ -162,6 +173,7 @@ void mgx::DisplayBuffer::set_view_area(geom::Rectangle const& a)
 void mgx::DisplayBuffer::set_size(geom::Size const& size)
 {
     window_size = size;
+    damage_tracker.invalidate();
 }
 
 void mgx::DisplayBuffer::set_transformation(glm::mat2 const& t)
@@ -22,6 +22,7 @@
 #include "mir/graphics/display.h"
 #include "mir/renderer/gl/render_target.h"
 #include "egl_helper.h"
+#include "frame_damage.h"
 
 #include <EGL/egl.h>
 #include <memory>
@@ -80,6 +81,9 @@ private:
     geometry::Size window_size;
     glm::mat2 transform;
     helpers::EGLHelper const egl;
+    common::SwapBuffersWithDamage const swap_buffers_with_damage;
+    common::FrameDamage damage_tracker;
+    std::optional<geometry::Rectangles> frame_damage;
     std::shared_ptr<AtomicFrame> const last_frame;
     DisplayConfigurationOutputId const output_id;
 
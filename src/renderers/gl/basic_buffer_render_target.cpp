@@ -21,10 +21,285 @@
 
 #include <boost/throw_exception.hpp>
 #include <GLES2/gl2ext.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include <cstring>
+#include <vector>
 
 namespace mg = mir::graphics;
 namespace mrg = mir::renderer::gl;
 namespace mrs = mir::renderer::software;
+namespace geom = mir::geometry;
+
+namespace
+{
+/// The glReadPixels() format that matches the buffer's byte order, if there is one
+auto read_format_for(MirPixelFormat format) -> std::optional<GLenum>
+{
+    switch (format)
+    {
+    case mir_pixel_format_argb_8888:
+    case mir_pixel_format_xrgb_8888:
+        return GL_BGRA_EXT;
+
+    case mir_pixel_format_abgr_8888:
+    case mir_pixel_format_xbgr_8888:
+        return GL_RGBA;
+
+    default:
+        return std::nullopt;
+    }
+}
+
+/// Check a framebuffer of \a size can be read back into \a buffer, returning the format to read it in
+auto check_buffer(mrs::BufferDescriptor const& buffer, geom::Size const& size) -> GLenum
+{
+    if (buffer.size() != size)
+    {
+        BOOST_THROW_EXCEPTION(std::logic_error("given size does not match buffer size"));
+    }
+    if (buffer.stride() < geom::Stride{size.width.as_int() * 4})
+    {
+        BOOST_THROW_EXCEPTION(std::logic_error("invalid buffer stride " + std::to_string(buffer.stride().as_int())));
+    }
+    auto const format = read_format_for(buffer.format());
+    if (!format)
+    {
+        BOOST_THROW_EXCEPTION(std::logic_error("invalid pixel format " + std::to_string(buffer.format())));
+    }
+    return format.value();
+}
+
+/// Copy tightly packed rows of \a pixels into \a area of \a mapping
+void copy_rows(unsigned char const* pixels, mrs::Mapping<unsigned char>& mapping, geom::Rectangle const& area)
+{
+    auto const row_length = area.size.width.as_int() * 4;
+    auto const stride = mapping.stride().as_int();
+    auto const dest = mapping.data() + area.top_left.y.as_int() * stride + area.top_left.x.as_int() * 4;
+    for (auto row = 0; row < area.size.height.as_int(); row++)
+    {
+        memcpy(dest + row * stride, pixels + row * row_length, row_length);
+    }
+}
+
+auto bytes_in(geom::Rectangle const& area) -> GLsizeiptr
+{
+    return area.size.width.as_int() * area.size.height.as_int() * 4;
+}
+}
+
+class mrg::BasicBufferRenderTarget::AsyncReadback
+{
+public:
+    /// Null if the current context lacks pixel pack buffers, buffer mapping or EGL fences
+    static auto create() -> std::unique_ptr<AsyncReadback>;
+
+    ~AsyncReadback();
+
+    /// Queue a read of \a area of the bound framebuffer, which finish() writes into the same area of \a buffer
+    void start(std::shared_ptr<mrs::WriteMappableBuffer> const& buffer, GLenum format, geom::Rectangle const& area);
+
+    /// Wait for the reads started and write them into their buffers
+    void finish();
+
+private:
+    AsyncReadback(
+        EGLDisplay display,
+        GLenum usage,
+        PFNGLMAPBUFFERRANGEEXTPROC map_buffer_range,
+        PFNGLUNMAPBUFFEROESPROC unmap_buffer,
+        PFNEGLCREATESYNCKHRPROC create_sync,
+        PFNEGLDESTROYSYNCKHRPROC destroy_sync,
+        PFNEGLCLIENTWAITSYNCKHRPROC client_wait_sync);
+
+    struct Read
+    {
+        GLuint pbo;
+        EGLSyncKHR fence;
+        std::shared_ptr<mrs::WriteMappableBuffer> buffer;
+        geom::Rectangle area;
+    };
+
+    void write(Read const& read);
+
+    EGLDisplay const display;
+    GLenum const usage;
+    PFNGLMAPBUFFERRANGEEXTPROC const map_buffer_range;
+    PFNGLUNMAPBUFFEROESPROC const unmap_buffer;
+    PFNEGLCREATESYNCKHRPROC const create_sync;
+    PFNEGLDESTROYSYNCKHRPROC const destroy_sync;
+    PFNEGLCLIENTWAITSYNCKHRPROC const client_wait_sync;
+
+    std::vector<Read> in_flight;
+    std::vector<GLuint> idle_pbos;
+};
+
+auto mrg::BasicBufferRenderTarget::AsyncReadback::create() -> std::unique_ptr<AsyncReadback>
+{
+    auto const version = reinterpret_cast<char const*>(glGetString(GL_VERSION));
+    auto const gl_extensions = reinterpret_cast<char const*>(glGetString(GL_EXTENSIONS));
+    auto const display = eglGetCurrentDisplay();
+    auto const egl_extensions = display != EGL_NO_DISPLAY ? eglQueryString(display, EGL_EXTENSIONS) : nullptr;
+
+    if (!version || !egl_extensions || !strstr(egl_extensions, "EGL_KHR_fence_sync"))
+    {
+        return nullptr;
+    }
+
+    // Pixel pack buffers and glMapBufferRange() are core in GLES 3; GLES 2 needs them as extensions
+    bool const gles3 = strncmp(version, "OpenGL ES 3", strlen("OpenGL ES 3")) == 0;
+    if (!gles3 &&
+        (!gl_extensions ||
+         !strstr(gl_extensions, "GL_NV_pixel_buffer_object") ||
+         !strstr(gl_extensions, "GL_EXT_map_buffer_range") ||
+         !strstr(gl_extensions, "GL_OES_mapbuffer")))
+    {
+        return nullptr;
+    }
+
+    auto const map_buffer_range = reinterpret_cast<PFNGLMAPBUFFERRANGEEXTPROC>(
+        eglGetProcAddress(gles3 ? "glMapBufferRange" : "glMapBufferRangeEXT"));
+    auto const unmap_buffer = reinterpret_cast<PFNGLUNMAPBUFFEROESPROC>(
+        eglGetProcAddress(gles3 ? "glUnmapBuffer" : "glUnmapBufferOES"));
+    auto const create_sync = reinterpret_cast<PFNEGLCREATESYNCKHRPROC>(eglGetProcAddress("eglCreateSyncKHR"));
+    auto const destroy_sync = reinterpret_cast<PFNEGLDESTROYSYNCKHRPROC>(eglGetProcAddress("eglDestroySyncKHR"));
+    auto const client_wait_sync =
+        reinterpret_cast<PFNEGLCLIENTWAITSYNCKHRPROC>(eglGetProcAddress("eglClientWaitSyncKHR"));
+
+    if (!map_buffer_range || !unmap_buffer || !create_sync || !destroy_sync || !client_wait_sync)
+    {
+        return nullptr;
+    }
+
+    // GL_STREAM_READ (from GLES 3) lets the driver put the buffer in memory the CPU reads quickly
+    GLenum const stream_read = 0x88E1;
+    return std::unique_ptr<AsyncReadback>{new AsyncReadback{
+        display,
+        gles3 ? stream_read : GL_STREAM_DRAW,
+        map_buffer_range,
+        unmap_buffer,
+        create_sync,
+        destroy_sync,
+        client_wait_sync}};
+}
+
+mrg::BasicBufferRenderTarget::AsyncReadback::AsyncReadback(
+    EGLDisplay display,
+    GLenum usage,
+    PFNGLMAPBUFFERRANGEEXTPROC map_buffer_range,
+    PFNGLUNMAPBUFFEROESPROC unmap_buffer,
+    PFNEGLCREATESYNCKHRPROC create_sync,
+    PFNEGLDESTROYSYNCKHRPROC destroy_sync,
+    PFNEGLCLIENTWAITSYNCKHRPROC client_wait_sync)
+    : display{display},
+      usage{usage},
+      map_buffer_range{map_buffer_range},
+      unmap_buffer{unmap_buffer},
+      create_sync{create_sync},
+      destroy_sync{destroy_sync},
+      client_wait_sync{client_wait_sync}
+{
+}
+
+mrg::BasicBufferRenderTarget::AsyncReadback::~AsyncReadback()
+{
+    for (auto const& read : in_flight)
+    {
+        destroy_sync(display, read.fence);
+        idle_pbos.push_back(read.pbo);
+    }
+    if (!idle_pbos.empty())
+    {
+        glDeleteBuffers(idle_pbos.size(), idle_pbos.data());
+    }
+}
+
+void mrg::BasicBufferRenderTarget::AsyncReadback::start(
+    std::shared_ptr<mrs::WriteMappableBuffer> const& buffer,
+    GLenum format,
+    geom::Rectangle const& area)
+{
+    GLuint pbo;
+    if (idle_pbos.empty())
+    {
+        glGenBuffers(1, &pbo);
+    }
+    else
+    {
+        pbo = idle_pbos.back();
+        idle_pbos.pop_back();
+    }
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER_NV, pbo);
+    glBufferData(GL_PIXEL_PACK_BUFFER_NV, bytes_in(area), nullptr, usage);
+    // With a pack buffer bound, glReadPixels() queues the copy into it and returns
+    glReadPixels(
+        area.top_left.x.as_int(), area.top_left.y.as_int(),
+        area.size.width.as_int(), area.size.height.as_int(),
+        format, GL_UNSIGNED_BYTE, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER_NV, 0);
+
+    auto const fence = create_sync(display, EGL_SYNC_FENCE_KHR, nullptr);
+    if (fence == EGL_NO_SYNC_KHR)
+    {
+        idle_pbos.push_back(pbo);
+        BOOST_THROW_EXCEPTION(mg::egl_error("Failed to create readback fence"));
+    }
+    glFlush();
+
+    in_flight.push_back(Read{pbo, fence, buffer, area});
+}
+
+void mrg::BasicBufferRenderTarget::AsyncReadback::finish()
+{
+    auto reads = std::move(in_flight);
+    in_flight.clear();
+
+    std::exception_ptr error;
+    for (auto const& read : reads)
+    {
+        try
+        {
+            write(read);
+        }
+        catch (...)
+        {
+            error = std::current_exception();
+        }
+        destroy_sync(display, read.fence);
+        idle_pbos.push_back(read.pbo);
+    }
+
+    if (error)
+    {
+        std::rethrow_exception(error);
+    }
+}
+
+void mrg::BasicBufferRenderTarget::AsyncReadback::write(Read const& read)
+{
+    if (client_wait_sync(display, read.fence, 0, EGL_FOREVER_KHR) != EGL_CONDITION_SATISFIED_KHR)
+    {
+        BOOST_THROW_EXCEPTION(mg::egl_error("Failed to wait for readback fence"));
+    }
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER_NV, read.pbo);
+    auto const pixels = map_buffer_range(GL_PIXEL_PACK_BUFFER_NV, 0, bytes_in(read.area), GL_MAP_READ_BIT_EXT);
+    if (!pixels)
+    {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER_NV, 0);
+        BOOST_THROW_EXCEPTION(mg::gl_error("Failed to map readback buffer"));
+    }
+
+    {
+        auto const mapping = read.buffer->map_writeable();
+        copy_rows(static_cast<unsigned char const*>(pixels), *mapping, read.area);
+    }
+
+    unmap_buffer(GL_PIXEL_PACK_BUFFER_NV);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER_NV, 0);
+}
 
 mrg::BasicBufferRenderTarget::Framebuffer::Framebuffer(geometry::Size const& size)
     : size{size}
@@ -81,26 +356,30 @@ mrg::BasicBufferRenderTarget::Framebuffer::~Framebuffer()
     glDeleteRenderbuffers(1, &colour_buffer);
 }
 
-void mrg::BasicBufferRenderTarget::Framebuffer::copy_to(software::WriteMappableBuffer& buffer)
+void mrg::BasicBufferRenderTarget::Framebuffer::copy_to(
+    software::WriteMappableBuffer& buffer,
+    geom::Rectangle const& area)
 {
+    auto const format = check_buffer(buffer, size);
     glBindFramebuffer(GL_FRAMEBUFFER, fbo);
     auto mapping = buffer.map_writeable();
-    if (mapping->size() != size)
+    if (area.size.width == size.width && mapping->stride() == geom::Stride{size.width.as_int() * 4})
     {
-        BOOST_THROW_EXCEPTION(std::logic_error("given size does not match buffer size"));
-    }
-    if (mapping->stride() != geometry::Stride{size.width.as_int() * 4})
-    {
-        BOOST_THROW_EXCEPTION(std::logic_error("invalid buffer stride " + std::to_string(mapping->stride().as_int())));
+        // The rows are contiguous in the buffer, so they can be read straight in
+        glReadPixels(
+            0, area.top_left.y.as_int(),
+            area.size.width.as_int(), area.size.height.as_int(),
+            format, GL_UNSIGNED_BYTE, mapping->data() + area.top_left.y.as_int() * mapping->stride().as_int());
     }
-    if (mapping->format() != mir_pixel_format_argb_8888)
+    else
     {
-        BOOST_THROW_EXCEPTION(std::logic_error("invalid pixel format " + std::to_string(mapping->format())));
+        std::vector<unsigned char> pixels(bytes_in(area));
+        glReadPixels(
+            area.top_left.x.as_int(), area.top_left.y.as_int(),
+            area.size.width.as_int(), area.size.height.as_int(),
+            format, GL_UNSIGNED_BYTE, pixels.data());
+        copy_rows(pixels.data(), *mapping, area);
     }
-    glReadPixels(
-        0, 0,
-        size.width.as_int(), size.height.as_int(),
-        GL_BGRA_EXT, GL_UNSIGNED_BYTE, mapping->data());
 }
 
 void mrg::BasicBufferRenderTarget::Framebuffer::bind()
@@ -113,9 +392,12 @@ mrg::BasicBufferRenderTarget::BasicBufferRenderTarget(std::shared_ptr<Context> c
 {
 }
 
+mrg::BasicBufferRenderTarget::~BasicBufferRenderTarget() = default;
+
 void mrg::BasicBufferRenderTarget::set_buffer(std::shared_ptr<software::WriteMappableBuffer> const& buffer)
 {
     this->buffer = buffer;
+    damage.reset();
     if (framebuffer && framebuffer->size == buffer->size())
     {
         return;
@@ -152,7 +434,49 @@ void mrg::BasicBufferRenderTarget::swap_buffers()
     {
         BOOST_THROW_EXCEPTION(std::logic_error("swap_buffers() called when buffer unset"));
     }
-    framebuffer->copy_to(*buffer);
+
+    // GL counts rows up from the bottom of the frame, and they land in the buffer in that order
+    auto const frame = geom::Rectangle{{}, framebuffer->size};
+    auto area = damage ? intersection_of(frame, damage.value()) : frame;
+    damage.reset();
+    if (area.size.width.as_int() == 0 || area.size.height.as_int() == 0)
+    {
+        return;
+    }
+    area.top_left.y = geom::Y{frame.size.height.as_int() - area.bottom().as_int()};
+
+    if (!readback_probed)
+    {
+        readback = AsyncReadback::create();
+        readback_probed = true;
+    }
+
+    if (readback)
+    {
+        auto const format = check_buffer(*buffer, framebuffer->size);
+        framebuffer->bind();
+        readback->start(buffer, format, area);
+        copy_pending = true;
+    }
+    else
+    {
+        framebuffer->copy_to(*buffer, area);
+    }
+}
+
+void mrg::BasicBufferRenderTarget::set_damage(geom::Rectangle const& damage)
+{
+    this->damage = damage;
+}
+
+auto mrg::BasicBufferRenderTarget::take_pending_copy() -> std::function<void()>
+{
+    if (!copy_pending)
+    {
+        return {};
+    }
+    copy_pending = false;
+    return [this]() { readback->finish(); };
 }
 
 void mrg::BasicBufferRenderTarget::bind()
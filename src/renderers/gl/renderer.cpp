@@ -19,6 +19,7 @@
 #include "mir/compositor/buffer_stream.h"
 #include "mir/graphics/renderable.h"
 #include "mir/graphics/buffer.h"
+#include "mir/graphics/solid_color_buffer.h"
 #include "mir/graphics/display_buffer.h"
 #include "mir/gl/tessellation_helpers.h"
 #include "mir/log.h"
@@ -38,6 +39,7 @@
 #include <cmath>
 #include <sstream>
 #include <mutex>
+#include <optional>
 
 namespace mg = mir::graphics;
 namespace mgl = mir::gl;
@@ -146,6 +148,18 @@ const GLchar* const vertex_shader_src =
     "   v_texcoord = texcoord;\n"
     "}\n"
 };
+
+// Fills with a SolidColorBuffer's color, premultiplied by the renderable's alpha; there's no texture to sample
+const GLchar* const fill_fragment_shader_src =
+{
+    "#ifdef GL_ES\n"
+    "precision mediump float;\n"
+    "#endif\n"
+    "uniform vec4 color;\n"
+    "void main() {\n"
+    "    gl_FragColor = color;\n"
+    "}\n"
+};
 }
 
 class mrg::Renderer::ProgramFactory : public mir::graphics::gl::ProgramFactory
@@ -228,6 +242,21 @@ public:
         // for deletion. GL will only delete them once the GL Program they're linked in is destroyed.
     }
 
+    // The one program for all SolidColorBuffers; alpha is folded into the color, so there's no alpha variant
+    auto fill_program() -> mrg::Renderer::Program const&
+    {
+        if (!fill)
+        {
+            std::lock_guard lock{compilation_mutex};
+
+            ShaderHandle const fill_shader{compile_shader(GL_FRAGMENT_SHADER, fill_fragment_shader_src)};
+            fill_handle.emplace(link_shader(vertex_shader, fill_shader));
+            fill.emplace(*fill_handle);
+        }
+
+        return *fill;
+    }
+
 private:
     static GLuint compile_shader(GLenum type, GLchar const* src)
     {
@@ -278,6 +307,8 @@ private:
 
     ShaderHandle const vertex_shader;
     std::vector<std::pair<void const*, std::unique_ptr<::Program>>> programs;
+    std::optional<ProgramHandle> fill_handle;
+    std::optional<mrg::Renderer::Program> fill;
     // GL requires us to synchronise multi-threaded access to the shader APIs.
     std::mutex compilation_mutex;
 };
@@ -300,6 +331,7 @@ mrg::Renderer::Program::Program(GLuint program_id)
     transform_uniform = glGetUniformLocation(id, "transform");
     screen_to_gl_coords_uniform = glGetUniformLocation(id, "screen_to_gl_coords");
     alpha_uniform = glGetUniformLocation(id, "alpha");
+    color_uniform = glGetUniformLocation(id, "color");
 }
 
 mrg::Renderer::Renderer(RenderTarget& render_target)
@@ -408,8 +440,10 @@ void mrg::Renderer::draw(mg::Renderable const& renderable) const
         );
     }
 
-    auto const texture = std::dynamic_pointer_cast<mg::gl::Texture>(renderable.buffer());
-    if (!texture)
+    auto const buffer = renderable.buffer();
+    auto const solid_color = std::dynamic_pointer_cast<mg::SolidColorBuffer>(buffer);
+    auto const texture = std::dynamic_pointer_cast<mg::gl::Texture>(buffer);
+    if (!texture && !solid_color)
     {
         mir::log_error("Buffer does not support GL rendering!");
         return;
@@ -418,6 +452,10 @@ void mrg::Renderer::draw(mg::Renderable const& renderable) const
     auto const& prog =
         [this, &texture](bool alpha) -> Program const&
         {
+                if (!texture)
+                {
+                    return program_factory->fill_program();
+                }
                 auto const& family = static_cast<::Program const&>(texture->shader(*program_factory));
                 if (alpha)
                 {
@@ -454,7 +492,7 @@ void mrg::Renderer::draw(mg::Renderable const& renderable) const
     glUniform2f(prog.centre_uniform, centrex, centrey);
 
     glm::mat4 transform = renderable.transformation();
-    if (texture->layout() == mg::gl::Texture::Layout::TopRowFirst)
+    if (texture && texture->layout() == mg::gl::Texture::Layout::TopRowFirst)
     {
         // GL textures have (0,0) at bottom-left rather than top-left
         // We have to invert this texture to get it the way up GL expects.
@@ -472,8 +510,15 @@ void mrg::Renderer::draw(mg::Renderable const& renderable) const
     if (prog.alpha_uniform >= 0)
         glUniform1f(prog.alpha_uniform, renderable.alpha());
 
+    if (solid_color)
+    {
+        auto const color = solid_color->color() * renderable.alpha();
+        glUniform4f(prog.color_uniform, color.r, color.g, color.b, color.a);
+    }
+
     glEnableVertexAttribArray(prog.position_attr);
-    glEnableVertexAttribArray(prog.texcoord_attr);
+    if (texture)
+        glEnableVertexAttribArray(prog.texcoord_attr);
 
     primitives.clear();
     tessellate(primitives, renderable);
@@ -489,7 +534,16 @@ void mrg::Renderer::draw(mg::Renderable const& renderable) const
         BlendSeparate client_blend;
 
         // These renderable method names could be better (see LP: #1236224)
-        if (renderable.shaped())  // Client is RGBA:
+        if (solid_color)
+        {   // The color is premultiplied, and there's no uninitialized alpha channel to worry about
+            if (solid_color->opaque() && renderable.alpha() == 1.0f)
+                client_blend = {GL_ONE,  GL_ZERO,
+                                GL_ZERO, GL_ONE};
+            else
+                client_blend = {GL_ONE, GL_ONE_MINUS_SRC_ALPHA,
+                                GL_ONE, GL_ONE_MINUS_SRC_ALPHA};
+        }
+        else if (renderable.shaped())  // Client is RGBA:
         {
             client_blend = {GL_ONE, GL_ONE_MINUS_SRC_ALPHA,
                             GL_ONE, GL_ONE_MINUS_SRC_ALPHA};
@@ -513,14 +567,17 @@ void mrg::Renderer::draw(mg::Renderable const& renderable) const
             BlendSeparate blend;
 
             blend = client_blend;
-            texture->bind();
 
             glVertexAttribPointer(prog.position_attr, 3, GL_FLOAT,
                                   GL_FALSE, sizeof(mgl::Vertex),
                                   &p.vertices[0].position);
-            glVertexAttribPointer(prog.texcoord_attr, 2, GL_FLOAT,
-                                  GL_FALSE, sizeof(mgl::Vertex),
-                                  &p.vertices[0].texcoord);
+            if (texture)
+            {
+                texture->bind();
+                glVertexAttribPointer(prog.texcoord_attr, 2, GL_FLOAT,
+                                      GL_FALSE, sizeof(mgl::Vertex),
+                                      &p.vertices[0].texcoord);
+            }
 
             if (blend.dst_rgb == GL_ZERO)
             {
@@ -536,7 +593,8 @@ void mrg::Renderer::draw(mg::Renderable const& renderable) const
             glDrawArrays(p.type, 0, p.nvertices);
 
             // We're done with the texture for now
-            texture->add_syncpoint();
+            if (texture)
+                texture->add_syncpoint();
         }
     }
     catch (std::exception const& ex)
@@ -544,7 +602,8 @@ void mrg::Renderer::draw(mg::Renderable const& renderable) const
         report_exception();
     }
 
-    glDisableVertexAttribArray(prog.texcoord_attr);
+    if (texture)
+        glDisableVertexAttribArray(prog.texcoord_attr);
     glDisableVertexAttribArray(prog.position_attr);
     if (renderable.clip_area())
     {
@@ -16,20 +16,35 @@
 
 #include "basic_screen_shooter.h"
 #include "mir/renderer/gl/buffer_render_target.h"
+#include "mir/renderer/sw/pixel_source.h"
 #include "mir/renderer/renderer.h"
 #include "mir/renderer/gl/context.h"
 #include "mir/compositor/scene_element.h"
 #include "mir/compositor/scene.h"
+#include "mir/scene/scene_change_notification.h"
 #include "mir/log.h"
 #include "mir/executor.h"
 
 namespace mc = mir::compositor;
+namespace ms = mir::scene;
 namespace mr = mir::renderer;
 namespace mg = mir::graphics;
 namespace mrg = mir::renderer::gl;
 namespace mrs = mir::renderer::software;
 namespace geom = mir::geometry;
 
+namespace
+{
+void log_capture_failure()
+{
+    mir::log(
+        ::mir::logging::Severity::error,
+        "BasicScreenShooter",
+        std::current_exception(),
+        "failed to capture screen");
+}
+}
+
 mc::BasicScreenShooter::Self::Self(
     std::shared_ptr<Scene> const& scene,
     std::shared_ptr<time::Clock> const& clock,
@@ -44,31 +59,66 @@ mc::BasicScreenShooter::Self::Self(
 
 auto mc::BasicScreenShooter::Self::render(
     std::shared_ptr<mrs::WriteMappableBuffer> const& buffer,
-    geom::Rectangle const& area) -> time::Timestamp
+    geom::Rectangle const& area,
+    std::optional<geom::Rectangle> const& damage) -> Capture
 {
     std::lock_guard lock{mutex};
 
-    auto scene_elements = scene->scene_elements_for(this);
-    auto const captured_time = clock->now();
-    mg::RenderableList renderable_list;
-    renderable_list.reserve(scene_elements.size());
-    for (auto const& element : scene_elements)
-    {
-        renderable_list.push_back(element->renderable());
-    }
-    scene_elements.clear();
+    // Read before looking at the scene, so a change while rendering makes the next capture render again
+    auto const generation = scene_generation.load();
 
     render_target->make_current();
     render_target->set_buffer(buffer);
+    if (damage)
+    {
+        render_target->set_damage(damage.value());
+    }
 
-    render_target->bind();
-    renderer->set_viewport(area);
-    renderer->render(renderable_list);
+    time::Timestamp captured_time;
+    if (last_frame &&
+        last_frame->area == area &&
+        last_frame->size == buffer->size() &&
+        last_frame->scene_generation == generation)
+    {
+        // Nothing has changed since the last capture, so the frame it rendered can be copied out again
+        captured_time = last_frame->captured_time;
+        render_target->swap_buffers();
+    }
+    else
+    {
+        last_frame.reset();
+
+        auto scene_elements = scene->scene_elements_for(this);
+        captured_time = clock->now();
+        mg::RenderableList renderable_list;
+        renderable_list.reserve(scene_elements.size());
+        for (auto const& element : scene_elements)
+        {
+            renderable_list.push_back(element->renderable());
+        }
+        scene_elements.clear();
+
+        render_target->bind();
+        renderer->set_viewport(area);
+        renderer->render(renderable_list);
+        renderable_list.clear();
 
+        last_frame = LastFrame{area, buffer->size(), generation, captured_time};
+    }
+
+    auto pending_copy = render_target->take_pending_copy();
     render_target->release_current();
-    renderable_list.clear();
 
-    return captured_time;
+    return {captured_time, std::move(pending_copy)};
+}
+
+void mc::BasicScreenShooter::Self::finish(std::function<void()> const& pending_copy)
+{
+    std::lock_guard lock{mutex};
+
+    render_target->make_current();
+    pending_copy();
+    render_target->release_current();
 }
 
 mc::BasicScreenShooter::BasicScreenShooter(
@@ -78,33 +128,93 @@ mc::BasicScreenShooter::BasicScreenShooter(
     std::unique_ptr<mrg::BufferRenderTarget>&& render_target,
     std::unique_ptr<mr::Renderer>&& renderer)
     : self{std::make_shared<Self>(scene, clock, std::move(render_target), std::move(renderer))},
+      scene_observer{[weak_self=std::weak_ptr<Self>{self}]()
+          {
+              auto const scene_changed = [weak_self]()
+                  {
+                      if (auto const self = weak_self.lock())
+                      {
+                          self->scene_generation++;
+                      }
+                  };
+              return std::make_shared<ms::SceneChangeNotification>(
+                  scene_changed,
+                  [scene_changed](int, geom::Rectangle const&) { scene_changed(); });
+          }()},
       executor{executor}
 {
+    self->scene->add_observer(scene_observer);
+}
+
+mc::BasicScreenShooter::~BasicScreenShooter()
+{
+    self->scene->remove_observer(scene_observer);
 }
 
 void mc::BasicScreenShooter::capture(
     std::shared_ptr<mrs::WriteMappableBuffer> const& buffer,
     geom::Rectangle const& area,
     std::function<void(std::optional<time::Timestamp>)>&& callback)
+{
+    start_capture(buffer, area, std::nullopt, std::move(callback));
+}
+
+void mc::BasicScreenShooter::capture_damage(
+    std::shared_ptr<mrs::WriteMappableBuffer> const& buffer,
+    geom::Rectangle const& area,
+    geom::Rectangle const& damage,
+    std::function<void(std::optional<time::Timestamp>)>&& callback)
+{
+    start_capture(buffer, area, damage, std::move(callback));
+}
+
+void mc::BasicScreenShooter::start_capture(
+    std::shared_ptr<mrs::WriteMappableBuffer> const& buffer,
+    geom::Rectangle const& area,
+    std::optional<geom::Rectangle> const& damage,
+    std::function<void(std::optional<time::Timestamp>)>&& callback)
 {
     // TODO: use an atomic to keep track of number of in-flight captures, and error if it's too many
 
-    executor.spawn([weak_self=std::weak_ptr<Self>{self}, buffer, area, callback=std::move(callback)]
+    executor.spawn(
+        [weak_self=std::weak_ptr<Self>{self}, &executor=executor, buffer, area, damage, callback=std::move(callback)]
+        () mutable
         {
             if (auto const self = weak_self.lock())
             {
                 try
                 {
-                    callback(self->render(buffer, area));
+                    auto capture = self->render(buffer, area, damage);
+                    if (!capture.pending_copy)
+                    {
+                        callback(capture.captured_time);
+                        return;
+                    }
+
+                    // Leave the GPU to read the frame back while the executor gets on with other work
+                    executor.spawn([weak_self, capture=std::move(capture), callback=std::move(callback)]()
+                        {
+                            if (auto const self = weak_self.lock())
+                            {
+                                try
+                                {
+                                    self->finish(capture.pending_copy);
+                                    callback(capture.captured_time);
+                                    return;
+                                }
+                                catch (...)
+                                {
+                                    log_capture_failure();
+                                }
+                            }
+
+                            callback(std::nullopt);
+                        });
                     return;
                 }
                 catch (...)
                 {
-                    mir::log(
-                        ::mir::logging::Severity::error,
-                        "BasicScreenShooter",
-                        std::current_exception(),
-                        "failed to capture screen");
+                    log_capture_failure();
                 }
             }
 
@@ -20,6 +20,7 @@
 #include "mir/compositor/screen_shooter.h"
 #include "mir/time/clock.h"
 
+#include <atomic>
 #include <mutex>
 
 namespace mir
@@ -33,6 +34,10 @@ namespace gl
 class BufferRenderTarget;
 }
 }
+namespace scene
+{
+class Observer;
+}
 namespace compositor
 {
 class Scene;
@@ -46,12 +51,19 @@ public:
         Executor& executor,
         std::unique_ptr<renderer::gl::BufferRenderTarget>&& render_target,
         std::unique_ptr<renderer::Renderer>&& renderer);
+    ~BasicScreenShooter();
 
     void capture(
         std::shared_ptr<renderer::software::WriteMappableBuffer> const& buffer,
         geometry::Rectangle const& area,
         std::function<void(std::optional<time::Timestamp>)>&& callback) override;
 
+    void capture_damage(
+        std::shared_ptr<renderer::software::WriteMappableBuffer> const& buffer,
+        geometry::Rectangle const& area,
+        geometry::Rectangle const& damage,
+        std::function<void(std::optional<time::Timestamp>)>&& callback) override;
+
 private:
     struct Self
     {
@@ -61,17 +73,45 @@ private:
             std::unique_ptr<renderer::gl::BufferRenderTarget>&& render_target,
             std::unique_ptr<renderer::Renderer>&& renderer);
 
+        struct Capture
+        {
+            time::Timestamp captured_time;
+            std::function<void()> pending_copy;     ///< Empty if the buffer has already been written
+        };
+
         auto render(
             std::shared_ptr<renderer::software::WriteMappableBuffer> const& buffer,
-            geometry::Rectangle const& area) -> time::Timestamp;
+            geometry::Rectangle const& area,
+            std::optional<geometry::Rectangle> const& damage) -> Capture;
+
+        void finish(std::function<void()> const& pending_copy);
+
+        /// The frame left in the render target by the last render()
+        struct LastFrame
+        {
+            geometry::Rectangle area;
+            geometry::Size size;
+            uint64_t scene_generation;
+            time::Timestamp captured_time;
+        };
 
         std::mutex mutex;
         std::shared_ptr<Scene> const scene;
         std::unique_ptr<renderer::gl::BufferRenderTarget> const render_target;
         std::unique_ptr<renderer::Renderer> const renderer;
         std::shared_ptr<time::Clock> const clock;
+        std::optional<LastFrame> last_frame;
+        std::atomic<uint64_t> scene_generation{0};  ///< Bumped whenever the scene changes
     };
+
+    void start_capture(
+        std::shared_ptr<renderer::software::WriteMappableBuffer> const& buffer,
+        geometry::Rectangle const& area,
+        std::optional<geometry::Rectangle> const& damage,
+        std::function<void(std::optional<time::Timestamp>)>&& callback);
+
     std::shared_ptr<Self> const self;
+    std::shared_ptr<scene::Observer> const scene_observer;
     Executor& executor;
 };
 }
@@ -20,6 +20,7 @@
 #include "mir/compositor/scene_element.h"
 #include "mir/graphics/renderable.h"
 #include "mir/graphics/display_buffer.h"
+#include "mir/graphics/overlay_planes.h"
 #include "mir/graphics/buffer.h"
 #include "mir/renderer/renderer.h"
 #include "occlusion.h"
@@ -32,6 +33,7 @@ mc::DefaultDisplayBufferCompositor::DefaultDisplayBufferCompositor(
     std::shared_ptr<mir::renderer::Renderer> const& renderer,
     std::shared_ptr<mc::CompositorReport> const& report) :
     display_buffer(display_buffer),
+    overlay_planes(dynamic_cast<mg::OverlayPlanes*>(display_buffer.native_display_buffer())),
     renderer(renderer),
     report(report)
 {
@@ -72,9 +74,14 @@ void mc::DefaultDisplayBufferCompositor::composite(mc::SceneElementSequence&& sc
     }
     else
     {
+        // Anything the hardware scans out on its own planes needn't be rendered
+        auto to_render = overlay_planes ?
+            overlay_planes->assign_planes(renderable_list) :
+            renderable_list;
+
         renderer->set_output_transform(display_buffer.transformation());
         renderer->set_viewport(view_area);
-        renderer->render(renderable_list);
+        renderer->render(to_render);
 
         report->renderables_in_frame(this, renderable_list);
         report->rendered_frame(this);
@@ -91,6 +98,7 @@ void mc::DefaultDisplayBufferCompositor::composite(mc::SceneElementSequence&& sc
          *        acquisition calls when we composite the next frame.
          */
         renderable_list.clear();
+        to_render.clear();
     }
 
     report->finished_frame(this);
@@ -26,6 +26,7 @@ namespace mir
 namespace graphics
 {
 class DisplayBuffer;
+class OverlayPlanes;
 }
 namespace renderer
 {
@@ -48,6 +49,7 @@ public:
 
 private:
     graphics::DisplayBuffer& display_buffer;
+    graphics::OverlayPlanes* const overlay_planes;
     std::shared_ptr<renderer::Renderer> const renderer;
     std::shared_ptr<CompositorReport> const report;
 };
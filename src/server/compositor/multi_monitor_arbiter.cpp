@@ -20,6 +20,8 @@
 #include "schedule.h"
 #include <boost/throw_exception.hpp>
 
+#include <algorithm>
+
 namespace mg = mir::graphics;
 namespace mc = mir::compositor;
 namespace mf = mir::frontend;
@@ -29,7 +31,7 @@ mc::MultiMonitorArbiter::MultiMonitorArbiter(
     schedule(schedule)
 {
     // We're highly unlikely to have more than 6 outputs
-    current_buffer_users.reserve(6);
+    latches.reserve(6);
 }
 
 mc::MultiMonitorArbiter::~MultiMonitorArbiter()
@@ -40,15 +42,16 @@ std::shared_ptr<mg::Buffer> mc::MultiMonitorArbiter::compositor_acquire(composit
 {
     std::lock_guard lk(mutex);
 
-    // If there is no current buffer or there is, but this compositor is already using it...
-    if (!current_buffer || is_user_of_current_buffer(id))
+    // If there is no current buffer or there is, but this compositor has already latched it...
+    if (!current_buffer || has_latched_current_buffer(id))
     {
         // And if there is a scheduled buffer
         if (schedule->num_scheduled() > 0)
         {
-            // Advance the current buffer
-            current_buffer = schedule->next_buffer();
-            clear_current_users();
+            // Advance the current buffer. Compositors that have not latched the old one yet get this one instead, so
+            // whichever compositor runs fastest sets the pace and slower ones skip to the newest frame it has shown.
+            // (Giving them a newer frame still would show different frames on outputs that the surface spans.)
+            advance_current_buffer();
         }
         // Otherwise leave the current buffer alone
     }
@@ -57,9 +60,9 @@ std::shared_ptr<mg::Buffer> mc::MultiMonitorArbiter::compositor_acquire(composit
     if (!current_buffer)
         BOOST_THROW_EXCEPTION(std::logic_error("no buffer to give to compositor"));
 
-    // The compositor is now a user of the current buffer
+    // The compositor has now latched the current buffer
     // This means we will try to give it a new buffer next time it asks
-    add_current_buffer_user(id);
+    latch_current_buffer(id);
     return current_buffer;
 }
 
@@ -71,8 +74,7 @@ std::shared_ptr<mg::Buffer> mc::MultiMonitorArbiter::snapshot_acquire()
     {
         if (schedule->num_scheduled() > 0)
         {
-            current_buffer = schedule->next_buffer();
-            clear_current_users();
+            advance_current_buffer();
         }
         else
         {
@@ -95,10 +97,10 @@ bool mc::MultiMonitorArbiter::buffer_ready_for(mc::CompositorID id)
     // If there are scheduled buffers then there is one ready for any compositor
     if (schedule->num_scheduled() > 0)
         return true;
-    // If we have a current buffer that the compositor isn't yet using, it is ready
-    else if (current_buffer && !is_user_of_current_buffer(id))
+    // If we have a current buffer that the compositor hasn't latched yet, it is ready
+    else if (current_buffer && !has_latched_current_buffer(id))
         return true;
-    // There are no scheduled buffers and either no current buffer, or a current buffer already used by this compositor
+    // There are no scheduled buffers and either no current buffer, or a current buffer already latched by this compositor
     else
         return false;
 }
@@ -108,49 +110,52 @@ void mc::MultiMonitorArbiter::advance_schedule()
     std::lock_guard lk(mutex);
     if (schedule->num_scheduled() > 0)
     {
-        current_buffer = schedule->next_buffer();
-        clear_current_users();
-    } 
+        advance_current_buffer();
+    }
+}
+
+void mc::MultiMonitorArbiter::advance_current_buffer()
+{
+    // The compositors that are still using the old buffer hold their own references to it
+    current_buffer = schedule->next_buffer();
+    ++current_frame;
 }
 
-void mc::MultiMonitorArbiter::add_current_buffer_user(mc::CompositorID id)
+void mc::MultiMonitorArbiter::latch_current_buffer(mc::CompositorID id)
 {
-    // First try and find an empty slot in our vector…
-    for (auto& slot : current_buffer_users)
+    // Reuse this compositor's latch, or that of any compositor that hasn't kept up (so may have gone away)…
+    Latch* reusable{nullptr};
+    for (auto& latch : latches)
     {
-        if (slot == id)
+        if (latch.id == id)
         {
+            latch.frame = current_frame;
             return;
         }
-        else if (!slot)
+        else if (!reusable && latch.frame != current_frame)
         {
-            slot = id;
-            return;
+            reusable = &latch;
         }
     }
-    //…no empty slot, so we'll need to grow the vector.
-    current_buffer_users.push_back({id});
+
+    if (reusable)
+    {
+        *reusable = {id, current_frame};
+    }
+    else
+    {
+        //…no reusable latch, so we'll need to grow the vector.
+        latches.push_back({id, current_frame});
+    }
 }
 
-bool mc::MultiMonitorArbiter::is_user_of_current_buffer(mir::compositor::CompositorID id)
+bool mc::MultiMonitorArbiter::has_latched_current_buffer(mc::CompositorID id) const
 {
     return std::any_of(
-        current_buffer_users.begin(),
-        current_buffer_users.end(),
-        [id](auto const& slot)
+        latches.begin(),
+        latches.end(),
+        [this, id](auto const& latch)
         {
-            if (slot)
-            {
-                return *slot == id;
-            }
-            return false;
+            return latch.id == id && latch.frame == current_frame;
         });
 }
-
-void mc::MultiMonitorArbiter::clear_current_users()
-{
-    for (auto& slot : current_buffer_users)
-    {
-        slot = {};
-    }
-}
@@ -21,10 +21,10 @@
 #include "mir/compositor/compositor_id.h"
 #include "mir/graphics/buffer_id.h"
 #include "buffer_acquisition.h"
+#include <cstdint>
 #include <memory>
 #include <mutex>
 #include <vector>
-#include <optional>
 
 namespace mir
 {
@@ -47,13 +47,23 @@ public:
     void advance_schedule();
 
 private:
-    void add_current_buffer_user(compositor::CompositorID id);
-    bool is_user_of_current_buffer(compositor::CompositorID id);
-    void clear_current_users();
+    /// The frame a compositor last latched. Compositors only share the buffer, not their progress through the
+    /// schedule, so one compositor latching a frame never holds another back.
+    struct Latch
+    {
+        compositor::CompositorID id;
+        uint64_t frame;
+    };
+
+    void advance_current_buffer();
+    void latch_current_buffer(compositor::CompositorID id);
+    bool has_latched_current_buffer(compositor::CompositorID id) const;
 
     std::mutex mutable mutex;
     std::shared_ptr<graphics::Buffer> current_buffer;
-    std::vector<std::optional<compositor::CompositorID>> current_buffer_users;
+    /// Counts the buffers taken from the schedule, so each compositor can tell whether it has seen the current one
+    uint64_t current_frame{0};
+    std::vector<Latch> latches;
     std::shared_ptr<Schedule> schedule;
 };
 
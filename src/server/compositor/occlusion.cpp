@@ -17,6 +17,7 @@
 #include "mir/geometry/rectangle.h"
 #include "mir/compositor/scene_element.h"
 #include "mir/graphics/renderable.h"
+#include "mir/graphics/solid_color_buffer.h"
 #include "occlusion.h"
 
 #include <vector>
@@ -27,6 +28,18 @@ using namespace mir::compositor;
 
 namespace
 {
+bool renderable_is_opaque(Renderable const& renderable)
+{
+    if (renderable.alpha() != 1.0f)
+        return false;
+
+    // A solid color knows whether it is opaque, whatever the renderable's shape says
+    if (auto const solid_color = std::dynamic_pointer_cast<SolidColorBuffer>(renderable.buffer()))
+        return solid_color->opaque();
+
+    return !renderable.shaped();
+}
+
 bool renderable_is_occluded(
     Renderable const& renderable, 
     Rectangle const& area,
@@ -54,7 +67,7 @@ bool renderable_is_occluded(
         }
     }
 
-    if (!occluded && renderable.alpha() == 1.0f && !renderable.shaped())
+    if (!occluded && renderable_is_opaque(renderable))
         coverage.push_back(clipped_window);
 
     return occluded;
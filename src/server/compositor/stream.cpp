@@ -86,7 +86,19 @@ void mc::Stream::set_frame_posted_callback(
 
 std::shared_ptr<mg::Buffer> mc::Stream::lock_compositor_buffer(void const* id)
 {
-    return arbiter->compositor_acquire(id);
+    auto const buffer = arbiter->compositor_acquire(id);
+
+    std::function<void()> callback;
+    {
+        std::lock_guard lock{callback_mutex};
+        std::swap(callback, repaint_callback);
+    }
+    if (callback)
+    {
+        callback();
+    }
+
+    return buffer;
 }
 
 geom::Size mc::Stream::stream_size()
@@ -164,3 +176,9 @@ void mc::Stream::set_scale(float scale)
     std::lock_guard lk(mutex);
     scale_ = scale;
 }
+
+void mc::Stream::on_next_repaint(std::function<void()> const& callback)
+{
+    std::lock_guard lock{callback_mutex};
+    repaint_callback = callback;
+}
@@ -52,6 +52,7 @@ public:
     void drop_old_buffers() override;
     bool has_submitted_buffer() const override;
     void set_scale(float scale) override;
+    void on_next_repaint(std::function<void()> const& callback) override;
 
 private:
     enum class ScheduleMode;
@@ -68,6 +69,7 @@ private:
 
     std::mutex callback_mutex;
     std::function<void(geometry::Size const&)> frame_callback;
+    std::function<void()> repaint_callback;
 };
 }
 }
@@ -23,6 +23,7 @@
 #include "mir/cookie/authority.h"
 #include "mir/frontend/wayland.h"
 
+#include "mir/logging/async_logger.h"
 #include "mir/logging/dumb_console_logger.h"
 #include "mir/options/program_option.h"
 #include "mir/frontend/session_credentials.h"
@@ -211,8 +212,13 @@ auto mir::DefaultServerConfiguration::the_logger()
     -> std::shared_ptr<ml::Logger>
 {
     return logger(
-        []() -> std::shared_ptr<ml::Logger>
+        [this]() -> std::shared_ptr<ml::Logger>
         {
+            if (the_options()->is_set(options::async_logging_opt))
+            {
+                return std::make_shared<ml::AsyncLogger>(std::make_shared<ml::DumbConsoleLogger>());
+            }
+
             return std::make_shared<ml::DumbConsoleLogger>();
         });
 }
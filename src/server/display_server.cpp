@@ -77,6 +77,7 @@ struct mir::DisplayServer::Private
           compositor{config.the_compositor()},
           wayland_connector{config.the_wayland_connector()},
           xwayland_connector{config.the_xwayland_connector()},
+          rfb_connector{config.the_rfb_connector()},
           input_manager{config.the_input_manager()},
           main_loop{config.the_main_loop()},
           server_status_listener{config.the_server_status_listener()},
@@ -198,6 +199,7 @@ struct mir::DisplayServer::Private
     std::shared_ptr<mc::Compositor> const compositor;
     std::shared_ptr<mf::Connector> const wayland_connector;
     std::shared_ptr<mf::Connector> const xwayland_connector;
+    std::shared_ptr<mf::Connector> const rfb_connector;
     std::shared_ptr<mi::InputManager> const input_manager;
     std::shared_ptr<mir::MainLoop> const main_loop;
     std::shared_ptr<mir::ServerStatusListener> const server_status_listener;
@@ -233,11 +235,13 @@ void mir::DisplayServer::run()
     server.input_dispatcher->start();
     server.wayland_connector->start();
     server.xwayland_connector->start();
+    server.rfb_connector->start();
 
     server.server_status_listener->started();
 
     server.main_loop->run();
 
+    server.rfb_connector->stop();
     server.xwayland_connector->stop();
     server.wayland_connector->stop();
     server.input_dispatcher->stop();
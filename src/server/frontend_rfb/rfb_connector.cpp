@@ -0,0 +1,233 @@
+/*
+ * Copyright © 2022 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "rfb_connector.h"
+#include "rfb_session.h"
+
+#include "mir/dispatch/multiplexing_dispatchable.h"
+#include "mir/dispatch/readable_fd.h"
+#include "mir/dispatch/threaded_dispatcher.h"
+#include "mir/log.h"
+
+#include <boost/throw_exception.hpp>
+
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <system_error>
+
+namespace mf = mir::frontend;
+namespace md = mir::dispatch;
+namespace mi = mir::input;
+
+namespace
+{
+auto is_loopback(sockaddr const* address) -> bool
+{
+    switch (address->sa_family)
+    {
+    case AF_INET:
+        return (ntohl(reinterpret_cast<sockaddr_in const*>(address)->sin_addr.s_addr) >> 24) == IN_LOOPBACKNET;
+
+    case AF_INET6:
+    {
+        auto const& address6 = reinterpret_cast<sockaddr_in6 const*>(address)->sin6_addr;
+        if (IN6_IS_ADDR_V4MAPPED(&address6))
+        {
+            return address6.s6_addr[12] == IN_LOOPBACKNET;
+        }
+        return IN6_IS_ADDR_LOOPBACK(&address6);
+    }
+
+    default:
+        return false;
+    }
+}
+
+auto bind_listening_socket(std::string const& address, int port) -> mir::Fd
+{
+    addrinfo hints{};
+    hints.ai_flags = AI_PASSIVE | AI_NUMERICHOST | AI_NUMERICSERV;
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+
+    addrinfo* addresses;
+    if (auto const error = getaddrinfo(address.c_str(), std::to_string(port).c_str(), &hints, &addresses))
+    {
+        BOOST_THROW_EXCEPTION(std::runtime_error{
+            "Invalid RFB address " + address + ": " + gai_strerror(error)});
+    }
+    std::unique_ptr<addrinfo, void(*)(addrinfo*)> const cleanup{addresses, &freeaddrinfo};
+
+    // Viewers aren't authenticated and can inject input, so only local users (or SSH tunnels) may connect
+    if (!is_loopback(addresses->ai_addr))
+    {
+        BOOST_THROW_EXCEPTION(std::runtime_error{
+            "RFB address " + address + " is not a loopback address. RFB viewers are not authenticated, "
+            "so tunnel them to a loopback address (e.g. with ssh -L) instead"});
+    }
+
+    auto const raw_fd = socket(addresses->ai_family, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+    if (raw_fd < 0)
+    {
+        BOOST_THROW_EXCEPTION((std::system_error{errno, std::system_category(), "Failed to create RFB socket"}));
+    }
+    mir::Fd fd{raw_fd};
+
+    int const reuse{1};
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof reuse);
+
+    if (bind(fd, addresses->ai_addr, addresses->ai_addrlen) < 0)
+    {
+        BOOST_THROW_EXCEPTION((std::system_error{
+            errno, std::system_category(), "Failed to bind RFB socket to " + address + ":" + std::to_string(port)}));
+    }
+
+    return fd;
+}
+}
+
+mf::RfbConnector::RfbConnector(
+    std::string const& address,
+    int port,
+    std::shared_ptr<RfbFrameSource> const& frames,
+    std::shared_ptr<mi::InputDeviceRegistry> const& device_registry,
+    Executor& executor)
+    : listen_socket{bind_listening_socket(address, port)},
+      frames{frames},
+      device_registry{device_registry},
+      executor{executor}
+{
+}
+
+mf::RfbConnector::~RfbConnector()
+{
+    stop();
+}
+
+void mf::RfbConnector::start()
+{
+    std::lock_guard lock{mutex};
+    if (accept_thread)
+    {
+        return;
+    }
+
+    if (listen(listen_socket, SOMAXCONN) < 0)
+    {
+        BOOST_THROW_EXCEPTION((std::system_error{errno, std::system_category(), "Failed to listen on RFB socket"}));
+    }
+
+    auto const dispatcher = std::make_shared<md::MultiplexingDispatchable>();
+    dispatcher->add_watch(std::make_shared<md::ReadableFd>(listen_socket, [this]() { accept_viewer(); }));
+    accept_thread = std::make_unique<md::ThreadedDispatcher>("Mir/RFB accept", dispatcher);
+
+    log_info("Serving RFB viewers on port %d", port());
+    log_warning(
+        "RFB viewers are not authenticated: any local user can connect to port %d to see the screen and send input",
+        port());
+}
+
+void mf::RfbConnector::stop()
+{
+    std::unique_ptr<md::ThreadedDispatcher> stopping_thread;
+    std::vector<std::unique_ptr<RfbSession>> stopping_sessions;
+    {
+        std::lock_guard lock{mutex};
+        stopping_thread = std::move(accept_thread);
+    }
+    // Join the accept thread before taking the sessions, so no more can be added
+    stopping_thread.reset();
+    {
+        std::lock_guard lock{mutex};
+        stopping_sessions = std::move(sessions);
+        sessions.clear();
+    }
+}
+
+int mf::RfbConnector::client_socket_fd() const
+{
+    return -1;
+}
+
+int mf::RfbConnector::client_socket_fd(
+    std::function<void(std::shared_ptr<scene::Session> const& session)> const& /*connect_handler*/) const
+{
+    return -1;
+}
+
+auto mf::RfbConnector::socket_name() const -> optional_value<std::string>
+{
+    return {};
+}
+
+auto mf::RfbConnector::port() const -> int
+{
+    sockaddr_storage address{};
+    socklen_t length{sizeof address};
+    if (getsockname(listen_socket, reinterpret_cast<sockaddr*>(&address), &length) < 0)
+    {
+        BOOST_THROW_EXCEPTION((std::system_error{errno, std::system_category(), "Failed to get RFB socket address"}));
+    }
+
+    return ntohs(address.ss_family == AF_INET6 ?
+        reinterpret_cast<sockaddr_in6 const&>(address).sin6_port :
+        reinterpret_cast<sockaddr_in const&>(address).sin_port);
+}
+
+void mf::RfbConnector::accept_viewer()
+{
+    auto const viewer_fd = accept4(listen_socket, nullptr, nullptr, SOCK_CLOEXEC);
+    if (viewer_fd < 0)
+    {
+        if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+        {
+            log_warning("Failed to accept RFB viewer: %s", strerror(errno));
+        }
+        return;
+    }
+    Fd viewer{viewer_fd};
+
+    // Updates are written whole, so don't hold back the last segment of each
+    int const no_delay{1};
+    setsockopt(viewer, IPPROTO_TCP, TCP_NODELAY, &no_delay, sizeof no_delay);
+
+    std::vector<std::unique_ptr<RfbSession>> finished;
+    {
+        std::lock_guard lock{mutex};
+        auto const first_finished = std::stable_partition(
+            sessions.begin(),
+            sessions.end(),
+            [](auto const& session) { return !session->finished(); });
+        std::move(first_finished, sessions.end(), std::back_inserter(finished));
+        sessions.erase(first_finished, sessions.end());
+
+        try
+        {
+            sessions.push_back(std::make_unique<RfbSession>(std::move(viewer), frames, device_registry, executor));
+        }
+        catch (std::exception const&)
+        {
+            log(logging::Severity::warning, MIR_LOG_COMPONENT, std::current_exception(), "Failed to start RFB session");
+        }
+    }
+}
@@ -0,0 +1,91 @@
+/*
+ * Copyright © 2022 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_FRONTEND_RFB_CONNECTOR_H_
+#define MIR_FRONTEND_RFB_CONNECTOR_H_
+
+#include "mir/frontend/connector.h"
+#include "mir/fd.h"
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace mir
+{
+class Executor;
+namespace dispatch
+{
+class ThreadedDispatcher;
+}
+namespace input
+{
+class InputDeviceRegistry;
+}
+namespace frontend
+{
+class RfbFrameSource;
+class RfbSession;
+
+/// Accepts RFB (VNC) viewers on a TCP socket. Viewers are not Mir clients, so there is no client socket.
+class RfbConnector : public Connector
+{
+public:
+    /**
+     * Binds the listening socket, but only accepts viewers once started.
+     *
+     * Viewers are not authenticated, so \a address has to be a loopback address.
+     *
+     * \param port  The TCP port to listen on, or 0 for any free port
+     * \throws std::runtime_error if \a address is not a loopback address
+     * \throws std::system_error if the socket cannot be bound
+     */
+    RfbConnector(
+        std::string const& address,
+        int port,
+        std::shared_ptr<RfbFrameSource> const& frames,
+        std::shared_ptr<input::InputDeviceRegistry> const& device_registry,
+        Executor& executor);
+    ~RfbConnector();
+
+    void start() override;
+    void stop() override;
+
+    int client_socket_fd() const override;
+    int client_socket_fd(
+        std::function<void(std::shared_ptr<scene::Session> const& session)> const& connect_handler) const override;
+
+    auto socket_name() const -> optional_value<std::string> override;
+
+    /// The TCP port being listened on
+    auto port() const -> int;
+
+private:
+    void accept_viewer();
+
+    Fd const listen_socket;
+    std::shared_ptr<RfbFrameSource> const frames;
+    std::shared_ptr<input::InputDeviceRegistry> const device_registry;
+    Executor& executor;
+
+    std::mutex mutex;
+    std::unique_ptr<dispatch::ThreadedDispatcher> accept_thread;
+    std::vector<std::unique_ptr<RfbSession>> sessions;
+};
+}
+}
+
+#endif // MIR_FRONTEND_RFB_CONNECTOR_H_
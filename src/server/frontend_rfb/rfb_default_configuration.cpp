@@ -0,0 +1,75 @@
+/*
+ * Copyright © 2022 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/default_server_configuration.h"
+#include "mir/executor.h"
+#include "mir/fatal.h"
+#include "mir/frontend/null_connector.h"
+#include "mir/geometry/rectangles.h"
+#include "mir/graphics/display.h"
+#include "mir/graphics/display_configuration.h"
+#include "mir/options/default_configuration.h"
+#include "rfb_connector.h"
+#include "rfb_frame_source.h"
+
+namespace mf = mir::frontend;
+namespace mg = mir::graphics;
+namespace mo = mir::options;
+namespace geom = mir::geometry;
+
+std::shared_ptr<mf::Connector> mir::DefaultServerConfiguration::the_rfb_connector()
+{
+    return rfb_connector([this]() -> std::shared_ptr<mf::Connector>
+        {
+            auto const options = the_options();
+            if (!options->is_set(mo::rfb_port_opt))
+            {
+                return std::make_shared<mf::NullConnector>();
+            }
+
+            // Viewers see the bounding box of the outputs in use
+            auto output_area = [display=the_display()]()
+                {
+                    geom::Rectangles outputs;
+                    display->configuration()->for_each_output([&](mg::DisplayConfigurationOutput const& output)
+                        {
+                            if (output.used)
+                            {
+                                outputs.add(output.extents());
+                            }
+                        });
+                    return outputs.bounding_rectangle();
+                };
+
+            auto const address = options->get<std::string>(mo::rfb_address_opt);
+            auto const port = options->get<int>(mo::rfb_port_opt);
+            try
+            {
+                return std::make_shared<mf::RfbConnector>(
+                    address,
+                    port,
+                    std::make_shared<mf::RfbFrameSource>(the_scene(), the_screen_shooter(), std::move(output_area)),
+                    the_input_device_registry(),
+                    thread_pool_executor);
+            }
+            catch (std::exception const& x)
+            {
+                mir::fatal_error("Failed to start RfbConnector on %s:%d: %s", address.c_str(), port, x.what());
+            }
+
+            return std::make_shared<mf::NullConnector>();
+        });
+}
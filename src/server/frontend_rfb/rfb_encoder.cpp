@@ -0,0 +1,451 @@
+/*
+ * Copyright © 2022 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "rfb_encoder.h"
+#include "rfb_framebuffer.h"
+
+#include "mir/executor.h"
+
+#include <boost/throw_exception.hpp>
+#include <zlib.h>
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <exception>
+#include <latch>
+#include <stdexcept>
+#include <string>
+
+namespace mf = mir::frontend;
+namespace geom = mir::geometry;
+
+namespace
+{
+/// Tight sends data shorter than this uncompressed
+size_t constexpr tight_min_to_compress{12};
+
+uint32_t constexpr colour_mask{0x00ffffff};
+
+void put16(std::vector<uint8_t>& out, uint16_t value)
+{
+    out.push_back(value >> 8);
+    out.push_back(value & 0xff);
+}
+
+void put32(std::vector<uint8_t>& out, uint32_t value)
+{
+    put16(out, value >> 16);
+    put16(out, value & 0xffff);
+}
+
+void put_rect_header(std::vector<uint8_t>& out, geom::Rectangle const& rect, int32_t encoding)
+{
+    put16(out, rect.top_left.x.as_int());
+    put16(out, rect.top_left.y.as_int());
+    put16(out, rect.size.width.as_int());
+    put16(out, rect.size.height.as_int());
+    put32(out, static_cast<uint32_t>(encoding));
+}
+
+/// Tight's variable length encoding of data lengths: 7 bits per byte, in up to three bytes
+void put_compact_length(std::vector<uint8_t>& out, size_t length)
+{
+    out.push_back((length & 0x7f) | (length > 0x7f ? 0x80 : 0));
+    if (length > 0x7f)
+    {
+        out.push_back(((length >> 7) & 0x7f) | (length > 0x3fff ? 0x80 : 0));
+        if (length > 0x3fff)
+        {
+            out.push_back((length >> 14) & 0xff);
+        }
+    }
+}
+
+auto scale(uint32_t channel, uint16_t max) -> uint32_t
+{
+    return (channel * max + 127) / 255;
+}
+
+auto is_uniform(mf::RfbFramebuffer const& frame, geom::Rectangle const& rect) -> bool
+{
+    auto const first = frame.row(rect.top().as_int())[rect.left().as_int()] & colour_mask;
+    for (auto y = rect.top().as_int(); y != rect.bottom().as_int(); ++y)
+    {
+        auto const row = frame.row(y) + rect.left().as_int();
+        for (auto x = 0; x != rect.size.width.as_int(); ++x)
+        {
+            if ((row[x] & colour_mask) != first)
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+}
+
+class mf::RfbEncoder::DeflateStream
+{
+public:
+    DeflateStream() = default;
+
+    ~DeflateStream()
+    {
+        if (initialised)
+        {
+            deflateEnd(&stream);
+        }
+    }
+
+    /// Append \a size bytes of \a data to \a out, compressed and flushed to a byte boundary
+    void compress(uint8_t const* data, size_t size, int level, std::vector<uint8_t>& out)
+    {
+        if (!initialised)
+        {
+            if (deflateInit(&stream, level) != Z_OK)
+            {
+                BOOST_THROW_EXCEPTION(std::runtime_error{"Failed to initialise zlib stream"});
+            }
+            initialised = true;
+            current_level = level;
+        }
+        else if (level != current_level)
+        {
+            // The previous call flushed the stream, so the new level applies from here
+            if (deflateParams(&stream, level, Z_DEFAULT_STRATEGY) != Z_OK)
+            {
+                BOOST_THROW_EXCEPTION(std::runtime_error{"Failed to change zlib compression level"});
+            }
+            current_level = level;
+        }
+
+        stream.next_in = const_cast<Bytef*>(data);
+        stream.avail_in = size;
+
+        auto written = out.size();
+        do
+        {
+            out.resize(written + deflateBound(&stream, stream.avail_in) + 16);
+            stream.next_out = out.data() + written;
+            stream.avail_out = out.size() - written;
+            if (deflate(&stream, Z_SYNC_FLUSH) == Z_STREAM_ERROR)
+            {
+                BOOST_THROW_EXCEPTION(std::runtime_error{"Failed to compress RFB update"});
+            }
+            written = out.size() - stream.avail_out;
+        }
+        while (stream.avail_out == 0);
+        out.resize(written);
+    }
+
+private:
+    DeflateStream(DeflateStream const&) = delete;
+    DeflateStream& operator=(DeflateStream const&) = delete;
+
+    z_stream stream{};
+    bool initialised{false};
+    int current_level{Z_DEFAULT_COMPRESSION};
+};
+
+auto mf::RfbPixelFormat::tight_compact() const -> bool
+{
+    return bits_per_pixel == 32 && depth == 24 && red_max == 255 && green_max == 255 && blue_max == 255;
+}
+
+mf::RfbEncoder::RfbEncoder(Executor& executor)
+    : executor{executor},
+      compress_level{Z_DEFAULT_COMPRESSION},
+      zlib_stream{std::make_unique<DeflateStream>()},
+      tight_streams{
+          std::make_unique<DeflateStream>(),
+          std::make_unique<DeflateStream>(),
+          std::make_unique<DeflateStream>(),
+          std::make_unique<DeflateStream>()}
+{
+}
+
+mf::RfbEncoder::~RfbEncoder() = default;
+
+void mf::RfbEncoder::set_pixel_format(RfbPixelFormat const& new_format)
+{
+    if (!new_format.true_colour)
+    {
+        BOOST_THROW_EXCEPTION(std::invalid_argument{"Colour map pixel formats are not supported"});
+    }
+
+    switch (new_format.bits_per_pixel)
+    {
+    case 8:
+    case 16:
+    case 32:
+        break;
+
+    default:
+        BOOST_THROW_EXCEPTION(std::invalid_argument{
+            "Unsupported bits per pixel: " + std::to_string(new_format.bits_per_pixel)});
+    }
+
+    // Each channel has to fit in the pixel, or convert() would shift it past the top
+    auto const check_channel = [&](char const* name, uint16_t max, uint8_t shift)
+        {
+            if (max == 0 || shift + std::bit_width(max) > new_format.bits_per_pixel)
+            {
+                BOOST_THROW_EXCEPTION(std::invalid_argument{
+                    std::string{"Unsupported "} + name + " channel: max " + std::to_string(max) +
+                    ", shift " + std::to_string(shift)});
+            }
+        };
+    check_channel("red", new_format.red_max, new_format.red_shift);
+    check_channel("green", new_format.green_max, new_format.green_shift);
+    check_channel("blue", new_format.blue_max, new_format.blue_shift);
+
+    format = new_format;
+}
+
+void mf::RfbEncoder::set_encodings(std::vector<int32_t> const& encodings)
+{
+    encoding_ = rfb_encoding::raw;
+    desktop_size = false;
+    compress_level = Z_DEFAULT_COMPRESSION;
+
+    bool chosen{false};
+    for (auto const encoding : encodings)
+    {
+        switch (encoding)
+        {
+        case rfb_encoding::raw:
+        case rfb_encoding::zlib:
+        case rfb_encoding::tight:
+            if (!chosen)
+            {
+                encoding_ = encoding;
+                chosen = true;
+            }
+            break;
+
+        case rfb_encoding::desktop_size:
+            desktop_size = true;
+            break;
+
+        default:
+            if (rfb_encoding::compress_level_0 <= encoding && encoding <= rfb_encoding::compress_level_9)
+            {
+                compress_level = encoding - rfb_encoding::compress_level_0;
+            }
+            break;
+        }
+    }
+}
+
+void mf::RfbEncoder::encode(
+    RfbFramebuffer const& frame,
+    std::vector<geom::Rectangle> const& rects,
+    std::vector<uint8_t>& out)
+{
+    switch (encoding_)
+    {
+    case rfb_encoding::tight:
+    {
+        // Each stream's rectangles must be compressed in order, but the streams are independent
+        auto const stream_count = std::min(rects.size(), tight_streams.size());
+        if (stream_count <= 1)
+        {
+            for (auto const& rect : rects)
+            {
+                encode_tight(frame, rect, 0, out);
+            }
+            break;
+        }
+
+        std::vector<std::vector<uint8_t>> encoded(rects.size());
+        std::array<std::exception_ptr, 4> errors;
+        std::latch done{static_cast<std::ptrdiff_t>(stream_count)};
+        for (auto stream = 0u; stream != stream_count; ++stream)
+        {
+            executor.spawn([&, stream]()
+                {
+                    try
+                    {
+                        for (auto i = stream; i < rects.size(); i += stream_count)
+                        {
+                            encode_tight(frame, rects[i], stream, encoded[i]);
+                        }
+                    }
+                    catch (...)
+                    {
+                        errors[stream] = std::current_exception();
+                    }
+                    done.count_down();
+                });
+        }
+        done.wait();
+
+        for (auto const& error : errors)
+        {
+            if (error)
+            {
+                std::rethrow_exception(error);
+            }
+        }
+        for (auto const& data : encoded)
+        {
+            out.insert(out.end(), data.begin(), data.end());
+        }
+        break;
+    }
+
+    case rfb_encoding::zlib:
+        for (auto const& rect : rects)
+        {
+            encode_zlib(frame, rect, out);
+        }
+        break;
+
+    default:
+        for (auto const& rect : rects)
+        {
+            encode_raw(frame, rect, out);
+        }
+        break;
+    }
+}
+
+void mf::RfbEncoder::encode_desktop_size(geom::Size const& size, std::vector<uint8_t>& out)
+{
+    put_rect_header(out, {{}, size}, rfb_encoding::desktop_size);
+}
+
+void mf::RfbEncoder::convert(uint32_t const* pixels, int count, bool compact, uint8_t* out) const
+{
+    if (compact)
+    {
+        for (auto i = 0; i != count; ++i)
+        {
+            *out++ = pixels[i] >> 16;
+            *out++ = pixels[i] >> 8;
+            *out++ = pixels[i];
+        }
+        return;
+    }
+
+    bool const native =
+        format.bits_per_pixel == 32 && format.big_endian == (std::endian::native == std::endian::big) &&
+        format.red_max == 255 && format.green_max == 255 && format.blue_max == 255 &&
+        format.red_shift == 16 && format.green_shift == 8 && format.blue_shift == 0;
+    if (native)
+    {
+        memcpy(out, pixels, count * sizeof(uint32_t));
+        return;
+    }
+
+    auto const bytes = format.bytes_per_pixel();
+    for (auto i = 0; i != count; ++i)
+    {
+        auto const value =
+            scale((pixels[i] >> 16) & 0xff, format.red_max) << format.red_shift |
+            scale((pixels[i] >> 8) & 0xff, format.green_max) << format.green_shift |
+            scale(pixels[i] & 0xff, format.blue_max) << format.blue_shift;
+
+        for (auto b = 0u; b != bytes; ++b)
+        {
+            auto const shift = 8 * (format.big_endian ? bytes - 1 - b : b);
+            *out++ = value >> shift;
+        }
+    }
+}
+
+void mf::RfbEncoder::encode_raw(RfbFramebuffer const& frame, geom::Rectangle const& rect, std::vector<uint8_t>& out) const
+{
+    put_rect_header(out, rect, rfb_encoding::raw);
+
+    auto const width = rect.size.width.as_int();
+    auto const row_bytes = width * format.bytes_per_pixel();
+    auto offset = out.size();
+    out.resize(offset + row_bytes * rect.size.height.as_int());
+    for (auto y = rect.top().as_int(); y != rect.bottom().as_int(); ++y, offset += row_bytes)
+    {
+        convert(frame.row(y) + rect.left().as_int(), width, false, out.data() + offset);
+    }
+}
+
+void mf::RfbEncoder::encode_zlib(RfbFramebuffer const& frame, geom::Rectangle const& rect, std::vector<uint8_t>& out)
+{
+    put_rect_header(out, rect, rfb_encoding::zlib);
+
+    auto const width = rect.size.width.as_int();
+    auto const row_bytes = width * format.bytes_per_pixel();
+    std::vector<uint8_t> pixels(row_bytes * rect.size.height.as_int());
+    auto offset = 0u;
+    for (auto y = rect.top().as_int(); y != rect.bottom().as_int(); ++y, offset += row_bytes)
+    {
+        convert(frame.row(y) + rect.left().as_int(), width, false, pixels.data() + offset);
+    }
+
+    auto const length_at = out.size();
+    put32(out, 0);
+    zlib_stream->compress(pixels.data(), pixels.size(), compress_level, out);
+
+    auto const length = out.size() - length_at - 4;
+    for (auto i = 0; i != 4; ++i)
+    {
+        out[length_at + i] = length >> (8 * (3 - i));
+    }
+}
+
+void mf::RfbEncoder::encode_tight(
+    RfbFramebuffer const& frame,
+    geom::Rectangle const& rect,
+    int stream,
+    std::vector<uint8_t>& out)
+{
+    put_rect_header(out, rect, rfb_encoding::tight);
+
+    bool const compact = format.tight_compact();
+    auto const pixel_bytes = compact ? 3 : format.bytes_per_pixel();
+    auto const width = rect.size.width.as_int();
+
+    if (is_uniform(frame, rect))
+    {
+        uint8_t const fill_compression{0x80};
+        out.push_back(fill_compression);
+        auto const offset = out.size();
+        out.resize(offset + pixel_bytes);
+        convert(frame.row(rect.top().as_int()) + rect.left().as_int(), 1, compact, out.data() + offset);
+        return;
+    }
+
+    auto const row_bytes = width * pixel_bytes;
+    std::vector<uint8_t> pixels(row_bytes * rect.size.height.as_int());
+    auto offset = 0u;
+    for (auto y = rect.top().as_int(); y != rect.bottom().as_int(); ++y, offset += row_bytes)
+    {
+        convert(frame.row(y) + rect.left().as_int(), width, compact, pixels.data() + offset);
+    }
+
+    // Basic compression with the copy filter, on the given stream
+    out.push_back(stream << 4);
+    if (pixels.size() < tight_min_to_compress)
+    {
+        out.insert(out.end(), pixels.begin(), pixels.end());
+        return;
+    }
+
+    std::vector<uint8_t> compressed;
+    tight_streams[stream]->compress(pixels.data(), pixels.size(), compress_level, compressed);
+    put_compact_length(out, compressed.size());
+    out.insert(out.end(), compressed.begin(), compressed.end());
+}
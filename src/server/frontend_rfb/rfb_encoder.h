@@ -0,0 +1,114 @@
+/*
+ * Copyright © 2022 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_FRONTEND_RFB_ENCODER_H_
+#define MIR_FRONTEND_RFB_ENCODER_H_
+
+#include "mir/geometry/rectangle.h"
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace mir
+{
+class Executor;
+namespace frontend
+{
+class RfbFramebuffer;
+
+namespace rfb_encoding
+{
+int32_t constexpr raw{0};
+int32_t constexpr zlib{6};
+int32_t constexpr tight{7};
+int32_t constexpr desktop_size{-223};
+int32_t constexpr compress_level_0{-256};
+int32_t constexpr compress_level_9{-247};
+}
+
+/// The PIXEL_FORMAT of the RFB protocol
+struct RfbPixelFormat
+{
+    uint8_t bits_per_pixel{32};
+    uint8_t depth{24};
+    bool big_endian{false};
+    bool true_colour{true};
+    uint16_t red_max{255};
+    uint16_t green_max{255};
+    uint16_t blue_max{255};
+    uint8_t red_shift{16};
+    uint8_t green_shift{8};
+    uint8_t blue_shift{0};
+
+    /// Whether Tight sends pixels in this format as three bytes of red, green and blue
+    auto tight_compact() const -> bool;
+    auto bytes_per_pixel() const -> size_t { return bits_per_pixel / 8u; }
+};
+
+/**
+ * Encodes the rectangles of framebuffer updates for an RFB session.
+ *
+ * The Zlib and Tight encodings keep compression streams across updates, so each session needs its own encoder. Tight
+ * rectangles are spread over its four streams, which are compressed in parallel on the executor.
+ */
+class RfbEncoder
+{
+public:
+    explicit RfbEncoder(Executor& executor);
+    ~RfbEncoder();
+
+    /// \throws std::invalid_argument if \a format is not true colour at 8, 16 or 32 bits per pixel
+    void set_pixel_format(RfbPixelFormat const& format);
+
+    /// Use the first of \a encodings that is supported, and any compression level given
+    void set_encodings(std::vector<int32_t> const& encodings);
+
+    auto encoding() const -> int32_t { return encoding_; }
+    auto supports_desktop_size() const -> bool { return desktop_size; }
+
+    /// Append the rectangle headers and pixels of \a rects of \a frame to \a out
+    void encode(RfbFramebuffer const& frame, std::vector<geometry::Rectangle> const& rects, std::vector<uint8_t>& out);
+
+    /// Append the pseudo-rectangle telling the client the framebuffer is now \a size
+    static void encode_desktop_size(geometry::Size const& size, std::vector<uint8_t>& out);
+
+private:
+    class DeflateStream;
+
+    /// Convert a row of pixels to the client's format, or Tight's compact form if \a compact
+    void convert(uint32_t const* pixels, int count, bool compact, uint8_t* out) const;
+    void encode_raw(RfbFramebuffer const& frame, geometry::Rectangle const& rect, std::vector<uint8_t>& out) const;
+    void encode_zlib(RfbFramebuffer const& frame, geometry::Rectangle const& rect, std::vector<uint8_t>& out);
+    void encode_tight(
+        RfbFramebuffer const& frame,
+        geometry::Rectangle const& rect,
+        int stream,
+        std::vector<uint8_t>& out);
+
+    Executor& executor;
+    RfbPixelFormat format;
+    int32_t encoding_{rfb_encoding::raw};
+    bool desktop_size{false};
+    int compress_level;
+    std::unique_ptr<DeflateStream> const zlib_stream;
+    std::array<std::unique_ptr<DeflateStream>, 4> const tight_streams;
+};
+}
+}
+
+#endif // MIR_FRONTEND_RFB_ENCODER_H_
@@ -0,0 +1,245 @@
+/*
+ * Copyright © 2022 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "rfb_frame_source.h"
+#include "rfb_framebuffer.h"
+
+#include "mir/compositor/scene.h"
+#include "mir/compositor/screen_shooter.h"
+#include "mir/scene/scene_change_notification.h"
+#include "mir/geometry/rectangles.h"
+#include "mir/log.h"
+
+#include <utility>
+
+namespace mf = mir::frontend;
+namespace mc = mir::compositor;
+namespace ms = mir::scene;
+namespace geom = mir::geometry;
+
+namespace
+{
+/// Damage in the scene, as pixels of a frame capturing \a area
+auto frame_damage(geom::Rectangle const& damage, geom::Rectangle const& area) -> geom::Rectangle
+{
+    auto const visible = intersection_of(damage, area);
+    return {visible.top_left - as_displacement(area.top_left), visible.size};
+}
+}
+
+mf::RfbFrameSource::Self::Self(
+    std::shared_ptr<mc::ScreenShooter> const& screen_shooter,
+    std::function<geom::Rectangle()> output_area)
+    : screen_shooter{screen_shooter},
+      output_area{std::move(output_area)}
+{
+}
+
+void mf::RfbFrameSource::Self::apply_damage(std::optional<geom::Rectangle> const& new_damage)
+{
+    std::unique_lock lock{mutex};
+
+    if (new_damage && latest_buffer && intersection_of(new_damage.value(), latest_area).size == geom::Size{})
+    {
+        return;
+    }
+
+    if (!new_damage)
+    {
+        damage = std::nullopt;
+    }
+    else if (!damaged)
+    {
+        damage = new_damage;
+    }
+    else if (damage)
+    {
+        damage = geom::Rectangles{damage.value(), new_damage.value()}.bounding_rectangle();
+    }
+    damaged = true;
+
+    if (auto const capture = next_capture())
+    {
+        lock.unlock();
+        capture();
+    }
+}
+
+auto mf::RfbFrameSource::Self::next_capture() -> std::function<void()>
+{
+    if (capturing || !damaged || waiting.empty())
+    {
+        return {};
+    }
+
+    capturing = true;
+    damaged = false;
+    auto const scene_damage = std::exchange(damage, std::nullopt);
+    auto const area = output_area();
+
+    // The spare frame can be brought up to date by capturing what changed in the latest frame and since
+    bool const can_reuse_spare =
+        spare_buffer && spare_buffer.use_count() == 1 &&
+        spare_area == area && latest_area == area &&
+        latest_damage && scene_damage;
+
+    std::shared_ptr<RfbFramebuffer> buffer;
+    std::optional<geom::Rectangle> buffer_damage;
+    if (can_reuse_spare)
+    {
+        buffer = std::move(spare_buffer);
+        buffer_damage = frame_damage(
+            geom::Rectangles{latest_damage.value(), scene_damage.value()}.bounding_rectangle(),
+            area);
+    }
+    else
+    {
+        buffer = std::make_shared<RfbFramebuffer>(area.size);
+    }
+    spare_buffer.reset();
+
+    return [self=shared_from_this(), buffer, area, scene_damage, buffer_damage]()
+        {
+            auto callback = [weak_self=std::weak_ptr<Self>{self}, buffer, area, scene_damage](auto captured_time)
+                {
+                    if (auto const self = weak_self.lock())
+                    {
+                        self->captured(buffer, area, scene_damage, captured_time.has_value());
+                    }
+                };
+
+            if (buffer_damage)
+            {
+                self->screen_shooter->capture_damage(buffer, area, buffer_damage.value(), std::move(callback));
+            }
+            else
+            {
+                self->screen_shooter->capture(buffer, area, std::move(callback));
+            }
+        };
+}
+
+void mf::RfbFrameSource::Self::captured(
+    std::shared_ptr<RfbFramebuffer> const& buffer,
+    geom::Rectangle const& area,
+    std::optional<geom::Rectangle> const& scene_damage,
+    bool succeeded)
+{
+    if (!succeeded)
+    {
+        log_warning("Failed to capture the screen for RFB clients");
+        std::lock_guard lock{mutex};
+        // Capture everything next time rather than retrying straight away
+        capturing = false;
+        damaged = true;
+        damage = std::nullopt;
+        return;
+    }
+
+    std::shared_ptr<RfbFramebuffer const> previous;
+    {
+        std::lock_guard lock{mutex};
+        if (latest_buffer && latest_area == area)
+        {
+            previous = latest_buffer;
+        }
+    }
+
+    // Only one capture is in flight at a time, so the previous frame's hashes won't change under us
+    buffer->hash_tiles(
+        previous.get(),
+        scene_damage && previous ? std::make_optional(frame_damage(scene_damage.value(), area)) : std::nullopt);
+
+    std::vector<std::function<void()>> notify;
+    {
+        std::lock_guard lock{mutex};
+        spare_buffer = std::move(latest_buffer);
+        spare_area = latest_area;
+        latest_buffer = buffer;
+        latest_area = area;
+        latest_damage = previous ? scene_damage : std::nullopt;
+        latest_generation++;
+        capturing = false;
+        notify.swap(waiting);
+    }
+
+    for (auto const& waiter : notify)
+    {
+        waiter();
+    }
+}
+
+mf::RfbFrameSource::RfbFrameSource(
+    std::shared_ptr<mc::Scene> const& scene,
+    std::shared_ptr<mc::ScreenShooter> const& screen_shooter,
+    std::function<geom::Rectangle()> output_area)
+    : scene{scene},
+      self{std::make_shared<Self>(screen_shooter, std::move(output_area))},
+      scene_observer{[weak_self=std::weak_ptr<Self>{self}]()
+          {
+              return std::make_shared<ms::SceneChangeNotification>(
+                  [weak_self]()
+                  {
+                      if (auto const self = weak_self.lock())
+                      {
+                          self->apply_damage(std::nullopt);
+                      }
+                  },
+                  [weak_self](int, geom::Rectangle const& damage)
+                  {
+                      if (auto const self = weak_self.lock())
+                      {
+                          self->apply_damage(damage);
+                      }
+                  });
+          }()}
+{
+    scene->add_observer(scene_observer);
+}
+
+mf::RfbFrameSource::~RfbFrameSource()
+{
+    scene->remove_observer(scene_observer);
+}
+
+auto mf::RfbFrameSource::latest() const -> std::optional<Frame>
+{
+    std::lock_guard lock{self->mutex};
+    if (!self->latest_buffer)
+    {
+        return std::nullopt;
+    }
+    return Frame{self->latest_buffer, self->latest_area, self->latest_generation};
+}
+
+void mf::RfbFrameSource::request_frame(uint64_t generation, std::function<void()>&& notify)
+{
+    std::unique_lock lock{self->mutex};
+
+    if (self->latest_generation > generation)
+    {
+        lock.unlock();
+        notify();
+        return;
+    }
+
+    self->waiting.push_back(std::move(notify));
+    if (auto const capture = self->next_capture())
+    {
+        lock.unlock();
+        capture();
+    }
+}
@@ -0,0 +1,121 @@
+/*
+ * Copyright © 2022 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_FRONTEND_RFB_FRAME_SOURCE_H_
+#define MIR_FRONTEND_RFB_FRAME_SOURCE_H_
+
+#include "mir/geometry/rectangle.h"
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+namespace mir
+{
+namespace compositor
+{
+class Scene;
+class ScreenShooter;
+}
+namespace scene
+{
+class Observer;
+}
+namespace frontend
+{
+class RfbFramebuffer;
+
+/**
+ * Captures the screen for RFB sessions.
+ *
+ * A frame is only captured when the scene has been damaged since the last one and a session is waiting for a new
+ * frame. Where the frame before last is no longer held by any session its buffer is reused, so only the damaged part
+ * of the screen needs to be read back and rehashed.
+ */
+class RfbFrameSource
+{
+public:
+    struct Frame
+    {
+        std::shared_ptr<RfbFramebuffer const> buffer;
+        geometry::Rectangle area;   ///< The part of the scene captured
+        uint64_t generation;        ///< Counts up from 1 with each frame captured
+    };
+
+    /// \param output_area  Gives the part of the scene to capture, called each time a frame is captured
+    RfbFrameSource(
+        std::shared_ptr<compositor::Scene> const& scene,
+        std::shared_ptr<compositor::ScreenShooter> const& screen_shooter,
+        std::function<geometry::Rectangle()> output_area);
+    ~RfbFrameSource();
+
+    /// The most recently captured frame, if there has been one
+    auto latest() const -> std::optional<Frame>;
+
+    /**
+     * Call \a notify (on any thread) once there is a frame newer than \a generation, capturing one when the scene
+     * next changes if need be.
+     */
+    void request_frame(uint64_t generation, std::function<void()>&& notify);
+
+private:
+    struct Self : std::enable_shared_from_this<Self>
+    {
+        Self(
+            std::shared_ptr<compositor::ScreenShooter> const& screen_shooter,
+            std::function<geometry::Rectangle()> output_area);
+
+        /// nullopt damages everything
+        void apply_damage(std::optional<geometry::Rectangle> const& damage);
+
+        /// Returns a function to start a capture if one is needed, and empty otherwise. Called with the mutex held.
+        auto next_capture() -> std::function<void()>;
+
+        void captured(
+            std::shared_ptr<RfbFramebuffer> const& buffer,
+            geometry::Rectangle const& area,
+            std::optional<geometry::Rectangle> const& damage,
+            bool succeeded);
+
+        std::shared_ptr<compositor::ScreenShooter> const screen_shooter;
+        std::function<geometry::Rectangle()> const output_area;
+
+        std::mutex mutable mutex;
+        std::shared_ptr<RfbFramebuffer> latest_buffer;
+        geometry::Rectangle latest_area;
+        uint64_t latest_generation{0};
+        /// The damage between the spare frame and the latest one, nullopt if unknown
+        std::optional<geometry::Rectangle> latest_damage;
+        /// The frame before the latest, kept for reuse
+        std::shared_ptr<RfbFramebuffer> spare_buffer;
+        geometry::Rectangle spare_area;
+        bool damaged{true};
+        /// The damage since the latest frame, nullopt if damaged everywhere
+        std::optional<geometry::Rectangle> damage;
+        bool capturing{false};
+        std::vector<std::function<void()>> waiting;
+    };
+
+    std::shared_ptr<compositor::Scene> const scene;
+    std::shared_ptr<Self> const self;
+    std::shared_ptr<scene::Observer> const scene_observer;
+};
+}
+}
+
+#endif // MIR_FRONTEND_RFB_FRAME_SOURCE_H_
@@ -0,0 +1,206 @@
+/*
+ * Copyright © 2022 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "rfb_framebuffer.h"
+
+#include <cstring>
+
+namespace mf = mir::frontend;
+namespace mrs = mir::renderer::software;
+namespace geom = mir::geometry;
+
+namespace
+{
+/// Four 64-bit lanes, which the compiler maps onto whatever SIMD registers the target has
+using Lanes = uint64_t __attribute__((vector_size(32)));
+
+auto rotate_left(uint64_t value, int bits) -> uint64_t
+{
+    return (value << bits) | (value >> (64 - bits));
+}
+
+void mix(Lanes& state, Lanes const& chunk)
+{
+    Lanes const multipliers = {
+        0x9e3779b97f4a7c15ull, 0xc2b2ae3d27d4eb4full, 0x165667b19e3779f9ull, 0xd6e8feb86659fd93ull};
+    state = (state ^ chunk) * multipliers;
+    state ^= state >> 31;
+}
+
+class Mapping : public mrs::Mapping<unsigned char>
+{
+public:
+    Mapping(mf::RfbFramebuffer& buffer, unsigned char* data)
+        : buffer{buffer},
+          data_{data}
+    {
+    }
+
+    auto format() const -> MirPixelFormat override { return buffer.format(); }
+    auto stride() const -> geom::Stride override { return buffer.stride(); }
+    auto size() const -> geom::Size override { return buffer.size(); }
+    auto data() -> unsigned char* override { return data_; }
+    auto len() const -> size_t override { return stride().as_uint32_t() * size().height.as_uint32_t(); }
+
+private:
+    mf::RfbFramebuffer& buffer;
+    unsigned char* const data_;
+};
+}
+
+mf::RfbFramebuffer::RfbFramebuffer(geom::Size const& size)
+    : size_{size},
+      stride_{size.width.as_int() * 4},
+      pixels{std::make_unique_for_overwrite<unsigned char[]>(stride_.as_uint32_t() * size.height.as_uint32_t())}
+{
+}
+
+auto mf::RfbFramebuffer::map_writeable() -> std::unique_ptr<mrs::Mapping<unsigned char>>
+{
+    return std::make_unique<Mapping>(*this, pixels.get());
+}
+
+auto mf::RfbFramebuffer::format() const -> MirPixelFormat
+{
+    return mir_pixel_format_argb_8888;
+}
+
+auto mf::RfbFramebuffer::stride() const -> geom::Stride
+{
+    return stride_;
+}
+
+auto mf::RfbFramebuffer::size() const -> geom::Size
+{
+    return size_;
+}
+
+auto mf::RfbFramebuffer::row(int y) const -> uint32_t const*
+{
+    auto const flipped = size_.height.as_int() - 1 - y;
+    return reinterpret_cast<uint32_t const*>(pixels.get() + flipped * stride_.as_int());
+}
+
+auto mf::RfbFramebuffer::tiles_across() const -> int
+{
+    return (size_.width.as_int() + tile_size - 1) / tile_size;
+}
+
+auto mf::RfbFramebuffer::tile_area(size_t index) const -> geom::Rectangle
+{
+    auto const across = static_cast<size_t>(tiles_across());
+    geom::Point const top_left{(index % across) * tile_size, (index / across) * tile_size};
+    return intersection_of(geom::Rectangle{top_left, {tile_size, tile_size}}, geom::Rectangle{{}, size_});
+}
+
+void mf::RfbFramebuffer::hash_tiles(RfbFramebuffer const* previous, std::optional<geom::Rectangle> const& damage)
+{
+    auto const tiles_down = (size_.height.as_int() + tile_size - 1) / tile_size;
+    auto const tile_count = static_cast<size_t>(tiles_across() * tiles_down);
+    bool const reuse = previous && previous->size_ == size_ && damage;
+
+    hashes.resize(tile_count);
+    for (auto i = 0u; i != tile_count; ++i)
+    {
+        auto const tile = tile_area(i);
+        if (reuse && intersection_of(tile, damage.value()).size == geom::Size{})
+        {
+            hashes[i] = previous->hashes[i];
+        }
+        else
+        {
+            hashes[i] = hash_tile(tile);
+        }
+    }
+}
+
+auto mf::RfbFramebuffer::hash_tile(geom::Rectangle const& tile) const -> uint64_t
+{
+    Lanes state = {1, 2, 3, 4};
+    auto const length = tile.size.width.as_uint32_t() * 4;
+
+    for (auto y = tile.top().as_int(); y != tile.bottom().as_int(); ++y)
+    {
+        auto const bytes = reinterpret_cast<unsigned char const*>(row(y) + tile.left().as_int());
+
+        auto i = 0u;
+        for (; i + sizeof(Lanes) <= length; i += sizeof(Lanes))
+        {
+            Lanes chunk;
+            memcpy(&chunk, bytes + i, sizeof chunk);
+            mix(state, chunk);
+        }
+
+        if (i != length)
+        {
+            Lanes chunk = {};
+            memcpy(&chunk, bytes + i, length - i);
+            mix(state, chunk);
+        }
+    }
+
+    auto hash = state[0] ^ rotate_left(state[1], 16) ^ rotate_left(state[2], 32) ^ rotate_left(state[3], 48);
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdull;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+auto mf::changed_tiles(std::vector<uint64_t> const& sent_hashes, RfbFramebuffer const& frame) -> std::vector<size_t>
+{
+    auto const& hashes = frame.tile_hashes();
+    std::vector<size_t> result;
+
+    if (sent_hashes.size() != hashes.size())
+    {
+        result.resize(hashes.size());
+        for (auto i = 0u; i != hashes.size(); ++i)
+        {
+            result[i] = i;
+        }
+        return result;
+    }
+
+    auto constexpr lane_count = sizeof(Lanes) / sizeof(uint64_t);
+    auto i = 0u;
+    for (; i + lane_count <= hashes.size(); i += lane_count)
+    {
+        Lanes sent, current;
+        memcpy(&sent, sent_hashes.data() + i, sizeof sent);
+        memcpy(&current, hashes.data() + i, sizeof current);
+        auto const differ = sent != current;
+        if (differ[0] | differ[1] | differ[2] | differ[3])
+        {
+            for (auto lane = 0u; lane != lane_count; ++lane)
+            {
+                if (differ[lane])
+                {
+                    result.push_back(i + lane);
+                }
+            }
+        }
+    }
+
+    for (; i != hashes.size(); ++i)
+    {
+        if (sent_hashes[i] != hashes[i])
+        {
+            result.push_back(i);
+        }
+    }
+
+    return result;
+}
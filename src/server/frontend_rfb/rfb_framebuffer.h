@@ -0,0 +1,85 @@
+/*
+ * Copyright © 2022 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_FRONTEND_RFB_FRAMEBUFFER_H_
+#define MIR_FRONTEND_RFB_FRAMEBUFFER_H_
+
+#include "mir/renderer/sw/pixel_source.h"
+#include "mir/geometry/rectangle.h"
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace mir
+{
+namespace frontend
+{
+/**
+ * A frame captured for RFB clients.
+ *
+ * The frame is divided into square tiles, each with a hash of its pixels, so that what has changed since a client's
+ * last update can be found by comparing hashes rather than pixels.
+ */
+class RfbFramebuffer : public renderer::software::WriteMappableBuffer
+{
+public:
+    static int constexpr tile_size{64};
+
+    explicit RfbFramebuffer(geometry::Size const& size);
+
+    /// From WriteMappableBuffer
+    /// @{
+    auto map_writeable() -> std::unique_ptr<renderer::software::Mapping<unsigned char>> override;
+    auto format() const -> MirPixelFormat override;
+    auto stride() const -> geometry::Stride override;
+    auto size() const -> geometry::Size override;
+    /// @}
+
+    /// The ARGB8888 pixels of the row \a y down from the top (the screen shooter writes frames bottom-up)
+    auto row(int y) const -> uint32_t const*;
+
+    /**
+     * Hash the tiles.
+     *
+     * If \a previous is the same size only the tiles touching \a damage are hashed, the rest keeping the hashes they
+     * had in \a previous.
+     */
+    void hash_tiles(RfbFramebuffer const* previous, std::optional<geometry::Rectangle> const& damage);
+
+    auto tiles_across() const -> int;
+    auto tile_hashes() const -> std::vector<uint64_t> const& { return hashes; }
+    auto tile_area(size_t index) const -> geometry::Rectangle;
+
+private:
+    auto hash_tile(geometry::Rectangle const& tile) const -> uint64_t;
+
+    geometry::Size const size_;
+    geometry::Stride const stride_;
+    std::unique_ptr<unsigned char[]> const pixels;
+    std::vector<uint64_t> hashes;
+};
+
+/**
+ * The indices of the tiles of \a frame whose hashes differ from \a sent_hashes (every tile, if \a sent_hashes is
+ * for a frame of a different size)
+ */
+auto changed_tiles(std::vector<uint64_t> const& sent_hashes, RfbFramebuffer const& frame) -> std::vector<size_t>;
+}
+}
+
+#endif // MIR_FRONTEND_RFB_FRAMEBUFFER_H_
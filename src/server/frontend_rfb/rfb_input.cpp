@@ -0,0 +1,192 @@
+/*
+ * Copyright © 2022 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "rfb_input.h"
+
+#include "mir/input/virtual_input_device.h"
+#include "mir/input/input_device_registry.h"
+#include "mir/input/input_sink.h"
+#include "mir/input/event_builder.h"
+#include "mir/input/parameter_keymap.h"
+#include "mir/events/scroll_axis.h"
+#include "mir/log.h"
+
+#include <xkbcommon/xkbcommon.h>
+
+namespace mf = mir::frontend;
+namespace mi = mir::input;
+namespace mev = mir::events;
+namespace geom = mir::geometry;
+
+namespace
+{
+/// The offset between XKB keycodes and evdev scan codes
+int constexpr xkb_keycode_offset{8};
+
+/// Map each keysym of the default keymap to the scan code of a key producing it, unshifted if possible
+auto scan_codes_for_default_keymap() -> std::unordered_map<uint32_t, int>
+{
+    std::unique_ptr<xkb_context, void(*)(xkb_context*)> const context{
+        xkb_context_new(XKB_CONTEXT_NO_FLAGS),
+        &xkb_context_unref};
+    if (!context)
+    {
+        mir::log_warning("Failed to create XKB context, RFB clients won't be able to type");
+        return {};
+    }
+
+    auto const keymap = mi::ParameterKeymap{}.make_unique_xkb_keymap(context.get());
+    auto const min_keycode = xkb_keymap_min_keycode(keymap.get());
+    auto const max_keycode = xkb_keymap_max_keycode(keymap.get());
+
+    std::unordered_map<uint32_t, int> result;
+    for (xkb_level_index_t level = 0; level != 2; ++level)
+    {
+        for (auto keycode = min_keycode; keycode <= max_keycode; ++keycode)
+        {
+            if (level >= xkb_keymap_num_levels_for_key(keymap.get(), keycode, 0))
+            {
+                continue;
+            }
+
+            xkb_keysym_t const* syms;
+            auto const count = xkb_keymap_key_get_syms_by_level(keymap.get(), keycode, 0, level, &syms);
+            for (auto i = 0; i < count; ++i)
+            {
+                result.emplace(syms[i], keycode - xkb_keycode_offset);
+            }
+        }
+    }
+    return result;
+}
+
+auto pointer_buttons(uint8_t button_mask) -> MirPointerButtons
+{
+    MirPointerButtons buttons{0};
+    if (button_mask & (1 << 0))
+    {
+        buttons |= mir_pointer_button_primary;
+    }
+    if (button_mask & (1 << 1))
+    {
+        buttons |= mir_pointer_button_tertiary;
+    }
+    if (button_mask & (1 << 2))
+    {
+        buttons |= mir_pointer_button_secondary;
+    }
+    return buttons;
+}
+}
+
+mf::RfbInput::RfbInput(std::shared_ptr<mi::InputDeviceRegistry> const& device_registry)
+    : device_registry{device_registry},
+      keyboard_device{std::make_shared<mi::VirtualInputDevice>("rfb-keyboard", mi::DeviceCapability::keyboard)},
+      pointer_device{std::make_shared<mi::VirtualInputDevice>("rfb-pointer", mi::DeviceCapability::pointer)},
+      scan_codes{scan_codes_for_default_keymap()}
+{
+    device_registry->add_device(keyboard_device);
+    device_registry->add_device(pointer_device);
+}
+
+mf::RfbInput::~RfbInput()
+{
+    device_registry->remove_device(pointer_device);
+    device_registry->remove_device(keyboard_device);
+}
+
+void mf::RfbInput::key(bool down, uint32_t keysym)
+{
+    auto const scan_code = scan_codes.find(keysym);
+    if (scan_code == scan_codes.end())
+    {
+        log_debug("RFB client sent keysym 0x%x, which is not in the keymap", keysym);
+        return;
+    }
+
+    keyboard_device->if_started_then([&](mi::InputSink* sink, mi::EventBuilder* builder)
+        {
+            sink->handle_input(builder->key_event(
+                std::nullopt,
+                down ? mir_keyboard_action_down : mir_keyboard_action_up,
+                0,
+                scan_code->second));
+        });
+}
+
+void mf::RfbInput::pointer(uint8_t new_button_mask, geom::Point new_position)
+{
+    pointer_device->if_started_then([&](mi::InputSink* sink, mi::EventBuilder* builder)
+        {
+            auto const buttons = pointer_buttons(button_mask);
+            auto const new_buttons = pointer_buttons(new_button_mask);
+
+            if (new_position != position)
+            {
+                auto const motion = position ? new_position - position.value() : geom::Displacement{};
+                sink->handle_input(builder->pointer_event(
+                    std::nullopt,
+                    mir_pointer_action_motion,
+                    buttons,
+                    geom::PointF{new_position},
+                    geom::DisplacementF{motion},
+                    mir_pointer_axis_source_none,
+                    {}, {}));
+            }
+
+            if (buttons & ~new_buttons)
+            {
+                sink->handle_input(builder->pointer_event(
+                    std::nullopt,
+                    mir_pointer_action_button_up,
+                    buttons & new_buttons,
+                    {}, {}, mir_pointer_axis_source_none, {}, {}));
+            }
+
+            if (new_buttons & ~buttons)
+            {
+                sink->handle_input(builder->pointer_event(
+                    std::nullopt,
+                    mir_pointer_action_button_down,
+                    new_buttons,
+                    {}, {}, mir_pointer_axis_source_none, {}, {}));
+            }
+
+            // The wheel "buttons" are pressed and released for each click, so scroll as they go down
+            auto const clicked = new_button_mask & ~button_mask;
+            auto const clicks = [&](int negative_bit, int positive_bit)
+                {
+                    return ((clicked >> positive_bit) & 1) - ((clicked >> negative_bit) & 1);
+                };
+            auto const v_clicks = clicks(3, 4);
+            auto const h_clicks = clicks(5, 6);
+            if (v_clicks || h_clicks)
+            {
+                float const precise_per_click{15};
+                sink->handle_input(builder->pointer_event(
+                    std::nullopt,
+                    mir_pointer_action_motion,
+                    new_buttons,
+                    {}, {},
+                    mir_pointer_axis_source_wheel,
+                    mev::ScrollAxisH{geom::DeltaXF{h_clicks * precise_per_click}, geom::DeltaX{h_clicks}, false},
+                    mev::ScrollAxisV{geom::DeltaYF{v_clicks * precise_per_click}, geom::DeltaY{v_clicks}, false}));
+            }
+        });
+
+    button_mask = new_button_mask;
+    position = new_position;
+}
@@ -0,0 +1,68 @@
+/*
+ * Copyright © 2022 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_FRONTEND_RFB_INPUT_H_
+#define MIR_FRONTEND_RFB_INPUT_H_
+
+#include "mir/geometry/point.h"
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <unordered_map>
+
+namespace mir
+{
+namespace input
+{
+class InputDeviceRegistry;
+class VirtualInputDevice;
+}
+namespace frontend
+{
+/**
+ * Injects an RFB client's key and pointer events through virtual input devices.
+ *
+ * RFB sends keysyms rather than key codes, so keys are mapped back to scan codes through the default keymap.
+ */
+class RfbInput
+{
+public:
+    explicit RfbInput(std::shared_ptr<input::InputDeviceRegistry> const& device_registry);
+    ~RfbInput();
+
+    void key(bool down, uint32_t keysym);
+
+    /// \param button_mask  The RFB button mask: bits 0-2 are the left, middle and right buttons, 3-6 the wheel
+    /// \param position     Where the pointer is in the scene
+    void pointer(uint8_t button_mask, geometry::Point position);
+
+private:
+    RfbInput(RfbInput const&) = delete;
+    RfbInput& operator=(RfbInput const&) = delete;
+
+    std::shared_ptr<input::InputDeviceRegistry> const device_registry;
+    std::shared_ptr<input::VirtualInputDevice> const keyboard_device;
+    std::shared_ptr<input::VirtualInputDevice> const pointer_device;
+    std::unordered_map<uint32_t, int> const scan_codes;
+
+    uint8_t button_mask{0};
+    std::optional<geometry::Point> position;
+};
+}
+}
+
+#endif // MIR_FRONTEND_RFB_INPUT_H_
@@ -0,0 +1,504 @@
+/*
+ * Copyright © 2022 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "rfb_session.h"
+#include "rfb_framebuffer.h"
+#include "rfb_input.h"
+
+#include "mir/log.h"
+#include "mir/thread_name.h"
+
+#include <boost/throw_exception.hpp>
+
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+
+namespace mf = mir::frontend;
+namespace mi = mir::input;
+namespace geom = mir::geometry;
+
+namespace
+{
+char const server_version[] = "RFB 003.008\n";
+size_t constexpr version_length{12};
+uint8_t constexpr security_none{1};
+char const desktop_name[] = "Mir";
+
+namespace client_message
+{
+uint8_t constexpr set_pixel_format{0};
+uint8_t constexpr set_encodings{2};
+uint8_t constexpr framebuffer_update_request{3};
+uint8_t constexpr key_event{4};
+uint8_t constexpr pointer_event{5};
+uint8_t constexpr client_cut_text{6};
+}
+
+uint8_t constexpr framebuffer_update{0};
+
+/// Changed tiles next to each other along a row are sent as one rectangle of up to this many tiles
+size_t constexpr max_tiles_per_rect{4};
+
+auto get16(uint8_t const* data) -> uint16_t
+{
+    return data[0] << 8 | data[1];
+}
+
+auto get32(uint8_t const* data) -> uint32_t
+{
+    return static_cast<uint32_t>(get16(data)) << 16 | get16(data + 2);
+}
+
+void put16(std::vector<uint8_t>& out, uint16_t value)
+{
+    out.push_back(value >> 8);
+    out.push_back(value & 0xff);
+}
+
+void put32(std::vector<uint8_t>& out, uint32_t value)
+{
+    put16(out, value >> 16);
+    put16(out, value & 0xffff);
+}
+
+void put_pixel_format(std::vector<uint8_t>& out, mf::RfbPixelFormat const& format)
+{
+    out.push_back(format.bits_per_pixel);
+    out.push_back(format.depth);
+    out.push_back(format.big_endian);
+    out.push_back(format.true_colour);
+    put16(out, format.red_max);
+    put16(out, format.green_max);
+    put16(out, format.blue_max);
+    out.push_back(format.red_shift);
+    out.push_back(format.green_shift);
+    out.push_back(format.blue_shift);
+    out.insert(out.end(), 3, 0);
+}
+
+auto get_pixel_format(uint8_t const* data) -> mf::RfbPixelFormat
+{
+    mf::RfbPixelFormat format;
+    format.bits_per_pixel = data[0];
+    format.depth = data[1];
+    format.big_endian = data[2] != 0;
+    format.true_colour = data[3] != 0;
+    format.red_max = get16(data + 4);
+    format.green_max = get16(data + 6);
+    format.blue_max = get16(data + 8);
+    format.red_shift = data[10];
+    format.green_shift = data[11];
+    format.blue_shift = data[12];
+    return format;
+}
+}
+
+mf::RfbSession::RfbSession(
+    Fd socket,
+    std::shared_ptr<RfbFrameSource> const& frames,
+    std::shared_ptr<mi::InputDeviceRegistry> const& device_registry,
+    Executor& executor)
+    : socket{std::move(socket)},
+      wakeup{eventfd(0, EFD_CLOEXEC)},
+      frames{frames},
+      device_registry{device_registry},
+      encoder{executor}
+{
+    if (wakeup < 0)
+    {
+        BOOST_THROW_EXCEPTION((std::system_error{errno, std::system_category(), "Failed to create RFB session eventfd"}));
+    }
+
+    thread = std::thread{[this]() { run(); }};
+}
+
+mf::RfbSession::~RfbSession()
+{
+    stopping = true;
+    eventfd_write(wakeup, 1);
+    // Wake the thread if it is blocked reading or writing
+    shutdown(socket, SHUT_RDWR);
+    thread.join();
+}
+
+void mf::RfbSession::run()
+{
+    mir::set_thread_name("Mir/RFB");
+
+    try
+    {
+        handshake();
+        serve();
+    }
+    catch (std::exception const& error)
+    {
+        if (!stopping)
+        {
+            log_info("RFB client disconnected: %s", error.what());
+        }
+    }
+
+    // The session isn't destroyed until the next viewer connects, so let this one know now
+    shutdown(socket, SHUT_RDWR);
+    finished_ = true;
+}
+
+void mf::RfbSession::handshake()
+{
+    write(server_version, version_length);
+
+    char client_version[version_length + 1]{};
+    read(client_version, version_length);
+    int major, minor;
+    if (sscanf(client_version, "RFB %3d.%3d\n", &major, &minor) != 2 || major != 3)
+    {
+        BOOST_THROW_EXCEPTION(std::runtime_error{"Unsupported RFB protocol version"});
+    }
+
+    if (minor < 7)
+    {
+        // Version 3.3 has the server pick the security type
+        std::vector<uint8_t> security;
+        put32(security, security_none);
+        write(security.data(), security.size());
+    }
+    else
+    {
+        uint8_t const security_types[]{1, security_none};
+        write(security_types, sizeof security_types);
+
+        uint8_t chosen;
+        read(&chosen, sizeof chosen);
+        if (chosen != security_none)
+        {
+            BOOST_THROW_EXCEPTION(std::runtime_error{"Client chose an unsupported security type"});
+        }
+
+        if (minor >= 8)
+        {
+            uint8_t const security_result_ok[4]{};
+            write(security_result_ok, sizeof security_result_ok);
+        }
+    }
+
+    uint8_t shared_flag;
+    read(&shared_flag, sizeof shared_flag);
+
+    auto const frame = first_frame();
+    client_size = frame.buffer->size();
+    client_top_left = frame.area.top_left;
+
+    std::vector<uint8_t> server_init;
+    put16(server_init, client_size.width.as_int());
+    put16(server_init, client_size.height.as_int());
+    put_pixel_format(server_init, RfbPixelFormat{});
+    put32(server_init, sizeof desktop_name - 1);
+    server_init.insert(server_init.end(), desktop_name, desktop_name + sizeof desktop_name - 1);
+    write(server_init.data(), server_init.size());
+
+    input = std::make_unique<RfbInput>(device_registry);
+}
+
+auto mf::RfbSession::first_frame() -> RfbFrameSource::Frame
+{
+    while (true)
+    {
+        if (auto const frame = frames->latest())
+        {
+            return frame.value();
+        }
+
+        frames->request_frame(0, [wakeup=wakeup]() { eventfd_write(wakeup, 1); });
+        wait_for_wakeup();
+    }
+}
+
+void mf::RfbSession::wait_for_wakeup()
+{
+    // Watch the socket too, to notice the client hanging up while we wait
+    pollfd fds[]{{wakeup, POLLIN, 0}, {socket, 0, 0}};
+    while (poll(fds, 2, -1) < 0)
+    {
+        if (errno != EINTR)
+        {
+            BOOST_THROW_EXCEPTION((std::system_error{errno, std::system_category(), "Failed to poll RFB session"}));
+        }
+    }
+
+    if (fds[1].revents & (POLLHUP | POLLERR))
+    {
+        BOOST_THROW_EXCEPTION(std::runtime_error{"Client hung up"});
+    }
+
+    eventfd_t count;
+    eventfd_read(wakeup, &count);
+    if (stopping)
+    {
+        BOOST_THROW_EXCEPTION(std::runtime_error{"Server stopping"});
+    }
+}
+
+void mf::RfbSession::serve()
+{
+    while (true)
+    {
+        pollfd fds[]{{socket, POLLIN, 0}, {wakeup, POLLIN, 0}};
+        if (poll(fds, 2, -1) < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            BOOST_THROW_EXCEPTION((std::system_error{errno, std::system_category(), "Failed to poll RFB session"}));
+        }
+
+        if (fds[1].revents & POLLIN)
+        {
+            eventfd_t count;
+            eventfd_read(wakeup, &count);
+            if (stopping)
+            {
+                return;
+            }
+            waiting_for_frame = false;
+            try_send_update();
+        }
+
+        if (fds[0].revents)
+        {
+            handle_message();
+        }
+    }
+}
+
+void mf::RfbSession::handle_message()
+{
+    uint8_t type;
+    read(&type, sizeof type);
+
+    switch (type)
+    {
+    case client_message::set_pixel_format:
+    {
+        uint8_t data[19];
+        read(data, sizeof data);
+        encoder.set_pixel_format(get_pixel_format(data + 3));
+        // Everything the client has is in the old format
+        sent_hashes.clear();
+        break;
+    }
+
+    case client_message::set_encodings:
+    {
+        uint8_t header[3];
+        read(header, sizeof header);
+        std::vector<uint8_t> data(get16(header + 1) * 4);
+        read(data.data(), data.size());
+
+        std::vector<int32_t> encodings;
+        for (auto i = 0u; i < data.size(); i += 4)
+        {
+            encodings.push_back(static_cast<int32_t>(get32(data.data() + i)));
+        }
+        encoder.set_encodings(encodings);
+        break;
+    }
+
+    case client_message::framebuffer_update_request:
+    {
+        uint8_t data[9];
+        read(data, sizeof data);
+        bool const incremental = data[0] != 0;
+        update_request = UpdateRequest{
+            incremental,
+            {{get16(data + 1), get16(data + 3)}, {get16(data + 5), get16(data + 7)}}};
+        if (!incremental)
+        {
+            sent_hashes.clear();
+        }
+        try_send_update();
+        break;
+    }
+
+    case client_message::key_event:
+    {
+        uint8_t data[7];
+        read(data, sizeof data);
+        input->key(data[0] != 0, get32(data + 3));
+        break;
+    }
+
+    case client_message::pointer_event:
+    {
+        uint8_t data[5];
+        read(data, sizeof data);
+        input->pointer(data[0], client_top_left + geom::Displacement{get16(data + 1), get16(data + 3)});
+        break;
+    }
+
+    case client_message::client_cut_text:
+    {
+        // The clipboard isn't shared, so skip the text
+        uint8_t header[7];
+        read(header, sizeof header);
+        uint8_t text[4096];
+        for (auto remaining = get32(header + 3); remaining;)
+        {
+            auto const chunk = std::min<size_t>(remaining, sizeof text);
+            read(text, chunk);
+            remaining -= chunk;
+        }
+        break;
+    }
+
+    default:
+        BOOST_THROW_EXCEPTION(std::runtime_error{"Unsupported RFB message type " + std::to_string(type)});
+    }
+}
+
+void mf::RfbSession::try_send_update()
+{
+    if (!update_request)
+    {
+        return;
+    }
+
+    if (auto const frame = frames->latest())
+    {
+        seen_generation = frame->generation;
+        auto const& buffer = *frame->buffer;
+        auto const& hashes = buffer.tile_hashes();
+
+        bool const resize = buffer.size() != client_size && encoder.supports_desktop_size();
+        if (resize)
+        {
+            client_size = buffer.size();
+            update_request->area = {{}, client_size};
+            sent_hashes.clear();
+        }
+        client_top_left = frame->area.top_left;
+
+        if (sent_hashes.size() != hashes.size())
+        {
+            // Hashes that can't match, so every tile is sent
+            sent_hashes.resize(hashes.size());
+            for (auto i = 0u; i != hashes.size(); ++i)
+            {
+                sent_hashes[i] = ~hashes[i];
+            }
+        }
+
+        geom::Rectangle const framebuffer{{}, client_size};
+        auto const tiles_across = static_cast<size_t>(buffer.tiles_across());
+        std::vector<geom::Rectangle> rects;
+        size_t run_end{0};
+        size_t run_length{0};
+        for (auto const tile : changed_tiles(sent_hashes, buffer))
+        {
+            auto const tile_area = buffer.tile_area(tile);
+            if (intersection_of(tile_area, update_request->area).size == geom::Size{})
+            {
+                continue;
+            }
+
+            sent_hashes[tile] = hashes[tile];
+            auto const visible = intersection_of(tile_area, framebuffer);
+            if (visible.size == geom::Size{})
+            {
+                continue;
+            }
+
+            if (run_length && tile == run_end && tile % tiles_across != 0 && run_length < max_tiles_per_rect)
+            {
+                rects.back().size.width += visible.size.width;
+                run_length++;
+            }
+            else
+            {
+                rects.push_back(visible);
+                run_length = 1;
+            }
+            run_end = tile + 1;
+        }
+
+        if (!rects.empty() || resize)
+        {
+            std::vector<uint8_t> message{framebuffer_update, 0};
+            put16(message, rects.size() + (resize ? 1 : 0));
+            if (resize)
+            {
+                RfbEncoder::encode_desktop_size(client_size, message);
+            }
+            encoder.encode(buffer, rects, message);
+            write(message.data(), message.size());
+            update_request.reset();
+            return;
+        }
+    }
+
+    if (!waiting_for_frame)
+    {
+        waiting_for_frame = true;
+        frames->request_frame(seen_generation, [wakeup=wakeup]() { eventfd_write(wakeup, 1); });
+    }
+}
+
+void mf::RfbSession::read(void* data, size_t size)
+{
+    auto const bytes = static_cast<uint8_t*>(data);
+    for (size_t done = 0; done < size;)
+    {
+        auto const result = recv(socket, bytes + done, size - done, 0);
+        if (result == 0)
+        {
+            BOOST_THROW_EXCEPTION(std::runtime_error{"Client hung up"});
+        }
+        else if (result < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            BOOST_THROW_EXCEPTION((std::system_error{errno, std::system_category(), "Failed to read from RFB client"}));
+        }
+        done += result;
+    }
+}
+
+void mf::RfbSession::write(void const* data, size_t size)
+{
+    auto const bytes = static_cast<uint8_t const*>(data);
+    for (size_t done = 0; done < size;)
+    {
+        auto const result = send(socket, bytes + done, size - done, MSG_NOSIGNAL);
+        if (result < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            BOOST_THROW_EXCEPTION((std::system_error{errno, std::system_category(), "Failed to write to RFB client"}));
+        }
+        done += result;
+    }
+}
@@ -0,0 +1,107 @@
+/*
+ * Copyright © 2022 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_FRONTEND_RFB_SESSION_H_
+#define MIR_FRONTEND_RFB_SESSION_H_
+
+#include "rfb_encoder.h"
+#include "rfb_frame_source.h"
+
+#include "mir/fd.h"
+#include "mir/geometry/rectangle.h"
+
+#include <atomic>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <vector>
+
+namespace mir
+{
+class Executor;
+namespace input
+{
+class InputDeviceRegistry;
+}
+namespace frontend
+{
+class RfbInput;
+
+/**
+ * Serves one RFB (VNC) client, on a thread of its own.
+ *
+ * Speaks version 3.8 of the protocol (accepting 3.3 and 3.7 clients) with no authentication. Updates only cover the
+ * tiles that changed since the client was last sent them.
+ */
+class RfbSession
+{
+public:
+    RfbSession(
+        Fd socket,
+        std::shared_ptr<RfbFrameSource> const& frames,
+        std::shared_ptr<input::InputDeviceRegistry> const& device_registry,
+        Executor& executor);
+
+    /// Disconnects the client if it hasn't already gone
+    ~RfbSession();
+
+    /// Whether the client has disconnected
+    auto finished() const -> bool { return finished_; }
+
+private:
+    RfbSession(RfbSession const&) = delete;
+    RfbSession& operator=(RfbSession const&) = delete;
+
+    struct UpdateRequest
+    {
+        bool incremental;
+        geometry::Rectangle area;
+    };
+
+    void run();
+    void handshake();
+    void serve();
+    void handle_message();
+    void try_send_update();
+
+    /// Wait for the first frame, to tell the client the size of the screen
+    auto first_frame() -> RfbFrameSource::Frame;
+    void wait_for_wakeup();
+    void read(void* data, size_t size);
+    void write(void const* data, size_t size);
+
+    Fd const socket;
+    Fd const wakeup;
+    std::shared_ptr<RfbFrameSource> const frames;
+    std::shared_ptr<input::InputDeviceRegistry> const device_registry;
+    RfbEncoder encoder;
+
+    std::unique_ptr<RfbInput> input;
+    std::optional<UpdateRequest> update_request;
+    bool waiting_for_frame{false};
+    uint64_t seen_generation{0};
+    geometry::Size client_size;
+    geometry::Point client_top_left;
+    std::vector<uint64_t> sent_hashes;
+
+    std::atomic<bool> stopping{false};
+    std::atomic<bool> finished_{false};
+    std::thread thread;
+};
+}
+}
+
+#endif // MIR_FRONTEND_RFB_SESSION_H_
@@ -0,0 +1,64 @@
+/*
+ * Copyright © 2022 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "configure_throttle.h"
+
+namespace mf = mir::frontend;
+
+void mf::ConfigureThrottle::configure_sent(uint32_t serial)
+{
+    outstanding_serial = serial;
+    outstanding_acked = false;
+    resize_held_back = false;
+}
+
+void mf::ConfigureThrottle::configure_acked(uint32_t serial)
+{
+    // Acking an earlier configure leaves the last one outstanding
+    if (outstanding_serial == serial)
+    {
+        outstanding_acked = true;
+    }
+}
+
+void mf::ConfigureThrottle::committed()
+{
+    if (outstanding_acked)
+    {
+        outstanding_serial = std::nullopt;
+        outstanding_acked = false;
+    }
+}
+
+auto mf::ConfigureThrottle::configure_outstanding() const -> bool
+{
+    return outstanding_serial.has_value();
+}
+
+auto mf::ConfigureThrottle::hold_back_resize(bool is_resizing) -> bool
+{
+    if (is_resizing && configure_outstanding())
+    {
+        resize_held_back = true;
+        return true;
+    }
+    return false;
+}
+
+auto mf::ConfigureThrottle::resize_due() const -> bool
+{
+    return resize_held_back && !configure_outstanding();
+}
@@ -0,0 +1,57 @@
+/*
+ * Copyright © 2022 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_FRONTEND_CONFIGURE_THROTTLE_H
+#define MIR_FRONTEND_CONFIGURE_THROTTLE_H
+
+#include <cstdint>
+#include <optional>
+
+namespace mir
+{
+namespace frontend
+{
+/// Tracks the configures a window has sent, so that during an interactive resize a new size is held back until the
+/// client has acked and committed the last one, rather than piling up configures it would render stale sizes for
+class ConfigureThrottle
+{
+public:
+    /// A configure that the client must ack has been sent with the given serial (this includes any held back size)
+    void configure_sent(uint32_t serial);
+    /// The client has acked the configure with the given serial (which takes effect on its next commit)
+    void configure_acked(uint32_t serial);
+    /// The client has committed
+    void committed();
+
+    /// If the last configure sent has yet to be acked and committed by the client
+    auto configure_outstanding() const -> bool;
+
+    /// The window has been resized. Returns if the configure for it should be held back (it then becomes
+    /// resize_due() once the client catches up)
+    auto hold_back_resize(bool is_resizing) -> bool;
+    /// If a held back resize should now be sent
+    auto resize_due() const -> bool;
+
+private:
+    /// The serial of the last configure sent, until it has been acked and committed
+    std::optional<uint32_t> outstanding_serial;
+    bool outstanding_acked{false};
+    bool resize_held_back{false};
+};
+}
+}
+
+#endif // MIR_FRONTEND_CONFIGURE_THROTTLE_H
@@ -25,7 +25,8 @@ namespace mf = mir::frontend;
 
 namespace
 {
-auto const delay = std::chrono::milliseconds{16};
+auto const frame_delay = std::chrono::milliseconds{16};
+auto const throttled_delay = std::chrono::milliseconds{1000};
 }
 
 struct mf::FrameExecutor::Callbacks
@@ -35,7 +36,24 @@ struct mf::FrameExecutor::Callbacks
 };
 
 mf::FrameExecutor::FrameExecutor(time::AlarmFactory& alarm_factory)
-    : callbacks{std::make_shared<Callbacks>()},
+    : frame_queue{alarm_factory, frame_delay},
+      throttled_queue{alarm_factory, throttled_delay}
+{
+}
+
+void mf::FrameExecutor::spawn(std::function<void()>&& work)
+{
+    frame_queue.spawn(std::move(work));
+}
+
+void mf::FrameExecutor::spawn_throttled(std::function<void()>&& work)
+{
+    throttled_queue.spawn(std::move(work));
+}
+
+mf::FrameExecutor::Queue::Queue(time::AlarmFactory& alarm_factory, std::chrono::milliseconds delay)
+    : delay{delay},
+      callbacks{std::make_shared<Callbacks>()},
       alarm{alarm_factory.create_alarm([weak_callbacks = std::weak_ptr<Callbacks>{callbacks}]()
           {
               fire_callbacks(weak_callbacks);
@@ -43,7 +61,7 @@ mf::FrameExecutor::FrameExecutor(time::AlarmFactory& alarm_factory)
 {
 }
 
-void mf::FrameExecutor::spawn(std::function<void()>&& work)
+void mf::FrameExecutor::Queue::spawn(std::function<void()>&& work)
 {
     std::unique_lock lock{callbacks->mutex};
     bool const needs_alarm = callbacks->queued.empty();
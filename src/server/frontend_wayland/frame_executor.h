@@ -19,6 +19,7 @@
 
 #include <mir/executor.h>
 
+#include <chrono>
 #include <memory>
 
 namespace mir
@@ -32,21 +33,39 @@ class AlarmFactory;
 namespace frontend
 {
 
-/// Runs frame callbacks that do not have a buffer to be attached to.
+/// Runs frame callbacks that are not sent when the compositor repaints the surface: those for commits without a
+/// new buffer, those for surfaces that are not on screen, and any that a repaint never comes for.
 class FrameExecutor : public Executor
 {
 public:
     explicit FrameExecutor(time::AlarmFactory& alarm_factory);
 
-    // This can be called from any thread. Given callback is run on the main loop thread. The wayland executor is NOT
-    // automatically used.
+    // This can be called from any thread. Given callback is run on the main loop thread, after roughly a frame. The
+    // wayland executor is NOT automatically used.
     void spawn(std::function<void()>&& work) override;
 
+    // As spawn(), but at a low rate. For surfaces the user can't see, so that clients don't burn CPU on frames
+    // nobody will look at.
+    void spawn_throttled(std::function<void()>&& work);
+
 private:
     struct Callbacks;
 
-    std::shared_ptr<Callbacks> const callbacks; // shared_ptr so it can potentially outlive this object
-    std::unique_ptr<time::Alarm> const alarm;
+    class Queue
+    {
+    public:
+        Queue(time::AlarmFactory& alarm_factory, std::chrono::milliseconds delay);
+
+        void spawn(std::function<void()>&& work);
+
+    private:
+        std::chrono::milliseconds const delay;
+        std::shared_ptr<Callbacks> const callbacks; // shared_ptr so it can potentially outlive this object
+        std::unique_ptr<time::Alarm> const alarm;
+    };
+
+    Queue frame_queue;
+    Queue throttled_queue;
 
     static void fire_callbacks(std::weak_ptr<Callbacks> const& weak_callbacks);
 };
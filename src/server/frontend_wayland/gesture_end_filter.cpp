@@ -0,0 +1,82 @@
+/*
+ * Copyright © 2022 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gesture_end_filter.h"
+
+#include "mir/executor.h"
+
+namespace mf = mir::frontend;
+
+mf::GestureEndFilter::GestureEndFilter(
+    MirInputEvent const* gesture_start,
+    Executor& executor,
+    std::function<void()>&& on_end)
+    : device{mir_input_event_get_device_id(gesture_start)},
+      type{mir_input_event_get_type(gesture_start)},
+      executor{executor},
+      on_end{std::move(on_end)}
+{
+}
+
+bool mf::GestureEndFilter::handle(MirEvent const& event)
+{
+    if (mir_event_get_type(&event) == mir_event_type_input &&
+        is_end(mir_event_get_input_event(&event)) &&
+        !ended.exchange(true))
+    {
+        executor.spawn([weak_self = weak_from_this()]
+            {
+                if (auto const self = weak_self.lock())
+                {
+                    self->on_end();
+                }
+            });
+    }
+
+    return false;
+}
+
+auto mf::GestureEndFilter::is_end(MirInputEvent const* event) const -> bool
+{
+    // Other devices (such as a keyboard sending auto-repeats) don't end the gesture
+    if (mir_input_event_get_device_id(event) != device || mir_input_event_get_type(event) != type)
+    {
+        return false;
+    }
+
+    switch (type)
+    {
+    case mir_input_event_type_pointer:
+        return mir_pointer_event_buttons(mir_input_event_get_pointer_event(event)) == 0;
+
+    case mir_input_event_type_touch:
+    {
+        auto const touch = mir_input_event_get_touch_event(event);
+        for (auto i = 0u; i != mir_touch_event_point_count(touch); ++i)
+        {
+            if (mir_touch_event_action(touch, i) != mir_touch_action_up)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    default:
+        // A gesture started by anything else (a key press, say) has nothing held down to wait for
+        return true;
+    }
+}
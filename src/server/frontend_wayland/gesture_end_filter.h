@@ -0,0 +1,57 @@
+/*
+ * Copyright © 2022 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_FRONTEND_GESTURE_END_FILTER_H
+#define MIR_FRONTEND_GESTURE_END_FILTER_H
+
+#include "mir/input/event_filter.h"
+#include "mir_toolkit/event.h"
+
+#include <atomic>
+#include <functional>
+#include <memory>
+
+namespace mir
+{
+class Executor;
+
+namespace frontend
+{
+/// Watches for the end of the pointer or touch gesture that started with a given input event: the release of every
+/// button or touch on the device it came from. Sees input the window manager consumes (which the client never gets),
+/// so it can end window management gestures such as an interactive resize. Never consumes events itself.
+class GestureEndFilter : public input::EventFilter, public std::enable_shared_from_this<GestureEndFilter>
+{
+public:
+    /// \param on_end   spawned (once) on the executor when the gesture ends, and skipped if the filter has been
+    ///                 dropped by the time it runs (so a stale end can't cut short a gesture that replaced it)
+    GestureEndFilter(MirInputEvent const* gesture_start, Executor& executor, std::function<void()>&& on_end);
+
+    bool handle(MirEvent const& event) override;
+
+private:
+    auto is_end(MirInputEvent const* event) const -> bool;
+
+    MirInputDeviceId const device;
+    MirInputEventType const type;
+    Executor& executor;
+    std::function<void()> const on_end;
+    std::atomic<bool> ended{false};
+};
+}
+}
+
+#endif // MIR_FRONTEND_GESTURE_END_FILTER_H
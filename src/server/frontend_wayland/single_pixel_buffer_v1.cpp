@@ -0,0 +1,100 @@
+/*
+ * Copyright © 2022 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "single_pixel_buffer_v1.h"
+
+#include "mir/graphics/solid_color_buffer.h"
+
+#include <limits>
+
+namespace mf = mir::frontend;
+namespace mg = mir::graphics;
+namespace mw = mir::wayland;
+
+namespace
+{
+class SinglePixelBufferManagerV1Global : public mw::SinglePixelBufferManagerV1::Global
+{
+public:
+    SinglePixelBufferManagerV1Global(wl_display* display);
+
+private:
+    void bind(wl_resource* new_resource) override;
+};
+
+class SinglePixelBufferManagerV1 : public mw::SinglePixelBufferManagerV1
+{
+public:
+    SinglePixelBufferManagerV1(wl_resource* resource);
+
+private:
+    void create_u32_rgba_buffer(wl_resource* id, uint32_t r, uint32_t g, uint32_t b, uint32_t a) override;
+};
+
+auto u32_to_component(uint32_t value) -> float
+{
+    return static_cast<float>(static_cast<double>(value) / std::numeric_limits<uint32_t>::max());
+}
+}
+
+auto mf::create_single_pixel_buffer_manager_v1(wl_display* display)
+-> std::shared_ptr<mw::SinglePixelBufferManagerV1::Global>
+{
+    return std::make_shared<SinglePixelBufferManagerV1Global>(display);
+}
+
+SinglePixelBufferManagerV1Global::SinglePixelBufferManagerV1Global(wl_display* display)
+    : Global{display, Version<1>()}
+{
+}
+
+void SinglePixelBufferManagerV1Global::bind(wl_resource* new_resource)
+{
+    new SinglePixelBufferManagerV1{new_resource};
+}
+
+SinglePixelBufferManagerV1::SinglePixelBufferManagerV1(wl_resource* resource)
+    : mw::SinglePixelBufferManagerV1{resource, Version<1>()}
+{
+}
+
+void SinglePixelBufferManagerV1::create_u32_rgba_buffer(
+    wl_resource* id,
+    uint32_t r,
+    uint32_t g,
+    uint32_t b,
+    uint32_t a)
+{
+    new mf::SinglePixelBufferV1{
+        id,
+        {u32_to_component(r), u32_to_component(g), u32_to_component(b), u32_to_component(a)}};
+}
+
+mf::SinglePixelBufferV1::SinglePixelBufferV1(wl_resource* new_resource, glm::vec4 const& color)
+    : mw::Buffer{new_resource, Version<1>()},
+      color{color}
+{
+}
+
+auto mf::SinglePixelBufferV1::from_wl_buffer(wl_resource* buffer) -> SinglePixelBufferV1*
+{
+    return dynamic_cast<SinglePixelBufferV1*>(mw::Buffer::from(buffer));
+}
+
+auto mf::SinglePixelBufferV1::graphics_buffer() const -> std::shared_ptr<mg::Buffer>
+{
+    return std::make_shared<mg::SolidColorBuffer>(geometry::Size{1, 1}, color);
+}
@@ -0,0 +1,58 @@
+/*
+ * Copyright © 2022 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_FRONTEND_SINGLE_PIXEL_BUFFER_V1_H_
+#define MIR_FRONTEND_SINGLE_PIXEL_BUFFER_V1_H_
+
+#include "single-pixel-buffer-v1_wrapper.h"
+#include "wayland_wrapper.h"
+
+#include <glm/glm.hpp>
+#include <memory>
+
+namespace mir
+{
+namespace graphics
+{
+class Buffer;
+}
+namespace frontend
+{
+auto create_single_pixel_buffer_manager_v1(wl_display* display)
+-> std::shared_ptr<wayland::SinglePixelBufferManagerV1::Global>;
+
+/// A wl_buffer that is one pixel of one color
+/// The color is all there is to it, so it is drawn as a graphics::SolidColorBuffer rather than being uploaded
+class SinglePixelBufferV1 : public wayland::Buffer
+{
+public:
+    /// \param color premultiplied RGBA, each component in the range [0, 1]
+    SinglePixelBufferV1(wl_resource* new_resource, glm::vec4 const& color);
+
+    /// The single pixel buffer behind a wl_buffer, or nullptr if it is some other kind of buffer
+    static auto from_wl_buffer(wl_resource* buffer) -> SinglePixelBufferV1*;
+
+    /// A graphics buffer of this buffer's color
+    /// It holds nothing from the wl_buffer, so the wl_buffer can be released as soon as this is made.
+    auto graphics_buffer() const -> std::shared_ptr<graphics::Buffer>;
+
+private:
+    glm::vec4 const color;
+};
+}
+}
+
+#endif // MIR_FRONTEND_SINGLE_PIXEL_BUFFER_V1_H_
@@ -63,7 +63,7 @@ public:
     WlCompositor(
         struct wl_display* display,
         std::shared_ptr<mir::Executor> const& wayland_executor,
-        std::shared_ptr<mir::Executor> const& frame_callback_executor,
+        std::shared_ptr<FrameExecutor> const& frame_callback_executor,
         std::shared_ptr<mg::GraphicBufferAllocator> const& allocator)
         : Global(display, Version<4>()),
           allocator{allocator},
@@ -77,7 +77,7 @@ public:
 private:
     std::shared_ptr<mg::GraphicBufferAllocator> const allocator;
     std::shared_ptr<mir::Executor> const wayland_executor;
-    std::shared_ptr<mir::Executor> const frame_callback_executor;
+    std::shared_ptr<FrameExecutor> const frame_callback_executor;
     std::map<std::pair<wl_client*, uint32_t>, std::vector<std::function<void(WlSurface*)>>> surface_callbacks;
 
     class Instance : wayland::Compositor
@@ -284,6 +284,7 @@ mf::WaylandConnector::WaylandConnector(
         input_hub,
         keyboard_observer_registrar,
         seat,
+        composite_event_filter,
         enable_key_repeat);
     output_manager = std::make_unique<mf::OutputManager>(
         display.get(),
@@ -36,6 +36,7 @@
 #include "input_method_v2.h"
 #include "idle_inhibit_v1.h"
 #include "wlr_screencopy_v1.h"
+#include "single_pixel_buffer_v1.h"
 
 #include "mir/graphics/platform.h"
 #include "mir/options/default_configuration.h"
@@ -168,6 +169,10 @@ std::vector<ExtensionBuilder> const internal_extension_builders = {
                 ctx.screen_shooter,
                 ctx.surface_stack);
         }),
+    make_extension_builder<mw::SinglePixelBufferManagerV1>([](auto const& ctx)
+        {
+            return mf::create_single_pixel_buffer_manager_v1(ctx.display);
+        }),
 };
 
 ExtensionBuilder const xwayland_builder {
@@ -265,7 +270,8 @@ auto mf::get_standard_extensions() -> std::vector<std::string>
         mw::XdgOutputManagerV1::interface_name,
         mw::TextInputManagerV1::interface_name,
         mw::TextInputManagerV2::interface_name,
-        mw::TextInputManagerV3::interface_name};
+        mw::TextInputManagerV3::interface_name,
+        mw::SinglePixelBufferManagerV1::interface_name};
 }
 
 auto mf::get_supported_extensions() -> std::vector<std::string>
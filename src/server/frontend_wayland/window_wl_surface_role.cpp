@@ -69,6 +69,7 @@ mf::WindowWlSurfaceRole::WindowWlSurfaceRole(
     OutputManager* output_manager)
     : surface{surface},
       client{client},
+      seat{seat},
       shell{shell},
       session{client->client_session()},
       output_manager{output_manager},
@@ -182,6 +183,22 @@ void mf::WindowWlSurfaceRole::initiate_interactive_resize(MirResizeEdge edge, ui
         {
             auto const timestamp = mir_input_event_get_event_time(mir_event_get_input_event(ev.get()));
             shell->request_resize(session, scene_surface, timestamp, edge);
+
+            resize_gesture = seat->on_gesture_end(
+                mir_event_get_input_event(ev.get()),
+                [self = mw::make_weak(this)]()
+                {
+                    if (self)
+                    {
+                        self.value().end_interactive_resize();
+                    }
+                });
+
+            if (!interactive_resize_in_progress)
+            {
+                interactive_resize_in_progress = true;
+                handle_resizing_change(true);
+            }
         }
     }
 }
@@ -280,6 +297,21 @@ void mf::WindowWlSurfaceRole::remove_state_now(MirWindowState state)
     }
 }
 
+void mf::WindowWlSurfaceRole::configure_acked(uint32_t serial)
+{
+    configure_throttle.configure_acked(serial);
+}
+
+void mf::WindowWlSurfaceRole::end_interactive_resize()
+{
+    resize_gesture.reset();
+    if (interactive_resize_in_progress)
+    {
+        interactive_resize_in_progress = false;
+        handle_resizing_change(false);
+    }
+}
+
 auto mf::WindowWlSurfaceRole::pending_size() const -> geom::Size
 {
     auto size = current_size();
@@ -333,6 +365,26 @@ auto mf::WindowWlSurfaceRole::is_active() const -> bool
     }
 }
 
+auto mf::WindowWlSurfaceRole::is_resizing() const -> bool
+{
+    return interactive_resize_in_progress;
+}
+
+void mf::WindowWlSurfaceRole::configure_sent(uint32_t serial)
+{
+    configure_throttle.configure_sent(serial);
+}
+
+auto mf::WindowWlSurfaceRole::hold_back_resize_configure() -> bool
+{
+    return configure_throttle.hold_back_resize(interactive_resize_in_progress);
+}
+
+auto mf::WindowWlSurfaceRole::held_back_resize_due() const -> bool
+{
+    return configure_throttle.resize_due();
+}
+
 void mf::WindowWlSurfaceRole::commit(WlSurfaceState const& state)
 {
     if (!surface)
@@ -341,6 +393,9 @@ void mf::WindowWlSurfaceRole::commit(WlSurfaceState const& state)
     }
 
     surface.value().commit(state);
+
+    configure_throttle.committed();
+
     handle_commit();
 
     auto size = pending_size();
@@ -18,6 +18,7 @@
 #define MIR_FRONTEND_WINDOW_WL_SURFACE_ROLE_H
 
 #include "wl_surface_role.h"
+#include "configure_throttle.h"
 
 #include "mir/wayland/weak.h"
 #include "mir/wayland/lifetime_tracker.h"
@@ -42,6 +43,10 @@ namespace scene
 class Surface;
 class Session;
 }
+namespace input
+{
+class EventFilter;
+}
 namespace shell
 {
 struct SurfaceSpecification;
@@ -97,6 +102,9 @@ public:
     void remove_state_now(MirWindowState state);
     void create_scene_surface();
 
+    /// The client has acked the configure with the given serial (which takes effect on its next commit)
+    void configure_acked(uint32_t serial);
+
     /// Gets called after the surface has committed (so current_size() may return the committed buffer size) but before
     /// the Mir window is modified (so if a pending size is set or a spec is applied those changes will take effect)
     virtual void handle_commit() = 0;
@@ -107,6 +115,7 @@ public:
         std::optional<geometry::Point> const& new_top_left,
         geometry::Size const& new_size) = 0;
     virtual void handle_close_request() = 0;
+    virtual void handle_resizing_change(bool /*is_now_resizing*/) {}
 
 protected:
     /// The size the window will be after the next commit
@@ -121,6 +130,16 @@ protected:
     auto window_state() const -> MirWindowState;
     auto is_active() const -> bool;
 
+    /// If an interactive resize started by the client is in progress
+    auto is_resizing() const -> bool;
+
+    /// A configure that the client must ack has been sent with the given serial
+    void configure_sent(uint32_t serial);
+    /// If the configure for a resize should be held back until the client has caught up with the last one (it is then
+    /// sent from handle_commit() once held_back_resize_due())
+    auto hold_back_resize_configure() -> bool;
+    auto held_back_resize_due() const -> bool;
+
     void commit(WlSurfaceState const& state) override;
     void surface_destroyed() override;
 
@@ -129,6 +148,7 @@ protected:
 private:
     wayland::Weak<WlSurface> const surface;
     wayland::Client* const client;
+    WlSeat* const seat;
     std::shared_ptr<shell::Shell> const shell;
     std::shared_ptr<scene::Session> const session;
     OutputManager* output_manager;
@@ -160,7 +180,14 @@ private:
 
     std::unique_ptr<shell::SurfaceSpecification> pending_changes;
 
+    ConfigureThrottle configure_throttle;
+
+    bool interactive_resize_in_progress{false};
+    /// Watches for the end of the resize gesture, which the window manager consumes so the client never sees it
+    std::shared_ptr<input::EventFilter> resize_gesture;
+
     shell::SurfaceSpecification& spec();
+    void end_interactive_resize();
 };
 
 }
@@ -23,6 +23,7 @@
 #include "wl_keyboard.h"
 #include "wl_pointer.h"
 #include "wl_touch.h"
+#include "gesture_end_filter.h"
 
 #include "mir/executor.h"
 #include "mir/wayland/client.h"
@@ -33,6 +34,7 @@
 #include "mir/input/parameter_keymap.h"
 #include "mir/input/mir_keyboard_config.h"
 #include "mir/input/keyboard_observer.h"
+#include "mir/input/composite_event_filter.h"
 #include "mir/scene/surface.h"
 
 #include <mutex>
@@ -192,6 +194,7 @@ mf::WlSeat::WlSeat(
     std::shared_ptr<mi::InputDeviceHub> const& input_hub,
     std::shared_ptr<ObserverRegistrar<input::KeyboardObserver>> const& keyboard_observer_registrar,
     std::shared_ptr<mi::Seat> const& seat,
+    std::shared_ptr<mi::CompositeEventFilter> const& event_filter,
     bool enable_key_repeat)
     :   Global(display, Version<8>()),
         keymap{std::make_shared<input::ParameterKeymap>()},
@@ -211,6 +214,8 @@ mf::WlSeat::WlSeat(
         clock{clock},
         input_hub{input_hub},
         seat{seat},
+        wayland_executor{wayland_executor},
+        event_filter{event_filter},
         enable_key_repeat{enable_key_repeat}
 {
     input_hub->add_observer(config_observer);
@@ -352,3 +357,14 @@ void mf::WlSeat::remove_focus_listener(mw::Client* client, FocusListener* listen
 {
     focus_listeners->unregister_listener(client, listener);
 }
+
+auto mf::WlSeat::on_gesture_end(
+    MirInputEvent const* gesture_start,
+    std::function<void()>&& on_end) -> std::shared_ptr<mi::EventFilter>
+{
+    auto const filter = std::make_shared<GestureEndFilter>(gesture_start, wayland_executor, std::move(on_end));
+    // Ahead of the window manager, which consumes the input of its own gestures
+    event_filter->prepend(filter);
+    // When the filter is dropped it is automatically removed from the composite filter
+    return filter;
+}
@@ -24,6 +24,8 @@
 #include <vector>
 #include <functional>
 
+struct MirInputEvent;
+
 namespace mir
 {
 class Executor;
@@ -35,6 +37,8 @@ class InputDeviceHub;
 class Seat;
 class Keymap;
 class KeyboardObserver;
+class CompositeEventFilter;
+class EventFilter;
 }
 namespace time
 {
@@ -59,6 +63,7 @@ public:
         std::shared_ptr<mir::input::InputDeviceHub> const& input_hub,
         std::shared_ptr<ObserverRegistrar<input::KeyboardObserver>> const& keyboard_observer_registrar,
         std::shared_ptr<mir::input::Seat> const& seat,
+        std::shared_ptr<input::CompositeEventFilter> const& event_filter,
         bool enable_key_repeat);
 
     ~WlSeat();
@@ -88,6 +93,13 @@ public:
     void add_focus_listener(wayland::Client* client, FocusListener* listener);
     void remove_focus_listener(wayland::Client* client, FocusListener* listener);
 
+    /// Calls on_end on the Wayland thread once the pointer or touch gesture that started with gesture_start ends (every
+    /// button or touch is released), even if the window manager consumes the input that ends it. Stops watching when
+    /// the returned handle is dropped.
+    auto on_gesture_end(
+        MirInputEvent const* gesture_start,
+        std::function<void()>&& on_end) -> std::shared_ptr<input::EventFilter>;
+
 private:
     void set_focus_to(WlSurface* surface);
 
@@ -116,6 +128,8 @@ private:
     std::shared_ptr<time::Clock> const clock;
     std::shared_ptr<input::InputDeviceHub> const input_hub;
     std::shared_ptr<input::Seat> const seat;
+    Executor& wayland_executor;
+    std::shared_ptr<input::CompositeEventFilter> const event_filter;
     bool const enable_key_repeat;
 
     void bind(wl_resource* new_wl_seat) override;
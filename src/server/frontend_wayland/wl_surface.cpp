@@ -20,7 +20,9 @@
 #include "wl_surface_role.h"
 #include "wl_subcompositor.h"
 #include "wl_region.h"
+#include "single_pixel_buffer_v1.h"
 #include "deleted_for_resource.h"
+#include "frame_executor.h"
 
 #include "wayland_wrapper.h"
 
@@ -84,7 +86,7 @@ bool mf::WlSurfaceState::surface_data_needs_refresh() const
 mf::WlSurface::WlSurface(
     wl_resource* new_resource,
     std::shared_ptr<Executor> const& wayland_executor,
-    std::shared_ptr<Executor> const& frame_callback_executor,
+    std::shared_ptr<FrameExecutor> const& frame_callback_executor,
     std::shared_ptr<graphics::GraphicBufferAllocator> const& allocator)
     : Surface(new_resource, Version<4>()),
         session{client->client_session()},
@@ -250,6 +252,65 @@ void mf::WlSurface::send_frame_callbacks()
     frame_callbacks.clear();
 }
 
+void mf::pace_frame_callbacks(
+    compositor::BufferStream& stream,
+    FrameExecutor& frame_callback_executor,
+    std::optional<std::shared_ptr<scene::Surface>> const& scene_surface,
+    bool new_buffer,
+    std::function<void()> const& send_frame_callbacks)
+{
+    // Whichever of these comes first sends the callbacks; the others find none left to send
+    stream.on_next_repaint(send_frame_callbacks);
+
+    if (!scene_surface || !scene_surface.value())
+    {
+        // Not part of the scene (e.g. a cursor), so not repainted by the compositor either
+        frame_callback_executor.spawn(std::function<void()>{send_frame_callbacks});
+        return;
+    }
+
+    // The rendering tracker marks the window occluded once no output shows any of it
+    bool const hidden =
+        !scene_surface.value()->visible() ||
+        scene_surface.value()->query(mir_window_attrib_visibility) == mir_window_visibility_occluded;
+
+    if (hidden || new_buffer)
+    {
+        // Nothing will repaint a hidden surface, and a new buffer is waiting on a repaint unless the compositor
+        // isn't running at all. Either way the client shouldn't spin.
+        frame_callback_executor.spawn_throttled(std::function<void()>{send_frame_callbacks});
+    }
+    else
+    {
+        // Nothing is waiting to be shown, so the surface may not be repainted at all
+        frame_callback_executor.spawn(std::function<void()>{send_frame_callbacks});
+    }
+}
+
+void mf::WlSurface::schedule_frame_callbacks(bool new_buffer)
+{
+    if (frame_callbacks.empty())
+    {
+        return;
+    }
+
+    pace_frame_callbacks(
+        *stream,
+        *frame_callback_executor,
+        scene_surface(),
+        new_buffer,
+        [executor = wayland_executor, weak_self = mw::make_weak(this)]()
+        {
+            executor->spawn([weak_self]()
+                {
+                    if (weak_self)
+                    {
+                        weak_self.value().send_frame_callbacks();
+                    }
+                });
+        });
+}
+
 void mf::WlSurface::attach(std::optional<wl_resource*> const& buffer, int32_t x, int32_t y)
 {
     if (x != 0 || y != 0)
@@ -351,17 +412,6 @@ void mf::WlSurface::commit(WlSurfaceState const& state)
     if (state.scale)
         stream->set_scale(state.scale.value());
 
-    auto const executor_send_frame_callbacks = [executor = wayland_executor, weak_self = mw::make_weak(this)]()
-        {
-            executor->spawn([weak_self]()
-                {
-                    if (weak_self)
-                    {
-                        weak_self.value().send_frame_callbacks();
-                    }
-                });
-        };
-
     if (state.buffer)
     {
         wl_resource * buffer = *state.buffer;
@@ -376,7 +426,13 @@ void mf::WlSurface::commit(WlSurfaceState const& state)
         {
             std::shared_ptr<graphics::Buffer> mir_buffer;
 
-            if (auto const shm_buffer = wl_shm_buffer_get(buffer))
+            if (auto const single_pixel_buffer = SinglePixelBufferV1::from_wl_buffer(buffer))
+            {
+                // Nothing is read from the wl_buffer after this, so the client can have it straight back
+                mir_buffer = single_pixel_buffer->graphics_buffer();
+                single_pixel_buffer->send_release_event();
+            }
+            else if (auto const shm_buffer = wl_shm_buffer_get(buffer))
             {
                 auto const stride = wl_shm_buffer_get_stride(shm_buffer);
                 auto const width = wl_shm_buffer_get_width(shm_buffer);
@@ -392,10 +448,11 @@ void mf::WlSurface::commit(WlSurfaceState const& state)
                     BOOST_THROW_EXCEPTION((
                                               std::runtime_error{"Buffer has invalid stride"}));
                 }
+                // Frame callbacks wait for the compositor to show the buffer, not just to upload it
                 mir_buffer = allocator->buffer_from_shm(
                     buffer,
                     wayland_executor,
-                    std::move(executor_send_frame_callbacks));
+                    [](){});
                 tracepoint(
                     mir_server_wayland,
                     sw_buffer_committed,
@@ -415,7 +472,7 @@ void mf::WlSurface::commit(WlSurfaceState const& state)
 
                 mir_buffer = allocator->buffer_from_resource(
                     buffer,
-                    std::move(executor_send_frame_callbacks),
+                    [](){},
                     std::move(release_buffer));
                 tracepoint(
                     mir_server_wayland,
@@ -433,11 +490,12 @@ void mf::WlSurface::commit(WlSurfaceState const& state)
             }
 
             buffer_size_ = new_buffer_size;
+            schedule_frame_callbacks(true);
         }
     }
     else
     {
-        frame_callback_executor->spawn(std::move(executor_send_frame_callbacks));
+        schedule_frame_callbacks(false);
     }
 
     for (WlSubsurface* child: children)
@@ -27,8 +27,11 @@
 #include "mir/geometry/point.h"
 #include "mir/geometry/rectangle.h"
 
-#include <vector>
+#include <functional>
 #include <map>
+#include <memory>
+#include <optional>
+#include <vector>
 
 namespace mir
 {
@@ -41,6 +44,7 @@ class GraphicBufferAllocator;
 namespace scene
 {
 class Session;
+class Surface;
 }
 namespace shell
 {
@@ -54,6 +58,19 @@ namespace frontend
 {
 class WlSurface;
 class WlSubsurface;
+class FrameExecutor;
+
+/// Arranges for send_frame_callbacks to run when a surface's frame callbacks are due
+/// That is when a compositor next repaints the stream, or at a throttled rate if the surface is hidden or no repaint
+/// comes. Whichever happens first runs it; send_frame_callbacks must cope with being run again after that.
+/// \param scene_surface   The surface the stream is shown in, if any
+/// \param new_buffer      Whether a new buffer was just submitted to the stream
+void pace_frame_callbacks(
+    compositor::BufferStream& stream,
+    FrameExecutor& frame_callback_executor,
+    std::optional<std::shared_ptr<scene::Surface>> const& scene_surface,
+    bool new_buffer,
+    std::function<void()> const& send_frame_callbacks);
 
 struct WlSurfaceState
 {
@@ -106,7 +123,7 @@ class WlSurface : public wayland::Surface
 public:
     WlSurface(wl_resource* new_resource,
               std::shared_ptr<mir::Executor> const& wayland_executor,
-              std::shared_ptr<mir::Executor> const& frame_callback_executor,
+              std::shared_ptr<FrameExecutor> const& frame_callback_executor,
               std::shared_ptr<graphics::GraphicBufferAllocator> const& allocator);
 
     ~WlSurface();
@@ -140,7 +157,7 @@ public:
 private:
     std::shared_ptr<mir::graphics::GraphicBufferAllocator> const allocator;
     std::shared_ptr<mir::Executor> const wayland_executor;
-    std::shared_ptr<mir::Executor> const frame_callback_executor;
+    std::shared_ptr<FrameExecutor> const frame_callback_executor;
 
     NullWlSurfaceRole null_role;
     WlSurfaceRole* role;
@@ -153,6 +170,8 @@ private:
     std::optional<std::vector<mir::geometry::Rectangle>> input_shape;
 
     void send_frame_callbacks();
+    /// Arrange for the frame callbacks to be sent once the surface is next repainted, or throttled if it's not visible
+    void schedule_frame_callbacks(bool new_buffer);
 
     void attach(std::optional<wl_resource*> const& buffer, int32_t x, int32_t y) override;
     void damage(int32_t x, int32_t y, int32_t width, int32_t height) override;
@@ -29,6 +29,7 @@
 #include "wayland_wrapper.h"
 #include "wayland_timespec.h"
 #include "output_manager.h"
+#include "deleted_for_resource.h"
 
 #include <boost/throw_exception.hpp>
 #include <mutex>
@@ -119,6 +120,11 @@ public:
 
     void capture_on_damage(WlrScreencopyV1DamageTracker::Frame* frame);
 
+    /// Forget and return whether \a buffer holds the last capture of \a params made through this manager
+    auto take_last_capture(wl_resource* buffer, WlrScreencopyV1DamageTracker::FrameParams const& params) -> bool;
+    /// Remember that \a buffer now holds a capture of \a params
+    void set_last_capture(wl_resource* buffer, WlrScreencopyV1DamageTracker::FrameParams const& params);
+
 private:
     /// From wayland::WlrScreencopyManagerV1
     /// @{
@@ -133,6 +139,18 @@ private:
 
     std::shared_ptr<WlrScreencopyV1Ctx> const ctx;
     WlrScreencopyV1DamageTracker damage_tracker;
+
+    /// Clients usually capture into the same few buffers over and over, so if they hand back the buffer holding the
+    /// last capture, only the damage since then needs writing to it
+    struct LastCapture
+    {
+        /// The wl_buffer, rather than its memory, as a new buffer can be mapped where a destroyed one was
+        wl_resource* buffer;
+        /// Set once the wl_buffer is destroyed, after which its address may be reused for another
+        std::shared_ptr<bool> buffer_destroyed;
+        WlrScreencopyV1DamageTracker::FrameParams params;
+    };
+    std::optional<LastCapture> last_capture;
 };
 
 class WlrScreencopyFrameV1
@@ -173,6 +191,8 @@ private:
     bool copy_has_been_called{false};
     bool should_send_damage{false};
     std::shared_ptr<renderer::software::WriteMappableBuffer> target;
+    wl_resource* target_buffer{nullptr};    ///< The wl_buffer behind target, to recognise it when it comes back
+    std::shared_ptr<bool> target_buffer_destroyed;
     /// @}
 };
 }
@@ -369,6 +389,26 @@ void mf::WlrScreencopyManagerV1::capture_on_damage(WlrScreencopyV1DamageTracker:
     damage_tracker.capture_on_damage(frame);
 }
 
+auto mf::WlrScreencopyManagerV1::take_last_capture(
+    wl_resource* buffer,
+    WlrScreencopyV1DamageTracker::FrameParams const& params) -> bool
+{
+    auto const result =
+        last_capture &&
+        !*last_capture->buffer_destroyed &&
+        last_capture->buffer == buffer &&
+        last_capture->params == params;
+    last_capture.reset();
+    return result;
+}
+
+void mf::WlrScreencopyManagerV1::set_last_capture(
+    wl_resource* buffer,
+    WlrScreencopyV1DamageTracker::FrameParams const& params)
+{
+    last_capture = LastCapture{buffer, deleted_flag_for_resource(buffer), params};
+}
+
 void mf::WlrScreencopyManagerV1::capture_output(
     wl_resource* frame,
     int32_t overlay_cursor,
@@ -424,9 +464,8 @@ void mf::WlrScreencopyFrameV1::capture(geom::Rectangle buffer_space_damage)
             "WlrScreencopyFrameV1::capture() called without a target, copy %s been called",
             copy_has_been_called ? "has" : "has not");
     }
-    ctx->screen_shooter->capture(std::move(target), params.output_space_area,
-        [wayland_executor=ctx->wayland_executor, buffer_space_damage, self=mw::make_weak(this)]
-            (std::optional<time::Timestamp> captured_time)
+    auto callback = [wayland_executor=ctx->wayland_executor, buffer_space_damage, self=mw::make_weak(this)]
+        (std::optional<time::Timestamp> captured_time)
         {
             wayland_executor->spawn([self, captured_time, buffer_space_damage]()
                 {
@@ -435,7 +474,27 @@ void mf::WlrScreencopyFrameV1::capture(geom::Rectangle buffer_space_damage)
                         self.value().report_result(captured_time, buffer_space_damage);
                     }
                 });
-        });
+        };
+
+    if (should_send_damage && manager && manager.value().take_last_capture(target_buffer, params))
+    {
+        auto damage = buffer_space_damage;
+        if (damage.size != geom::Size{})
+        {
+            // Scaling the damage into buffer space can round it down, so grow it by a pixel to cover the edges
+            damage.top_left = damage.top_left - geom::Displacement{1, 1};
+            damage.size = {damage.size.width.as_int() + 2, damage.size.height.as_int() + 2};
+        }
+        ctx->screen_shooter->capture_damage(
+            std::move(target),
+            params.output_space_area,
+            damage,
+            std::move(callback));
+    }
+    else
+    {
+        ctx->screen_shooter->capture(std::move(target), params.output_space_area, std::move(callback));
+    }
 }
 
 void mf::WlrScreencopyFrameV1::prepare_target(wl_resource* buffer)
@@ -449,8 +508,15 @@ void mf::WlrScreencopyFrameV1::prepare_target(wl_resource* buffer)
     }
     copy_has_been_called = true;
     auto graphics_buffer = ctx->allocator->buffer_from_shm(buffer, ctx->wayland_executor, [](){});
-    if (graphics_buffer->pixel_format() != mir_pixel_format_argb_8888)
+    switch (graphics_buffer->pixel_format())
     {
+    case mir_pixel_format_argb_8888:
+    case mir_pixel_format_xrgb_8888:
+    case mir_pixel_format_abgr_8888:
+    case mir_pixel_format_xbgr_8888:
+        break;
+
+    default:
         BOOST_THROW_EXCEPTION(mw::ProtocolError(
             resource,
             Error::invalid_buffer,
@@ -468,16 +534,19 @@ void mf::WlrScreencopyFrameV1::prepare_target(wl_resource* buffer)
             params.buffer_size.width.as_int(),
             params.buffer_size.height.as_int()));
     }
-    auto const buffer_stride = geom::Stride{wl_shm_buffer_get_stride(wl_shm_buffer_get(buffer))};
-    if (buffer_stride != stride)
+    auto const shm_buffer = wl_shm_buffer_get(buffer);
+    auto const buffer_stride = geom::Stride{wl_shm_buffer_get_stride(shm_buffer)};
+    if (buffer_stride < stride)
     {
         BOOST_THROW_EXCEPTION(mw::ProtocolError(
             resource,
             Error::invalid_buffer,
-            "Invalid stride %d, should be %d",
+            "Invalid stride %d, should be at least %d",
             buffer_stride.as_int(),
             stride.as_int()));
     }
+    target_buffer = buffer;
+    target_buffer_destroyed = deleted_flag_for_resource(buffer);
     target = std::dynamic_pointer_cast<renderer::software::WriteMappableBuffer>(std::move(graphics_buffer));
     if (!target)
     {
@@ -491,6 +560,12 @@ void mf::WlrScreencopyFrameV1::report_result(
 {
     if (captured_time)
     {
+        // If the client destroyed the buffer while we were writing to it there's nothing to remember
+        if (should_send_damage && manager && !*target_buffer_destroyed)
+        {
+            manager.value().set_last_capture(target_buffer, params);
+        }
+
         send_flags_event(Flags::y_invert);
 
         if (should_send_damage)
@@ -56,7 +56,8 @@ public:
     void set_window_geometry(int32_t x, int32_t y, int32_t width, int32_t height) override;
     void ack_configure(uint32_t serial) override;
 
-    void send_configure();
+    /// Returns the serial of the configure sent
+    auto send_configure() -> uint32_t;
 
     mw::Weak<WindowWlSurfaceRole> const& window_role();
 
@@ -95,11 +96,12 @@ public:
     void unset_fullscreen() override;
     void set_minimized() override;
 
-    void handle_commit() override {};
+    void handle_commit() override;
     void handle_state_change(MirWindowState /*new_state*/) override;
     void handle_active_change(bool /*is_now_active*/) override;
     void handle_resize(std::optional<geometry::Point> const& new_top_left, geometry::Size const& new_size) override;
     void handle_close_request() override;
+    void handle_resizing_change(bool /*is_now_resizing*/) override;
 
 private:
     static XdgToplevelStable* from(wl_resource* surface);
@@ -246,14 +248,17 @@ void mf::XdgSurfaceStable::set_window_geometry(int32_t x, int32_t y, int32_t wid
 
 void mf::XdgSurfaceStable::ack_configure(uint32_t serial)
 {
-    (void)serial;
-    // TODO
+    if (window_role_)
+    {
+        window_role_.value().configure_acked(serial);
+    }
 }
 
-void mf::XdgSurfaceStable::send_configure()
+auto mf::XdgSurfaceStable::send_configure() -> uint32_t
 {
     auto const serial = client->next_serial(nullptr);
     send_configure_event(serial);
+    return serial;
 }
 
 mw::Weak<mf::WindowWlSurfaceRole> const& mf::XdgSurfaceStable::window_role()
@@ -403,7 +408,7 @@ mf::XdgToplevelStable::XdgToplevelStable(wl_resource* new_resource, XdgSurfaceSt
     wl_array_init(&states);
     send_configure_event(0, 0, &states);
     wl_array_release(&states);
-    xdg_surface->send_configure();
+    configure_sent(xdg_surface->send_configure());
 }
 
 void mf::XdgToplevelStable::set_parent(std::optional<struct wl_resource*> const& parent)
@@ -523,6 +528,14 @@ void mf::XdgToplevelStable::set_minimized()
     add_state_now(mir_window_state_minimized);
 }
 
+void mf::XdgToplevelStable::handle_commit()
+{
+    if (held_back_resize_due())
+    {
+        send_toplevel_configure();
+    }
+}
+
 void mf::XdgToplevelStable::handle_state_change(MirWindowState /*new_state*/)
 {
     send_toplevel_configure();
@@ -537,6 +550,13 @@ void mf::XdgToplevelStable::handle_resize(
     std::optional<geometry::Point> const& /*new_top_left*/,
     geometry::Size const& /*new_size*/)
 {
+    if (hold_back_resize_configure())
+    {
+        // Rather than pile up configures the client would render stale sizes for, send the latest size once it has
+        // acked and committed the last one (see handle_commit())
+        return;
+    }
+
     send_toplevel_configure();
 }
 
@@ -545,6 +565,12 @@ void mf::XdgToplevelStable::handle_close_request()
     send_close_event();
 }
 
+void mf::XdgToplevelStable::handle_resizing_change(bool /*is_now_resizing*/)
+{
+    // Also sends the final size of a resize, if it has been held back
+    send_toplevel_configure();
+}
+
 void mf::XdgToplevelStable::send_toplevel_configure()
 {
     wl_array states;
@@ -574,7 +600,11 @@ void mf::XdgToplevelStable::send_toplevel_configure()
                 *state = State::fullscreen;
         }
 
-        // TODO: plumb resizing state through Mir?
+        if (is_resizing())
+        {
+            if (uint32_t *state = static_cast<decltype(state)>(wl_array_add(&states, sizeof *state)))
+                *state = State::resizing;
+        }
     }
 
     // 0 sizes means default for toplevel configure
@@ -583,7 +613,7 @@ void mf::XdgToplevelStable::send_toplevel_configure()
     send_configure_event(size.width.as_int(), size.height.as_int(), &states);
     wl_array_release(&states);
 
-    xdg_surface->send_configure();
+    configure_sent(xdg_surface->send_configure());
 }
 
 mf::XdgToplevelStable* mf::XdgToplevelStable::from(wl_resource* surface)
@@ -89,3 +89,8 @@ auto mf::ScaledBufferStream::framedropping() const -> bool
 }
 
 
+
+void mf::ScaledBufferStream::on_next_repaint(std::function<void()> const& callback)
+{
+    inner->on_next_repaint(callback);
+}
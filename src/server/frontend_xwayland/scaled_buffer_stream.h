@@ -51,6 +51,7 @@ public:
     void drop_old_buffers();
     auto has_submitted_buffer() const -> bool;
     auto framedropping() const -> bool;
+    void on_next_repaint(std::function<void()> const& callback);
     /// @}
 
 private:
@@ -25,6 +25,8 @@
 #include <string.h>
 #include <fcntl.h>
 #include <unistd.h>
+#include <algorithm>
+#include <vector>
 
 namespace mf = mir::frontend;
 namespace ms = mir::scene;
@@ -32,7 +34,19 @@ namespace md = mir::dispatch;
 
 namespace
 {
-size_t const increment_chunk_size = 64 * 1024;
+/// The size of the buffer clipboard data is first read into. It grows as needed, up to the largest chunk we can send.
+size_t const initial_buffer_size = 64 * 1024;
+/// The most clipboard data sent in one property, even if the X server would accept more
+size_t const max_chunk_size_limit = 4 * 1024 * 1024;
+
+/// The most data the X server accepts in a single ChangeProperty request (up to max_chunk_size_limit). Anything larger
+/// needs an incremental transfer.
+auto max_chunk_size_for(mf::XCBConnection const& connection) -> size_t
+{
+    // The maximum request length is in 4-byte units, and includes the 24 byte ChangeProperty header
+    size_t const max_request_size = xcb_get_maximum_request_length(connection) * size_t{4};
+    return std::min(max_request_size - 24, max_chunk_size_limit);
+}
 
 auto create_selection_window(mf::XCBConnection const& connection) -> xcb_window_t
 {
@@ -93,7 +107,8 @@ public:
         xcb_window_t requester,
         xcb_atom_t selection,
         xcb_atom_t property,
-        xcb_atom_t target)
+        xcb_atom_t target,
+        size_t max_chunk_size)
         : connection{connection},
           provider{provider},
           source_fd{std::move(source_fd)},
@@ -102,10 +117,12 @@ public:
           selection{selection},
           property{property},
           target{target},
-          buffer_size{increment_chunk_size},
+          max_chunk_size{max_chunk_size},
           data_size{0},
-          buffer{new uint8_t[buffer_size]}
+          buffer(std::min(initial_buffer_size, max_chunk_size))
     {
+        // Other transfers share our dispatcher, so a slow source must not block it
+        fcntl(this->source_fd, F_SETFL, fcntl(this->source_fd, F_GETFL) | O_NONBLOCK);
     }
 
 private:
@@ -125,45 +142,59 @@ private:
 
         if (events & md::FdEvent::readable || events & md::FdEvent::remote_closed)
         {
-            auto const free_space = buffer_size - data_size;
-            ssize_t len = 0;
-            if (free_space > 0)
+            // Read all the data that's available, growing the buffer as needed up to the largest chunk we can send
+            bool hit_eof = false;
+            while (!hit_eof)
             {
-                len = read(source_fd, buffer.get() + data_size, free_space);
+                if (data_size == buffer.size())
+                {
+                    if (buffer.size() >= max_chunk_size)
+                    {
+                        break;
+                    }
+                    buffer.resize(std::min(buffer.size() * 2, max_chunk_size));
+                }
+
+                auto const len = read(source_fd, buffer.data() + data_size, buffer.size() - data_size);
                 if (len < 0)
                 {
+                    if (errno == EINTR)
+                    {
+                        continue;
+                    }
+                    if (errno == EAGAIN)
+                    {
+                        // We haven't filled up the buffer or hit EOF, so keep reading when there's more
+                        return true;
+                    }
                     // Error reading from fd
                     notify_cancelled(strerror(errno));
                     return false;
                 }
+                hit_eof = len == 0;
                 data_size += len;
             }
 
-            if (len == 0)
-            {
-                // We've either hit EOF or filled up our buffer
+            // We've either hit EOF or filled up our buffer
 
-                if (incremental_transfer_in_progress)
-                {
-                    // Time to send more data.
-                    progress_incremental_transfer();
-                }
-                else if (free_space == 0)
-                {
-                    // We filled up the buffer. Long buffers need to use incremental transfers.
-                    initiate_incremental_transfer();
-                }
-                else
-                {
-                    // We hit EOF before filling up the buffer, so we send all data to the X11 client in one go
-                    send_all_data_in_single_transfer();
-                }
-
-                // in any case, we don't want to keep reading
-                return false;
+            if (incremental_transfer_in_progress)
+            {
+                // Time to send more data.
+                progress_incremental_transfer();
+            }
+            else if (!hit_eof)
+            {
+                // We filled up the buffer. Long buffers need to use incremental transfers.
+                initiate_incremental_transfer();
+            }
+            else
+            {
+                // We hit EOF before filling up the buffer, so we send all data to the X11 client in one go
+                send_all_data_in_single_transfer();
             }
 
-            // If we haven't filled up the buffer or hit EOF, keep reading by returning true
+            // in any case, we don't want to keep reading
+            return false;
         }
 
         return true;
@@ -185,7 +216,7 @@ private:
             target,
             8, // format
             data_size,
-            buffer.get());
+            buffer.data());
         notify_sent();
         connection->flush();
     }
@@ -227,7 +258,7 @@ private:
             target,
             8, // format
             data_size,
-            buffer.get());
+            buffer.data());
         connection->flush();
         bool const still_sending = data_size > 0;
         data_size = 0;
@@ -267,10 +298,10 @@ private:
     xcb_atom_t const selection;
     xcb_atom_t const property;
     xcb_atom_t const target;
-    size_t const buffer_size; ///< the size of the allocated memory
+    size_t const max_chunk_size; ///< the most data sent in one property
     bool incremental_transfer_in_progress = false;
     size_t data_size; ///< how much of the buffer is being used
-    std::unique_ptr<uint8_t[]> const buffer;
+    std::vector<uint8_t> buffer;
 };
 
 class mf::XWaylandClipboardProvider::ClipboardObserver : public scene::ClipboardObserver
@@ -299,7 +330,8 @@ mf::XWaylandClipboardProvider::XWaylandClipboardProvider(
       dispatcher{dispatcher},
       clipboard{clipboard},
       clipboard_observer{std::make_shared<ClipboardObserver>(this)},
-      selection_window{create_selection_window(*connection)}
+      selection_window{create_selection_window(*connection)},
+      max_chunk_size{max_chunk_size_for(*connection)}
 {
     clipboard->register_interest(clipboard_observer);
     if (auto const source = clipboard->paste_source())
@@ -387,6 +419,8 @@ void mf::XWaylandClipboardProvider::xfixes_selection_notify_event(xcb_xfixes_sel
 void mf::XWaylandClipboardProvider::property_deleted_event(xcb_window_t window, xcb_atom_t property)
 {
     auto const window_prop = std::make_pair(window, property);
+    // Senders defer themselves from the dispatcher thread
+    std::lock_guard lock{threadsafe_self->mutex};
     auto const iter = pending_incremental_sends.find(window_prop);
     if (iter != pending_incremental_sends.end())
     {
@@ -468,7 +502,8 @@ void mf::XWaylandClipboardProvider::send_data(
         requester,
         connection->CLIPBOARD,
         property,
-        target));
+        target,
+        max_chunk_size));
 }
 
 void mf::XWaylandClipboardProvider::paste_source_set(std::shared_ptr<ms::ClipboardSource> const& source)
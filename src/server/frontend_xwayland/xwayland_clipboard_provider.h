@@ -103,6 +103,8 @@ private:
     std::shared_ptr<scene::Clipboard> const clipboard;
     std::shared_ptr<ClipboardObserver> const clipboard_observer;
     xcb_window_t const selection_window;
+    /// The most data we send to X11 in one property. Larger selections are sent incrementally in chunks of this size.
+    size_t const max_chunk_size;
 
     std::mutex mutex;
     /// The timestamp of when we took ownership of the clipboard. May be XCB_TIME_CURRENT_TIME or outdated if we haven't
@@ -111,7 +113,7 @@ private:
     /// The source X11 clients can paste from. Should never be a source from this XWayland connection. Can be null
     std::shared_ptr<scene::ClipboardSource> current_source;
     /// Maps window/property pairs to SelectionSender's that are waiting for those properties to be deleted in order to
-    /// continue an incremental send.
+    /// continue an incremental send. Guarded by threadsafe_self->mutex, as senders add themselves from the dispatcher.
     std::map<std::pair<xcb_window_t, xcb_atom_t>, std::shared_ptr<SelectionSender>> pending_incremental_sends;
 };
 }
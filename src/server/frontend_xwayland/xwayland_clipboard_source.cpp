@@ -22,8 +22,11 @@
 
 #include <xcb/xfixes.h>
 #include <string.h>
+#include <fcntl.h>
+#include <sys/uio.h>
 #include <unistd.h>
-#include <map>
+#include <array>
+#include <deque>
 #include <set>
 
 namespace mf = mir::frontend;
@@ -32,21 +35,32 @@ namespace md = mir::dispatch;
 
 namespace
 {
-auto create_receiving_window(mf::XCBConnection const& connection) -> xcb_window_t
+/// The most chunks of clipboard data written to a Wayland client in one writev()
+size_t const max_chunks_per_write = 16;
+
+/// Creates a window that we get property change events for, that X11 clients can put selection data on
+auto create_property_window(mf::XCBConnection const& connection) -> xcb_window_t
 {
     uint32_t const attrib_values[]{XCB_EVENT_MASK_PROPERTY_CHANGE};
 
-    xcb_window_t const receiving_window = xcb_generate_id(connection);
+    xcb_window_t const window = xcb_generate_id(connection);
     xcb_create_window(
         connection,
         XCB_COPY_FROM_PARENT,
-        receiving_window,
+        window,
         connection.root_window(),
         0, 0, 10, 10, 0,
         XCB_WINDOW_CLASS_INPUT_OUTPUT,
         connection.screen()->root_visual,
         XCB_CW_EVENT_MASK, attrib_values);
 
+    return window;
+}
+
+auto create_receiving_window(mf::XCBConnection const& connection) -> xcb_window_t
+{
+    xcb_window_t const receiving_window = create_property_window(connection);
+
     xcb_set_selection_owner(connection, receiving_window, connection.CLIPBOARD_MANAGER, XCB_TIME_CURRENT_TIME);
 
     uint32_t const mask =
@@ -122,21 +136,16 @@ public:
     DataSender(mir::Fd const& destination_fd)
         : destination_fd{destination_fd}
     {
+        // Other transfers share our dispatcher, so a slow reader must not block it
+        fcntl(destination_fd, F_SETFL, fcntl(destination_fd, F_GETFL) | O_NONBLOCK);
     }
 
     /// Returns if the previous buffer was empty. If return value is true, this needs to be added to the dispatcher.
     auto add_data(std::vector<uint8_t>&& new_data) -> bool {
         std::lock_guard lock{mutex};
-        if (data.empty())
-        {
-            data = std::move(new_data);
-            return true;
-        }
-        else
-        {
-            data.insert(data.end(), new_data.begin(), new_data.end());
-            return false;
-        }
+        auto const was_empty = chunks.empty();
+        chunks.push_back(std::move(new_data));
+        return was_empty;
     }
 
 private:
@@ -163,16 +172,41 @@ private:
 
         if (events & md::FdEvent::writable)
         {
-            auto const len = write(destination_fd, &data[0], data.size());
+            // Write as much of the queued data as the fd will take
+            std::array<iovec, max_chunks_per_write> iov;
+            size_t iov_count = 0;
+            for (auto chunk = chunks.begin(); chunk != chunks.end() && iov_count != iov.size(); ++chunk, ++iov_count)
+            {
+                auto const offset = chunk == chunks.begin() ? front_chunk_offset : 0;
+                iov[iov_count] = {chunk->data() + offset, chunk->size() - offset};
+            }
+
+            auto const len = writev(destination_fd, iov.data(), iov_count);
             if (len < 0)
             {
+                if (errno == EAGAIN || errno == EINTR)
+                {
+                    return true;
+                }
                 mir::log_error("failed to send X11 clipboard data: %s", strerror(errno));
                 return false;
             }
-            data.erase(data.begin(), data.begin() + len);
+
+            for (auto written = static_cast<size_t>(len); written > 0;)
+            {
+                auto const remaining = chunks.front().size() - front_chunk_offset;
+                if (written < remaining)
+                {
+                    front_chunk_offset += written;
+                    break;
+                }
+                written -= remaining;
+                chunks.pop_front();
+                front_chunk_offset = 0;
+            }
         }
 
-        return !data.empty();
+        return !chunks.empty();
     }
 
     auto relevant_events() const -> md::FdEvents override
@@ -183,7 +217,10 @@ private:
     mir::Fd const destination_fd;
 
     std::mutex mutex;
-    std::vector<uint8_t> data;
+    /// The data still to be written, in the chunks it was read from X11 in
+    std::deque<std::vector<uint8_t>> chunks;
+    /// How much of the first chunk has been written
+    size_t front_chunk_offset{0};
 };
 
 mf::XWaylandClipboardSource::XWaylandClipboardSource(
@@ -224,30 +261,36 @@ mf::XWaylandClipboardSource::~XWaylandClipboardSource()
         source_to_reset->invalidate_owner();
     }
 
+    lock.lock();
+    for (auto const& send : in_progress_sends)
+    {
+        xcb_destroy_window(connection, send.first);
+    }
+    in_progress_sends.clear();
+    lock.unlock();
+
     xcb_destroy_window(connection, receiving_window);
     connection.flush();
 }
 
 void mf::XWaylandClipboardSource::initiate_send(xcb_atom_t target_type, Fd const& receiver_fd)
 {
-    std::unique_lock lock{mutex};
-    if (in_progress_send)
+    // Each send gets a window of its own, so any number can be in progress at once
+    auto const window = create_property_window(connection);
     {
-        log_error("can not send clipboard data from X11 because another send is currently in progress");
-        return;
+        std::lock_guard lock{mutex};
+        in_progress_sends[window] = {std::make_shared<DataSender>(receiver_fd)};
     }
-    in_progress_send = std::make_shared<DataSender>(receiver_fd);
-    lock.unlock();
 
     if (verbose_xwayland_logging_enabled())
     {
         log_info("Initiating clipboard data send from X11");
     }
 
-    // This will cause the client to load the data into receiving_window._WL_SELECTION
+    // This will cause the client to load the data into window._WL_SELECTION
     xcb_convert_selection(
         connection,
-        receiving_window,
+        window,
         connection.CLIPBOARD,
         target_type,
         connection._WL_SELECTION,
@@ -259,7 +302,28 @@ void mf::XWaylandClipboardSource::initiate_send(xcb_atom_t target_type, Fd const
 
 void mf::XWaylandClipboardSource::selection_notify_event(xcb_selection_notify_event_t* event)
 {
-    if (event->property != connection._WL_SELECTION)
+    if (event->requestor != receiving_window)
+    {
+        // A send from our source has been requested, and the data is now loaded into a property on the send's window
+        // (unless the conversion failed). We will now read it out and give it to the send's DataSender, which will
+        // write it to the receiver fd
+
+        std::lock_guard lock{mutex};
+        if (event->property != connection._WL_SELECTION)
+        {
+            log_warning("X11 client failed to provide clipboard data");
+            end_in_progress_send(lock, event->requestor);
+        }
+        else
+        {
+            if (verbose_xwayland_logging_enabled())
+            {
+                log_info("Clipboard data from X11 client is ready");
+            }
+            read_and_send_wl_selection_data(lock, event->requestor);
+        }
+    }
+    else if (event->property != connection._WL_SELECTION)
     {
         // Convert selection failed
     }
@@ -284,19 +348,6 @@ void mf::XWaylandClipboardSource::selection_notify_event(xcb_selection_notify_ev
 
         completion();
     }
-    else
-    {
-        // A send from our source has been requested, and the data is now loaded into a property on our window. We will
-        // now read it out and give it to in_progress_send, which will write it to the receiver fd
-
-        if (verbose_xwayland_logging_enabled())
-        {
-            log_info("Clipboard data from X11 client is ready");
-        }
-
-        std::lock_guard lock{mutex};
-        read_and_send_wl_selection_data(lock);
-    }
 }
 
 void mf::XWaylandClipboardSource::xfixes_selection_notify_event(xcb_xfixes_selection_notify_event_t* event)
@@ -345,15 +396,16 @@ void mf::XWaylandClipboardSource::xfixes_selection_notify_event(xcb_xfixes_selec
 
 void mf::XWaylandClipboardSource::property_notify_event(xcb_window_t window, xcb_atom_t property)
 {
-    if (window != receiving_window || property != connection._WL_SELECTION)
+    if (property != connection._WL_SELECTION)
     {
         return;
     }
 
     std::lock_guard lock{mutex};
-    if (incremental_transfer_in_progress)
+    auto const send = in_progress_sends.find(window);
+    if (send != in_progress_sends.end() && send->second.incremental)
     {
-        read_and_send_wl_selection_data(lock);
+        read_and_send_wl_selection_data(lock, window);
     }
 }
 
@@ -396,10 +448,12 @@ void mf::XWaylandClipboardSource::create_source(xcb_timestamp_t timestamp, std::
     clipboard->set_paste_source(source);
 }
 
-void mf::XWaylandClipboardSource::read_and_send_wl_selection_data(std::lock_guard<std::mutex> const& lock)
+void mf::XWaylandClipboardSource::read_and_send_wl_selection_data(
+    std::lock_guard<std::mutex> const& lock,
+    xcb_window_t window)
 {
     auto const completion = connection.read_property(
-        receiving_window,
+        window,
         connection._WL_SELECTION,
         true, // delete
         0x1fffffff, // length lifted from Weston
@@ -411,31 +465,36 @@ void mf::XWaylandClipboardSource::read_and_send_wl_selection_data(std::lock_guar
                 {
                     log_info("Initiating incremental data transfer from X11");
                 }
-                incremental_transfer_in_progress = true;
+                auto const send = in_progress_sends.find(window);
+                if (send != in_progress_sends.end())
+                {
+                    send->second.incremental = true;
+                }
             }
             else
             {
                 auto const data_ptr = static_cast<uint8_t*>(xcb_get_property_value(reply));
                 auto const data_size = xcb_get_property_value_length(reply);
-                add_data_to_in_progress_send(lock, data_ptr, data_size);
+                add_data_to_in_progress_send(lock, window, data_ptr, data_size);
             }
         },
         [&](const std::string& error_message)
         {
             log_error("Error getting selection property: %s", error_message.c_str());
-            in_progress_send.reset();
+            end_in_progress_send(lock, window);
         }});
 
     completion();
 }
 
 void mf::XWaylandClipboardSource::add_data_to_in_progress_send(
-    std::lock_guard<std::mutex> const&,
+    std::lock_guard<std::mutex> const& lock,
+    xcb_window_t window,
     uint8_t* data_ptr,
     size_t data_size)
 {
-
-    if (!in_progress_send)
+    auto const send = in_progress_sends.find(window);
+    if (send == in_progress_sends.end())
     {
         log_error("Can not send clipboard data from X11 because there is no send in progress");
         return;
@@ -449,18 +508,25 @@ void mf::XWaylandClipboardSource::add_data_to_in_progress_send(
             log_info("Writing %zu bytes of clipboard data from X11", data.size());
         }
 
-        if (in_progress_send->add_data(std::move(data)))
+        if (send->second.sender->add_data(std::move(data)))
         {
             // add_data() returns if it needs to be added to the dispatcher
-            dispatcher->add_watch(in_progress_send);
+            dispatcher->add_watch(send->second.sender);
         }
     }
 
     // Normal transfers are done after the first chunk, incremental transfers are done after a zero-size chunk
-    if (!incremental_transfer_in_progress || data_size == 0)
+    if (!send->second.incremental || data_size == 0)
+    {
+        end_in_progress_send(lock, window);
+    }
+}
+
+void mf::XWaylandClipboardSource::end_in_progress_send(std::lock_guard<std::mutex> const&, xcb_window_t window)
+{
+    // The DataSender may still be sending data on its fd, but the dispatcher will hold onto it until it's done
+    if (in_progress_sends.erase(window))
     {
-        // in_progress_send may still be sending data on it's fd, but the dispatcher will hold onto it until it's done
-        in_progress_send.reset();
-        incremental_transfer_in_progress = false;
+        xcb_destroy_window(connection, window);
     }
 }
@@ -19,6 +19,8 @@
 
 #include "xcb_connection.h"
 
+#include <map>
+
 struct xcb_xfixes_selection_notify_event_t;
 
 namespace mir
@@ -70,11 +72,18 @@ private:
     /// clipboard_ownership_timestamp when the source is ready.
     void create_source(xcb_timestamp_t timestamp, std::vector<xcb_atom_t> const& targets);
 
-    /// Called when there is new data in the _WL_SELECTION property that needs to be sent to the in-progress send
-    void read_and_send_wl_selection_data(std::lock_guard<std::mutex> const& lock);
+    /// Called when there is new data in the _WL_SELECTION property of window that needs to be sent to its send
+    void read_and_send_wl_selection_data(std::lock_guard<std::mutex> const& lock, xcb_window_t window);
+
+    /// Sends the given data to the destination fd of the send receiving on window
+    void add_data_to_in_progress_send(
+        std::lock_guard<std::mutex> const& lock,
+        xcb_window_t window,
+        uint8_t* data_ptr,
+        size_t data_size);
 
-    /// Sends the given data to the current destination fd
-    void add_data_to_in_progress_send(std::lock_guard<std::mutex> const& lock, uint8_t* data_ptr, size_t data_size);
+    /// Stops receiving data for the send on window (the data already received is still written to its fd)
+    void end_in_progress_send(std::lock_guard<std::mutex> const& lock, xcb_window_t window);
 
     XCBConnection& connection;
     std::shared_ptr<dispatch::MultiplexingDispatchable> const dispatcher;
@@ -85,8 +94,15 @@ private:
     xcb_window_t current_clipbaord_owner{XCB_WINDOW_NONE};
     xcb_timestamp_t clipboard_ownership_timestamp{0};
     std::shared_ptr<ClipboardSource> clipboard_source;
-    bool incremental_transfer_in_progress{false};
-    std::shared_ptr<DataSender> in_progress_send;
+
+    struct InProgressSend
+    {
+        std::shared_ptr<DataSender> sender;
+        bool incremental{false};
+    };
+    /// Each send has its own window for the X11 client to put the data on, so several can be in progress at once. Keyed
+    /// by that window.
+    std::map<xcb_window_t, InProgressSend> in_progress_sends;
 };
 }
 }
@@ -19,6 +19,7 @@
 #include "xwayland_connector.h"
 
 #include "wayland_connector.h"
+#include "xwayland_idle_timeout.h"
 #include "xwayland_server.h"
 #include "xwayland_spawner.h"
 #include "xwayland_wm.h"
@@ -34,13 +35,17 @@ namespace md = mir::dispatch;
 
 mf::XWaylandConnector::XWaylandConnector(
     std::shared_ptr<Executor> const& main_loop,
+    std::shared_ptr<time::AlarmFactory> const& alarm_factory,
     std::shared_ptr<WaylandConnector> const& wayland_connector,
     std::string const& xwayland_path,
-    float scale)
+    float scale,
+    std::optional<std::chrono::milliseconds> idle_timeout)
     : main_loop{main_loop},
+      alarm_factory{alarm_factory},
       wayland_connector{wayland_connector},
       xwayland_path{xwayland_path},
-      scale{scale}
+      scale{scale},
+      idle_timeout{idle_timeout}
 {
     if (access(xwayland_path.c_str(), F_OK | X_OK) != 0)
     {
@@ -139,6 +144,7 @@ void mf::XWaylandConnector::clean_up(std::unique_lock<std::mutex> lock)
     auto local_server{std::move(server)};
     auto local_wm{std::move(wm)};
     auto local_wm_event_thread{std::move(wm_event_thread)};
+    auto local_idle{std::move(idle)};
     auto local_spawner{std::move(spawner)};
 
     lock.unlock();
@@ -150,6 +156,9 @@ void mf::XWaylandConnector::spawn()
 {
     std::unique_lock lock{mutex};
 
+    // If an idle XWayland is being stopped, wait until it has gone and then start a new one for this client
+    stopped_idle.wait(lock, [this]() { return !stopping_idle; });
+
     if (server || !spawner)
     {
         // If we have a server then we've already spawned
@@ -199,12 +208,35 @@ void mf::XWaylandConnector::spawn()
                         }
                     });
             });
+        if (idle_timeout)
+        {
+            idle = std::make_unique<XWaylandIdleTimeout>(*alarm_factory, idle_timeout.value(), [this]()
+                {
+                    // The window manager holds our mutex while it reports window changes (which can cancel this
+                    // alarm), so the alarm must not wait for it. Check whether we are still idle separately.
+                    main_loop->spawn([weak_self=weak_from_this()]()
+                        {
+                            if (auto const self = weak_self.lock())
+                            {
+                                self->stop_if_idle();
+                            }
+                        });
+                });
+        }
         wm = std::make_unique<XWaylandWM>(
             wayland_connector,
             server->client(),
             server->x11_wm_fd(),
             wm_dispatcher,
-            scale);
+            scale,
+            [this](size_t window_count)
+            {
+                // Called with our mutex locked, from the constructor and from handle_events()
+                if (idle)
+                {
+                    idle->window_count_changed(window_count);
+                }
+            });
         mir::log_info("XWayland is running");
     }
     catch (...)
@@ -230,3 +262,61 @@ void mf::XWaylandConnector::spawn()
             });
     }
 }
+
+void mf::XWaylandConnector::stop_if_idle()
+{
+    std::unique_lock lock{mutex};
+
+    if (!idle || !idle->idle() || !spawner || !server)
+    {
+        // Either this XWayland has already gone or a client window has turned up since the timeout expired
+        return;
+    }
+
+    // Clients without windows (such as clipboard managers) still need this XWayland, so give them the whole timeout
+    // again to create one or go away
+    auto const sockets = server->socket_count();
+    auto const clients = wm->client_count();
+    if (!clients || clients.value())
+    {
+        idle->client_connected();
+        return;
+    }
+
+    // XWayland listens on the spawner's sockets too, so it could accept a client between counting the clients and
+    // stopping it. Suspend it first: from now on connecting clients are queued on the sockets, and any it accepted
+    // since being counted show up as new sockets.
+    server->suspend();
+    if (spawner->has_pending_connection() || server->socket_count() != sockets)
+    {
+        // A client has turned up since the timeout expired, so leave this XWayland to serve it
+        server->resume();
+        idle->client_connected();
+        return;
+    }
+
+    mir::log_info("Stopping XWayland as there have been no X11 clients for %lldms",
+        static_cast<long long>(idle_timeout.value().count()));
+
+    // The spawner (and so the X11 sockets) are kept. Clients that connect from now on are queued on the sockets, and
+    // spawn() waits for this XWayland to be gone before starting another to accept them.
+    auto local_server{std::move(server)};
+    auto local_wm{std::move(wm)};
+    auto local_wm_event_thread{std::move(wm_event_thread)};
+    auto local_idle{std::move(idle)};
+    stopping_idle = true;
+
+    lock.unlock();
+
+    local_idle.reset();
+    local_wm_event_thread.reset();
+    local_wm.reset();
+    local_server.reset();
+
+    lock.lock();
+    stopping_idle = false;
+    lock.unlock();
+    stopped_idle.notify_all();
+
+    mir::log_info("XWayland stopped, it will be restarted when an X11 client connects");
+}
@@ -21,8 +21,11 @@
 
 #include "mir/frontend/connector.h"
 
+#include <chrono>
+#include <condition_variable>
 #include <memory>
 #include <mutex>
+#include <optional>
 
 namespace mir
 {
@@ -32,12 +35,17 @@ namespace dispatch
 class ReadableFd;
 class ThreadedDispatcher;
 }
+namespace time
+{
+class AlarmFactory;
+}
 namespace frontend
 {
 class WaylandConnector;
 class XWaylandServer;
 class XWaylandSpawner;
 class XWaylandWM;
+class XWaylandIdleTimeout;
 class XWaylandConnector : public Connector, public std::enable_shared_from_this<XWaylandConnector>
 {
 public:
@@ -46,11 +54,16 @@ public:
     /// scale and the scale the application uses should all match. Application scale needs to be configured on a per-app
     /// or even per-toolkit basis. GDK_SCALE is used by default for XWayland scale because many apps respect it, so it's
     /// generally as correct as anything.
+    ///
+    /// If an idle timeout is given, XWayland is stopped once there have been no X11 client windows for that long and
+    /// no X11 clients are connected. It is started again (on the same display) when the next client connects.
     XWaylandConnector(
         std::shared_ptr<Executor> const& main_loop,
+        std::shared_ptr<time::AlarmFactory> const& alarm_factory,
         std::shared_ptr<WaylandConnector> const& wayland_connector,
         std::string const& xwayland_path,
-        float scale);
+        float scale,
+        std::optional<std::chrono::milliseconds> idle_timeout);
     ~XWaylandConnector();
 
     void start() override;
@@ -64,9 +77,11 @@ public:
 
 private:
     std::shared_ptr<Executor> const main_loop;
+    std::shared_ptr<time::AlarmFactory> const alarm_factory;
     std::shared_ptr<WaylandConnector> const wayland_connector;
     std::string const xwayland_path;
     float const scale;
+    std::optional<std::chrono::milliseconds> const idle_timeout;
 
     /// Creates the spawner if it doesn't already exist and is_started is true, given lock must be locked
     void maybe_create_spawner(std::unique_lock<std::mutex> const& lock);
@@ -75,6 +90,11 @@ private:
     /// Called the first time a client attempts to connect. Creates the server (which forks the XWayland process), wm
     /// and wm_event_thread.
     void spawn();
+    /// Called on the main loop once the idle timeout has expired. Stops XWayland (leaving the spawner to start it again
+    /// for the next client) if there are still no client windows, no clients connected and none waiting to connect.
+    /// XWayland is suspended before checking for waiting clients, so that it can't accept one that is then
+    /// disconnected.
+    void stop_if_idle();
 
     std::mutex mutable mutex;
     /// Set in start() and stop(), should always reflect the state Mir has requested this object to be in
@@ -83,6 +103,10 @@ private:
     std::unique_ptr<XWaylandServer> server;
     std::unique_ptr<XWaylandWM> wm;
     std::unique_ptr<dispatch::ThreadedDispatcher> wm_event_thread;
+    std::unique_ptr<XWaylandIdleTimeout> idle;
+    /// Set while an idle XWayland is being stopped, so that a client connecting meanwhile waits for a new one to start
+    bool stopping_idle{false};
+    std::condition_variable stopped_idle;
 };
 } /* frontend */
 } /* mir */
@@ -19,47 +19,20 @@
 #include "mir/log.h"
 #include "mir/options/default_configuration.h"
 #include "mir/main_loop.h"
+#include "mir/frontend/null_connector.h"
 #include "wayland_connector.h"
 #include "xwayland_connector.h"
 
 #include <boost/lexical_cast.hpp>
 
+#include <chrono>
+#include <optional>
 #include <string>
 #include <cstdlib>
 
 namespace mf = mir::frontend;
-namespace ms = mir::scene;
 namespace mo = mir::options;
 
-namespace
-{
-struct NullConnector : mf::Connector
-{
-    void start() override
-    {
-    }
-
-    void stop() override
-    {
-    }
-
-    int client_socket_fd() const override
-    {
-        return 0;
-    }
-
-    int client_socket_fd(std::function<void(std::shared_ptr<ms::Session> const&)> const&) const override
-    {
-        return -1;
-    }
-
-    mir::optional_value<std::string> socket_name() const override
-    {
-        return mir::optional_value<std::string>();
-    }
-};
-}
-
 std::shared_ptr<mf::Connector> mir::DefaultServerConfiguration::the_xwayland_connector()
 {
     return xwayland_connector([this]() -> std::shared_ptr<mf::Connector> {
@@ -74,12 +47,24 @@ std::shared_ptr<mf::Connector> mir::DefaultServerConfiguration::the_xwayland_con
                 {
                     BOOST_THROW_EXCEPTION(std::runtime_error("scale outside of valid range"));
                 }
+                std::optional<std::chrono::milliseconds> idle_timeout;
+                if (options->is_set("xwayland-idle-timeout"))
+                {
+                    auto const seconds = options->get<int>("xwayland-idle-timeout");
+                    if (seconds <= 0)
+                    {
+                        BOOST_THROW_EXCEPTION(std::runtime_error("xwayland-idle-timeout must be positive"));
+                    }
+                    idle_timeout = std::chrono::seconds{seconds};
+                }
                 auto wayland_connector = std::static_pointer_cast<mf::WaylandConnector>(the_wayland_connector());
                 return std::make_shared<mf::XWaylandConnector>(
+                    the_main_loop(),
                     the_main_loop(),
                     wayland_connector,
                     options->get<std::string>("xwayland-path"),
-                    scale);
+                    scale,
+                    idle_timeout);
             }
             catch (std::exception& x)
             {
@@ -91,6 +76,6 @@ std::shared_ptr<mf::Connector> mir::DefaultServerConfiguration::the_xwayland_con
             }
         }
 
-        return std::make_shared<NullConnector>();
+        return std::make_shared<mf::NullConnector>();
     });
 }
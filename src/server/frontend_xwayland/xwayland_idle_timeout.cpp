@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2022 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "xwayland_idle_timeout.h"
+
+#include "mir/time/alarm.h"
+#include "mir/time/alarm_factory.h"
+
+namespace mf = mir::frontend;
+
+mf::XWaylandIdleTimeout::XWaylandIdleTimeout(
+    time::AlarmFactory& alarm_factory,
+    std::chrono::milliseconds timeout,
+    std::function<void()> const& on_idle)
+    : timeout{timeout},
+      alarm{alarm_factory.create_alarm(on_idle)}
+{
+    alarm->reschedule_in(timeout);
+}
+
+mf::XWaylandIdleTimeout::~XWaylandIdleTimeout() = default;
+
+void mf::XWaylandIdleTimeout::window_count_changed(size_t count)
+{
+    std::lock_guard lock{mutex};
+
+    if (count && !window_count)
+    {
+        alarm->cancel();
+    }
+    else if (!count && window_count)
+    {
+        alarm->reschedule_in(timeout);
+    }
+
+    window_count = count;
+}
+
+void mf::XWaylandIdleTimeout::client_connected()
+{
+    std::lock_guard lock{mutex};
+
+    if (!window_count)
+    {
+        alarm->reschedule_in(timeout);
+    }
+}
+
+auto mf::XWaylandIdleTimeout::idle() const -> bool
+{
+    std::lock_guard lock{mutex};
+    return !window_count && alarm->state() == time::Alarm::State::triggered;
+}
@@ -0,0 +1,72 @@
+/*
+ * Copyright (C) 2022 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_FRONTEND_XWAYLAND_IDLE_TIMEOUT_H
+#define MIR_FRONTEND_XWAYLAND_IDLE_TIMEOUT_H
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+namespace mir
+{
+namespace time
+{
+class Alarm;
+class AlarmFactory;
+}
+namespace frontend
+{
+/// Tracks whether any X11 client has a window, and reports once none has had one for the timeout
+/// Clients without windows aren't seen here, so whoever acts on the timeout should check for connected clients and
+/// call client_connected() if there are any. Starts out idle (Xwayland is started for a client that has only just
+/// connected), so the timeout also covers clients that never create a window.
+class XWaylandIdleTimeout
+{
+public:
+    /// \param on_idle called from the alarm (on the main loop) when the timeout expires. Windows may have been created
+    ///                since, so it should check idle() under whatever lock serialises it with window_count_changed().
+    XWaylandIdleTimeout(
+        time::AlarmFactory& alarm_factory,
+        std::chrono::milliseconds timeout,
+        std::function<void()> const& on_idle);
+    ~XWaylandIdleTimeout();
+
+    /// Called by the window manager with the number of client windows whenever it changes
+    void window_count_changed(size_t count);
+
+    /// Starts the timeout again if there are no windows, as a client has connected (or is still connected)
+    void client_connected();
+
+    /// If there have been no client windows for the whole timeout
+    auto idle() const -> bool;
+
+private:
+    XWaylandIdleTimeout(XWaylandIdleTimeout const&) = delete;
+    XWaylandIdleTimeout& operator=(XWaylandIdleTimeout const&) = delete;
+
+    std::chrono::milliseconds const timeout;
+    std::unique_ptr<time::Alarm> const alarm;
+
+    std::mutex mutable mutex;
+    size_t window_count{0};
+};
+}
+}
+
+#endif // MIR_FRONTEND_XWAYLAND_IDLE_TIMEOUT_H
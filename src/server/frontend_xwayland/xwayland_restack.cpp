@@ -0,0 +1,142 @@
+/*
+ * Copyright (C) 2022 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "xwayland_restack.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+namespace mf = mir::frontend;
+
+namespace
+{
+/// Which entries of \a positions (-1 for none) make up the longest run of increasing positions
+auto longest_increasing_run(std::vector<int> const& positions) -> std::vector<bool>
+{
+    // tails[k] is the index of the smallest position ending an increasing run of length k + 1
+    std::vector<size_t> tails;
+    std::vector<size_t> previous(positions.size(), positions.size());
+
+    for (size_t i = 0; i != positions.size(); ++i)
+    {
+        if (positions[i] < 0)
+        {
+            continue;
+        }
+
+        auto const tail = std::lower_bound(
+            tails.begin(), tails.end(), positions[i],
+            [&](size_t index, int position) { return positions[index] < position; });
+
+        if (tail != tails.begin())
+        {
+            previous[i] = *(tail - 1);
+        }
+
+        if (tail == tails.end())
+        {
+            tails.push_back(i);
+        }
+        else
+        {
+            *tail = i;
+        }
+    }
+
+    std::vector<bool> in_run(positions.size(), false);
+    if (!tails.empty())
+    {
+        for (auto i = tails.back(); i != positions.size(); i = previous[i])
+        {
+            in_run[i] = true;
+        }
+    }
+    return in_run;
+}
+}
+
+auto mf::restack_operations(
+    std::vector<xcb_window_t> const& old_order,
+    std::vector<xcb_window_t> const& new_order) -> std::vector<RestackOperation>
+{
+    std::vector<RestackOperation> operations;
+    if (new_order.empty())
+    {
+        return operations;
+    }
+
+    std::unordered_map<xcb_window_t, int> old_positions;
+    old_positions.reserve(old_order.size());
+    for (size_t i = 0; i != old_order.size(); ++i)
+    {
+        old_positions.emplace(old_order[i], static_cast<int>(i));
+    }
+
+    std::vector<int> positions;
+    positions.reserve(new_order.size());
+    for (auto const window : new_order)
+    {
+        auto const old_position = old_positions.find(window);
+        positions.push_back(old_position == old_positions.end() ? -1 : old_position->second);
+    }
+
+    auto kept = longest_increasing_run(positions);
+    auto first_kept = static_cast<size_t>(std::find(kept.begin(), kept.end(), true) - kept.begin());
+
+    if (first_kept == kept.size())
+    {
+        // Nothing is known to be in place, so stack everything on the bottom window
+        first_kept = 0;
+        kept[0] = true;
+    }
+
+    // Windows below the bottom-most one left in place go beneath it, working downwards
+    for (auto i = first_kept; i-- != 0;)
+    {
+        operations.push_back({new_order[i], new_order[i + 1], XCB_STACK_MODE_BELOW});
+    }
+
+    // Every other window that moves goes directly above the one that must be below it, working upwards
+    for (auto i = first_kept + 1; i < new_order.size(); ++i)
+    {
+        if (!kept[i])
+        {
+            operations.push_back({new_order[i], new_order[i - 1], XCB_STACK_MODE_ABOVE});
+        }
+    }
+
+    return operations;
+}
+
+auto mf::stacking_consistent_with(
+    std::vector<xcb_window_t> const& order,
+    xcb_window_t window,
+    xcb_window_t above_sibling) -> bool
+{
+    auto const window_position = std::find(order.begin(), order.end(), window);
+    if (window_position == order.end())
+    {
+        return true;
+    }
+
+    if (above_sibling == XCB_WINDOW_NONE)
+    {
+        return window_position == order.begin();
+    }
+
+    // The sibling must not be one we put above the window
+    return std::find(window_position, order.end(), above_sibling) == order.end();
+}
@@ -0,0 +1,55 @@
+/*
+ * Copyright (C) 2022 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_FRONTEND_XWAYLAND_RESTACK_H
+#define MIR_FRONTEND_XWAYLAND_RESTACK_H
+
+#include <xcb/xproto.h>
+
+#include <vector>
+
+namespace mir
+{
+namespace frontend
+{
+/// A single configure_window() that moves \a window directly above or below \a sibling
+struct RestackOperation
+{
+    xcb_window_t window;
+    xcb_window_t sibling;
+    xcb_stack_mode_t mode;
+
+    auto operator==(RestackOperation const& other) const -> bool = default;
+};
+
+/// The fewest restack operations that take windows stacked in \a old_order to \a new_order (both bottom to top)
+/// The windows that are in the same relative order in both (the longest such run) are left where they are, and each
+/// other window is moved next to a neighbour it must end up beside. Windows not in \a new_order are not touched. The
+/// operations must be sent in the order given.
+auto restack_operations(
+    std::vector<xcb_window_t> const& old_order,
+    std::vector<xcb_window_t> const& new_order) -> std::vector<RestackOperation>;
+
+/// Whether X reporting \a window directly above \a above_sibling (or at the bottom, if none) agrees with \a order
+/// Only windows in \a order can be compared, so a restack relative to other windows is not detected.
+auto stacking_consistent_with(
+    std::vector<xcb_window_t> const& order,
+    xcb_window_t window,
+    xcb_window_t above_sibling) -> bool;
+}
+}
+
+#endif // MIR_FRONTEND_XWAYLAND_RESTACK_H
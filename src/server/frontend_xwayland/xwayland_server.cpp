@@ -31,6 +31,7 @@
 #include <chrono>
 #include <condition_variable>
 #include <cstring>
+#include <filesystem>
 
 namespace mf = mir::frontend;
 namespace md = mir::dispatch;
@@ -186,6 +187,8 @@ mf::XWaylandServer::~XWaylandServer()
     // Terminate any running xservers
     if (kill(xwayland.pid, SIGTERM) == 0)
     {
+        // A suspended Xwayland only acts on the SIGTERM once it is continued
+        kill(xwayland.pid, SIGCONT);
         std::this_thread::sleep_for(100ms);// After 100ms...
         if (is_running())
         {
@@ -201,6 +204,38 @@ mf::XWaylandServer::~XWaylandServer()
     }
 }
 
+void mf::XWaylandServer::suspend()
+{
+    if (kill(xwayland.pid, SIGSTOP) != 0)
+    {
+        log_warning("Failed to suspend Xwayland process with PID %d: %s", xwayland.pid, strerror(errno));
+    }
+}
+
+void mf::XWaylandServer::resume()
+{
+    if (kill(xwayland.pid, SIGCONT) != 0)
+    {
+        log_warning("Failed to resume Xwayland process with PID %d: %s", xwayland.pid, strerror(errno));
+    }
+}
+
+auto mf::XWaylandServer::socket_count() const -> size_t
+{
+    size_t count{0};
+    std::error_code error;
+    for (std::filesystem::directory_iterator fd{"/proc/" + std::to_string(xwayland.pid) + "/fd", error}, end;
+         fd != end;
+         fd.increment(error))
+    {
+        if (std::filesystem::read_symlink(fd->path(), error).native().starts_with("socket:"))
+        {
+            ++count;
+        }
+    }
+    return count;
+}
+
 auto mf::XWaylandServer::is_running() const -> bool
 {
     std::lock_guard lock{mutex};
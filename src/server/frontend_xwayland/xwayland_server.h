@@ -56,6 +56,15 @@ public:
     auto x11_wm_fd() const -> Fd const& { return xwayland.x11_fd; }
     auto is_running() const -> bool;
 
+    /// Stops the Xwayland process, so that it neither accepts nor serves clients until resume(). Clients connecting
+    /// meanwhile are queued on the spawner's sockets.
+    void suspend();
+    void resume();
+
+    /// The number of sockets the Xwayland process has open. It goes up as Xwayland accepts X11 clients, and can be
+    /// read while Xwayland is suspended.
+    auto socket_count() const -> size_t;
+
 private:
     XWaylandServer(XWaylandServer const&) = delete;
     XWaylandServer& operator=(XWaylandServer const&) = delete;
@@ -27,10 +27,14 @@
 #include "mir/thread_name.h"
 
 #include <fcntl.h>
+#include <poll.h>
 #include <sys/socket.h>
 #include <sys/un.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <cstring>
+
 namespace mf = mir::frontend;
 namespace md = mir::dispatch;
 
@@ -213,6 +217,24 @@ auto mf::XWaylandSpawner::socket_fds() const -> std::vector<Fd> const&
     return fds;
 }
 
+auto mf::XWaylandSpawner::has_pending_connection() const -> bool
+{
+    std::vector<pollfd> pollfds;
+    for (auto const& fd : fds)
+    {
+        pollfds.push_back({fd, POLLIN, 0});
+    }
+
+    if (poll(pollfds.data(), pollfds.size(), 0) < 0)
+    {
+        // Assume there is, as the answer is used to decide whether it is safe to stop Xwayland
+        mir::log_warning("Failed to poll X11 sockets: %s", strerror(errno));
+        return true;
+    }
+
+    return std::any_of(pollfds.begin(), pollfds.end(), [](auto const& pollfd) { return pollfd.revents & POLLIN; });
+}
+
 bool mf::XWaylandSpawner::set_cloexec(mir::Fd const& fd, bool cloexec)
 {
     int flags = fcntl(fd, F_GETFD);
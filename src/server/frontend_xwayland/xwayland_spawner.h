@@ -52,6 +52,8 @@ public:
     /// \returns whatever sockets we're waiting on
     /// (on construction we try to open both an abstract and non-abstrack socket)
     auto socket_fds() const -> std::vector<Fd> const&;
+    /// If a client is waiting on any of our sockets for its connection to be accepted
+    auto has_pending_connection() const -> bool;
 
     /// Enables or disables the CLOEXEC flag for the given fd
     /// \returns if the operation succeeded
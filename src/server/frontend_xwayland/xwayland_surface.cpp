@@ -405,14 +405,21 @@ mf::XWaylandSurface::~XWaylandSurface()
 
 void mf::XWaylandSurface::map()
 {
+    // The replies to earlier requests must not be applied over the values read below
+    complete_property_reads();
+
     std::unique_lock lock{mutex};
     auto state = cached.state.with_withdrawn(false);
     lock.unlock();
 
+    // Properties set before we started watching the window will not have been notified, so read them all now. This
+    // is done here rather than when the wl_surface is attached so it doesn't hold up the Wayland thread.
+    auto reply_functions = request_all_properties();
+
     // _NET_WM_STATE is not in property_handlers because we only read it on window creation
     // We, the server (not the client) are responsible for updating it after the window has been mapped
     // The client should use a client message to change state later
-    auto const cookie = connection->read_property(
+    reply_functions.push_back(connection->read_property(
         window,
         connection->_NET_WM_STATE,
         {
@@ -423,10 +430,13 @@ void mf::XWaylandSurface::map()
                     state = state.with_net_wm_state_change(*connection, NetWmStateAction::ADD, net_wm_state);
                 }
             }
-        });
+        }));
 
-    // If we had more properties to read we would queue them all up before completing the first one
-    cookie();
+    // All the requests are in flight, so this is a single round trip
+    for (auto const& reply_function : reply_functions)
+    {
+        reply_function();
+    }
 
     uint32_t const workspace = 1;
     connection->set_property<XCBType::CARDINAL32>(
@@ -544,6 +554,8 @@ void mf::XWaylandSurface::take_focus()
 
 void mf::XWaylandSurface::configure_request(xcb_configure_request_event_t* event)
 {
+    complete_property_reads();
+
     std::unique_lock lock{mutex};
     if (event->value_mask & XCB_CONFIG_WINDOW_X || event->value_mask & XCB_CONFIG_WINDOW_Y)
     {
@@ -585,6 +597,8 @@ void mf::XWaylandSurface::configure_request(xcb_configure_request_event_t* event
 
 void mf::XWaylandSurface::configure_notify(xcb_configure_notify_event_t* event)
 {
+    complete_property_reads();
+
     std::unique_lock lock{mutex};
     cached.override_redirect = event->override_redirect;
     // If this configure is in response to a configure we sent we don't want to make a window manager request
@@ -625,6 +639,8 @@ void mf::XWaylandSurface::net_wm_state_client_message(uint32_t const (&data)[5])
 
     (void)source_indication;
 
+    complete_property_reads();
+
     std::unique_lock lock{mutex};
     auto new_state = cached.state;
     for (xcb_atom_t const property : properties)
@@ -645,6 +661,8 @@ void mf::XWaylandSurface::wm_change_state_client_message(uint32_t const (&data)[
 
     WmState const requested_state = static_cast<WmState>(data[0]);
 
+    complete_property_reads();
+
     std::unique_lock lock{mutex};
     auto const new_state = cached.state.with_wm_state(requested_state);
     inform_client_of_window_state(std::move(lock), new_state);
@@ -657,11 +675,26 @@ void mf::XWaylandSurface::property_notify(xcb_atom_t property)
     auto const handler = property_handlers.find(property);
     if (handler != property_handlers.end())
     {
-        auto completion = handler->second();
-        completion();
+        pending_property_reads.push_back(handler->second());
+    }
+}
 
-        apply_any_mods_to_scene_surface();
+void mf::XWaylandSurface::complete_property_reads()
+{
+    if (pending_property_reads.empty())
+    {
+        return;
     }
+
+    auto const reads = std::move(pending_property_reads);
+    pending_property_reads.clear();
+
+    for (auto const& read : reads)
+    {
+        read();
+    }
+
+    apply_any_mods_to_scene_surface();
 }
 
 void mf::XWaylandSurface::attach_wl_surface(WlSurface* wl_surface)
@@ -707,35 +740,38 @@ void mf::XWaylandSurface::attach_wl_surface(WlSurface* wl_surface)
         spec.state = state.active_mir_state();
     }
 
-    std::vector<std::function<void()>> reply_functions;
+    bool all_properties_read;
+    {
+        std::lock_guard lock{mutex};
+        all_properties_read = cached.all_properties_read;
+    }
 
-    // Read all properties
-    for (auto const& handler : property_handlers)
+    if (!all_properties_read)
     {
-        reply_functions.push_back(handler.second());
+        // Override-redirect windows map themselves without a map request, so map() has not read their properties
+        for (auto const& reply_function : request_all_properties())
+        {
+            reply_function();
+        }
+    }
+
+    std::optional<uint32_t> pid;
+    {
+        std::lock_guard lock{mutex};
+        pid = cached.pid;
     }
 
     std::shared_ptr<XWaylandClientManager::Session> local_client_session;
     std::shared_ptr<ms::Session> session;
-    reply_functions.push_back(connection->read_property(
-        window, connection->_NET_WM_PID,
-        XCBConnection::Handler<uint32_t>{
-            [&](uint32_t pid)
-            {
-                local_client_session = client_manager->session_for_client(pid);
-                session = local_client_session->session();
-            },
-            [&](std::string const&)
-            {
-                log_warning("X11 app did not set _NET_WM_PID, grouping it under the default XWayland application");
-                session = get_session(wl_surface->resource);
-            }
-        }));
-
-    // Wait for and process all the XCB replies
-    for (auto const& reply_function : reply_functions)
+    if (pid)
     {
-        reply_function();
+        local_client_session = client_manager->session_for_client(pid.value());
+        session = local_client_session->session();
+    }
+    else
+    {
+        log_warning("X11 app did not set _NET_WM_PID, grouping it under the default XWayland application");
+        session = get_session(wl_surface->resource);
     }
 
     if (!session)
@@ -1035,6 +1071,40 @@ auto mf::XWaylandSurface::consume_pending_spec(
         return std::nullopt;
 }
 
+auto mf::XWaylandSurface::request_all_properties() -> std::vector<std::function<void()>>
+{
+    std::vector<std::function<void()>> reply_functions;
+
+    for (auto const& handler : property_handlers)
+    {
+        reply_functions.push_back(handler.second());
+    }
+
+    reply_functions.push_back(connection->read_property(
+        window, connection->_NET_WM_PID,
+        XCBConnection::Handler<uint32_t>{
+            [this](uint32_t pid)
+            {
+                std::lock_guard lock{mutex};
+                cached.pid = pid;
+            },
+            [this](std::string const&)
+            {
+                std::lock_guard lock{mutex};
+                cached.pid = std::nullopt;
+            }
+        }));
+
+    // Called after all the others have been processed
+    reply_functions.push_back([this]()
+        {
+            std::lock_guard lock{mutex};
+            cached.all_properties_read = true;
+        });
+
+    return reply_functions;
+}
+
 void mf::XWaylandSurface::is_transient_for(xcb_window_t transient_for)
 {
     if (verbose_xwayland_logging_enabled())
@@ -86,7 +86,13 @@ public:
     void configure_notify(xcb_configure_notify_event_t* event);
     void net_wm_state_client_message(uint32_t const (&data)[5]);
     void wm_change_state_client_message(uint32_t const (&data)[5]);
+    /// Requests the new value of a property that has changed, without waiting for it. The value is applied by
+    /// complete_property_reads(), so the reads for a burst of property changes share one round trip.
     void property_notify(xcb_atom_t property);
+    /// Waits for and applies the values requested by property_notify(), in the order they were requested. The window
+    /// manager calls this once it has handled a batch of events, and the event handlers above that use cached
+    /// properties call it first so they never see a stale value.
+    void complete_property_reads();
     void attach_wl_surface(WlSurface* wl_surface); ///< Should only be called on the Wayland thread
     void move_resize(uint32_t detail);
 
@@ -203,6 +209,9 @@ private:
     void wm_hints(std::vector<int32_t> const& hints);
     void wm_size_hints(std::vector<int32_t> const& hints);
     void motif_wm_hints(std::vector<uint32_t> const& hints);
+    /// Requests every property in property_handlers, and _NET_WM_PID, without waiting for any of them
+    /// \returns functions that wait for and process each reply
+    auto request_all_properties() -> std::vector<std::function<void()>>;
 
     /// Returns the scene surface associated with a given xcb_window, or nullptr if none
     static auto xcb_window_get_scene_surface(XWaylandWM* xwm, xcb_window_t window) -> std::shared_ptr<scene::Surface>;
@@ -215,6 +224,9 @@ private:
     xcb_window_t const window;
     float const scale;
     std::map<xcb_window_t, std::function<std::function<void()>()>> const property_handlers;
+    /// Property reads requested by property_notify() whose replies have not been processed yet. Only used on the X11
+    /// event thread.
+    std::vector<std::function<void()>> pending_property_reads;
 
     std::mutex mutable mutex;
 
@@ -242,6 +254,11 @@ private:
 
         xcb_window_t transient_for{XCB_WINDOW_NONE};
         std::vector<xcb_atom_t> wm_types;
+
+        /// If all properties have been read (when the window was mapped), so attaching a wl_surface needn't read them
+        bool all_properties_read{false};
+        /// The client's _NET_WM_PID, if it set one
+        std::optional<uint32_t> pid;
     } cached;
 
     /// When we send a configure we push it to the back, when we get notified of a configure we pop it and all the ones
@@ -27,6 +27,7 @@
 #include "xwayland_client_manager.h"
 #include "xwayland_clipboard_source.h"
 #include "xwayland_clipboard_provider.h"
+#include "xwayland_restack.h"
 
 #include "mir/c_memory.h"
 #include "mir/fd.h"
@@ -36,6 +37,7 @@
 
 #include <cstring>
 #include <boost/throw_exception.hpp>
+#include <xcb/res.h>
 
 namespace mf = mir::frontend;
 namespace ms = mir::scene;
@@ -81,6 +83,7 @@ auto init_xfixes(mf::XCBConnection const& connection) -> xcb_query_extension_rep
 
     xcb_prefetch_extension_data(connection, &xcb_xfixes_id);
     xcb_prefetch_extension_data(connection, &xcb_composite_id);
+    xcb_prefetch_extension_data(connection, &xcb_res_id);
 
     auto const xfixes = xcb_get_extension_data(connection, &xcb_xfixes_id);
     if (!xfixes || !xfixes->present)
@@ -101,6 +104,18 @@ auto init_xfixes(mf::XCBConnection const& connection) -> xcb_query_extension_rep
     return xfixes;
 }
 
+auto init_xres(mf::XCBConnection const& connection) -> bool
+{
+    auto const xres = xcb_get_extension_data(connection, &xcb_res_id);
+    if (!xres || !xres->present)
+    {
+        mir::log_warning("X-Resource not available, so XWayland can't tell when it has no clients to stop when idle");
+        return false;
+    }
+
+    return true;
+}
+
 auto focus_mode_to_string(uint32_t focus_mode) -> std::string
 {
     switch (focus_mode)
@@ -136,9 +151,11 @@ mf::XWaylandWM::XWaylandWM(
     wl_client* wayland_client,
     Fd const& fd,
     std::shared_ptr<dispatch::MultiplexingDispatchable> const& dispatcher,
-    float assumed_surface_scale)
+    float assumed_surface_scale,
+    std::function<void(size_t)> window_count_changed)
     : connection{std::make_shared<XCBConnection>(fd)},
       xfixes{init_xfixes(*connection)},
+      xres{init_xres(*connection)},
       wayland_connector(wayland_connector),
       wayland_client{wayland_client},
       wm_shell{std::static_pointer_cast<XWaylandWMShell>(wayland_connector->get_extension("x11-support"))},
@@ -149,7 +166,8 @@ mf::XWaylandWM::XWaylandWM(
       wm_window{create_wm_window(*connection)},
       scene_observer{std::make_shared<XWaylandSceneObserver>(this)},
       client_manager{std::make_shared<XWaylandClientManager>(wm_shell->shell)},
-      assumed_surface_scale{assumed_surface_scale}
+      assumed_surface_scale{assumed_surface_scale},
+      window_count_changed{std::move(window_count_changed)}
 {
     uint32_t const attrib_values[]{
         XCB_EVENT_MASK_SUBSTRUCTURE_NOTIFY | XCB_EVENT_MASK_SUBSTRUCTURE_REDIRECT | XCB_EVENT_MASK_PROPERTY_CHANGE};
@@ -278,22 +296,34 @@ void mf::XWaylandWM::handle_events()
 
     connection->verify_not_in_error_state();
 
-    while (xcb_generic_event_t* const event = xcb_poll_for_event(*connection))
+    for (;;)
     {
-        try
+        while (xcb_generic_event_t* const event = xcb_poll_for_event(*connection))
         {
-            handle_event(event);
+            try
+            {
+                handle_event(event);
+            }
+            catch (...)
+            {
+                log(
+                    logging::Severity::warning,
+                    MIR_LOG_COMPONENT,
+                    std::current_exception(),
+                    "Error processing XCB event");
+            }
+            free(event);
+            got_events = true;
         }
-        catch (...)
+
+        if (pending_property_reads.empty())
         {
-            log(
-                logging::Severity::warning,
-                MIR_LOG_COMPONENT,
-                std::current_exception(),
-                "Error processing XCB event");
+            break;
         }
-        free(event);
-        got_events = true;
+
+        // Any events that arrive while we wait for the replies are queued by XCB rather than left on the socket, so
+        // go round again to handle them
+        complete_property_reads();
     }
 
     if (got_events)
@@ -302,6 +332,33 @@ void mf::XWaylandWM::handle_events()
     }
 }
 
+auto mf::XWaylandWM::client_count() -> std::optional<size_t>
+{
+    if (!xres)
+    {
+        return std::nullopt;
+    }
+
+    auto const reply = make_unique_cptr(
+        xcb_res_query_clients_reply(*connection, xcb_res_query_clients(*connection), nullptr));
+    if (!reply)
+    {
+        return std::nullopt;
+    }
+
+    // The X server lists itself (with resource base 0) and this window manager too
+    auto const own_resource_base = xcb_get_setup(*connection)->resource_id_base;
+    size_t count{0};
+    for (auto client = xcb_res_query_clients_clients_iterator(reply.get()); client.rem; xcb_res_client_next(&client))
+    {
+        if (client.data->resource_base && client.data->resource_base != own_resource_base)
+        {
+            ++count;
+        }
+    }
+    return count;
+}
+
 auto mf::XWaylandWM::get_wm_surface(
     xcb_window_t xcb_window) -> std::optional<std::shared_ptr<XWaylandSurface>>
 {
@@ -383,7 +440,13 @@ void mf::XWaylandWM::remember_scene_surface(std::weak_ptr<scene::Surface> const&
 void mf::XWaylandWM::forget_scene_surface(std::weak_ptr<scene::Surface> const& scene_surface)
 {
     std::lock_guard lock{mutex};
-    scene_surfaces.erase(scene_surface);
+    auto const surface_window = scene_surfaces.find(scene_surface);
+    if (surface_window != scene_surfaces.end())
+    {
+        // The window ID may be reused, so don't let a new window inherit this one's place
+        std::erase(sent_stacking_order, surface_window->second);
+        scene_surfaces.erase(surface_window);
+    }
     scene_surface_set.erase(scene_surface);
 }
 
@@ -411,10 +474,11 @@ void mf::XWaylandWM::surfaces_reordered(scene::SurfaceSet const& affected_surfac
 
 void mf::XWaylandWM::restack_surfaces()
 {
-    std::vector<xcb_window_t> new_order;
+    std::vector<RestackOperation> operations;
 
     {
         std::lock_guard lock{mutex};
+        std::vector<xcb_window_t> new_order;
         auto const new_surface_order = wm_shell->surface_stack->stacking_order_of(scene_surface_set);
         for (auto const& surface : new_surface_order)
         {
@@ -424,29 +488,33 @@ void mf::XWaylandWM::restack_surfaces()
                 new_order.push_back(surface_window->second);
             }
         }
+
+        operations = restack_operations(sent_stacking_order, new_order);
+        sent_stacking_order = std::move(new_order);
     }
 
-    xcb_window_t window_below = 0;
-    for (auto const& window : new_order)
+    if (operations.empty())
     {
-        if (window_below)
-        {
-            if (verbose_xwayland_logging_enabled())
-            {
-                log_debug(
-                    "Stacking %s on top of %s",
-                    connection->window_debug_string(window).c_str(),
-                    connection->window_debug_string(window_below).c_str());
-            }
+        return;
+    }
 
-            connection->configure_window(
-                window,
-                std::nullopt,
-                std::nullopt,
-                window_below,
-                XCB_STACK_MODE_ABOVE);
+    for (auto const& operation : operations)
+    {
+        if (verbose_xwayland_logging_enabled())
+        {
+            log_debug(
+                "Stacking %s %s %s",
+                connection->window_debug_string(operation.window).c_str(),
+                operation.mode == XCB_STACK_MODE_ABOVE ? "on top of" : "below",
+                connection->window_debug_string(operation.sibling).c_str());
         }
-        window_below = window;
+
+        connection->configure_window(
+            operation.window,
+            std::nullopt,
+            std::nullopt,
+            operation.sibling,
+            operation.mode);
     }
 
     connection->flush();
@@ -519,6 +587,7 @@ void mf::XWaylandWM::manage_window(xcb_window_t window, geom::Rectangle const& g
         geometry,
         override_redirect,
         assumed_surface_scale);
+    window_count_changed(surfaces.size());
 }
 
 void mf::XWaylandWM::handle_event(xcb_generic_event_t* event)
@@ -644,7 +713,7 @@ void mf::XWaylandWM::handle_property_notify(xcb_property_notify_event_t *event)
                         value.c_str());
                 };
 
-            auto const reply_function = connection->read_property(
+            pending_property_reads.push_back(connection->read_property(
                 event->window,
                 event->atom,
                 {
@@ -657,15 +726,19 @@ void mf::XWaylandWM::handle_property_notify(xcb_property_notify_event_t *event)
                     {
                         log_prop("error getting value: " + message);
                     }
-                });
-
-            reply_function();
+                }));
         }
     }
 
     if (auto const surface = get_wm_surface(event->window))
     {
         surface.value()->property_notify(event->atom);
+        // The surface is kept alive until its read completes, even if the window is destroyed meanwhile
+        pending_property_reads.push_back(
+            [surface = surface.value()]()
+            {
+                surface->complete_property_reads();
+            });
     }
 
     // Inform the clipboard provider, in case this is part of an incremental data send
@@ -681,6 +754,28 @@ void mf::XWaylandWM::handle_property_notify(xcb_property_notify_event_t *event)
     }
 }
 
+void mf::XWaylandWM::complete_property_reads()
+{
+    auto const reads = std::move(pending_property_reads);
+    pending_property_reads.clear();
+
+    for (auto const& read : reads)
+    {
+        try
+        {
+            read();
+        }
+        catch (...)
+        {
+            log(
+                logging::Severity::warning,
+                MIR_LOG_COMPONENT,
+                std::current_exception(),
+                "Error processing XCB property");
+        }
+    }
+}
+
 void mf::XWaylandWM::handle_create_notify(xcb_create_notify_event_t *event)
 {
     if (verbose_xwayland_logging_enabled())
@@ -735,6 +830,7 @@ void mf::XWaylandWM::handle_destroy_notify(xcb_destroy_notify_event_t *event)
         {
             surface = iter->second;
             surfaces.erase(iter);
+            window_count_changed(surfaces.size());
         }
     }
 
@@ -889,6 +985,15 @@ void mf::XWaylandWM::handle_configure_notify(xcb_configure_notify_event_t *event
             log_warning("border width unsupported (border width %d)", event->border_width);
     }
 
+    {
+        std::lock_guard lock{mutex};
+        if (!stacking_consistent_with(sent_stacking_order, event->window, event->above_sibling))
+        {
+            // Something other than us restacked our windows, so the next restack must send the whole order
+            sent_stacking_order.clear();
+        }
+    }
+
     if (auto const surface = get_wm_surface(event->window))
     {
         surface.value()->configure_notify(event);
@@ -24,11 +24,13 @@
 #include "wayland_connector.h"
 #include "xcb_connection.h"
 
+#include <functional>
 #include <map>
 #include <set>
 #include <thread>
 #include <optional>
 #include <mutex>
+#include <vector>
 
 #include <wayland-server-core.h>
 #include <xcb/xfixes.h>
@@ -62,17 +64,23 @@ private:
 
 public:
     /// Takes ownership of the given FD
+    /// \param window_count_changed called with the number of client windows whenever it changes
     XWaylandWM(
         std::shared_ptr<WaylandConnector> wayland_connector,
         wl_client* wayland_client,
         Fd const& fd,
         std::shared_ptr<dispatch::MultiplexingDispatchable> const& dispatcher,
-        float assumed_surface_scale);
+        float assumed_surface_scale,
+        std::function<void(size_t)> window_count_changed);
     ~XWaylandWM();
 
     /// Called by the XWayland connector when there may be new events
     void handle_events();
 
+    /// The number of X11 clients connected (with or without windows), not counting this window manager
+    /// Asks the X server, so blocks for a round trip. Empty if the server doesn't support the X-Resource extension.
+    auto client_count() -> std::optional<size_t>;
+
     auto get_wm_surface(xcb_window_t xcb_window) -> std::optional<std::shared_ptr<XWaylandSurface>>;
     auto get_focused_window() -> std::optional<xcb_window_t>;
     void set_focus(xcb_window_t xcb_window, bool should_be_focused);
@@ -105,8 +113,11 @@ private:
     void handle_destroy_notify(xcb_destroy_notify_event_t *event);
     void handle_focus_in(xcb_focus_in_event_t* event);
     void handle_error(xcb_generic_error_t* event);
+    /// Waits for and applies the property values requested while handling events, in the order they were requested
+    void complete_property_reads();
 
     xcb_query_extension_reply_t const* const xfixes; ///< Must not be freed, can be null
+    bool const xres;
     std::shared_ptr<WaylandConnector> const wayland_connector;
     wl_client* const wayland_client;
     std::shared_ptr<XWaylandWMShell> const wm_shell;
@@ -121,6 +132,7 @@ private:
     /// at the app will appear the wrong size. If this matches the app but both are smaller than the output scale, the
     /// app will appear the correct size but blurry.
     float const assumed_surface_scale;
+    std::function<void(size_t)> const window_count_changed;
 
     std::mutex mutex;
     std::map<xcb_window_t, std::shared_ptr<XWaylandSurface>> surfaces;
@@ -131,6 +143,12 @@ private:
     /// Could be regenerated from scene_surfaces at any time, but more efficient to keep this up to date
     std::set<std::weak_ptr<scene::Surface>, std::owner_less<std::weak_ptr<scene::Surface>>> scene_surface_set;
     std::optional<xcb_window_t> focused_window;
+    /// The stacking order (bottom to top) we last sent to X, so only the windows that have moved need restacking.
+    /// Emptied if X reports a restack we didn't ask for.
+    std::vector<xcb_window_t> sent_stacking_order;
+    /// Property reads requested by handle_property_notify() whose replies have not been processed yet. Only used from
+    /// handle_events().
+    std::vector<std::function<void()>> pending_property_reads;
 };
 } /* frontend */
 } /* mir */
@@ -0,0 +1,122 @@
+/*
+ * Copyright © 2022 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "animated_cursor.h"
+#include "mir/lockable_callback.h"
+#include "mir/time/alarm.h"
+#include "mir/time/alarm_factory.h"
+
+#include <algorithm>
+
+namespace mg = mir::graphics;
+
+namespace
+{
+/// Themes with frames of no delay would otherwise keep the main loop spinning
+auto delay_of(mg::AnimatedCursorImage::Frame const& frame) -> std::chrono::milliseconds
+{
+    return std::max(frame.delay, std::chrono::milliseconds{10});
+}
+}
+
+/// Takes the cursor's lock while the alarm fires, so the alarm can be cancelled and rescheduled under the same lock
+class mg::AnimatedCursor::AlarmCallback : public LockableCallback
+{
+public:
+    explicit AlarmCallback(AnimatedCursor& cursor)
+        : cursor{cursor}
+    {
+    }
+
+    void operator()() override
+    {
+        cursor.show_next_frame();
+    }
+
+    void lock() override
+    {
+        cursor.mutex.lock();
+    }
+
+    void unlock() override
+    {
+        cursor.mutex.unlock();
+    }
+
+private:
+    AnimatedCursor& cursor;
+};
+
+mg::AnimatedCursor::AnimatedCursor(std::shared_ptr<Cursor> const& wrapped, time::AlarmFactory& alarm_factory)
+    : wrapped{wrapped},
+      alarm{alarm_factory.create_alarm(std::make_unique<AlarmCallback>(*this))}
+{
+}
+
+mg::AnimatedCursor::~AnimatedCursor()
+{
+    std::lock_guard lock{mutex};
+    alarm->cancel();
+}
+
+void mg::AnimatedCursor::show(CursorImage const& cursor_image)
+{
+    std::lock_guard lock{mutex};
+
+    alarm->cancel();
+    frames.clear();
+    current_frame = 0;
+
+    // The whole animation is passed on first, so the wrapped cursor can prepare every frame at once
+    wrapped->show(cursor_image);
+
+    if (auto const animated = dynamic_cast<AnimatedCursorImage const*>(&cursor_image))
+    {
+        if (animated->frames().size() > 1)
+        {
+            frames = animated->frames();
+            alarm->reschedule_in(delay_of(frames.front()));
+        }
+    }
+}
+
+void mg::AnimatedCursor::hide()
+{
+    std::lock_guard lock{mutex};
+
+    alarm->cancel();
+    frames.clear();
+    wrapped->hide();
+}
+
+void mg::AnimatedCursor::move_to(geometry::Point position)
+{
+    wrapped->move_to(position);
+}
+
+void mg::AnimatedCursor::show_next_frame()
+{
+    // The alarm may have fired just as it was cancelled
+    if (frames.empty())
+    {
+        return;
+    }
+
+    current_frame = (current_frame + 1) % frames.size();
+    auto const& frame = frames[current_frame];
+    wrapped->show(*frame.image);
+    alarm->reschedule_in(delay_of(frame));
+}
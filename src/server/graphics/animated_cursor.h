@@ -0,0 +1,61 @@
+/*
+ * Copyright © 2022 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_GRAPHICS_ANIMATED_CURSOR_H_
+#define MIR_GRAPHICS_ANIMATED_CURSOR_H_
+
+#include "mir/graphics/cursor.h"
+#include "mir/graphics/cursor_image.h"
+
+#include <mutex>
+#include <vector>
+
+namespace mir
+{
+namespace time
+{
+class Alarm;
+class AlarmFactory;
+}
+namespace graphics
+{
+/// Steps the wrapped cursor through the frames of AnimatedCursorImages; other images are passed straight through
+class AnimatedCursor : public Cursor
+{
+public:
+    AnimatedCursor(std::shared_ptr<Cursor> const& wrapped, time::AlarmFactory& alarm_factory);
+    ~AnimatedCursor();
+
+    void show(CursorImage const& cursor_image) override;
+    void hide() override;
+    void move_to(geometry::Point position) override;
+
+private:
+    class AlarmCallback;
+    void show_next_frame();
+
+    std::shared_ptr<Cursor> const wrapped;
+
+    std::mutex mutex;
+    /// The frames of the animation being shown, or empty if there is none
+    std::vector<AnimatedCursorImage::Frame> frames;
+    size_t current_frame{0};
+    std::unique_ptr<time::Alarm> const alarm;
+};
+}
+}
+
+#endif // MIR_GRAPHICS_ANIMATED_CURSOR_H_
@@ -20,6 +20,7 @@
 #include "mir/graphics/default_display_configuration_policy.h"
 #include "mir/graphics/graphic_buffer_allocator.h"
 #include "mir/graphics/display.h"
+#include "animated_cursor.h"
 #include "null_cursor.h"
 #include "software_cursor.h"
 #include "platform_probe.h"
@@ -36,9 +37,11 @@
 #include "mir/log.h"
 #include "mir/report_exception.h"
 #include "mir/main_loop.h"
+#include "mir/udev/wrapper.h"
 
 #include <boost/throw_exception.hpp>
 
+#include <cstdlib>
 #include <sstream>
 
 namespace mg = mir::graphics;
@@ -133,6 +136,36 @@ auto select_platforms_from_list(std::string const& selection, std::vector<std::s
 
     return selected_modules;
 }
+
+/// The cache of the \a platform_type platforms chosen, if --cache-platform-probe is set and there is a cache directory
+auto platform_probe_cache(
+    mir::options::Option const& options,
+    std::string const& platform_type,
+    std::string const& platform_path) -> std::unique_ptr<mg::PlatformProbeCache>
+{
+    if (!options.is_set(mir::options::cache_platform_probe_opt))
+    {
+        return nullptr;
+    }
+
+    std::string cache_dir;
+    if (auto const xdg_cache_home = getenv("XDG_CACHE_HOME"))
+    {
+        cache_dir = xdg_cache_home;
+    }
+    else if (auto const home = getenv("HOME"))
+    {
+        cache_dir = std::string{home} + "/.cache";
+    }
+    else
+    {
+        return nullptr;
+    }
+
+    return std::make_unique<mg::PlatformProbeCache>(
+        cache_dir + "/mir/" + platform_type + "-platforms",
+        mg::system_identity(platform_path, std::make_shared<mir::udev::Context>()));
+}
 }
 
 auto mir::DefaultServerConfiguration::the_display_platforms() -> std::vector<std::shared_ptr<graphics::DisplayPlatform>> const&
@@ -189,7 +222,8 @@ auto mir::DefaultServerConfiguration::the_display_platforms() -> std::vector<std
             }
             else
             {
-                platform_modules = mir::graphics::display_modules_for_device(platforms, dynamic_cast<mir::options::ProgramOption&>(*the_options()), the_console_services());
+                auto const cache = platform_probe_cache(*the_options(), "display", path);
+                platform_modules = mir::graphics::display_modules_for_device(platforms, dynamic_cast<mir::options::ProgramOption&>(*the_options()), the_console_services(), cache.get());
             }
 
             for (auto const& [device, platform]: platform_modules)
@@ -292,7 +326,8 @@ auto mir::DefaultServerConfiguration::the_rendering_platforms() ->
             }
             else
             {
-                platform_modules = mir::graphics::rendering_modules_for_device(platforms, dynamic_cast<mir::options::ProgramOption&>(*the_options()), the_console_services());
+                auto const cache = platform_probe_cache(*the_options(), "rendering", path);
+                platform_modules = mir::graphics::rendering_modules_for_device(platforms, dynamic_cast<mir::options::ProgramOption&>(*the_options()), the_console_services(), cache.get());
             }
 
             for (auto const& [device, platform]: platform_modules)
@@ -397,6 +432,11 @@ mir::DefaultServerConfiguration::the_cursor()
                     the_input_scene());
             }
 
+            if (cursor_choice != "null")
+            {
+                primary_cursor = std::make_shared<mg::AnimatedCursor>(primary_cursor, *the_main_loop());
+            }
+
             primary_cursor->show(*the_default_cursor_image());
             return wrap_cursor(primary_cursor);
         });
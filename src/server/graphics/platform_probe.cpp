@@ -15,35 +15,49 @@
  */
 
 #include "mir/log.h"
+#include "mir/console_services.h"
 #include "mir/graphics/platform.h"
+#include "mir/udev/wrapper.h"
 #include "platform_probe.h"
 
 #include <boost/throw_exception.hpp>
 
+#include <algorithm>
+#include <condition_variable>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <mutex>
+#include <set>
+#include <sstream>
+
 namespace mg = mir::graphics;
 
 namespace
 {
-auto probe_module(
-    mir::graphics::PlatformProbe const& probe,
-    mir::SharedLibrary& module,
-    char const* platform_type_name,
-    mir::options::ProgramOption const& options,
-    std::shared_ptr<mir::ConsoleServices> const& console) -> std::vector<mg::SupportedDevice>
+auto module_description(mir::SharedLibrary const& module) -> mir::ModuleProperties const*
 {
     auto describe = module.load_function<mir::graphics::DescribeModule>(
         "describe_graphics_module",
         MIR_SERVER_GRAPHICS_PLATFORM_VERSION);
 
-    auto desc = describe();
+    return describe();
+}
+
+void log_module_found(mir::SharedLibrary const& module, char const* platform_type_name)
+{
+    auto desc = module_description(module);
     mir::log_info("Found %s driver: %s (version %d.%d.%d)",
                   platform_type_name,
                   desc->name,
                   desc->major_version,
                   desc->minor_version,
                   desc->micro_version);
+}
 
-    auto supported_devices = probe(console, std::make_shared<mir::udev::Context>(), options);
+void log_supported_devices(std::vector<mg::SupportedDevice> const& supported_devices)
+{
     if (supported_devices.empty())
     {
         mir::log_info("(Unsupported by system environment)");
@@ -70,10 +84,110 @@ auto probe_module(
             mir::log_info("\t%s (priority %i)", device_name.c_str(), device.support_level);
         }
     }
+}
+
+auto probe_module(
+    mir::graphics::PlatformProbe const& probe,
+    mir::SharedLibrary& module,
+    char const* platform_type_name,
+    mir::options::ProgramOption const& options,
+    std::shared_ptr<mir::ConsoleServices> const& console) -> std::vector<mg::SupportedDevice>
+{
+    log_module_found(module, platform_type_name);
+    auto supported_devices = probe(console, std::make_shared<mir::udev::Context>(), options);
+    log_supported_devices(supported_devices);
     return supported_devices;
 }
 }
 
+mg::PlatformProbeCache::PlatformProbeCache(std::string file, std::string identity)
+    : file{std::move(file)},
+      identity{std::move(identity)}
+{
+}
+
+auto mg::PlatformProbeCache::chosen_modules() const -> std::vector<std::string>
+{
+    // The file holds the identity of the system, a blank line, then the name of each module chosen on it
+    std::ifstream in{file};
+    std::stringstream cached_identity;
+    for (std::string line; std::getline(in, line) && !line.empty();)
+    {
+        cached_identity << line << "\n";
+    }
+
+    std::vector<std::string> result;
+    if (cached_identity.str() == identity)
+    {
+        for (std::string line; std::getline(in, line);)
+        {
+            result.push_back(line);
+        }
+    }
+    return result;
+}
+
+void mg::PlatformProbeCache::store(std::vector<std::string> const& module_names) const
+{
+    // Written aside and renamed into place, so a server starting at the same time never reads half a file
+    std::error_code ignored;
+    std::filesystem::create_directories(std::filesystem::path{file}.parent_path(), ignored);
+
+    auto const new_file = file + ".new";
+    {
+        std::ofstream out{new_file};
+        out << identity << "\n";
+        for (auto const& name : module_names)
+        {
+            out << name << "\n";
+        }
+        if (!out)
+        {
+            mir::log_warning("Failed to write platform probe cache %s", new_file.c_str());
+            return;
+        }
+    }
+    std::filesystem::rename(new_file, file, ignored);
+}
+
+auto mg::system_identity(std::string const& platform_path, std::shared_ptr<udev::Context> const& udev) -> std::string
+{
+    std::set<std::string> lines;
+
+    std::error_code error;
+    for (std::filesystem::directory_iterator entry{platform_path, error}, end; !error && entry != end; entry.increment(error))
+    {
+        std::error_code ignored;
+        auto const size = entry->file_size(ignored);
+        auto const modified = entry->last_write_time(ignored).time_since_epoch().count();
+        lines.insert("module " + entry->path().filename().string() + " " + std::to_string(size) + " " + std::to_string(modified));
+    }
+
+    mir::udev::Enumerator drm_devices{udev};
+    drm_devices.match_subsystem("drm");
+    drm_devices.scan_devices();
+    for (auto const& device : drm_devices)
+    {
+        lines.insert(std::string{"device "} + device.syspath());
+    }
+
+    // Hosted platforms probe for these
+    for (auto const name : {"DISPLAY", "WAYLAND_DISPLAY"})
+    {
+        if (auto const value = getenv(name))
+        {
+            lines.insert(std::string{"environment "} + name + "=" + value);
+        }
+    }
+
+    std::string identity;
+    for (auto const& line : lines)
+    {
+        identity += line + "\n";
+    }
+    return identity;
+}
+
 auto mir::graphics::probe_display_module(
     SharedLibrary& module,
     options::ProgramOption const& options,
@@ -127,28 +241,163 @@ enum class ModuleType
     Display
 };
 
-auto modules_for_device(
+auto type_name(ModuleType type) -> char const*
+{
+    switch (type)
+    {
+    case ModuleType::Rendering:
+        return "rendering";
+    case ModuleType::Display:
+        return "display";
+    }
+    return "unknown";
+}
+
+auto load_probe(ModuleType type, mir::SharedLibrary const& module) -> mg::PlatformProbe
+{
+    return module.load_function<mg::PlatformProbe>(
+        type == ModuleType::Rendering ? "probe_rendering_platform" : "probe_display_platform",
+        MIR_SERVER_GRAPHICS_PLATFORM_VERSION);
+}
+
+/// Gives one probe at a time the use of the console's devices. A console (such as logind) hands out each device only
+/// once, and several modules (gbm-kms and eglstream-kms, say) probe the same DRM nodes.
+class ConsoleDeviceTurn
+{
+public:
+    void take()
+    {
+        std::unique_lock lock{mutex};
+        turn_free.wait(lock, [this] { return !taken; });
+        taken = true;
+    }
+
+    void give_back()
+    {
+        {
+            std::lock_guard lock{mutex};
+            taken = false;
+        }
+        turn_free.notify_one();
+    }
+
+private:
+    std::mutex mutex;
+    std::condition_variable turn_free;
+    bool taken{false};
+};
+
+/// The console a single probe sees. The probe waits for its turn the first time it acquires a device and keeps the
+/// turn until it finishes (releasing its devices), so probes that never use the console aren't held up by those that
+/// do.
+class ProbeConsoleServices : public mir::ConsoleServices
+{
+public:
+    ProbeConsoleServices(std::shared_ptr<mir::ConsoleServices> const& console, ConsoleDeviceTurn& device_turn)
+        : console{console},
+          device_turn{device_turn}
+    {
+    }
+
+    void register_switch_handlers(
+        mg::EventHandlerRegister& handlers,
+        std::function<bool()> const& switch_away,
+        std::function<bool()> const& switch_back) override
+    {
+        console->register_switch_handlers(handlers, switch_away, switch_back);
+    }
+
+    void restore() override
+    {
+        console->restore();
+    }
+
+    auto create_vt_switcher() -> std::unique_ptr<mir::VTSwitcher> override
+    {
+        return console->create_vt_switcher();
+    }
+
+    auto acquire_device(int major, int minor, std::unique_ptr<mir::Device::Observer> observer)
+        -> std::future<std::unique_ptr<mir::Device>> override
+    {
+        {
+            std::lock_guard lock{mutex};
+            // A probe that holds on to its console can acquire devices later, but probing is over by then
+            if (!has_turn && !probe_finished)
+            {
+                device_turn.take();
+                has_turn = true;
+            }
+        }
+        return console->acquire_device(major, minor, std::move(observer));
+    }
+
+    void finished_probing()
+    {
+        std::lock_guard lock{mutex};
+        probe_finished = true;
+        if (has_turn)
+        {
+            has_turn = false;
+            device_turn.give_back();
+        }
+    }
+
+private:
+    std::shared_ptr<mir::ConsoleServices> const console;
+    ConsoleDeviceTurn& device_turn;
+
+    std::mutex mutex;
+    bool has_turn{false};
+    bool probe_finished{false};
+};
+
+auto best_modules_for_device(
     ModuleType type,
     std::vector<std::shared_ptr<mir::SharedLibrary>> const& modules,
     mir::options::ProgramOption const& options,
     std::shared_ptr<mir::ConsoleServices> const& console)
 -> std::vector<std::pair<mg::SupportedDevice, std::shared_ptr<mir::SharedLibrary>>>
 {
+    // Probes may open devices, initialise EGL or query udev, so run them all at once. They get a thread each, rather
+    // than a place on the thread pool, as they may block (for example, waiting their turn for the console's devices).
+    ConsoleDeviceTurn device_turn;
+    std::vector<std::future<std::vector<mg::SupportedDevice>>> probes;
+    for (auto const& module : modules)
+    {
+        probes.push_back(std::async(
+            std::launch::async,
+            [&, module]
+            {
+                auto const probe_console = std::make_shared<ProbeConsoleServices>(console, device_turn);
+                try
+                {
+                    auto supported_devices = load_probe(type, *module)(
+                        probe_console,
+                        std::make_shared<mir::udev::Context>(),
+                        options);
+                    probe_console->finished_probing();
+                    return supported_devices;
+                }
+                catch (...)
+                {
+                    probe_console->finished_probing();
+                    throw;
+                }
+            }));
+    }
+
+    // The results are taken in module order, so the choice is the same as probing one module after another
     std::vector<std::pair<mg::SupportedDevice, std::shared_ptr<mir::SharedLibrary>>> best_modules_so_far;
-    for (auto& module : modules)
+    for (size_t i = 0; i != modules.size(); ++i)
     {
+        auto const& module = modules[i];
         try
         {
-            std::vector<mg::SupportedDevice> supported_devices;
-            switch (type)
-            {
-            case ModuleType::Rendering:
-                supported_devices = mg::probe_rendering_module(*module, options, console);
-                break;
-            case ModuleType::Display:
-                supported_devices = mg::probe_display_module(*module, options, console);
-                break;
-            }
+            auto supported_devices = probes[i].get();
+            log_module_found(*module, type_name(type));
+            log_supported_devices(supported_devices);
+
             for (auto& device : supported_devices)
             {
                 if (device.device)
@@ -211,28 +460,94 @@ auto modules_for_device(
     }
     return best_modules_so_far;
 }
+
+auto module_names(std::vector<std::pair<mg::SupportedDevice, std::shared_ptr<mir::SharedLibrary>>> const& chosen)
+-> std::vector<std::string>
+{
+    std::set<std::string> names;
+    for (auto const& [device, module] : chosen)
+    {
+        names.insert(module_description(*module)->name);
+    }
+    return {names.begin(), names.end()};
+}
+
+auto modules_for_device(
+    ModuleType type,
+    std::vector<std::shared_ptr<mir::SharedLibrary>> const& modules,
+    mir::options::ProgramOption const& options,
+    std::shared_ptr<mir::ConsoleServices> const& console,
+    mg::PlatformProbeCache const* cache)
+-> std::vector<std::pair<mg::SupportedDevice, std::shared_ptr<mir::SharedLibrary>>>
+{
+    if (auto const cached_names = cache ? cache->chosen_modules() : std::vector<std::string>{}; !cached_names.empty())
+    {
+        std::vector<std::shared_ptr<mir::SharedLibrary>> cached_modules;
+        for (auto const& module : modules)
+        {
+            try
+            {
+                auto const name = module_description(*module)->name;
+                if (std::find(cached_names.begin(), cached_names.end(), name) != cached_names.end())
+                {
+                    cached_modules.push_back(module);
+                }
+            }
+            catch (std::runtime_error const&)
+            {
+                // Not a graphics module
+            }
+        }
+
+        try
+        {
+            // The other modules lost on this system before, so if these still win there's no need to probe them
+            auto chosen = best_modules_for_device(type, cached_modules, options, console);
+            if (module_names(chosen) == cached_names)
+            {
+                mir::log_info("Using the %s platforms chosen when last started on this system", type_name(type));
+                return chosen;
+            }
+        }
+        catch (std::runtime_error const&)
+        {
+        }
+        mir::log_info("The %s platforms chosen last time no longer support this system; probing all", type_name(type));
+    }
+
+    auto chosen = best_modules_for_device(type, modules, options, console);
+    if (cache)
+    {
+        cache->store(module_names(chosen));
+    }
+    return chosen;
+}
 }
 
 auto mir::graphics::display_modules_for_device(
     std::vector<std::shared_ptr<SharedLibrary>> const& modules,
     options::ProgramOption const& options,
-    std::shared_ptr<ConsoleServices> const& console) -> std::vector<std::pair<SupportedDevice, std::shared_ptr<SharedLibrary>>>
+    std::shared_ptr<ConsoleServices> const& console,
+    PlatformProbeCache const* cache) -> std::vector<std::pair<SupportedDevice, std::shared_ptr<SharedLibrary>>>
 {
     return modules_for_device(
         ModuleType::Display,
         modules,
         options,
-        console);
+        console,
+        cache);
 }
 
 auto mir::graphics::rendering_modules_for_device(
     std::vector<std::shared_ptr<SharedLibrary>> const& modules,
     options::ProgramOption const& options,
-    std::shared_ptr<ConsoleServices> const& console) -> std::vector<std::pair<SupportedDevice, std::shared_ptr<SharedLibrary>>>
+    std::shared_ptr<ConsoleServices> const& console,
+    PlatformProbeCache const* cache) -> std::vector<std::pair<SupportedDevice, std::shared_ptr<SharedLibrary>>>
 {
     return modules_for_device(
         ModuleType::Rendering,
         modules,
         options,
-        console);
+        console,
+        cache);
 }
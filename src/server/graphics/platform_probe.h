@@ -19,6 +19,7 @@
 
 #include <vector>
 #include <memory>
+#include <string>
 #include <tuple>
 #include "mir/shared_library.h"
 #include "mir/options/program_option.h"
@@ -28,8 +29,34 @@ namespace mir
 {
 class ConsoleServices;
 
+namespace udev
+{
+class Context;
+}
+
 namespace graphics
 {
+/// Remembers which modules were chosen on a system, so that later starts on it need only probe those modules
+class PlatformProbeCache
+{
+public:
+    /// \param file      where the choice is kept
+    /// \param identity  describes the system (see system_identity()); a choice made on any other system is ignored
+    PlatformProbeCache(std::string file, std::string identity);
+
+    /// The names of the modules chosen on this system, or none if no choice has been stored for it
+    auto chosen_modules() const -> std::vector<std::string>;
+
+    void store(std::vector<std::string> const& module_names) const;
+
+private:
+    std::string const file;
+    std::string const identity;
+};
+
+/// Describes what probing depends on: the module files in \a platform_path, the DRM devices and any host display
+auto system_identity(std::string const& platform_path, std::shared_ptr<udev::Context> const& udev) -> std::string;
+
 auto probe_display_module(
     SharedLibrary& module,
     options::ProgramOption const& options,
@@ -40,16 +67,20 @@ auto probe_rendering_module(
     options::ProgramOption const& options,
     std::shared_ptr<ConsoleServices> const& console) -> std::vector<SupportedDevice>;
 
+/// Probes \a modules concurrently, and picks the best module for each device
+/// If \a cache holds a choice for this system only the modules chosen are probed, unless they no longer support it.
 auto display_modules_for_device(
     std::vector<std::shared_ptr<SharedLibrary>> const& modules,
     options::ProgramOption const& options,
-    std::shared_ptr<ConsoleServices> const& console)
+    std::shared_ptr<ConsoleServices> const& console,
+    PlatformProbeCache const* cache = nullptr)
     -> std::vector<std::pair<SupportedDevice, std::shared_ptr<SharedLibrary>>>;
 
 auto rendering_modules_for_device(
     std::vector<std::shared_ptr<SharedLibrary>> const& modules,
     options::ProgramOption const& options,
-    std::shared_ptr<ConsoleServices> const& console)
+    std::shared_ptr<ConsoleServices> const& console,
+    PlatformProbeCache const* cache = nullptr)
     -> std::vector<std::pair<SupportedDevice, std::shared_ptr<SharedLibrary>>>;
 }
 }
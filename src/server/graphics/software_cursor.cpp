@@ -26,6 +26,7 @@
 
 #include <boost/throw_exception.hpp>
 #include <stdexcept>
+#include <string_view>
 #include <mutex>
 
 namespace mg = mir::graphics;
@@ -52,7 +53,26 @@ MirPixelFormat get_8888_format(std::vector<MirPixelFormat> const& formats)
     return mir_pixel_format_invalid;
 }
 
+/// Enough for every frame of the animated cursors in common themes
+size_t const max_cached_images{64};
+
+auto pixels_of(mg::CursorImage const& image) -> std::string_view
+{
+    return {
+        static_cast<char const*>(image.as_argb_8888()),
+        image.size().width.as_uint32_t() * image.size().height.as_uint32_t() * MIR_BYTES_PER_PIXEL(mir_pixel_format_argb_8888)};
 }
+}
+
+/// An image that has been uploaded. Images are matched by content rather than by the CursorImage object, as an
+/// object may be reused with new content (and the same content may arrive in many objects).
+struct mg::SoftwareCursor::CachedImage
+{
+    geom::Size size;
+    size_t hash;
+    std::string pixels;
+    std::shared_ptr<mg::Buffer> buffer;
+};
 
 class mg::detail::CursorRenderable : public mg::Renderable
 {
@@ -140,6 +160,18 @@ void mg::SoftwareCursor::show(CursorImage const& cursor_image)
     if (renderable)
         position = renderable->screen_position().top_left;
 
+    // Upload every frame of an animation now, so that stepping through it only swaps renderables
+    if (auto const animated = dynamic_cast<AnimatedCursorImage const*>(&cursor_image))
+    {
+        for (auto const& frame : animated->frames())
+        {
+            if (frame.image->size().width.as_uint32_t() != 0 && frame.image->size().height.as_uint32_t() != 0)
+            {
+                buffer_for(*frame.image);
+            }
+        }
+    }
+
     renderable = create_renderable_for(cursor_image, position);
     hotspot = cursor_image.hotspot();
     visible = true;
@@ -162,21 +194,43 @@ mg::SoftwareCursor::create_renderable_for(CursorImage const& cursor_image, geom:
     if (cursor_image.size().width.as_uint32_t() == 0 || cursor_image.size().height.as_uint32_t() == 0)
         BOOST_THROW_EXCEPTION(std::logic_error("zero sized software cursor image is invalid"));
 
-    auto buffer = mrs::alloc_buffer_with_content(
-        *allocator,
-        static_cast<unsigned char const*>(cursor_image.as_argb_8888()),
-        cursor_image.size(),
-        geom::Stride{
-            cursor_image.size().width.as_uint32_t() * MIR_BYTES_PER_PIXEL(mir_pixel_format_argb_8888)},
-        mir_pixel_format_argb_8888);
-
     auto new_renderable = std::make_shared<detail::CursorRenderable>(
-        std::move(buffer),
+        buffer_for(cursor_image),
         position + hotspot - cursor_image.hotspot());
 
     return new_renderable;
 }
 
+auto mg::SoftwareCursor::buffer_for(CursorImage const& cursor_image) -> std::shared_ptr<Buffer>
+{
+    auto const size = cursor_image.size();
+    auto const pixels = pixels_of(cursor_image);
+    auto const hash = std::hash<std::string_view>{}(pixels);
+
+    for (auto cached = cached_images.begin(); cached != cached_images.end(); ++cached)
+    {
+        if (cached->hash == hash && cached->size == size && cached->pixels == pixels)
+        {
+            cached_images.splice(cached_images.begin(), cached_images, cached);
+            return cached->buffer;
+        }
+    }
+
+    auto buffer = mrs::alloc_buffer_with_content(
+        *allocator,
+        reinterpret_cast<unsigned char const*>(pixels.data()),
+        size,
+        geom::Stride{size.width.as_uint32_t() * MIR_BYTES_PER_PIXEL(mir_pixel_format_argb_8888)},
+        mir_pixel_format_argb_8888);
+
+    cached_images.push_front({size, hash, std::string{pixels}, buffer});
+    if (cached_images.size() > max_cached_images)
+    {
+        cached_images.pop_back();
+    }
+    return buffer;
+}
+
 void mg::SoftwareCursor::hide()
 {
     std::lock_guard lg{guard};
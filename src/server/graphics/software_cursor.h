@@ -20,6 +20,7 @@
 #include "mir/graphics/cursor.h"
 #include "mir_toolkit/client_types.h"
 #include "mir/geometry/displacement.h"
+#include <list>
 #include <mutex>
 
 namespace mir
@@ -28,6 +29,7 @@ class Executor;
 namespace input { class Scene; }
 namespace graphics
 {
+class Buffer;
 class GraphicBufferAllocator;
 class Renderable;
 
@@ -52,6 +54,8 @@ public:
 private:
     std::shared_ptr<detail::CursorRenderable> create_renderable_for(
         CursorImage const& cursor_image, geometry::Point position);
+    /// A buffer holding \a cursor_image, only uploading it if it is not among the images shown recently
+    auto buffer_for(CursorImage const& cursor_image) -> std::shared_ptr<Buffer>;
 
     std::shared_ptr<GraphicBufferAllocator> const allocator;
     std::shared_ptr<input::Scene> const scene;
@@ -65,6 +69,10 @@ private:
     std::shared_ptr<detail::CursorRenderable> renderable;
     bool visible;
     geometry::Displacement hotspot;
+
+    struct CachedImage;
+    /// Buffers for the images shown most recently, most recent first
+    std::list<CachedImage> cached_images;
 };
 
 }
@@ -130,6 +130,7 @@ private:
 ms::SurfaceStack::SurfaceStack(
     std::shared_ptr<SceneReport> const& report) :
     report{report},
+    snapshot{std::make_shared<Snapshot const>()},
     scene_changed{false},
     surface_observer{std::make_shared<SurfaceDepthLayerObserver>(this)}
 {
@@ -149,29 +150,27 @@ ms::SurfaceStack::~SurfaceStack() noexcept(true)
 
 mc::SceneElementSequence ms::SurfaceStack::scene_elements_for(mc::CompositorID id)
 {
-    RecursiveReadLock lg(guard);
-
+    // Cleared before taking the snapshot, so a change published after it marks the scene as changed again
     scene_changed = false;
+    auto const state = current_snapshot();
+
     mc::SceneElementSequence elements;
-    for (auto const& layer : surface_layers)
+    for (auto const& [surface, tracker] : state->surfaces)
     {
-        for (auto const& surface : layer)
+        if (surface->visible())
         {
-            if (surface->visible())
+            for (auto& renderable : surface->generate_renderables(id))
             {
-                for (auto& renderable : surface->generate_renderables(id))
-                {
-                    elements.emplace_back(
-                        std::make_shared<SurfaceSceneElement>(
-                            surface->name(),
-                            renderable,
-                            rendering_trackers[surface.get()],
-                            id));
-                }
+                elements.emplace_back(
+                    std::make_shared<SurfaceSceneElement>(
+                        surface->name(),
+                        renderable,
+                        tracker,
+                        id));
             }
         }
     }
-    for (auto const& renderable : overlays)
+    for (auto const& renderable : state->overlays)
     {
         elements.emplace_back(std::make_shared<OverlaySceneElement>(renderable));
     }
@@ -180,26 +179,17 @@ mc::SceneElementSequence ms::SurfaceStack::scene_elements_for(mc::CompositorID i
 
 int ms::SurfaceStack::frames_pending(mc::CompositorID id) const
 {
-    RecursiveReadLock lg(guard);
-
     int result = scene_changed ? 1 : 0;
-    for (auto const& layer : surface_layers)
+    for (auto const& [surface, tracker] : current_snapshot()->surfaces)
     {
-        for (auto const& surface : layer)
+        if (surface->visible() && tracker->is_exposed_in(id))
         {
-            if (surface->visible())
-            {
-                auto const tracker = rendering_trackers.find(surface.get());
-                if (tracker != rendering_trackers.end() && tracker->second->is_exposed_in(id))
-                {
-                    // Note that we ask the surface and not a Renderable.
-                    // This is because we don't want to waste time and resources
-                    // on a snapshot till we're sure we need it...
-                    int ready = surface->buffers_ready_for_compositor(id);
-                    if (ready > result)
-                        result = ready;
-                }
-            }
+            // Note that we ask the surface and not a Renderable.
+            // This is because we don't want to waste time and resources
+            // on a snapshot till we're sure we need it...
+            int ready = surface->buffers_ready_for_compositor(id);
+            if (ready > result)
+                result = ready;
         }
     }
     return result;
@@ -229,6 +219,7 @@ void ms::SurfaceStack::add_input_visualization(
     {
         RecursiveWriteLock lg(guard);
         overlays.push_back(overlay);
+        publish_snapshot();
     }
     emit_scene_changed();
 }
@@ -245,6 +236,7 @@ void ms::SurfaceStack::remove_input_visualization(
             BOOST_THROW_EXCEPTION(std::runtime_error("Attempt to remove an overlay which was never added or which has been previously removed"));
         }
         overlays.erase(p);
+        publish_snapshot();
     }
     
     emit_scene_changed();
@@ -268,6 +260,7 @@ void ms::SurfaceStack::add_surface(
         insert_surface_at_top_of_depth_layer(surface);
         create_rendering_tracker_for(surface);
         surface->register_interest(surface_observer, immediate_executor);
+        publish_snapshot();
     }
     surface->set_reception_mode(input_mode);
     observers.surface_added(surface);
@@ -293,6 +286,7 @@ void ms::SurfaceStack::remove_surface(std::weak_ptr<Surface> const& surface)
                 rendering_trackers.erase(keep_alive.get());
                 keep_alive->unregister_interest(*surface_observer);
                 found_surface = true;
+                publish_snapshot();
                 break;
             }
         }
@@ -322,18 +316,15 @@ InReverse<Container> in_reverse(Container& container) { return InReverse<Contain
 auto ms::SurfaceStack::surface_at(geometry::Point cursor) const
 -> std::shared_ptr<Surface>
 {
-    RecursiveReadLock lg(guard);
-    for (auto const& layer : in_reverse(surface_layers))
+    auto const state = current_snapshot();
+    for (auto const& entry : in_reverse(state->surfaces))
     {
-        for (auto const& surface : in_reverse(layer))
-        {
-            // TODO There's a lack of clarity about how the input area will
-            // TODO be maintained and whether this test will detect clicks on
-            // TODO decorations (it should) as these may be outside the area
-            // TODO known to the client.  But it works for now.
-            if (surface->input_area_contains(cursor))
-                    return surface;
-        }
+        // TODO There's a lack of clarity about how the input area will
+        // TODO be maintained and whether this test will detect clicks on
+        // TODO decorations (it should) as these may be outside the area
+        // TODO known to the client.  But it works for now.
+        if (entry.surface->input_area_contains(cursor))
+                return entry.surface;
     }
 
     return {};
@@ -341,13 +332,9 @@ auto ms::SurfaceStack::surface_at(geometry::Point cursor) const
 
 void ms::SurfaceStack::for_each(std::function<void(std::shared_ptr<mi::Surface> const&)> const& callback)
 {
-    RecursiveReadLock lg(guard);
-    for (auto const& layer : surface_layers)
+    for (auto const& entry : current_snapshot()->surfaces)
     {
-        for (auto const& surface : layer)
-        {
-            callback(surface);
-        }
+        callback(entry.surface);
     }
 }
 
@@ -373,6 +360,7 @@ void ms::SurfaceStack::raise(Surface const* surface)
                 layer.erase(p);
                 insert_surface_at_top_of_depth_layer(surface_shared);
                 affected_surfaces.insert(surface_shared);
+                publish_snapshot();
                 break;
             }
         }
@@ -423,6 +411,9 @@ void ms::SurfaceStack::raise(SurfaceSet const& ss)
             if (old_layer != layer)
                 surfaces_reordered = true;
         }
+
+        if (surfaces_reordered)
+            publish_snapshot();
     }
 
     if (surfaces_reordered)
@@ -456,6 +447,26 @@ void ms::SurfaceStack::insert_surface_at_top_of_depth_layer(std::shared_ptr<Surf
     surface_layers[depth_index].push_back(surface);
 }
 
+void ms::SurfaceStack::publish_snapshot()
+{
+    auto next = std::make_shared<Snapshot>();
+    for (auto const& layer : surface_layers)
+    {
+        for (auto const& surface : layer)
+        {
+            next->surfaces.push_back({surface, rendering_trackers.at(surface.get())});
+        }
+    }
+    next->overlays = overlays;
+
+    std::atomic_store(&snapshot, std::shared_ptr<Snapshot const>{std::move(next)});
+}
+
+auto ms::SurfaceStack::current_snapshot() const -> std::shared_ptr<Snapshot const>
+{
+    return std::atomic_load(&snapshot);
+}
+
 void ms::SurfaceStack::add_observer(std::shared_ptr<ms::Observer> const& observer)
 {
     observers.add(observer);
@@ -486,15 +497,11 @@ auto ms::SurfaceStack::stacking_order_of(SurfaceSet const& surfaces) const -> Su
 {
     SurfaceList result;
 
-    RecursiveReadLock lk(guard);
-    for (auto const& layer : surface_layers)
+    for (auto const& entry : current_snapshot()->surfaces)
     {
-        for (auto const& surface : layer)
+        if (surfaces.find(entry.surface) != surfaces.end())
         {
-            if (surfaces.find(surface) != surfaces.end())
-            {
-                result.push_back(surface);
-            }
+            result.push_back(entry.surface);
         }
     }
     return result;
@@ -114,6 +114,25 @@ private:
     void update_rendering_tracker_compositors();
     void insert_surface_at_top_of_depth_layer(std::shared_ptr<Surface> const& surface);
 
+    /// An immutable copy of what the compositors and input need from the stack
+    struct Snapshot
+    {
+        struct Entry
+        {
+            std::shared_ptr<Surface> surface;
+            std::shared_ptr<RenderingTracker> tracker;
+        };
+
+        std::vector<Entry> surfaces; ///< In stacking order, bottom to top
+        std::vector<std::shared_ptr<graphics::Renderable>> overlays;
+    };
+
+    /// Replaces the snapshot with a copy of the current state. Must be called with the guard write-locked.
+    void publish_snapshot();
+    /// The latest snapshot, which readers may use without locking the guard
+    auto current_snapshot() const -> std::shared_ptr<Snapshot const>;
+
+    /// Serialises changes to the stack. Readers use the snapshot instead, so they never wait for a writer.
     RecursiveReadWriteMutex mutable guard;
 
     std::shared_ptr<SceneReport> const report;
@@ -131,6 +150,9 @@ private:
     
     std::vector<std::shared_ptr<graphics::Renderable>> overlays;
 
+    /// Only ever accessed with std::atomic_load() and std::atomic_store()
+    std::shared_ptr<Snapshot const> snapshot;
+
     Observers observers;
     std::atomic<bool> scene_changed;
     std::shared_ptr<SurfaceObserver> surface_observer;
@@ -16,7 +16,9 @@
 
 #include "mir/server.h"
 
+#include "mir/abnormal_exit.h"
 #include "mir/emergency_cleanup.h"
+#include "mir/executor.h"
 #include "mir/fd.h"
 #include "mir/frontend/connector.h"
 #include "mir/graphics/graphic_buffer_allocator.h"
@@ -392,6 +394,22 @@ void mir::Server::run()
         mir::log_info("Starting");
         verify_accessing_allowed(self->server_config);
 
+        auto const options = self->server_config->the_options();
+        if (options->is_set(mo::thread_pool_size_opt))
+        {
+            int const thread_pool_size = options->get<int>(mo::thread_pool_size_opt);
+            if (thread_pool_size < 1)
+            {
+                throw mir::AbnormalExit(
+                    "Invalid " +
+                    std::string{mo::thread_pool_size_opt} +
+                    " value " +
+                    std::to_string(thread_pool_size) +
+                    ", must be > 0");
+            }
+            ThreadPoolExecutor::set_thread_count(thread_pool_size);
+        }
+
         auto const emergency_cleanup = self->server_config->the_emergency_cleanup();
         auto const composite_event_filter = self->server_config->the_composite_event_filter();
 
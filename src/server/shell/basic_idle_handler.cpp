@@ -18,7 +18,7 @@
 #include "mir/fatal.h"
 #include "mir/scene/idle_hub.h"
 #include "mir/graphics/renderable.h"
-#include "mir/renderer/sw/pixel_source.h"
+#include "mir/graphics/solid_color_buffer.h"
 #include "mir/input/scene.h"
 #include "mir/shell/display_configuration_controller.h"
 
@@ -28,25 +28,18 @@ namespace ms = mir::scene;
 namespace mg = mir::graphics;
 namespace mi = mir::input;
 namespace geom = mir::geometry;
-namespace mrs = mir::renderer::software;
 namespace msh = mir::shell;
 
 namespace
 {
 auto const dim_time_before_off = std::chrono::seconds{10};
-unsigned char const black_pixel_data[4] = {0, 0, 0, 255};
 int const coverage_size = 100000;
 
 struct DimmingRenderable : public mg::Renderable
 {
 public:
-    DimmingRenderable(mg::GraphicBufferAllocator& allocator)
-        : buffer_{mrs::alloc_buffer_with_content(
-              allocator,
-              black_pixel_data,
-              {1, 1},
-              geom::Stride{4}, // 1 pixel, 4 bytes per pixel
-              mir_pixel_format_abgr_8888)}
+    DimmingRenderable()
+        : buffer_{std::make_shared<mg::SolidColorBuffer>(geom::Size{1, 1}, glm::vec4{0.0f, 0.0f, 0.0f, 1.0f})}
     {
     }
 
@@ -91,11 +84,8 @@ private:
 
 struct Dimmer : ms::IdleStateObserver
 {
-    Dimmer(
-        std::shared_ptr<mi::Scene> const& input_scene,
-        std::shared_ptr<mg::GraphicBufferAllocator> const& allocator)
-        : input_scene{input_scene},
-          allocator{allocator}
+    Dimmer(std::shared_ptr<mi::Scene> const& input_scene)
+        : input_scene{input_scene}
     {
     }
 
@@ -113,14 +103,13 @@ struct Dimmer : ms::IdleStateObserver
     {
         if (!renderable)
         {
-            renderable = std::make_shared<DimmingRenderable>(*allocator);
+            renderable = std::make_shared<DimmingRenderable>();
             input_scene->add_input_visualization(renderable);
         }
     }
 
 private:
     std::shared_ptr<mi::Scene> const input_scene;
-    std::shared_ptr<mg::GraphicBufferAllocator> const allocator;
     std::shared_ptr<mg::Renderable> renderable;
 };
 
@@ -151,11 +140,9 @@ private:
 msh::BasicIdleHandler::BasicIdleHandler(
     std::shared_ptr<ms::IdleHub> const& idle_hub,
     std::shared_ptr<input::Scene> const& input_scene,
-    std::shared_ptr<graphics::GraphicBufferAllocator> const& allocator,
     std::shared_ptr<msh::DisplayConfigurationController> const& display_config_controller)
     : idle_hub{idle_hub},
       input_scene{input_scene},
-      allocator{allocator},
       display_config_controller{display_config_controller}
 {
 }
@@ -185,7 +172,7 @@ void msh::BasicIdleHandler::set_display_off_timeout(std::optional<time::Duration
         if (off_timeout >= dim_time_before_off * 2)
         {
             auto const dim_timeout = off_timeout - dim_time_before_off;
-            auto const dimmer = std::make_shared<Dimmer>(input_scene, allocator);
+            auto const dimmer = std::make_shared<Dimmer>(input_scene);
             observers.push_back(dimmer);
             idle_hub->register_interest(dimmer, dim_timeout);
         }
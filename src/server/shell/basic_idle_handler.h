@@ -25,10 +25,6 @@
 
 namespace mir
 {
-namespace graphics
-{
-class GraphicBufferAllocator;
-}
 namespace input
 {
 class Scene;
@@ -48,7 +44,6 @@ public:
     BasicIdleHandler(
         std::shared_ptr<scene::IdleHub> const& idle_hub,
         std::shared_ptr<input::Scene> const& input_scene,
-        std::shared_ptr<graphics::GraphicBufferAllocator> const& allocator,
         std::shared_ptr<shell::DisplayConfigurationController> const& display_config_controller);
 
     ~BasicIdleHandler();
@@ -60,7 +55,6 @@ private:
 
     std::shared_ptr<scene::IdleHub> const idle_hub;
     std::shared_ptr<input::Scene> const input_scene;
-    std::shared_ptr<graphics::GraphicBufferAllocator> const allocator;
     std::shared_ptr<shell::DisplayConfigurationController> const display_config_controller;
 
     std::mutex mutex;
@@ -0,0 +1,44 @@
+/*
+ * Copyright © 2022 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "glyph_cache.h"
+
+namespace geom = mir::geometry;
+namespace msd = mir::shell::decoration;
+
+msd::GlyphCache::GlyphCache(Rasterize rasterize, size_t max_size)
+    : rasterize{std::move(rasterize)},
+      max_size{max_size}
+{
+}
+
+auto msd::GlyphCache::glyph(char32_t character, geom::Height height) -> std::shared_ptr<Glyph const>
+{
+    auto const key = uint64_t{height.as_uint32_t()} << 32 | character;
+    if (auto const cached = glyphs.find(key); cached != glyphs.end())
+    {
+        return cached->second;
+    }
+
+    auto result = rasterize(character, height);
+
+    if (glyphs.size() >= max_size)
+    {
+        glyphs.clear();
+    }
+    glyphs.emplace(key, result);
+    return result;
+}
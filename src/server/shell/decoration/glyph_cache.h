@@ -0,0 +1,68 @@
+/*
+ * Copyright © 2022 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_SHELL_DECORATION_GLYPH_CACHE_H_
+#define MIR_SHELL_DECORATION_GLYPH_CACHE_H_
+
+#include "mir/geometry/displacement.h"
+#include "mir/geometry/size.h"
+
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace mir
+{
+namespace shell
+{
+namespace decoration
+{
+/// A rasterized glyph, shared by every decoration that draws it
+struct Glyph
+{
+    geometry::Displacement offset;          ///< From the pen position to the top left of the bitmap
+    geometry::Displacement advance;
+    geometry::Size size;
+    std::vector<unsigned char> coverage;    ///< One byte per pixel, with no padding between rows
+};
+
+/// The glyphs we have rasterized, keyed by character and pixel height
+/// Glyphs hold only coverage, so are drawn in any color without being rasterized again. Titles use few characters at
+/// one size, so the cache is small; it is simply emptied should it grow too big. Callers must serialize access.
+class GlyphCache
+{
+public:
+    /// Rasterizes a glyph that is not in the cache, throwing std::runtime_error on failure
+    using Rasterize = std::function<std::shared_ptr<Glyph const>(char32_t character, geometry::Height height)>;
+
+    GlyphCache(Rasterize rasterize, size_t max_size);
+
+    auto glyph(char32_t character, geometry::Height height) -> std::shared_ptr<Glyph const>;
+
+private:
+    GlyphCache(GlyphCache const&) = delete;
+    GlyphCache& operator=(GlyphCache const&) = delete;
+
+    Rasterize const rasterize;
+    size_t const max_size;
+    std::unordered_map<uint64_t, std::shared_ptr<Glyph const>> glyphs;
+};
+}
+}
+}
+
+#endif // MIR_SHELL_DECORATION_GLYPH_CACHE_H_
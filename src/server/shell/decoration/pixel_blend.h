@@ -0,0 +1,74 @@
+/*
+ * Copyright © 2022 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_SHELL_DECORATION_PIXEL_BLEND_H_
+#define MIR_SHELL_DECORATION_PIXEL_BLEND_H_
+
+#include <cstdint>
+#include <cstring>
+
+namespace mir
+{
+namespace shell
+{
+namespace decoration
+{
+/// Four pixels at a time, in whatever SIMD registers the target has
+using PixelLanes = uint32_t __attribute__((vector_size(16)));
+
+/// Divides each of the two 16-bit halves of every lane by 255, rounding to nearest
+template<typename T>
+inline auto div255_pairs(T value) -> T
+{
+    value += 0x00800080;
+    return ((value + ((value >> 8) & 0x00ff00ff)) >> 8) & 0x00ff00ff;
+}
+
+/// Draws \a color over \a dest with the (0-255) opacity \a alpha, keeping the alpha of \a dest
+template<typename T>
+inline auto blend(T dest, T color, T alpha) -> T
+{
+    T const inverse = 255 - alpha;
+    T const red_blue = div255_pairs((color & 0x00ff00ff) * alpha + (dest & 0x00ff00ff) * inverse);
+    T const green = div255_pairs(((color >> 8) & 0xff) * alpha + ((dest >> 8) & 0xff) * inverse);
+    return red_blue | (green << 8) | (dest & 0xff000000);
+}
+
+/// Draws \a color over a row of \a length pixels, scaled by the coverage of each pixel
+/// Whole groups of four pixels are blended as PixelLanes, the rest one at a time
+inline void blend_row(uint32_t* dest, unsigned char const* coverage, int length, uint32_t color)
+{
+    uint32_t const color_alpha = color >> 24;
+    int x = 0;
+    for (; x + 4 <= length; x += 4)
+    {
+        PixelLanes const lane_coverage{coverage[x], coverage[x + 1], coverage[x + 2], coverage[x + 3]};
+        PixelLanes pixels;
+        memcpy(&pixels, dest + x, sizeof pixels);
+        PixelLanes const colors = PixelLanes{} + color;
+        pixels = blend<PixelLanes>(pixels, colors, div255_pairs<PixelLanes>(lane_coverage * color_alpha));
+        memcpy(dest + x, &pixels, sizeof pixels);
+    }
+    for (; x < length; x++)
+    {
+        dest[x] = blend<uint32_t>(dest[x], color, div255_pairs<uint32_t>(coverage[x] * color_alpha));
+    }
+}
+}
+}
+}
+
+#endif // MIR_SHELL_DECORATION_PIXEL_BLEND_H_
@@ -18,8 +18,11 @@
 #include "renderer.h"
 #include "window.h"
 #include "input.h"
+#include "glyph_cache.h"
+#include "pixel_blend.h"
 
 #include "mir/graphics/graphic_buffer_allocator.h"
+#include "mir/graphics/solid_color_buffer.h"
 #include "mir/renderer/sw/pixel_source.h"
 #include "mir/geometry/displacement.h"
 #include "mir/log.h"
@@ -31,6 +34,7 @@
 
 #include <locale>
 #include <codecvt>
+#include <cstring>
 
 namespace ms = mir::scene;
 namespace mg = mir::graphics;
@@ -213,16 +217,25 @@ public:
         Pixel color) override;
 
 private:
-    std::mutex mutex;
+    /// Titles use few characters at one size, so the cache need not be big
+    static size_t const max_cached_glyphs{1024};
+
+    std::mutex mutex; ///< Guards the FreeType objects and the glyph cache
     FT_Library library;
     FT_Face face;
+    geom::Height char_size;
+    GlyphCache glyphs{
+        [this](char32_t character, geom::Height height) { return make_glyph(character, height); },
+        max_cached_glyphs};
 
+    /// Requires mutex to be held
+    auto make_glyph(char32_t character, geom::Height height) -> std::shared_ptr<Glyph const>;
     void set_char_size(geom::Height height);
     void rasterize_glyph(char32_t glyph);
-    void render_glyph(
+    static void render_glyph(
         Pixel* buf,
         geom::Size buf_size,
-        FT_Bitmap const* glyph,
+        Glyph const& glyph,
         geom::Point top_left,
         Pixel color);
 
@@ -310,48 +323,63 @@ void msd::Renderer::Text::Impl::render(
     if (!area(buf_size) || height_pixels <= geom::Height{})
         return;
 
-    std::lock_guard lock{mutex};
+    auto const utf32 = utf8_to_utf32(text);
+    std::vector<std::shared_ptr<Glyph const>> text_glyphs;
+    text_glyphs.reserve(utf32.size());
 
-    if (!library || !face)
     {
-        log_warning("FreeType not initialized");
-        return;
+        std::lock_guard lock{mutex};
+
+        if (!library || !face)
+        {
+            log_warning("FreeType not initialized");
+            return;
+        }
+
+        for (char32_t const character : utf32)
+        {
+            try
+            {
+                text_glyphs.push_back(glyphs.glyph(character, height_pixels));
+            }
+            catch (std::runtime_error const& error)
+            {
+                log_warning("%s", error.what());
+            }
+        }
     }
 
-    try
+    // The glyphs are immutable, so other decorations can use the cache while we draw
+    for (auto const& glyph : text_glyphs)
     {
-        set_char_size(height_pixels);
+        render_glyph(buf, buf_size, *glyph, top_left + glyph->offset, color);
+        top_left += glyph->advance;
     }
-    catch (std::runtime_error const& error)
+}
+
+auto msd::Renderer::Text::Impl::make_glyph(char32_t character, geom::Height height) -> std::shared_ptr<Glyph const>
+{
+    if (height != char_size)
     {
-        log_warning("%s", error.what());
-        return;
+        set_char_size(height);
+        char_size = height;
     }
-
-    auto const utf32 = utf8_to_utf32(text);
-
-    for (char32_t const glyph : utf32)
+    rasterize_glyph(character);
+
+    auto const& slot = *face->glyph;
+    auto result = std::make_shared<Glyph>();
+    result->offset = {slot.bitmap_left, height.as_int() - slot.bitmap_top};
+    result->advance = {slot.advance.x / 64, slot.advance.y / 64};
+    result->size = {slot.bitmap.width, slot.bitmap.rows};
+    result->coverage.resize(area(result->size));
+    for (auto row = 0u; row < slot.bitmap.rows; row++)
     {
-        try
-        {
-            rasterize_glyph(glyph);
-
-            geom::Point glyph_top_left =
-                top_left +
-                geom::Displacement{
-                    face->glyph->bitmap_left,
-                    height_pixels.as_int() - face->glyph->bitmap_top};
-            render_glyph(buf, buf_size, &face->glyph->bitmap, glyph_top_left, color);
-
-            top_left += geom::Displacement{
-                face->glyph->advance.x / 64,
-                face->glyph->advance.y / 64};
-        }
-        catch (std::runtime_error const& error)
-        {
-            log_warning("%s", error.what());
-        }
+        memcpy(
+            result->coverage.data() + row * slot.bitmap.width,
+            slot.bitmap.buffer + row * slot.bitmap.pitch,
+            slot.bitmap.width);
     }
+    return result;
 }
 
 void msd::Renderer::Text::Impl::set_char_size(geom::Height height)
@@ -377,40 +405,30 @@ void msd::Renderer::Text::Impl::rasterize_glyph(char32_t glyph)
 void msd::Renderer::Text::Impl::render_glyph(
     Pixel* buf,
     geom::Size buf_size,
-    FT_Bitmap const* glyph,
+    Glyph const& glyph,
     geom::Point top_left,
     Pixel color)
 {
     geom::X const buffer_left = std::max(top_left.x, geom::X{});
-    geom::X const buffer_right = std::min(top_left.x + geom::DeltaX{glyph->width}, as_x(buf_size.width));
+    geom::X const buffer_right = std::min(top_left.x + as_delta(glyph.size.width), as_x(buf_size.width));
 
     geom::Y const buffer_top = std::max(top_left.y, geom::Y{});
-    geom::Y const buffer_bottom = std::min(top_left.y + geom::DeltaY{glyph->rows}, as_y(buf_size.height));
+    geom::Y const buffer_bottom = std::min(top_left.y + as_delta(glyph.size.height), as_y(buf_size.height));
 
-    geom::Displacement const glyph_offset = as_displacement(top_left);
+    if (buffer_left >= buffer_right)
+        return;
 
-    unsigned char* const color_pixels = (unsigned char *)&color;
-    unsigned char const color_alpha = color_pixels[3];
+    geom::Displacement const glyph_offset = as_displacement(top_left);
 
     for (geom::Y buffer_y = buffer_top; buffer_y < buffer_bottom; buffer_y += geom::DeltaY{1})
     {
         geom::Y const glyph_y = buffer_y - glyph_offset.dy;
-        unsigned char* const glyph_row = glyph->buffer + glyph_y.as_int() * glyph->pitch;
-        Pixel* const buffer_row = buf + buffer_y.as_int() * buf_size.width.as_int();
-
-        for (geom::X buffer_x = buffer_left; buffer_x < buffer_right; buffer_x += geom::DeltaX{1})
-        {
-            geom::X const glyph_x = buffer_x - glyph_offset.dx;
-            unsigned char const glyph_alpha = ((int)glyph_row[glyph_x.as_int()] * color_alpha) / 255;
-            unsigned char* const buffer_pixels = (unsigned char *)(buffer_row + buffer_x.as_int());
-            for (int i = 0; i < 3; i++)
-            {
-                // Blend color with the previous buffer color based on the glyph's alpha
-                buffer_pixels[i] =
-                    ((int)buffer_pixels[i] * (255 - glyph_alpha)) / 255 +
-                    ((int)color_pixels[i] * glyph_alpha) / 255;
-            }
-        }
+        geom::X const glyph_x = buffer_left - glyph_offset.dx;
+        blend_row(
+            buf + buffer_y.as_int() * buf_size.width.as_int() + buffer_left.as_int(),
+            glyph.coverage.data() + glyph_y.as_int() * glyph.size.width.as_int() + glyph_x.as_int(),
+            (buffer_right - buffer_left).as_int(),
+            color);
     }
 }
 
@@ -483,17 +501,6 @@ void msd::Renderer::update_state(WindowState const& window_state, InputState con
     right_border_size = window_state.right_border_rect().size;
     bottom_border_size = window_state.bottom_border_rect().size;
 
-    size_t length{0};
-    length = std::max(length, area(left_border_size));
-    length = std::max(length, area(right_border_size));
-    length = std::max(length, area(bottom_border_size));
-
-    if (length != solid_color_pixels_length)
-    {
-        solid_color_pixels_length = length;
-        solid_color_pixels.reset(); // force a reallocation next time it's needed
-    }
-
     if (window_state.titlebar_rect().size != titlebar_size)
     {
         titlebar_size = window_state.titlebar_rect().size;
@@ -508,7 +515,6 @@ void msd::Renderer::update_state(WindowState const& window_state, InputState con
     {
         current_theme = new_theme;
         needs_titlebar_redraw = true;
-        needs_solid_color_redraw = true;
     }
 
     if (window_state.window_name() != name)
@@ -608,55 +614,47 @@ auto msd::Renderer::render_titlebar() -> std::optional<std::shared_ptr<mg::Buffe
     needs_titlebar_redraw = false;
     needs_titlebar_buttons_redraw = false;
 
-    return make_buffer(titlebar_pixels.get(), titlebar_size);
+    return make_buffer(titlebar_pixels.get(), titlebar_size, titlebar_buffers);
 }
 
 auto msd::Renderer::render_left_border() -> std::optional<std::shared_ptr<mg::Buffer>>
 {
     if (!area(left_border_size))
         return std::nullopt;
-    update_solid_color_pixels();
-    return make_buffer(solid_color_pixels.get(), left_border_size);
+    return make_solid_color_buffer(left_border_size);
 }
 
 auto msd::Renderer::render_right_border() -> std::optional<std::shared_ptr<mg::Buffer>>
 {
     if (!area(right_border_size))
         return std::nullopt;
-    update_solid_color_pixels();
-    return make_buffer(solid_color_pixels.get(), right_border_size);
+    return make_solid_color_buffer(right_border_size);
 }
 
 auto msd::Renderer::render_bottom_border() -> std::optional<std::shared_ptr<mg::Buffer>>
 {
     if (!area(bottom_border_size))
         return std::nullopt;
-    update_solid_color_pixels();
-    return make_buffer(solid_color_pixels.get(), bottom_border_size);
+    return make_solid_color_buffer(bottom_border_size);
 }
 
-void msd::Renderer::update_solid_color_pixels()
+auto msd::Renderer::make_solid_color_buffer(geometry::Size size) const -> std::shared_ptr<mg::Buffer>
 {
-    if (!solid_color_pixels)
-    {
-        solid_color_pixels = alloc_pixels(geom::Size{solid_color_pixels_length, 1});
-        needs_solid_color_redraw = true;
-    }
-
-    if (needs_solid_color_redraw)
-    {
-        render_row(
-            solid_color_pixels.get(), geom::Size{solid_color_pixels_length, 1},
-            geom::Point{}, geom::Width{solid_color_pixels_length},
-            current_theme->background_color);
-    }
-
-    needs_solid_color_redraw = false;
+    auto const pixel = current_theme->background_color;
+    auto const alpha = ((pixel >> 24) & 0xFF) / 255.0f;
+    glm::vec4 const color{
+        ((pixel >> 16) & 0xFF) / 255.0f * alpha,
+        ((pixel >>  8) & 0xFF) / 255.0f * alpha,
+        ((pixel >>  0) & 0xFF) / 255.0f * alpha,
+        alpha};
+
+    return std::make_shared<mg::SolidColorBuffer>(size, color);
 }
 
 auto msd::Renderer::make_buffer(
     uint32_t const* pixels,
-    geometry::Size size) -> std::optional<std::shared_ptr<mg::Buffer>>
+    geometry::Size size,
+    RecentBuffers& recent) -> std::optional<std::shared_ptr<mg::Buffer>>
 {
     if (!area(size))
     {
@@ -664,14 +662,42 @@ auto msd::Renderer::make_buffer(
         return std::nullopt;
     }
 
+    geom::Stride const stride{size.width.as_uint32_t() * MIR_BYTES_PER_PIXEL(buffer_format)};
+
+    // A buffer only we hold is no longer being composited (nor waiting to be), so it can be written again
+    for (auto i = 0u; i != recent.size(); i++)
+    {
+        auto const& buffer = recent[i];
+        if (!buffer || buffer.use_count() != 1 || buffer->size() != size)
+            continue;
+
+        if (auto const writable = dynamic_cast<mrs::WriteMappableBuffer*>(buffer->native_buffer_base()))
+        {
+            auto const mapping = writable->map_writeable();
+            auto const dest_stride = mapping->stride().as_uint32_t();
+            for (auto y = 0u; y < size.height.as_uint32_t(); y++)
+            {
+                memcpy(
+                    mapping->data() + dest_stride * y,
+                    reinterpret_cast<unsigned char const*>(pixels) + stride.as_uint32_t() * y,
+                    stride.as_uint32_t());
+            }
+            std::rotate(recent.begin() + i, recent.begin() + i + 1, recent.end());
+            return recent.back();
+        }
+    }
+
     try
     {
-        return mrs::alloc_buffer_with_content(
+        auto buffer = mrs::alloc_buffer_with_content(
             *buffer_allocator,
             reinterpret_cast<unsigned char const*>(pixels),
             size,
-            geom::Stride{size.width.as_uint32_t() * MIR_BYTES_PER_PIXEL(buffer_format)},
+            stride,
             buffer_format);
+        std::rotate(recent.begin(), recent.begin() + 1, recent.end());
+        recent.back() = buffer;
+        return buffer;
     }
     catch (std::runtime_error const&)
     {
@@ -21,6 +21,7 @@
 
 #include "input.h"
 
+#include <array>
 #include <memory>
 #include <map>
 
@@ -110,12 +111,9 @@ private:
     std::map<ButtonFunction, Icon const> button_icons;
     std::shared_ptr<StaticGeometry const> const static_geometry;
 
-    bool needs_solid_color_redraw{true};
     geometry::Size left_border_size;
     geometry::Size right_border_size;
     geometry::Size bottom_border_size;
-    size_t solid_color_pixels_length{0};
-    std::unique_ptr<Pixel[]> solid_color_pixels; // can be nullptr
 
     geometry::Size titlebar_size{};
     std::unique_ptr<Pixel[]> titlebar_pixels; // can be nullptr
@@ -127,10 +125,17 @@ private:
 
     std::shared_ptr<Text> const text;
 
-    void update_solid_color_pixels();
+    /// The buffers most recently made for one part of the decoration, oldest first
+    /// Once the compositor has released one, it is written again rather than allocating another
+    using RecentBuffers = std::array<std::shared_ptr<graphics::Buffer>, 2>;
+    RecentBuffers titlebar_buffers;
+
+    /// Borders are the background color throughout, so need no pixels of their own
+    auto make_solid_color_buffer(geometry::Size size) const -> std::shared_ptr<graphics::Buffer>;
     auto make_buffer(
         Pixel const* pixels,
-        geometry::Size size) -> std::optional<std::shared_ptr<graphics::Buffer>>;
+        geometry::Size size,
+        RecentBuffers& recent) -> std::optional<std::shared_ptr<graphics::Buffer>>;
     static auto alloc_pixels(geometry::Size size) -> std::unique_ptr<Pixel[]>;
 };
 }
@@ -98,7 +98,6 @@ auto mir::DefaultServerConfiguration::the_idle_handler() -> std::shared_ptr<msh:
             auto const idle_handler = std::make_shared<msh::BasicIdleHandler>(
                 the_idle_hub(),
                 the_input_scene(),
-                the_buffer_allocator(),
                 the_display_configuration_controller());
 
             auto options = the_options();
@@ -0,0 +1,201 @@
+/*
+ * Copyright © 2022 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir_test_framework/async_server_runner.h"
+#include <miral/x11_support.h>
+#include <miral/minimal_window_manager.h>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <xcb/xcb.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <thread>
+
+namespace mtf = mir_test_framework;
+
+using namespace std::chrono;
+using namespace std::literals::chrono_literals;
+using namespace testing;
+
+namespace
+{
+char const* const xwayland_path{"/usr/bin/Xwayland"};
+auto const idle_timeout = 1s;
+std::string const started_message{"XWayland is running"};
+std::string const stopped_message{"XWayland stopped, it will be restarted when an X11 client connects"};
+
+/// An X11 client. Connecting starts Xwayland if it isn't running.
+class X11Client
+{
+public:
+    explicit X11Client(std::string const& display)
+        : connection{xcb_connect(display.c_str(), nullptr), &xcb_disconnect}
+    {
+    }
+
+    /// If the client is connected to a working X server
+    auto round_trip() -> bool
+    {
+        if (xcb_connection_has_error(connection.get()))
+        {
+            return false;
+        }
+
+        std::unique_ptr<xcb_get_input_focus_reply_t, decltype(&free)> const reply{
+            xcb_get_input_focus_reply(connection.get(), xcb_get_input_focus(connection.get()), nullptr),
+            &free};
+        return reply != nullptr;
+    }
+
+    void map_window()
+    {
+        auto const screen = xcb_setup_roots_iterator(xcb_get_setup(connection.get())).data;
+        auto const window = xcb_generate_id(connection.get());
+        xcb_create_window(
+            connection.get(), XCB_COPY_FROM_PARENT, window, screen->root,
+            0, 0, 100, 100, 0,
+            XCB_WINDOW_CLASS_INPUT_OUTPUT, screen->root_visual,
+            0, nullptr);
+        xcb_map_window(connection.get(), window);
+        xcb_flush(connection.get());
+    }
+
+private:
+    std::unique_ptr<xcb_connection_t, decltype(&xcb_disconnect)> const connection;
+};
+
+/// Runs a server that stops Xwayland after a second without X11 clients
+struct XWaylandIdleRestart : Test, mtf::AsyncServerRunner
+{
+    bool server_started{false};
+    std::string display;
+
+    XWaylandIdleRestart()
+    {
+        miral::X11Support{}(server);
+        add_to_environment("MIR_SERVER_ENABLE_X11", "1");
+        add_to_environment("MIR_SERVER_XWAYLAND_IDLE_TIMEOUT", std::to_string(idle_timeout.count()).c_str());
+        add_to_environment("WAYLAND_DISPLAY", "XWaylandIdleRestart");
+    }
+
+    void SetUp() override
+    {
+        if (access(xwayland_path, X_OK) != 0)
+        {
+            GTEST_SKIP() << xwayland_path << " is needed to run X11 clients";
+        }
+
+        miral::set_window_management_policy<miral::MinimalWindowManager>()(server);
+        start_server();
+        server_started = true;
+        display = server.x11_display().value();
+    }
+
+    void TearDown() override
+    {
+        if (server_started)
+        {
+            stop_server();
+        }
+    }
+
+    /// The number of lines in the server log that contain the message
+    auto logged(std::string const& message) const -> int
+    {
+        std::ifstream log{output_filename};
+        int count{0};
+        for (std::string line; std::getline(log, line);)
+        {
+            if (line.find(message) != std::string::npos)
+            {
+                ++count;
+            }
+        }
+        return count;
+    }
+
+    auto wait_until_logged(std::string const& message, int count) const -> bool
+    {
+        auto const give_up = steady_clock::now() + 10s;
+        while (logged(message) < count)
+        {
+            if (steady_clock::now() > give_up)
+            {
+                return false;
+            }
+            std::this_thread::sleep_for(10ms);
+        }
+        return true;
+    }
+};
+}
+
+TEST_F(XWaylandIdleRestart, xwayland_is_stopped_when_idle_and_restarted_for_the_next_client)
+{
+    {
+        X11Client first{display};
+        ASSERT_TRUE(first.round_trip());
+    }
+
+    ASSERT_TRUE(wait_until_logged(stopped_message, 1));
+
+    X11Client second{display};
+    EXPECT_TRUE(second.round_trip());
+    EXPECT_THAT(logged(started_message), Eq(2));
+}
+
+TEST_F(XWaylandIdleRestart, xwayland_keeps_running_while_a_client_has_a_window)
+{
+    X11Client client{display};
+    client.map_window();
+    ASSERT_TRUE(client.round_trip());
+
+    std::this_thread::sleep_for(3 * idle_timeout);
+
+    EXPECT_TRUE(client.round_trip());
+    EXPECT_THAT(logged(stopped_message), Eq(0));
+}
+
+TEST_F(XWaylandIdleRestart, xwayland_keeps_running_while_a_client_without_windows_is_connected)
+{
+    X11Client client{display};
+    ASSERT_TRUE(client.round_trip());
+
+    std::this_thread::sleep_for(3 * idle_timeout);
+
+    EXPECT_TRUE(client.round_trip());
+    EXPECT_THAT(logged(stopped_message), Eq(0));
+}
+
+TEST_F(XWaylandIdleRestart, xwayland_can_be_stopped_and_restarted_repeatedly)
+{
+    for (auto i = 1; i != 4; ++i)
+    {
+        {
+            X11Client client{display};
+            ASSERT_TRUE(client.round_trip()) << "restart " << i;
+        }
+        ASSERT_TRUE(wait_until_logged(stopped_message, i));
+    }
+
+    EXPECT_THAT(logged(started_message), Eq(3));
+}
@@ -79,6 +79,7 @@ struct MockBufferStream : public compositor::BufferStream
     MOCK_METHOD1(disassociate_buffer, void(graphics::BufferID));
     MOCK_METHOD1(associate_buffer, void(graphics::BufferID));
     MOCK_METHOD1(set_scale, void(float));
+    MOCK_METHOD1(on_next_repaint, void(std::function<void()> const&));
 
 };
 }
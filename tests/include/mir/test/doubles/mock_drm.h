@@ -124,6 +124,7 @@ public:
 
     MOCK_METHOD5(drmModePageFlip, int(int fd, uint32_t crtc_id, uint32_t fb_id,
                                                   uint32_t flags, void *user_data));
+    MOCK_METHOD4(drmModeAtomicCommit, int(int fd, drmModeAtomicReqPtr req, uint32_t flags, void* user_data));
     MOCK_METHOD2(drmHandleEvent, int(int fd, drmEventContextPtr evctx));
 
     MOCK_METHOD3(drmGetCap, int(int fd, uint64_t capability, uint64_t *value));
@@ -131,6 +132,8 @@ public:
     MOCK_METHOD2(drmModeGetProperty, drmModePropertyPtr(int fd, uint32_t propertyId));
     MOCK_METHOD1(drmModeFreeProperty, void(drmModePropertyPtr));
     MOCK_METHOD4(drmModeConnectorSetProperty, int(int fd, uint32_t connector_id, uint32_t property_id, uint64_t value));
+    MOCK_METHOD4(drmModeCreatePropertyBlob, int(int fd, void const* data, size_t size, uint32_t* id));
+    MOCK_METHOD2(drmModeDestroyPropertyBlob, int(int fd, uint32_t id));
 
     MOCK_METHOD2(drmGetMagic, int(int fd, drm_magic_t *magic));
     MOCK_METHOD2(drmAuthMagic, int(int fd, drm_magic_t magic));
@@ -199,6 +202,17 @@ private:
 };
 
 testing::Matcher<int> IsFdOfDevice(char const* device);
+
+/// A property set by drmModeAtomicAddProperty()
+struct AtomicProperty
+{
+    uint32_t object_id;
+    uint32_t property_id;
+    uint64_t value;
+};
+
+/// The properties added to an atomic request, in the order they were added
+auto atomic_request_properties(drmModeAtomicReqPtr request) -> std::vector<AtomicProperty>;
 }
 }
 }
@@ -71,6 +71,7 @@ public:
     void set_frame_posted_callback(std::function<void(geometry::Size const&)> const&) override {}
     bool has_submitted_buffer() const override { return true; }
     void set_scale(float) override {}
+    void on_next_repaint(std::function<void()> const&) override {}
 
     std::shared_ptr<graphics::Buffer> stub_compositor_buffer;
     int nready = 0;
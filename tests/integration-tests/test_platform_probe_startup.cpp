@@ -0,0 +1,193 @@
+/*
+ * Copyright © 2022 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/graphics/platform_probe.h"
+#include "mir/options/program_option.h"
+#include "mir/shared_library.h"
+#include "mir/udev/wrapper.h"
+#include "mir/test/doubles/null_console_services.h"
+#include "mir_test_framework/executable_path.h"
+
+#include <boost/throw_exception.hpp>
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <sys/sysmacros.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace mg = mir::graphics;
+namespace mtd = mir::test::doubles;
+namespace mtf = mir_test_framework;
+
+using namespace std::chrono;
+using namespace testing;
+
+namespace
+{
+/// Like logind, hands out a device only while nobody else holds it. Counts the devices acquired (the slow probe
+/// module acquires one per probe) and the attempts to acquire one that is already held.
+class ExclusiveConsoleServices : public mtd::NullConsoleServices
+{
+public:
+    auto acquire_device(int major, int minor, std::unique_ptr<mir::Device::Observer> observer)
+        -> std::future<std::unique_ptr<mir::Device>> override
+    {
+        auto const devnum = makedev(major, minor);
+        {
+            std::lock_guard lock{mutex};
+            if (!held.insert(devnum).second)
+            {
+                ++duplicate_acquisitions_;
+                BOOST_THROW_EXCEPTION((std::runtime_error{"Attempted to acquire a device multiple times"}));
+            }
+            ++acquisitions_;
+        }
+
+        observer->activated(mir::Fd{});
+        std::promise<std::unique_ptr<mir::Device>> promise;
+        promise.set_value(std::make_unique<HeldDevice>(*this, devnum));
+        return promise.get_future();
+    }
+
+    auto acquisitions() -> int
+    {
+        std::lock_guard lock{mutex};
+        return acquisitions_;
+    }
+
+    auto duplicate_acquisitions() -> int
+    {
+        std::lock_guard lock{mutex};
+        return duplicate_acquisitions_;
+    }
+
+private:
+    class HeldDevice : public mir::Device
+    {
+    public:
+        HeldDevice(ExclusiveConsoleServices& console, dev_t devnum)
+            : console{console},
+              devnum{devnum}
+        {
+        }
+
+        ~HeldDevice()
+        {
+            std::lock_guard lock{console.mutex};
+            console.held.erase(devnum);
+        }
+
+    private:
+        ExclusiveConsoleServices& console;
+        dev_t const devnum;
+    };
+
+    std::mutex mutex;
+    std::set<dev_t> held;
+    int acquisitions_{0};
+    int duplicate_acquisitions_{0};
+};
+
+/// Picks the display platform from several slow-to-probe modules and the stub platform, as a server starts
+struct PlatformProbeStartup : Test
+{
+    int const slow_module_count{4};
+
+    mir::options::ProgramOption const options;
+    std::shared_ptr<ExclusiveConsoleServices> const console{std::make_shared<ExclusiveConsoleServices>()};
+    std::vector<std::shared_ptr<mir::SharedLibrary>> modules;
+    std::string const cache_file{
+        (std::filesystem::temp_directory_path() / ("mir-probe-startup-" + std::to_string(getpid()))).string()};
+
+    void SetUp() override
+    {
+        for (auto i = 0; i != slow_module_count; ++i)
+        {
+            modules.push_back(std::make_shared<mir::SharedLibrary>(
+                mtf::library_path() + "/probe-test-modules/graphics-slow-probe.so"));
+        }
+        modules.push_back(std::make_shared<mir::SharedLibrary>(mtf::server_platform("graphics-dummy.so")));
+    }
+
+    void TearDown() override
+    {
+        std::filesystem::remove(cache_file);
+    }
+
+    /// Runs the probe, recording how long it took and returning how many slow modules it probed
+    template<typename Probe>
+    auto measure(std::string const& name, Probe const& probe) -> int
+    {
+        auto const acquisitions_before = console->acquisitions();
+        auto const start = steady_clock::now();
+        probe();
+        auto const elapsed = duration_cast<milliseconds>(steady_clock::now() - start);
+
+        // Timings are recorded for comparison, not asserted on, as they depend on the machine's load
+        RecordProperty(name + "_ms", std::to_string(elapsed.count()));
+        std::cout << name << ": " << elapsed.count() << "ms" << std::endl;
+        return console->acquisitions() - acquisitions_before;
+    }
+};
+}
+
+TEST_F(PlatformProbeStartup, modules_probing_the_same_device_take_turns_with_the_console)
+{
+    EXPECT_THAT(mg::display_modules_for_device(modules, options, console), SizeIs(1));
+
+    EXPECT_THAT(console->acquisitions(), Eq(slow_module_count));
+    EXPECT_THAT(console->duplicate_acquisitions(), Eq(0));
+}
+
+TEST_F(PlatformProbeStartup, cached_probing_skips_the_modules_that_were_not_chosen)
+{
+    auto const in_turn = measure("in_turn", [&]
+        {
+            for (auto const& module : modules)
+            {
+                mg::probe_display_module(*module, options, console);
+            }
+        });
+
+    auto const concurrent = measure("concurrent", [&]
+        {
+            EXPECT_THAT(mg::display_modules_for_device(modules, options, console), SizeIs(1));
+        });
+
+    mg::PlatformProbeCache const cache{
+        cache_file,
+        mg::system_identity(mtf::server_platform_path(), std::make_shared<mir::udev::Context>())};
+    mg::display_modules_for_device(modules, options, console, &cache);
+
+    auto const warm = measure("warm_start", [&]
+        {
+            EXPECT_THAT(mg::display_modules_for_device(modules, options, console, &cache), SizeIs(1));
+        });
+
+    EXPECT_THAT(in_turn, Eq(slow_module_count));
+    EXPECT_THAT(concurrent, Eq(slow_module_count));
+    EXPECT_THAT(warm, Eq(0));
+    EXPECT_THAT(console->duplicate_acquisitions(), Eq(0));
+}
@@ -0,0 +1,176 @@
+/*
+ * Copyright © 2022 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/report/null_report_factory.h"
+#include "src/server/scene/surface_stack.h"
+#include "mir/test/doubles/stub_surface.h"
+#include "mir/test/doubles/stub_renderable.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ms = mir::scene;
+namespace mc = mir::compositor;
+namespace mg = mir::graphics;
+namespace mi = mir::input;
+namespace mr = mir::report;
+namespace mtd = mir::test::doubles;
+namespace geom = mir::geometry;
+
+using namespace std::chrono;
+using namespace std::literals::chrono_literals;
+
+namespace
+{
+/// A visible window with a single renderable, covering a 100x100 square
+struct WindowSurface : mtd::StubSurface
+{
+    explicit WindowSurface(geom::Point top_left)
+        : area{top_left, {100, 100}},
+          renderable{std::make_shared<mtd::StubRenderable>(area)}
+    {
+    }
+
+    bool visible() const override { return true; }
+    bool input_area_contains(geom::Point const& point) const override { return area.contains(point); }
+    mg::RenderableList generate_renderables(mc::CompositorID) const override { return {renderable}; }
+
+    geom::Rectangle const area;
+    std::shared_ptr<mg::Renderable> const renderable;
+};
+
+struct SurfaceStackStats
+{
+    long frame_ns;
+    long hit_test_ns;
+    long worst_frame_us;
+};
+
+/// Compositor threads build frames and an input thread hit-tests the pointer, as a window manager restacks windows
+struct SurfaceStackContention : testing::Test
+{
+    int const window_count{200};
+    int const compositor_count{2};
+    milliseconds const run_time{500ms};
+
+    std::vector<std::shared_ptr<ms::Surface>> surfaces;
+
+    void SetUp() override
+    {
+        for (auto i = 0; i != window_count; ++i)
+        {
+            surfaces.push_back(std::make_shared<WindowSurface>(geom::Point{(i % 20) * 50, (i / 20) * 50}));
+        }
+    }
+
+    /// If \a restacking, a window manager thread raises a window every 50us while the readers run
+    auto run(ms::SurfaceStack& stack, bool restacking) -> SurfaceStackStats
+    {
+        std::atomic<bool> running{true};
+        std::atomic<long> frames{0};
+        std::atomic<long> frame_time{0};
+        std::atomic<long> worst_frame{0};
+        std::atomic<long> hit_tests{0};
+        std::atomic<long> hit_test_time{0};
+        std::vector<int> const compositor_ids(compositor_count);
+        std::vector<std::thread> threads;
+
+        for (auto c = 0; c != compositor_count; ++c)
+        {
+            threads.emplace_back([&, id = &compositor_ids[c]]
+                {
+                    while (running)
+                    {
+                        auto const start = steady_clock::now();
+                        EXPECT_EQ(stack.scene_elements_for(id).size(), static_cast<size_t>(window_count));
+                        auto const elapsed = duration_cast<nanoseconds>(steady_clock::now() - start).count();
+
+                        frames++;
+                        frame_time += elapsed;
+                        auto worst = worst_frame.load();
+                        while (elapsed > worst && !worst_frame.compare_exchange_weak(worst, elapsed))
+                        {
+                        }
+                    }
+                });
+        }
+
+        threads.emplace_back([&]
+            {
+                for (auto i = 0; running; ++i)
+                {
+                    auto const start = steady_clock::now();
+                    EXPECT_TRUE(stack.surface_at(geom::Point{(i * 7) % 1000, (i * 3) % 500}));
+                    hit_test_time += duration_cast<nanoseconds>(steady_clock::now() - start).count();
+                    hit_tests++;
+                }
+            });
+
+        if (restacking)
+        {
+            threads.emplace_back([&]
+                {
+                    for (auto i = 0; running; ++i)
+                    {
+                        stack.raise(surfaces[(i * 13) % window_count]);
+                        std::this_thread::sleep_for(50us);
+                    }
+                });
+        }
+
+        std::this_thread::sleep_for(run_time);
+        running = false;
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+
+        return {
+            frame_time / std::max(frames.load(), 1l),
+            hit_test_time / std::max(hit_tests.load(), 1l),
+            worst_frame / 1000};
+    }
+
+    void record(std::string const& name, SurfaceStackStats const& stats)
+    {
+        RecordProperty(name + "_frame_ns", std::to_string(stats.frame_ns));
+        RecordProperty(name + "_hit_test_ns", std::to_string(stats.hit_test_ns));
+        RecordProperty(name + "_worst_frame_us", std::to_string(stats.worst_frame_us));
+        std::cout << name << ": " << stats.frame_ns << "ns per frame (worst " << stats.worst_frame_us << "us), "
+                  << stats.hit_test_ns << "ns per hit test" << std::endl;
+    }
+};
+}
+
+TEST_F(SurfaceStackContention, readers_are_not_held_up_by_restacking)
+{
+    ms::SurfaceStack stack{mr::null_scene_report()};
+    for (auto const& surface : surfaces)
+    {
+        stack.add_surface(surface, mi::InputReceptionMode::normal);
+    }
+
+    // Compositors and input read a snapshot of the stack, so these should be close
+    record("idle", run(stack, false));
+    record("restacking", run(stack, true));
+}
@@ -0,0 +1,366 @@
+/*
+ * Copyright © 2022 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/frontend_xwayland/xwayland_surface.h"
+#include "src/server/frontend_xwayland/xwayland_wm_shell.h"
+#include "src/server/frontend_xwayland/xcb_connection.h"
+#include "src/server/frontend_wayland/wl_seat.h"
+
+#include "mir/input/keyboard_observer.h"
+#include "mir/test/doubles/explicit_executor.h"
+#include "mir/test/doubles/mock_input_device_hub.h"
+#include "mir/test/doubles/stub_observer_registrar.h"
+
+#include <boost/throw_exception.hpp>
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <wayland-server-core.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+namespace mf = mir::frontend;
+namespace mi = mir::input;
+namespace mtd = mir::test::doubles;
+namespace geom = mir::geometry;
+
+using namespace testing;
+
+namespace
+{
+/// The response_type of a reply (rather than an event or error)
+uint8_t const x11_reply{1};
+
+/// Just enough of an X server to run an XWaylandSurface against: it accepts the connection, answers InternAtom with a
+/// new atom, GetProperty as if the property were not set and GetInputFocus with nothing. It records each request along
+/// with the round trip it was sent in, so tests can check how often the client waited for replies.
+class StubXServer
+{
+public:
+    StubXServer()
+    {
+        int fds[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) < 0)
+        {
+            BOOST_THROW_EXCEPTION(std::system_error(errno, std::system_category(), "Creating socket pair failed"));
+        }
+        client_fd = mir::Fd{fds[0]};
+        server_fd = mir::Fd{fds[1]};
+        server = std::thread{[this] { serve(); }};
+    }
+
+    ~StubXServer()
+    {
+        shutdown(server_fd, SHUT_RDWR);
+        server.join();
+    }
+
+    /// The number of times the server has answered a batch of requests (so the number of times the client could have
+    /// been waiting for it)
+    auto round_trips() const -> int
+    {
+        std::lock_guard lock{mutex};
+        return reply_batches;
+    }
+
+    /// The round trip each request with the given opcode was sent in, in the order they were sent
+    auto round_trips_of(uint8_t opcode) const -> std::vector<int>
+    {
+        std::lock_guard lock{mutex};
+        std::vector<int> result;
+        for (auto const& request : requests)
+        {
+            if (request.opcode == opcode)
+            {
+                result.push_back(request.round_trip);
+            }
+        }
+        return result;
+    }
+
+    mir::Fd client_fd;
+
+private:
+    struct Request
+    {
+        uint8_t opcode;
+        int round_trip;
+    };
+
+    mir::Fd server_fd;
+    std::thread server;
+    uint16_t sequence{0};
+
+    std::mutex mutable mutex;
+    std::vector<Request> requests;
+    int reply_batches{0};
+
+    void serve()
+    {
+        // Connection setup: a 12 byte header with no authorisation data
+        std::vector<uint8_t> setup_request(12);
+        if (!read_exactly(setup_request.data(), setup_request.size()))
+        {
+            return;
+        }
+        send_setup();
+
+        std::vector<uint8_t> buffer;
+        for (;;)
+        {
+            uint8_t chunk[4096];
+            auto const count = read(server_fd, chunk, sizeof chunk);
+            if (count <= 0)
+            {
+                return;
+            }
+            buffer.insert(buffer.end(), chunk, chunk + count);
+
+            // Requests are a multiple of 4 bytes, with their length (in 4 byte units) in bytes 2-3
+            std::vector<uint8_t> replies;
+            size_t offset = 0;
+            while (buffer.size() - offset >= 4)
+            {
+                uint16_t length;
+                std::memcpy(&length, &buffer[offset + 2], sizeof length);
+                if (buffer.size() - offset < length * 4u)
+                {
+                    break;
+                }
+                reply_to(buffer[offset], replies);
+                offset += length * 4u;
+            }
+            buffer.erase(buffer.begin(), buffer.begin() + offset);
+
+            if (!replies.empty())
+            {
+                {
+                    std::lock_guard lock{mutex};
+                    ++reply_batches;
+                }
+                if (write(server_fd, replies.data(), replies.size()) < 0)
+                {
+                    return;
+                }
+            }
+        }
+    }
+
+    void reply_to(uint8_t opcode, std::vector<uint8_t>& replies)
+    {
+        ++sequence;
+
+        {
+            std::lock_guard lock{mutex};
+            requests.push_back({opcode, reply_batches});
+        }
+
+        switch (opcode)
+        {
+        case XCB_INTERN_ATOM:
+        {
+            xcb_intern_atom_reply_t reply{};
+            reply.response_type = x11_reply;
+            reply.sequence = sequence;
+            reply.atom = 1000 + sequence;
+            append(replies, reply, 32);
+            break;
+        }
+
+        case XCB_GET_PROPERTY:
+        {
+            xcb_get_property_reply_t reply{};
+            reply.response_type = x11_reply;
+            reply.sequence = sequence;
+            reply.type = XCB_ATOM_NONE;
+            append(replies, reply, 32);
+            break;
+        }
+
+        case XCB_GET_INPUT_FOCUS:
+        {
+            xcb_get_input_focus_reply_t reply{};
+            reply.response_type = x11_reply;
+            reply.sequence = sequence;
+            append(replies, reply, 32);
+            break;
+        }
+
+        default:
+            // Requests without replies
+            break;
+        }
+    }
+
+    void send_setup()
+    {
+        xcb_setup_t setup{};
+        setup.status = 1;
+        setup.protocol_major_version = 11;
+        setup.length = (sizeof(xcb_setup_t) + sizeof(xcb_screen_t) - 8) / 4;
+        setup.resource_id_base = 0x200000;
+        setup.resource_id_mask = 0x1fffff;
+        setup.maximum_request_length = 0xffff;
+        setup.roots_len = 1;
+        setup.bitmap_format_scanline_unit = 32;
+        setup.bitmap_format_scanline_pad = 32;
+        setup.min_keycode = 8;
+        setup.max_keycode = 255;
+
+        xcb_screen_t screen{};
+        screen.root = 0x100;
+        screen.width_in_pixels = 1024;
+        screen.height_in_pixels = 768;
+        screen.root_depth = 24;
+
+        std::vector<uint8_t> message;
+        append(message, setup, sizeof setup);
+        append(message, screen, sizeof screen);
+        if (write(server_fd, message.data(), message.size()) < 0)
+        {
+            BOOST_THROW_EXCEPTION(std::system_error(errno, std::system_category(), "Writing X11 setup failed"));
+        }
+    }
+
+    auto read_exactly(uint8_t* data, size_t size) -> bool
+    {
+        while (size)
+        {
+            auto const count = read(server_fd, data, size);
+            if (count <= 0)
+            {
+                return false;
+            }
+            data += count;
+            size -= count;
+        }
+        return true;
+    }
+
+    template<typename T>
+    static void append(std::vector<uint8_t>& to, T const& value, size_t size)
+    {
+        auto const bytes = reinterpret_cast<uint8_t const*>(&value);
+        to.insert(to.end(), bytes, bytes + size);
+    }
+};
+
+/// An unmapped XWaylandSurface, with no window manager or scene surface, talking to a StubXServer
+struct XWaylandPropertyReads : Test
+{
+    XWaylandPropertyReads()
+    {
+        // Resolve the atoms the surface uses, so only the surface's own requests are counted
+        sync();
+    }
+
+    ~XWaylandPropertyReads()
+    {
+        surface.reset();
+        seat.reset();
+        wl_display_destroy(display);
+    }
+
+    /// Waits until the server has seen every request sent so far
+    void sync()
+    {
+        free(xcb_get_input_focus_reply(*connection, xcb_get_input_focus(*connection), nullptr));
+    }
+
+    StubXServer server;
+    std::shared_ptr<mf::XCBConnection> const connection{std::make_shared<mf::XCBConnection>(server.client_fd)};
+    xcb_window_t const window{0x200001};
+
+    wl_display* const display{wl_display_create()};
+    std::shared_ptr<mtd::ExplicitExecutor> const executor{std::make_shared<mtd::ExplicitExecutor>()};
+    std::unique_ptr<mf::WlSeat> seat{std::make_unique<mf::WlSeat>(
+        display,
+        *executor,
+        nullptr,
+        std::make_shared<NiceMock<mtd::MockInputDeviceHub>>(),
+        std::make_shared<mtd::StubObserverRegistrar<mi::KeyboardObserver>>(),
+        nullptr,
+        nullptr,
+        false)};
+    mf::XWaylandWMShell const wm_shell{executor, nullptr, nullptr, *seat, nullptr};
+    std::unique_ptr<mf::XWaylandSurface> surface{std::make_unique<mf::XWaylandSurface>(
+        nullptr,
+        connection,
+        wm_shell,
+        nullptr,
+        window,
+        geom::Rectangle{{0, 0}, {100, 100}},
+        false,
+        1.0f)};
+};
+}
+
+TEST_F(XWaylandPropertyReads, mapping_a_window_reads_all_its_properties_in_one_round_trip)
+{
+    auto const before = server.round_trips();
+
+    surface->map();
+
+    EXPECT_THAT(server.round_trips() - before, Eq(1));
+    auto const reads = server.round_trips_of(XCB_GET_PROPERTY);
+    ASSERT_THAT(reads, Not(IsEmpty()));
+    EXPECT_THAT(reads, Each(Eq(reads.front())));
+}
+
+TEST_F(XWaylandPropertyReads, a_burst_of_property_changes_is_read_in_one_round_trip)
+{
+    auto const before = server.round_trips();
+
+    surface->property_notify(XCB_ATOM_WM_NAME);
+    surface->property_notify(XCB_ATOM_WM_CLASS);
+    surface->property_notify(connection->WM_NORMAL_HINTS);
+    surface->property_notify(connection->WM_PROTOCOLS);
+    surface->property_notify(connection->_NET_WM_WINDOW_TYPE);
+    EXPECT_THAT(server.round_trips() - before, Eq(0));
+
+    surface->complete_property_reads();
+
+    EXPECT_THAT(server.round_trips() - before, Eq(1));
+    auto const reads = server.round_trips_of(XCB_GET_PROPERTY);
+    ASSERT_THAT(reads, SizeIs(5));
+    EXPECT_THAT(reads, Each(Eq(reads.front())));
+}
+
+TEST_F(XWaylandPropertyReads, a_property_change_is_applied_before_a_configure_request_in_the_same_batch)
+{
+    surface->property_notify(connection->WM_NORMAL_HINTS);
+
+    xcb_configure_request_event_t request{};
+    request.window = window;
+    request.value_mask = XCB_CONFIG_WINDOW_WIDTH | XCB_CONFIG_WINDOW_HEIGHT;
+    request.width = 200;
+    request.height = 150;
+    surface->configure_request(&request);
+    sync();
+
+    // The reply to the property read has been waited for before the window is configured
+    auto const reads = server.round_trips_of(XCB_GET_PROPERTY);
+    auto const configures = server.round_trips_of(XCB_CONFIGURE_WINDOW);
+    ASSERT_THAT(reads, SizeIs(1));
+    ASSERT_THAT(configures, SizeIs(1));
+    EXPECT_THAT(configures.front(), Gt(reads.front()));
+}
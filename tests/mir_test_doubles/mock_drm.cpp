@@ -594,6 +594,16 @@ int drmModeConnectorSetProperty(int fd, uint32_t connector_id, uint32_t property
     return global_mock->drmModeConnectorSetProperty(fd, connector_id, property_id, value);
 }
 
+int drmModeCreatePropertyBlob(int fd, void const* data, size_t size, uint32_t* id)
+{
+    return global_mock->drmModeCreatePropertyBlob(fd, data, size, id);
+}
+
+int drmModeDestroyPropertyBlob(int fd, uint32_t id)
+{
+    return global_mock->drmModeDestroyPropertyBlob(fd, id);
+}
+
 void drmModeFreeConnector(drmModeConnectorPtr ptr)
 {
     global_mock->drmModeFreeConnector(ptr);
@@ -679,6 +689,38 @@ int drmModePageFlip(int fd, uint32_t crtc_id, uint32_t fb_id,
                                         flags, user_data);
 }
 
+/* Atomic requests are built in-process; only the commit goes to the mock */
+struct _drmModeAtomicReq
+{
+    std::vector<mtd::AtomicProperty> properties;
+};
+
+auto mtd::atomic_request_properties(drmModeAtomicReqPtr request) -> std::vector<AtomicProperty>
+{
+    return request->properties;
+}
+
+drmModeAtomicReqPtr drmModeAtomicAlloc()
+{
+    return new _drmModeAtomicReq;
+}
+
+void drmModeAtomicFree(drmModeAtomicReqPtr req)
+{
+    delete req;
+}
+
+int drmModeAtomicAddProperty(drmModeAtomicReqPtr req, uint32_t object_id, uint32_t property_id, uint64_t value)
+{
+    req->properties.push_back(mtd::AtomicProperty{object_id, property_id, value});
+    return req->properties.size();
+}
+
+int drmModeAtomicCommit(int fd, drmModeAtomicReqPtr req, uint32_t flags, void* user_data)
+{
+    return global_mock->drmModeAtomicCommit(fd, req, flags, user_data);
+}
+
 int drmHandleEvent(int fd, drmEventContextPtr evctx)
 {
     return global_mock->drmHandleEvent(fd, evctx);
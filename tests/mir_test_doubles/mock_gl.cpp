@@ -175,6 +175,12 @@ void glUniform2f(GLint location, GLfloat x, GLfloat y)
     global_mock_gl->glUniform2f(location, x, y);
 }
 
+void glUniform4f(GLint location, GLfloat x, GLfloat y, GLfloat z, GLfloat w)
+{
+    CHECK_GLOBAL_VOID_MOCK();
+    global_mock_gl->glUniform4f(location, x, y, z, w);
+}
+
 void glBindBuffer(GLenum buffer, GLuint name)
 {
     CHECK_GLOBAL_VOID_MOCK();
@@ -450,6 +456,12 @@ void glFinish()
     global_mock_gl->glFinish();
 }
 
+void glFlush()
+{
+    CHECK_GLOBAL_VOID_MOCK();
+    global_mock_gl->glFlush();
+}
+
 void glGenerateMipmap(GLenum target)
 {
     CHECK_GLOBAL_VOID_MOCK();
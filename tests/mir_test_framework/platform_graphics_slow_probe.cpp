@@ -0,0 +1,91 @@
+/*
+ * Copyright © 2022 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/libname.h"
+#include "mir/graphics/platform.h"
+#include "mir/assert_module_entry_point.h"
+#include "mir/console_services.h"
+#include "mir/fd.h"
+
+#include <chrono>
+#include <thread>
+
+namespace mg = mir::graphics;
+
+// A module that takes as long to probe as one that opens devices and initialises EGL, but never claims to support
+// anything. Like the KMS platforms it holds the first DRM node from the console while it probes. It is built outside
+// the server module directory, so that only the probing tests load it.
+
+namespace
+{
+int const drm_major{226};
+
+class IgnoreDeviceEvents : public mir::Device::Observer
+{
+public:
+    void activated(mir::Fd&&) override {}
+    void suspended() override {}
+    void removed() override {}
+};
+
+auto slow_probe(mir::ConsoleServices& console) -> std::vector<mg::SupportedDevice>
+{
+    auto const device = console.acquire_device(drm_major, 0, std::make_unique<IgnoreDeviceEvents>()).get();
+
+    std::this_thread::sleep_for(std::chrono::milliseconds{25});
+
+    std::vector<mg::SupportedDevice> result;
+    result.emplace_back(
+        mg::SupportedDevice {
+            nullptr,
+            mg::PlatformPriority::unsupported,
+            nullptr
+         });
+    return result;
+}
+
+mir::ModuleProperties const module_properties = {
+    "mir:slow-probe-stub",
+    MIR_VERSION_MAJOR,
+    MIR_VERSION_MINOR,
+    MIR_VERSION_MICRO,
+    mir::libname()
+};
+}
+
+auto probe_display_platform(
+    std::shared_ptr<mir::ConsoleServices> const& console,
+    std::shared_ptr<mir::udev::Context> const&,
+    mir::options::ProgramOption const&) -> std::vector<mg::SupportedDevice>
+{
+    mir::assert_entry_point_signature<mg::PlatformProbe>(&probe_display_platform);
+    return slow_probe(*console);
+}
+
+auto probe_rendering_platform(
+    std::shared_ptr<mir::ConsoleServices> const& console,
+    std::shared_ptr<mir::udev::Context> const&,
+    mir::options::ProgramOption const&) -> std::vector<mg::SupportedDevice>
+{
+    mir::assert_entry_point_signature<mg::PlatformProbe>(&probe_rendering_platform);
+    return slow_probe(*console);
+}
+
+mir::ModuleProperties const* describe_graphics_module()
+{
+    mir::assert_entry_point_signature<mg::DescribeModule>(&describe_graphics_module);
+    return &module_properties;
+}
@@ -360,3 +360,40 @@ TEST_F(ApplicationZone, readding_single_output_after_two_removed_removes_second_
     notify_configuration_applied(create_fake_display_configuration({display_area_a}));
     EXPECT_THAT(zone_b.extents(), Eq(display_area_b));
 }
+
+TEST_F(ApplicationZone, exclusive_zone_change_only_updates_the_application_zone_of_its_output)
+{
+    miral::Zone zone_b{{{}, {}}};
+    EXPECT_CALL(*window_manager_policy, advise_application_zone_create(_))
+        .WillOnce(Return())
+        .WillOnce(Invoke([&](Zone const& zone){ zone_b = zone; }));
+    notify_configuration_applied(create_fake_display_configuration({display_area_a, display_area_b}));
+
+    Window panel;
+    EXPECT_CALL(*window_manager_policy, advise_new_window(_))
+        .WillOnce(Invoke([&](WindowInfo const& window_info){ panel = window_info.window(); }));
+    EXPECT_CALL(*window_manager_policy, advise_application_zone_update(_, _)).Times(AnyNumber());
+    {
+        mir::shell::SurfaceSpecification params;
+        params.state = mir_window_state_attached;
+        params.attached_edges = MirPlacementGravity(mir_placement_gravity_north | mir_placement_gravity_west | mir_placement_gravity_east);
+        params.set_size({100, 30});
+        params.exclusive_rect = Rectangle{{0, 0}, {100, 30}};
+        params.output_id = mg::DisplayConfigurationOutputId{2};
+        basic_window_manager.add_surface(session, params, &create_surface);
+    }
+    Mock::VerifyAndClearExpectations(window_manager_policy);
+
+    miral::Zone updated{{{}, {}}};
+    EXPECT_CALL(*window_manager_policy, advise_application_zone_update(_, _))
+        .WillOnce(Invoke([&](Zone const& zone, Zone const&){ updated = zone; }));
+    {
+        WindowSpecification spec;
+        spec.exclusive_rect() = mir::optional_value<Rectangle>{Rectangle{{0, 0}, {100, 50}}};
+        window_manager_tools.modify_window(panel, spec);
+    }
+    Mock::VerifyAndClearExpectations(window_manager_policy);
+
+    EXPECT_TRUE(updated.is_same_zone(zone_b));
+    EXPECT_THAT(updated.extents(), Eq(Rectangle{{620, 50}, {800, 450}}));
+}
@@ -0,0 +1,131 @@
+/*
+ * Copyright © 2022 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "identity_map.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <string>
+#include <vector>
+
+using namespace testing;
+
+namespace
+{
+struct Thing
+{
+    int id;
+};
+}
+
+struct IdentityMap : testing::Test
+{
+    miral::IdentityMap<Thing, std::string> map;
+    std::shared_ptr<Thing> const a{std::make_shared<Thing>(Thing{1})};
+    std::shared_ptr<Thing> const b{std::make_shared<Thing>(Thing{2})};
+};
+
+TEST_F(IdentityMap, finds_values_by_object)
+{
+    map.emplace(a, "a");
+    map.emplace(b, "b");
+
+    EXPECT_THAT(map.at(a), Eq("a"));
+    EXPECT_THAT(map.at(std::weak_ptr<Thing>{b}), Eq("b"));
+    EXPECT_THAT(map.size(), Eq(2u));
+}
+
+TEST_F(IdentityMap, does_not_find_unknown_objects)
+{
+    map.emplace(a, "a");
+
+    EXPECT_FALSE(map.contains(b));
+    EXPECT_FALSE(map.contains(std::weak_ptr<Thing>{}));
+    EXPECT_THROW(map.at(b), std::out_of_range);
+}
+
+TEST_F(IdentityMap, emplace_keeps_an_existing_value)
+{
+    map.emplace(a, "a");
+
+    auto const result = map.emplace(a, "replacement");
+
+    EXPECT_FALSE(result.second);
+    EXPECT_THAT(map.at(a), Eq("a"));
+}
+
+TEST_F(IdentityMap, insert_or_assign_replaces_an_existing_value)
+{
+    map.emplace(a, "a");
+
+    map.insert_or_assign(a, "replacement");
+
+    EXPECT_THAT(map.at(a), Eq("replacement"));
+    EXPECT_THAT(map.size(), Eq(1u));
+}
+
+TEST_F(IdentityMap, an_object_that_has_been_destroyed_can_be_erased)
+{
+    auto doomed = std::make_shared<Thing>(Thing{3});
+    std::weak_ptr<Thing> const weak_doomed{doomed};
+    map.emplace(a, "a");
+    map.emplace(doomed, "doomed");
+    doomed.reset();
+
+    ASSERT_TRUE(map.contains(weak_doomed));
+    map.erase(weak_doomed);
+
+    EXPECT_FALSE(map.contains(weak_doomed));
+    EXPECT_THAT(map.size(), Eq(1u));
+}
+
+TEST_F(IdentityMap, an_object_with_the_same_address_but_a_different_owner_is_a_different_object)
+{
+    // As a new object allocated where a destroyed one was would be
+    std::shared_ptr<Thing> const impostor{std::make_shared<int>(), a.get()};
+    map.emplace(a, "a");
+
+    EXPECT_FALSE(map.contains(impostor));
+    EXPECT_THAT(map.at(a), Eq("a"));
+}
+
+TEST_F(IdentityMap, a_new_object_replaces_an_entry_left_behind_at_its_address)
+{
+    auto doomed = std::make_shared<Thing>(Thing{3});
+    map.emplace(doomed, "doomed");
+    std::shared_ptr<Thing> const successor{std::make_shared<int>(), doomed.get()};
+    doomed.reset();
+
+    auto const result = map.emplace(successor, "successor");
+
+    EXPECT_TRUE(result.second);
+    EXPECT_THAT(map.at(successor), Eq("successor"));
+}
+
+TEST_F(IdentityMap, values_stay_put_as_others_are_added)
+{
+    auto& value = map.emplace(a, "a").first->second.value;
+
+    std::vector<std::shared_ptr<Thing>> others;
+    for (auto i = 0; i != 1000; ++i)
+    {
+        others.push_back(std::make_shared<Thing>(Thing{i}));
+        map.emplace(others.back(), std::to_string(i));
+    }
+
+    EXPECT_THAT(&map.at(a), Eq(&value));
+}
@@ -0,0 +1,244 @@
+/*
+ * Copyright © 2022 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <miral/test_server.h>
+#include "wp_single_pixel_buffer_v1.h"
+
+#include <miral/application_info.h>
+#include <miral/internal_client.h>
+
+#include <mir/graphics/renderable.h>
+#include <mir/graphics/solid_color_buffer.h>
+#include <mir/scene/surface.h>
+
+#include <wayland-client.h>
+
+#include <condition_variable>
+#include <cstring>
+#include <memory>
+#include <mutex>
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+namespace mg = mir::graphics;
+namespace ms = mir::scene;
+
+using namespace testing;
+
+namespace
+{
+template<typename Type>
+auto make_scoped(Type* owned, void(*deleter)(Type*)) -> std::unique_ptr<Type, void(*)(Type*)>
+{
+    return {owned, deleter};
+}
+
+class WaylandClient
+{
+public:
+    void operator()(struct wl_display* display)
+    {
+        code(display);
+    }
+
+    void operator()(std::weak_ptr<ms::Session> const& session)
+    {
+        std::lock_guard lock{mutex};
+        session_ = session;
+    }
+
+    auto session() const -> std::shared_ptr<ms::Session>
+    {
+        std::lock_guard lock{mutex};
+        return session_.lock();
+    }
+
+    std::function<void(struct wl_display*)> code = [](auto){};
+
+private:
+    std::mutex mutable mutex;
+    std::weak_ptr<ms::Session> session_;
+};
+
+/// A wl_shell toplevel showing a single pixel buffer
+struct SinglePixelWindow
+{
+    void operator()(wl_display* display)
+    {
+        auto const registry = make_scoped(wl_display_get_registry(display), &wl_registry_destroy);
+        wl_registry_add_listener(registry.get(), &registry_listener, this);
+        wl_display_roundtrip(display);
+
+        ASSERT_THAT(compositor, NotNull());
+        ASSERT_THAT(shell, NotNull());
+        ASSERT_THAT(single_pixel_buffer_manager, NotNull());
+
+        auto const surface = make_scoped(wl_compositor_create_surface(compositor), &wl_surface_destroy);
+        auto const window = make_scoped(wl_shell_get_shell_surface(shell, surface.get()), &wl_shell_surface_destroy);
+        wl_shell_surface_set_toplevel(window.get());
+
+        // Opaque red
+        auto const buffer = make_scoped(
+            wp_single_pixel_buffer_manager_v1_create_u32_rgba_buffer(
+                single_pixel_buffer_manager, 0xffffffff, 0, 0, 0xffffffff),
+            &wl_buffer_destroy);
+        wl_buffer_add_listener(buffer.get(), &buffer_listener, this);
+
+        wl_surface_attach(surface.get(), buffer.get(), 0, 0);
+        wl_surface_commit(surface.get());
+        wl_display_roundtrip(display);
+
+        committed();
+
+        wp_single_pixel_buffer_manager_v1_destroy(single_pixel_buffer_manager);
+        wl_shell_destroy(shell);
+        wl_compositor_destroy(compositor);
+    }
+
+    static void new_global(
+        void* data,
+        struct wl_registry* registry,
+        uint32_t id,
+        char const* interface,
+        uint32_t /*version*/)
+    {
+        auto const self = static_cast<SinglePixelWindow*>(data);
+
+        if (strcmp(interface, wl_compositor_interface.name) == 0)
+        {
+            self->compositor = static_cast<wl_compositor*>(
+                wl_registry_bind(registry, id, &wl_compositor_interface, 1));
+        }
+
+        if (strcmp(interface, wl_shell_interface.name) == 0)
+        {
+            self->shell = static_cast<wl_shell*>(wl_registry_bind(registry, id, &wl_shell_interface, 1));
+        }
+
+        if (strcmp(interface, wp_single_pixel_buffer_manager_v1_interface.name) == 0)
+        {
+            self->single_pixel_buffer_manager = static_cast<wp_single_pixel_buffer_manager_v1*>(
+                wl_registry_bind(registry, id, &wp_single_pixel_buffer_manager_v1_interface, 1));
+        }
+    }
+
+    static void global_remove(void* /*data*/, struct wl_registry* /*registry*/, uint32_t /*name*/)
+    {
+    }
+
+    static void buffer_release(void* data, struct wl_buffer* /*buffer*/)
+    {
+        static_cast<SinglePixelWindow*>(data)->released = true;
+    }
+
+    static wl_registry_listener constexpr registry_listener = {
+        new_global,
+        global_remove
+    };
+
+    static wl_buffer_listener constexpr buffer_listener = {
+        buffer_release
+    };
+
+    /// Called with the window still mapped, after the commit has been handled
+    std::function<void()> committed = []{};
+
+    wl_compositor* compositor = nullptr;
+    wl_shell* shell = nullptr;
+    wp_single_pixel_buffer_manager_v1* single_pixel_buffer_manager = nullptr;
+    bool released = false;
+};
+
+wl_registry_listener constexpr SinglePixelWindow::registry_listener;
+wl_buffer_listener constexpr SinglePixelWindow::buffer_listener;
+
+struct SinglePixelBuffer : miral::TestServer
+{
+    SinglePixelBuffer()
+    {
+        add_server_init(launcher);
+    }
+
+    void run_as_client(std::function<void(struct wl_display*)>&& code)
+    {
+        bool client_run = false;
+        std::condition_variable cv;
+        std::mutex mutex;
+
+        client.code = [&](struct wl_display* display)
+            {
+                {
+                    std::lock_guard lock{mutex};
+                    code(display);
+                    client_run = true;
+                }
+                cv.notify_one();
+            };
+
+        std::unique_lock lock{mutex};
+        launcher.launch(client);
+        cv.wait(lock, [&]{ return client_run; });
+    }
+
+    /// The buffers the client's windows are currently drawn with
+    auto window_buffers() -> std::vector<std::shared_ptr<mg::Buffer>>
+    {
+        std::vector<std::shared_ptr<mg::Buffer>> result;
+        invoke_tools([&](miral::WindowManagerTools& tools)
+            {
+                for (auto const& window : tools.info_for(client.session()).windows())
+                {
+                    std::shared_ptr<ms::Surface> const surface = window;
+                    for (auto const& renderable : surface->generate_renderables(this))
+                    {
+                        result.push_back(renderable->buffer());
+                    }
+                }
+            });
+        return result;
+    }
+
+    miral::InternalClientLauncher launcher;
+    WaylandClient client;
+};
+}
+
+TEST_F(SinglePixelBuffer, committed_buffer_is_released_immediately)
+{
+    SinglePixelWindow window;
+
+    run_as_client(std::ref(window));
+
+    EXPECT_TRUE(window.released);
+}
+
+TEST_F(SinglePixelBuffer, committed_buffer_is_drawn_as_a_solid_color)
+{
+    std::vector<std::shared_ptr<mg::Buffer>> buffers;
+    SinglePixelWindow window;
+    window.committed = [&] { buffers = window_buffers(); };
+
+    run_as_client(std::ref(window));
+
+    ASSERT_THAT(buffers, SizeIs(1));
+    auto const solid_color = dynamic_cast<mg::SolidColorBuffer*>(buffers.front()->native_buffer_base());
+    ASSERT_THAT(solid_color, NotNull());
+    EXPECT_THAT(solid_color->size(), Eq(mir::geometry::Size{1, 1}));
+    EXPECT_THAT(solid_color->color().r, FloatEq(1.0f));
+    EXPECT_THAT(solid_color->color().g, FloatEq(0.0f));
+    EXPECT_THAT(solid_color->color().a, FloatEq(1.0f));
+}
@@ -0,0 +1,188 @@
+/*
+ * Copyright © 2022 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "xcursor_loader.h"
+
+#include <mir/graphics/cursor_image.h>
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+
+namespace mg = mir::graphics;
+namespace mi = mir::input;
+namespace geom = mir::geometry;
+namespace fs = std::filesystem;
+
+using namespace testing;
+
+namespace
+{
+struct Frame
+{
+    uint32_t pixel;
+    uint32_t delay;
+};
+
+/// Writes a cursor file of 24x24 images filled with the pixel of each frame
+void write_cursor(fs::path const& path, std::vector<Frame> const& frames)
+{
+    uint32_t const side{24};
+    uint32_t const header_length{16}, toc_length{12}, chunk_header_length{36};
+    uint32_t const image_type{0xfffd0002};
+
+    std::vector<uint32_t> data{0x72756358, header_length, 0x10000, static_cast<uint32_t>(frames.size())};
+    auto position = header_length + toc_length * frames.size();
+    for (auto const& frame : frames)
+    {
+        (void)frame;
+        data.insert(data.end(), {image_type, side, static_cast<uint32_t>(position)});
+        position += chunk_header_length + side * side * 4;
+    }
+    for (auto const& frame : frames)
+    {
+        data.insert(data.end(), {chunk_header_length, image_type, side, 1, side, side, 1, 2, frame.delay});
+        data.insert(data.end(), side * side, frame.pixel);
+    }
+
+    std::ofstream{path, std::ios::binary}.write(reinterpret_cast<char const*>(data.data()), data.size() * 4);
+}
+
+auto pixel_of(std::shared_ptr<mg::CursorImage> const& image) -> uint32_t
+{
+    return *static_cast<uint32_t const*>(image->as_argb_8888());
+}
+
+struct XCursorLoader : Test
+{
+    /// XCursor reads the search path once per process, so every test uses the same one, with a theme of its own
+    static void SetUpTestSuite()
+    {
+        search_path = fs::temp_directory_path() / ("mir_xcursor_loader_test_" + std::to_string(getpid()));
+        fs::create_directories(search_path);
+        setenv("XCURSOR_PATH", search_path.c_str(), true);
+    }
+
+    static void TearDownTestSuite()
+    {
+        fs::remove_all(search_path);
+    }
+
+    auto theme_dir(std::string const& theme) -> fs::path
+    {
+        auto const dir = search_path / theme / "cursors";
+        fs::create_directories(dir);
+        return dir;
+    }
+
+    std::string const theme{UnitTest::GetInstance()->current_test_info()->name()};
+    fs::path const cursors{theme_dir(theme)};
+
+    static inline fs::path search_path;
+};
+}
+
+TEST_F(XCursorLoader, loads_cursor_of_theme)
+{
+    write_cursor(cursors / "arrow", {{0xff112233, 0}});
+
+    miral::XCursorLoader loader{theme};
+    auto const image = loader.image("arrow", mi::default_cursor_size);
+
+    ASSERT_THAT(image, NotNull());
+    EXPECT_THAT(image->size(), Eq(geom::Size{24, 24}));
+    EXPECT_THAT(image->hotspot(), Eq(geom::Displacement{1, 2}));
+    EXPECT_THAT(pixel_of(image), Eq(0xff112233));
+}
+
+TEST_F(XCursorLoader, falls_back_to_arrow_for_unknown_cursor)
+{
+    write_cursor(cursors / "arrow", {{0xff112233, 0}});
+
+    miral::XCursorLoader loader{theme};
+
+    EXPECT_THAT(loader.image("no-such-cursor", mi::default_cursor_size), Eq(loader.image("arrow", mi::default_cursor_size)));
+}
+
+TEST_F(XCursorLoader, has_no_cursor_for_missing_theme)
+{
+    miral::XCursorLoader loader{"no-such-theme"};
+
+    EXPECT_THAT(loader.image("arrow", mi::default_cursor_size), IsNull());
+}
+
+TEST_F(XCursorLoader, reads_cursor_only_when_it_is_first_asked_for)
+{
+    write_cursor(cursors / "xterm", {{0xff000000, 0}});
+    miral::XCursorLoader loader{theme};
+
+    write_cursor(cursors / "xterm", {{0xffffffff, 0}});
+
+    EXPECT_THAT(pixel_of(loader.image("xterm", mi::default_cursor_size)), Eq(0xffffffff));
+}
+
+TEST_F(XCursorLoader, loads_frames_of_animated_cursor)
+{
+    write_cursor(cursors / "watch", {{0xff000001, 30}, {0xff000002, 40}, {0xff000003, 50}});
+
+    miral::XCursorLoader loader{theme};
+    auto const image = std::dynamic_pointer_cast<mg::AnimatedCursorImage>(loader.image("watch", mi::default_cursor_size));
+
+    ASSERT_THAT(image, NotNull());
+    ASSERT_THAT(image->frames().size(), Eq(3u));
+    for (auto i = 0u; i != 3; ++i)
+    {
+        EXPECT_THAT(pixel_of(image->frames()[i].image), Eq(0xff000001 + i));
+        EXPECT_THAT(image->frames()[i].delay, Eq(std::chrono::milliseconds{30 + 10 * i}));
+    }
+}
+
+TEST_F(XCursorLoader, cursors_of_theme_take_precedence_over_inherited_ones)
+{
+    auto const base = theme + "-base";
+    write_cursor(theme_dir(base) / "arrow", {{0xff000000, 0}});
+    write_cursor(theme_dir(base) / "hand2", {{0xff000000, 0}});
+    write_cursor(cursors / "arrow", {{0xffffffff, 0}});
+    std::ofstream{search_path / theme / "index.theme"} << "[Icon Theme]\nInherits=" << base << "\n";
+
+    miral::XCursorLoader loader{theme};
+
+    EXPECT_THAT(pixel_of(loader.image("arrow", mi::default_cursor_size)), Eq(0xffffffff));
+    EXPECT_THAT(loader.image("hand2", mi::default_cursor_size), NotNull());
+}
+
+TEST_F(XCursorLoader, reads_again_cursors_not_used_recently)
+{
+    int const cursor_count{100};
+    for (auto i = 0; i != cursor_count; ++i)
+    {
+        write_cursor(cursors / std::to_string(i), {{0xff000000, 0}});
+    }
+    miral::XCursorLoader loader{theme};
+
+    loader.image("0", mi::default_cursor_size);
+    write_cursor(cursors / "0", {{0xffffffff, 0}});
+    EXPECT_THAT(pixel_of(loader.image("0", mi::default_cursor_size)), Eq(0xff000000));
+
+    for (auto i = 1; i != cursor_count; ++i)
+    {
+        loader.image(std::to_string(i), mi::default_cursor_size);
+    }
+    EXPECT_THAT(pixel_of(loader.image("0", mi::default_cursor_size)), Eq(0xffffffff));
+}
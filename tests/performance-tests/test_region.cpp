@@ -0,0 +1,133 @@
+/*
+ * Copyright © 2022 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/geometry/region.h"
+#include "mir/geometry/rectangles.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace geom = mir::geometry;
+
+using namespace std::chrono;
+
+namespace
+{
+/// Regions like those of damage and window stacking on a 4K screen: many small rectangles, scattered and overlapping
+struct RegionPerformance : testing::Test
+{
+    geom::Rectangle const screen{{0, 0}, {3840, 2160}};
+    std::mt19937 generator{42};
+
+    auto random_region(int rects, int max_size) -> geom::Region
+    {
+        std::uniform_int_distribution<int> x{0, screen.size.width.as_int() - 1};
+        std::uniform_int_distribution<int> y{0, screen.size.height.as_int() - 1};
+        std::uniform_int_distribution<int> size{1, max_size};
+
+        geom::Region result;
+        for (auto i = 0; i != rects; ++i)
+        {
+            result = union_of(result, geom::Rectangle{{x(generator), y(generator)}, {size(generator), size(generator)}});
+        }
+        return result;
+    }
+
+    /// Time \a iterations runs of \a operation, recording the mean time per run
+    template<typename Operation>
+    void measure(std::string const& name, int iterations, Operation operation)
+    {
+        auto const start = steady_clock::now();
+        for (auto i = 0; i != iterations; ++i)
+        {
+            operation();
+        }
+        auto const per_run = duration_cast<nanoseconds>(steady_clock::now() - start) / iterations;
+
+        RecordProperty(name + "_ns", std::to_string(per_run.count()));
+        std::cout << name << ": " << per_run.count() << "ns" << std::endl;
+    }
+};
+}
+
+TEST_F(RegionPerformance, boolean_operations)
+{
+    auto const damage = random_region(200, 256);
+    auto const opaque = random_region(30, 1024);
+    std::cout << "Regions of " << damage.size() << " and " << opaque.size() << " rectangles" << std::endl;
+
+    size_t total{0};
+    measure("union", 1000, [&] { total += union_of(damage, opaque).size(); });
+    measure("intersection", 1000, [&] { total += intersection_of(damage, opaque).size(); });
+    measure("difference", 1000, [&] { total += difference_of(damage, opaque).size(); });
+    measure("clip_to_output", 1000, [&] { total += intersection_of(damage, geom::Rectangle{{0, 0}, {1920, 1080}}).size(); });
+
+    EXPECT_GT(total, 0u);
+}
+
+TEST_F(RegionPerformance, building_from_rectangles)
+{
+    std::uniform_int_distribution<int> position{0, 3000};
+    std::uniform_int_distribution<int> size{1, 200};
+    geom::Rectangles rects;
+    for (auto i = 0; i != 500; ++i)
+    {
+        rects.add({{position(generator), position(generator)}, {size(generator), size(generator)}});
+    }
+
+    size_t total{0};
+    measure("one_at_a_time_from_500_rectangles", 100, [&]
+        {
+            geom::Region region;
+            for (auto const& rect : rects)
+            {
+                region = union_of(region, rect);
+            }
+            total += region.size();
+        });
+    measure("at_once_from_500_rectangles", 100, [&] { total += geom::Region{rects}.size(); });
+
+    EXPECT_GT(total, 0u);
+}
+
+TEST_F(RegionPerformance, queries)
+{
+    auto const region = random_region(200, 256);
+    std::uniform_int_distribution<int> x{0, screen.size.width.as_int() - 1};
+    std::uniform_int_distribution<int> y{0, screen.size.height.as_int() - 1};
+    std::vector<geom::Point> points(1000);
+    for (auto& point : points)
+    {
+        point = {x(generator), y(generator)};
+    }
+
+    size_t hits{0};
+    measure("contains_1000_points", 1000, [&]
+        {
+            for (auto const& point : points)
+            {
+                hits += region.contains(point);
+            }
+        });
+    measure("contains_rectangle", 10000, [&] { hits += region.contains(geom::Rectangle{{100, 100}, {64, 64}}); });
+
+    EXPECT_GT(hits, 0u);
+}
@@ -0,0 +1,176 @@
+/*
+ * Copyright © 2022 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/executor.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+using namespace std::chrono;
+
+namespace
+{
+/// Counts work as it completes, so the test can wait for all of it
+class Latch
+{
+public:
+    explicit Latch(int count)
+        : remaining{count}
+    {
+    }
+
+    void count_down()
+    {
+        if (--remaining == 0)
+        {
+            std::lock_guard lock{mutex};
+            cv.notify_all();
+        }
+    }
+
+    void wait()
+    {
+        std::unique_lock lock{mutex};
+        cv.wait(lock, [this] { return remaining == 0; });
+    }
+
+private:
+    std::atomic<int> remaining;
+    std::mutex mutex;
+    std::condition_variable cv;
+};
+
+auto thread_count() -> int
+{
+    auto const tasks = std::filesystem::directory_iterator{"/proc/self/task"};
+    return std::distance(begin(tasks), end(tasks));
+}
+
+struct ThreadPoolPerformance : testing::Test
+{
+    void TearDown() override
+    {
+        mir::ThreadPoolExecutor::quiesce();
+    }
+
+    void record(std::string const& name, long value, char const* unit)
+    {
+        RecordProperty(name, std::to_string(value));
+        std::cout << name << ": " << value << unit << std::endl;
+    }
+};
+}
+
+TEST_F(ThreadPoolPerformance, throughput_of_tiny_work)
+{
+    int const work_count{10000};
+    Latch done{work_count};
+
+    auto const start = steady_clock::now();
+    for (auto i = 0; i != work_count; ++i)
+    {
+        mir::thread_pool_executor.spawn([&done] { done.count_down(); });
+    }
+    done.wait();
+    auto const per_item = duration_cast<nanoseconds>(steady_clock::now() - start) / work_count;
+
+    record("tiny_work_ns", per_item.count(), "ns");
+}
+
+TEST_F(ThreadPoolPerformance, throughput_of_work_spawned_from_work)
+{
+    int const fan_out{100};
+    int const work_count{fan_out * fan_out};
+    Latch done{work_count};
+
+    auto const start = steady_clock::now();
+    for (auto i = 0; i != fan_out; ++i)
+    {
+        mir::thread_pool_executor.spawn([&done]
+            {
+                for (auto j = 0; j != fan_out; ++j)
+                {
+                    mir::thread_pool_executor.spawn([&done] { done.count_down(); });
+                }
+            });
+    }
+    done.wait();
+    auto const per_item = duration_cast<nanoseconds>(steady_clock::now() - start) / work_count;
+
+    record("nested_work_ns", per_item.count(), "ns");
+}
+
+TEST_F(ThreadPoolPerformance, latency_from_spawn_to_start)
+{
+    int const samples{2000};
+    std::vector<nanoseconds> latencies;
+    latencies.reserve(samples);
+
+    for (auto i = 0; i != samples; ++i)
+    {
+        Latch started{1};
+        steady_clock::time_point start_time;
+        auto const spawn_time = steady_clock::now();
+        mir::thread_pool_executor.spawn([&] { start_time = steady_clock::now(); started.count_down(); });
+        started.wait();
+        latencies.push_back(duration_cast<nanoseconds>(start_time - spawn_time));
+    }
+
+    std::sort(latencies.begin(), latencies.end());
+    record("latency_median_ns", latencies[samples / 2].count(), "ns");
+    record("latency_99th_percentile_ns", latencies[samples * 99 / 100].count(), "ns");
+}
+
+TEST_F(ThreadPoolPerformance, threads_used_by_a_burst_of_work)
+{
+    int const work_count{200};
+    auto const threads_before = thread_count();
+    std::atomic<int> most_threads{0};
+    Latch done{work_count};
+
+    auto const start = steady_clock::now();
+    for (auto i = 0; i != work_count; ++i)
+    {
+        mir::thread_pool_executor.spawn([&]
+            {
+                // A little real work, as handling a client request might be
+                auto const until = steady_clock::now() + 200us;
+                while (steady_clock::now() < until)
+                {
+                }
+                auto const threads = thread_count();
+                auto most = most_threads.load();
+                while (threads > most && !most_threads.compare_exchange_weak(most, threads))
+                {
+                }
+                done.count_down();
+            });
+    }
+    done.wait();
+    auto const elapsed = duration_cast<microseconds>(steady_clock::now() - start);
+
+    record("burst_of_200_us", elapsed.count(), "us");
+    record("burst_of_200_threads_added", most_threads - threads_before, " threads");
+}
@@ -0,0 +1,149 @@
+/*
+ * Copyright © 2022 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "identity_map.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono;
+
+namespace
+{
+/// Stands in for a scene::Surface: only its identity matters
+struct Surface
+{
+    int id;
+};
+
+/// Stands in for the WindowInfo held for each surface
+struct Info
+{
+    int id;
+    char state[256];
+};
+
+/// How the window manager indexed its windows before
+using OrderedMap = std::map<std::weak_ptr<Surface>, Info, std::owner_less<std::weak_ptr<Surface>>>;
+using HashedMap = miral::IdentityMap<Surface, Info>;
+
+auto& value_of(OrderedMap::value_type& entry) { return entry.second; }
+auto& value_of(HashedMap::Storage::value_type& entry) { return entry.second.value; }
+
+/// Many clients' windows, looked up in the random order input and requests arrive in
+struct WindowInfoLookupPerformance : testing::Test
+{
+    int const window_count{500};
+    int const lookups_per_thread{200000};
+
+    std::vector<std::shared_ptr<Surface>> surfaces;
+    std::vector<std::weak_ptr<Surface>> requests;
+
+    void SetUp() override
+    {
+        for (auto i = 0; i != window_count; ++i)
+        {
+            surfaces.push_back(std::make_shared<Surface>(Surface{i}));
+        }
+
+        std::mt19937 random{42};
+        std::uniform_int_distribution<int> pick{0, window_count - 1};
+        for (auto i = 0; i != lookups_per_thread; ++i)
+        {
+            requests.push_back(surfaces[pick(random)]);
+        }
+    }
+
+    template<typename Map>
+    void fill(Map& map)
+    {
+        for (auto const& surface : surfaces)
+        {
+            map.emplace(surface, Info{surface->id, {}});
+        }
+    }
+
+    /// Each thread looks up every request under the one lock, as the window manager does; returns ns per lookup
+    template<typename Map>
+    auto time_lookups(Map& map, int thread_count) -> long
+    {
+        std::mutex mutex;
+        std::vector<std::thread> threads;
+
+        auto const start = steady_clock::now();
+        for (auto t = 0; t != thread_count; ++t)
+        {
+            threads.emplace_back([&]
+                {
+                    long checksum{0};
+                    for (auto const& request : requests)
+                    {
+                        std::lock_guard lock{mutex};
+                        checksum += value_of(*map.find(request)).id;
+                    }
+                    EXPECT_GT(checksum, 0);
+                });
+        }
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+        auto const elapsed = duration_cast<nanoseconds>(steady_clock::now() - start);
+
+        return elapsed.count() / (static_cast<long>(thread_count) * lookups_per_thread);
+    }
+
+    void record(std::string const& name, long value)
+    {
+        RecordProperty(name, std::to_string(value));
+        std::cout << name << ": " << value << "ns" << std::endl;
+    }
+};
+}
+
+TEST_F(WindowInfoLookupPerformance, uncontended_lookup)
+{
+    OrderedMap ordered;
+    HashedMap hashed;
+    fill(ordered);
+    fill(hashed);
+
+    record("ordered_lookup_ns", time_lookups(ordered, 1));
+    record("hashed_lookup_ns", time_lookups(hashed, 1));
+}
+
+TEST_F(WindowInfoLookupPerformance, contended_lookup)
+{
+    auto const thread_count = static_cast<int>(std::max(std::thread::hardware_concurrency(), 2u));
+    OrderedMap ordered;
+    HashedMap hashed;
+    fill(ordered);
+    fill(hashed);
+
+    // The less time each lookup holds the lock, the less the threads wait for each other
+    record("contended_ordered_lookup_ns", time_lookups(ordered, thread_count));
+    record("contended_hashed_lookup_ns", time_lookups(hashed, thread_count));
+}
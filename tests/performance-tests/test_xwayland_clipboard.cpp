@@ -0,0 +1,156 @@
+/*
+ * Copyright © 2022 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir_test_framework/async_server_runner.h"
+#include <miral/x11_support.h>
+#include <miral/minimal_window_manager.h>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <unistd.h>
+
+namespace mtf = mir_test_framework;
+
+using namespace std::chrono;
+using namespace std::literals::chrono_literals;
+using namespace testing;
+
+namespace
+{
+/// Copies text between X11 and Wayland clients through Xwayland, using the xclip and wl-clipboard tools
+struct XWaylandClipboardPerformance : testing::Test, mtf::AsyncServerRunner
+{
+    /// Large enough to need many incremental X11 transfers, as a copied image would
+    static constexpr size_t data_size = 32 * 1024 * 1024;
+
+    std::string const input_file{"/tmp/xwayland_clipboard_input_" + std::to_string(getpid())};
+    std::string const output_file{"/tmp/xwayland_clipboard_output_" + std::to_string(getpid())};
+    bool server_started{false};
+
+    XWaylandClipboardPerformance()
+    {
+        // As in the GLMark2 tests, this is a slightly awkward method of enabling X11 support
+        miral::X11Support{}(server);
+        add_to_environment("MIR_SERVER_ENABLE_X11", "1");
+        add_to_environment("WAYLAND_DISPLAY", "XWaylandClipboardPerformance");
+    }
+
+    void SetUp() override
+    {
+        for (auto const tool : {"xclip", "wl-copy", "wl-paste"})
+        {
+            if (run(std::string{"which "} + tool + " >/dev/null") != 0)
+            {
+                GTEST_SKIP() << tool << " is needed to copy and paste";
+            }
+        }
+
+        miral::set_window_management_policy<miral::MinimalWindowManager>()(server);
+        start_server();
+        server_started = true;
+        add_to_environment("DISPLAY", server.x11_display().value().c_str());
+
+        std::ofstream input{input_file};
+        std::string const line{"The quick brown fox jumps over the lazy dog 0123456789\n"};
+        for (size_t written = 0; written < data_size; written += line.size())
+        {
+            input << line;
+        }
+    }
+
+    void TearDown() override
+    {
+        if (server_started)
+        {
+            stop_server();
+        }
+        std::remove(input_file.c_str());
+        std::remove(output_file.c_str());
+    }
+
+    static auto run(std::string const& command) -> int
+    {
+        return std::system(command.c_str());
+    }
+
+    /// Waits for the selection to be offered through Xwayland, which takes a few round trips after the copy
+    static auto wait_for(std::string const& command) -> bool
+    {
+        auto const give_up = steady_clock::now() + 10s;
+        while (run(command) != 0)
+        {
+            if (steady_clock::now() > give_up)
+            {
+                return false;
+            }
+            std::this_thread::sleep_for(10ms);
+        }
+        return true;
+    }
+
+    void record_paste(std::string const& name, std::string const& paste_command)
+    {
+        auto const start = steady_clock::now();
+        ASSERT_THAT(run(paste_command + " >" + output_file), Eq(0)) << paste_command;
+        auto const elapsed = duration_cast<milliseconds>(steady_clock::now() - start);
+
+        std::ifstream output{output_file, std::ios::binary | std::ios::ate};
+        EXPECT_THAT(static_cast<size_t>(output.tellg()), Ge(data_size));
+
+        auto const megabytes_per_second = data_size / 1024 / 1024 * 1000 / std::max<long>(elapsed.count(), 1);
+        RecordProperty(name + "_ms", std::to_string(elapsed.count()));
+        RecordProperty(name + "_MiB_per_s", std::to_string(megabytes_per_second));
+        std::cout << name << ": " << elapsed.count() << "ms (" << megabytes_per_second << "MiB/s)" << std::endl;
+    }
+};
+}
+
+TEST_F(XWaylandClipboardPerformance, x11_to_wayland)
+{
+    // xclip keeps serving the selection in the background
+    ASSERT_THAT(run("xclip -selection clipboard -i " + input_file), Eq(0));
+    ASSERT_TRUE(wait_for("wl-paste --list-types 2>/dev/null | grep -q text/plain"));
+
+    record_paste("x11_to_wayland", "wl-paste --no-newline");
+}
+
+TEST_F(XWaylandClipboardPerformance, wayland_to_x11)
+{
+    // wl-copy keeps serving the selection in the background
+    ASSERT_THAT(run("wl-copy <" + input_file), Eq(0));
+    ASSERT_TRUE(wait_for("xclip -selection clipboard -t TARGETS -o 2>/dev/null | grep -q UTF8_STRING"));
+
+    record_paste("wayland_to_x11", "xclip -selection clipboard -o");
+}
+
+TEST_F(XWaylandClipboardPerformance, concurrent_x11_to_wayland)
+{
+    ASSERT_THAT(run("xclip -selection clipboard -i " + input_file), Eq(0));
+    ASSERT_TRUE(wait_for("wl-paste --list-types 2>/dev/null | grep -q text/plain"));
+
+    // A paste that is never read from must not hold up the others
+    ASSERT_THAT(run("sh -c 'wl-paste --no-newline | sleep 10' &"), Eq(0));
+    record_paste("x11_to_wayland_alongside_a_stalled_paste", "wl-paste --no-newline");
+}
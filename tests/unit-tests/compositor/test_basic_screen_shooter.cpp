@@ -17,6 +17,7 @@
 #include "src/server/compositor/basic_screen_shooter.h"
 
 #include "mir/renderer/gl/buffer_render_target.h"
+#include "mir/scene/observer.h"
 #include "mir/test/fake_shared.h"
 #include "mir/test/doubles/mock_scene.h"
 #include "mir/test/doubles/mock_renderer.h"
@@ -47,6 +48,8 @@ class MockBufferRenderTarget: public mrg::BufferRenderTarget
 {
 public:
     MOCK_METHOD(void, set_buffer, (std::shared_ptr<mrs::WriteMappableBuffer> const& buffer), (override));
+    MOCK_METHOD(void, set_damage, (geom::Rectangle const& damage), (override));
+    MOCK_METHOD(std::function<void()>, take_pending_copy, (), (override));
     MOCK_METHOD(geom::Size, size, (), (const, override));
     MOCK_METHOD(void, make_current, (), (override));
     MOCK_METHOD(void, release_current, (), (override));
@@ -62,6 +65,12 @@ struct BasicScreenShooter : Test
     }
 
     NiceMock<mtd::MockScene> scene;
+    std::shared_ptr<mir::scene::Observer> scene_observer;
+    bool const scene_observer_saved{[&]()
+        {
+            ON_CALL(scene, add_observer(_)).WillByDefault(SaveArg<0>(&scene_observer));
+            return true;
+        }()};
     mg::RenderableList renderables{[]()
         {
             mg::RenderableList renderables;
@@ -193,3 +202,116 @@ TEST_F(BasicScreenShooter, throw_in_render_causes_graceful_failure)
     EXPECT_CALL(callback, Call(nullopt_time));
     executor.execute();
 }
+
+TEST_F(BasicScreenShooter, reuses_frame_if_scene_has_not_changed)
+{
+    auto const first_capture_time = clock.now();
+    shooter.capture(mt::fake_shared(buffer), viewport_rect, [&](auto time)
+        {
+            callback.Call(time);
+        });
+    EXPECT_CALL(callback, Call(std::make_optional(first_capture_time)));
+    executor.execute();
+    Mock::VerifyAndClearExpectations(&callback);
+
+    clock.advance_by(1s);
+    shooter.capture(mt::fake_shared(buffer), viewport_rect, [&](auto time)
+        {
+            callback.Call(time);
+        });
+    EXPECT_CALL(renderer, render(_)).Times(0);
+    EXPECT_CALL(render_target, swap_buffers());
+    EXPECT_CALL(callback, Call(std::make_optional(first_capture_time)));
+    executor.execute();
+}
+
+TEST_F(BasicScreenShooter, renders_again_after_scene_changes)
+{
+    ASSERT_THAT(scene_observer, NotNull());
+    shooter.capture(mt::fake_shared(buffer), viewport_rect, [&](auto time)
+        {
+            callback.Call(time);
+        });
+    EXPECT_CALL(callback, Call(_));
+    executor.execute();
+    Mock::VerifyAndClearExpectations(&callback);
+
+    scene_observer->scene_changed();
+    clock.advance_by(1s);
+    shooter.capture(mt::fake_shared(buffer), viewport_rect, [&](auto time)
+        {
+            callback.Call(time);
+        });
+    EXPECT_CALL(renderer, render(_));
+    EXPECT_CALL(callback, Call(std::make_optional(clock.now())));
+    executor.execute();
+}
+
+TEST_F(BasicScreenShooter, renders_again_for_a_different_area)
+{
+    shooter.capture(mt::fake_shared(buffer), viewport_rect, [&](auto time)
+        {
+            callback.Call(time);
+        });
+    EXPECT_CALL(callback, Call(_));
+    executor.execute();
+    Mock::VerifyAndClearExpectations(&callback);
+
+    geom::Rectangle const other_rect{{0, 0}, {40, 50}};
+    shooter.capture(mt::fake_shared(buffer), other_rect, [&](auto time)
+        {
+            callback.Call(time);
+        });
+    EXPECT_CALL(renderer, set_viewport(Eq(other_rect)));
+    EXPECT_CALL(renderer, render(_));
+    EXPECT_CALL(callback, Call(_));
+    executor.execute();
+}
+
+TEST_F(BasicScreenShooter, capture_damage_sets_damage_before_render)
+{
+    geom::Rectangle const damage{{2, 3}, {4, 5}};
+    shooter.capture_damage(mt::fake_shared(buffer), viewport_rect, damage, [&](auto time)
+        {
+            callback.Call(time);
+        });
+    InSequence seq;
+    EXPECT_CALL(render_target, set_buffer(Eq(mt::fake_shared(buffer))));
+    EXPECT_CALL(render_target, set_damage(Eq(damage)));
+    EXPECT_CALL(renderer, render(_));
+    EXPECT_CALL(callback, Call(std::make_optional(clock.now())));
+    executor.execute();
+}
+
+TEST_F(BasicScreenShooter, finishes_pending_copy_with_context_current_before_calling_callback)
+{
+    MockFunction<void()> pending_copy;
+    ON_CALL(render_target, take_pending_copy()).WillByDefault(Return(pending_copy.AsStdFunction()));
+    shooter.capture(mt::fake_shared(buffer), viewport_rect, [&](auto time)
+        {
+            callback.Call(time);
+        });
+    InSequence seq;
+    EXPECT_CALL(render_target, make_current());
+    EXPECT_CALL(renderer, render(_));
+    EXPECT_CALL(render_target, release_current());
+    EXPECT_CALL(render_target, make_current());
+    EXPECT_CALL(pending_copy, Call());
+    EXPECT_CALL(render_target, release_current());
+    EXPECT_CALL(callback, Call(std::make_optional(clock.now())));
+    executor.execute();
+}
+
+TEST_F(BasicScreenShooter, throw_in_pending_copy_causes_graceful_failure)
+{
+    ON_CALL(render_target, take_pending_copy()).WillByDefault(Return([]()
+        {
+            throw std::runtime_error{"throw in pending copy!"};
+        }));
+    shooter.capture(mt::fake_shared(buffer), viewport_rect, [&](auto time)
+        {
+            callback.Call(time);
+        });
+    EXPECT_CALL(callback, Call(nullopt_time));
+    executor.execute();
+}
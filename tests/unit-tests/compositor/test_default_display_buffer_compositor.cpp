@@ -18,6 +18,7 @@
 #include "src/server/report/null_report_factory.h"
 #include "mir/compositor/scene.h"
 #include "mir/renderer/renderer.h"
+#include "mir/graphics/overlay_planes.h"
 #include "mir/geometry/rectangle.h"
 #include "mir/test/doubles/mock_renderer.h"
 #include "mir/test/fake_shared.h"
@@ -319,6 +320,58 @@ TEST_F(DefaultDisplayBufferCompositor, occluded_surfaces_are_not_rendered)
     }));
 }
 
+namespace
+{
+struct MockOverlayPlanesDisplayBuffer : mtd::MockDisplayBuffer, mg::OverlayPlanes
+{
+    MOCK_METHOD1(assign_planes, mg::RenderableList(mg::RenderableList const&));
+};
+}
+
+TEST_F(DefaultDisplayBufferCompositor, renderables_assigned_to_overlay_planes_are_not_rendered)
+{
+    using namespace testing;
+    NiceMock<MockOverlayPlanesDisplayBuffer> planes_buffer;
+    ON_CALL(planes_buffer, view_area())
+        .WillByDefault(Return(screen));
+    ON_CALL(planes_buffer, transformation())
+        .WillByDefault(Return(no_transformation));
+    ON_CALL(planes_buffer, overlay(_))
+        .WillByDefault(Return(false));
+
+    mg::RenderableList const all{big, small};
+    mg::RenderableList const composited{big};
+
+    EXPECT_CALL(planes_buffer, assign_planes(ContainerEq(all)))
+        .WillOnce(Return(composited));
+    EXPECT_CALL(mock_renderer, render(ContainerEq(composited)));
+
+    mc::DefaultDisplayBufferCompositor compositor(
+        planes_buffer,
+        mt::fake_shared(mock_renderer),
+        mr::null_compositor_report());
+    compositor.composite(make_scene_elements({big, small}));
+}
+
+TEST_F(DefaultDisplayBufferCompositor, overlay_planes_are_not_assigned_when_whole_frame_is_overlaid)
+{
+    using namespace testing;
+    NiceMock<MockOverlayPlanesDisplayBuffer> planes_buffer;
+    ON_CALL(planes_buffer, view_area())
+        .WillByDefault(Return(screen));
+    ON_CALL(planes_buffer, overlay(_))
+        .WillByDefault(Return(true));
+
+    EXPECT_CALL(planes_buffer, assign_planes(_))
+        .Times(0);
+
+    mc::DefaultDisplayBufferCompositor compositor(
+        planes_buffer,
+        mt::fake_shared(mock_renderer),
+        mr::null_compositor_report());
+    compositor.composite(make_scene_elements({fullscreen}));
+}
+
 namespace
 {
 struct MockSceneElement : mc::SceneElement
@@ -20,8 +20,15 @@
 #include "mir/test/doubles/stub_buffer.h"
 #include "src/server/compositor/multi_monitor_arbiter.h"
 #include "src/server/compositor/schedule.h"
+#include "src/server/compositor/queueing_schedule.h"
 
 #include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <map>
+
 using namespace testing;
 namespace mt = mir::test;
 namespace mtd = mir::test::doubles;
@@ -29,6 +36,8 @@ namespace mc = mir::compositor;
 namespace mg = mir::graphics;
 namespace mf = mir::frontend;
 
+using namespace std::chrono_literals;
+
 namespace
 {
 struct FixedSchedule : mc::Schedule
@@ -124,6 +133,91 @@ std::shared_ptr<mg::Buffer> wrap_with_destruction_notifier(
 
     return std::make_shared<DestructionNotifyingBuffer>(buffer, destroyed);
 }
+
+/// Simulates a client rendering into a stream that is shown on outputs with different refresh rates
+struct MixedRefreshRates
+{
+    struct Output
+    {
+        std::chrono::microseconds period;
+        std::chrono::microseconds phase;
+        std::vector<int> frames_shown{};
+        std::vector<int> newest_frame_at_refresh{};
+    };
+
+    /// Runs for \a duration, submitting a new frame every \a client_period and compositing each output at its rate
+    void run(std::chrono::microseconds client_period, std::vector<Output*> const& outputs, std::chrono::seconds duration)
+    {
+        std::map<std::chrono::microseconds, std::vector<std::function<void()>>> events;
+        for (auto t = 0us; t < duration; t += client_period)
+        {
+            events[t].push_back([this] { submit(); });
+        }
+        for (auto const output : outputs)
+        {
+            for (auto t = output->phase; t < duration; t += output->period)
+            {
+                events[t].push_back([this, output] { composite(*output); });
+            }
+        }
+
+        for (auto const& [time, actions] : events)
+        {
+            for (auto const& action : actions)
+            {
+                action();
+            }
+        }
+    }
+
+    void submit()
+    {
+        auto const buffer = std::make_shared<mtd::StubBuffer>();
+        frame_of[buffer->id().as_value()] = frames_submitted++;
+        schedule.schedule(buffer);
+    }
+
+    void composite(Output& output)
+    {
+        if (frames_submitted == 0)
+        {
+            return;
+        }
+
+        auto const buffer = arbiter.compositor_acquire(&output);
+        output.frames_shown.push_back(frame_of.at(buffer->id().as_value()));
+        output.newest_frame_at_refresh.push_back(frames_submitted - 1);
+    }
+
+    static auto repeats(Output const& output) -> int
+    {
+        auto repeated = 0;
+        for (auto i = 1u; i < output.frames_shown.size(); ++i)
+        {
+            if (output.frames_shown[i] == output.frames_shown[i - 1])
+            {
+                ++repeated;
+            }
+        }
+        return repeated;
+    }
+
+    /// How many frames behind the newest submission each refresh shows, at worst
+    static auto worst_lag(Output const& output) -> int
+    {
+        auto worst = 0;
+        for (auto i = 0u; i != output.frames_shown.size(); ++i)
+        {
+            worst = std::max(worst, output.newest_frame_at_refresh[i] - output.frames_shown[i]);
+        }
+        return worst;
+    }
+
+    mc::QueueingSchedule schedule;
+    mc::MultiMonitorArbiter arbiter{mt::fake_shared(schedule)};
+    std::map<uint32_t, int> frame_of;
+    int frames_submitted{0};
+};
 }
 
 TEST_F(MultiMonitorArbiter, compositor_access_before_any_submission_throws)
@@ -655,3 +749,45 @@ TEST_F(MultiMonitorArbiter, second_compositor_advances_schedule_after_both_aquir
     auto cbuffer4 = arbiter.compositor_acquire(&comp_id2);
     EXPECT_THAT(cbuffer1, Not(IsSameBufferAs(cbuffer4)));
 }
+
+TEST_F(MultiMonitorArbiter, fast_output_is_not_throttled_by_slow_output_sharing_the_surface)
+{
+    MixedRefreshRates harness;
+    MixedRefreshRates::Output fast{6944us, 1000us};
+    MixedRefreshRates::Output slow{16667us, 3000us};
+
+    harness.run(6944us, {&fast, &slow}, 1s);
+
+    // A client drawing at the fast output's rate has every frame shown there...
+    EXPECT_THAT(MixedRefreshRates::repeats(fast), Eq(0));
+    EXPECT_THAT(MixedRefreshRates::worst_lag(fast), Eq(0));
+    // ...while the slow output shows a new frame each time it refreshes, at worst the one the fast output is showing
+    EXPECT_THAT(MixedRefreshRates::repeats(slow), Eq(0));
+    EXPECT_THAT(MixedRefreshRates::worst_lag(slow), Le(1));
+}
+
+TEST_F(MultiMonitorArbiter, slow_output_does_not_hold_back_fast_output_when_it_composites_first)
+{
+    MixedRefreshRates harness;
+    MixedRefreshRates::Output fast{6944us, 3000us};
+    // Composites just before the fast output does, straight after each submission
+    MixedRefreshRates::Output slow{16667us, 100us};
+
+    harness.run(6944us, {&slow, &fast}, 1s);
+
+    EXPECT_THAT(MixedRefreshRates::repeats(fast), Eq(0));
+    EXPECT_THAT(MixedRefreshRates::worst_lag(fast), Eq(0));
+    EXPECT_THAT(MixedRefreshRates::worst_lag(slow), Le(1));
+}
+
+TEST_F(MultiMonitorArbiter, outputs_at_different_rates_both_keep_up_with_a_slower_client)
+{
+    MixedRefreshRates harness;
+    MixedRefreshRates::Output fast{6944us, 1000us};
+    MixedRefreshRates::Output slow{16667us, 2000us};
+
+    harness.run(33333us, {&fast, &slow}, 1s);
+
+    EXPECT_THAT(MixedRefreshRates::worst_lag(fast), Eq(0));
+    EXPECT_THAT(MixedRefreshRates::worst_lag(slow), Eq(0));
+}
@@ -16,6 +16,7 @@
 
 #include "mir/geometry/rectangle.h"
 #include "src/server/compositor/occlusion.h"
+#include "mir/graphics/solid_color_buffer.h"
 #include "mir/test/doubles/fake_renderable.h"
 #include "mir/test/doubles/stub_scene_element.h"
 
@@ -123,6 +124,32 @@ TEST_F(OcclusionFilterTest, shaped_window_occludes_nothing)
     EXPECT_THAT(renderables_from(elements), ElementsAre(bottom, top));
 }
 
+TEST_F(OcclusionFilterTest, opaque_solid_color_occludes_whatever_its_shape)
+{
+    auto top = std::make_shared<mtd::FakeRenderable>(Rectangle{{10, 10}, {10, 10}}, 1.0f, false);
+    top->set_buffer(std::make_shared<mg::SolidColorBuffer>(Size{1, 1}, glm::vec4{0.5f, 0.5f, 0.5f, 1.0f}));
+    auto bottom = std::make_shared<mtd::FakeRenderable>(12, 12, 5, 5);
+    auto elements = scene_elements_from({bottom, top});
+
+    auto const& occlusions = filter_occlusions_from(elements, monitor_rect);
+
+    EXPECT_THAT(renderables_from(occlusions), ElementsAre(bottom));
+    EXPECT_THAT(renderables_from(elements), ElementsAre(top));
+}
+
+TEST_F(OcclusionFilterTest, translucent_solid_color_occludes_nothing)
+{
+    auto top = std::make_shared<mtd::FakeRenderable>(10, 10, 10, 10);
+    top->set_buffer(std::make_shared<mg::SolidColorBuffer>(Size{1, 1}, glm::vec4{0.25f, 0.25f, 0.25f, 0.5f}));
+    auto bottom = std::make_shared<mtd::FakeRenderable>(12, 12, 5, 5);
+    auto elements = scene_elements_from({bottom, top});
+
+    auto const& occlusions = filter_occlusions_from(elements, monitor_rect);
+
+    EXPECT_THAT(renderables_from(occlusions), IsEmpty());
+    EXPECT_THAT(renderables_from(elements), ElementsAre(bottom, top));
+}
+
 TEST_F(OcclusionFilterTest, identical_window_occluded)
 {
     auto top = std::make_shared<mtd::FakeRenderable>(10, 10, 10, 10);
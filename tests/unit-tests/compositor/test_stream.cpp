@@ -151,6 +151,39 @@ TEST_F(Stream, frame_callback_is_called_without_scheduling_lock)
     stream.submit_buffer(buffers[0]);
 }
 
+TEST_F(Stream, calls_repaint_callback_once_when_compositor_next_takes_a_buffer)
+{
+    int repaint_count{0};
+    stream.submit_buffer(buffers[0]);
+    stream.on_next_repaint([&repaint_count]() { ++repaint_count; });
+    EXPECT_THAT(repaint_count, Eq(0));
+
+    stream.lock_compositor_buffer(this);
+    stream.lock_compositor_buffer(this);
+    EXPECT_THAT(repaint_count, Eq(1));
+}
+
+TEST_F(Stream, repaint_callback_replaces_one_not_yet_run)
+{
+    int first_count{0};
+    int second_count{0};
+    stream.submit_buffer(buffers[0]);
+    stream.on_next_repaint([&first_count]() { ++first_count; });
+    stream.on_next_repaint([&second_count]() { ++second_count; });
+
+    stream.lock_compositor_buffer(this);
+    EXPECT_THAT(first_count, Eq(0));
+    EXPECT_THAT(second_count, Eq(1));
+}
+
+TEST_F(Stream, repaint_callback_is_called_without_callback_lock)
+{
+    stream.submit_buffer(buffers[0]);
+    stream.on_next_repaint([this]() { stream.on_next_repaint([]() {}); });
+
+    stream.lock_compositor_buffer(this);
+}
+
 TEST_F(Stream, flattens_queue_out_when_told_to_drop)
 {
     for(auto& buffer : buffers)
@@ -0,0 +1,335 @@
+/*
+ * Copyright © 2022 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/frontend_rfb/rfb_connector.h"
+#include "src/server/frontend_rfb/rfb_frame_source.h"
+#include "mir/compositor/screen_shooter.h"
+#include "mir/executor.h"
+#include "mir/fd.h"
+#include "mir/renderer/sw/pixel_source.h"
+#include "mir/scene/observer.h"
+
+#include "mir/test/doubles/mock_input_device_registry.h"
+#include "mir/test/doubles/stub_scene.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+#include <system_error>
+
+namespace mc = mir::compositor;
+namespace mf = mir::frontend;
+namespace ms = mir::scene;
+namespace mtd = mir::test::doubles;
+namespace geom = mir::geometry;
+
+using namespace testing;
+
+namespace
+{
+uint32_t const background{0xff203040};
+uint32_t const highlight{0xffc0d0e0};
+
+/// Keeps hold of the RfbFrameSource's observer, so tests can damage the scene
+struct ObservedScene : mtd::StubScene
+{
+    void add_observer(std::shared_ptr<ms::Observer> const& observer) override
+    {
+        this->observer = observer;
+    }
+
+    void remove_observer(std::weak_ptr<ms::Observer> const&) override
+    {
+        observer.reset();
+    }
+
+    std::shared_ptr<ms::Observer> observer;
+};
+
+/// Paints the background, with the highlighted rectangle (if any) on top
+struct FakeScreenShooter : mc::ScreenShooter
+{
+    void capture(
+        std::shared_ptr<mir::renderer::software::WriteMappableBuffer> const& buffer,
+        geom::Rectangle const& area,
+        std::function<void(std::optional<mir::time::Timestamp>)>&& callback) override
+    {
+        {
+            auto const mapping = buffer->map_writeable();
+            auto const stride = mapping->stride().as_int();
+            auto const height = area.size.height.as_int();
+            std::lock_guard lock{mutex};
+            for (auto y = 0; y != height; ++y)
+            {
+                // Frames are captured bottom-up
+                auto const row = reinterpret_cast<uint32_t*>(mapping->data() + (height - 1 - y) * stride);
+                for (auto x = 0; x != area.size.width.as_int(); ++x)
+                {
+                    row[x] = highlighted.contains(geom::Point{x, y}) ? highlight : background;
+                }
+            }
+        }
+        callback(mir::time::Timestamp{});
+    }
+
+    void highlight_area(geom::Rectangle const& area)
+    {
+        std::lock_guard lock{mutex};
+        highlighted = area;
+    }
+
+    std::mutex mutex;
+    geom::Rectangle highlighted;
+};
+
+/// The viewer's end of the connection
+struct Viewer
+{
+    explicit Viewer(int port)
+        : socket{::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0)}
+    {
+        timeval const timeout{5, 0};
+        setsockopt(socket, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof timeout);
+
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(port);
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (connect(socket, reinterpret_cast<sockaddr*>(&address), sizeof address) < 0)
+        {
+            throw std::system_error{errno, std::system_category(), "Failed to connect to RFB server"};
+        }
+    }
+
+    auto bytes(size_t count) -> std::vector<uint8_t>
+    {
+        std::vector<uint8_t> result(count);
+        for (size_t done = 0; done != count;)
+        {
+            auto const received = recv(socket, result.data() + done, count - done, 0);
+            if (received <= 0)
+            {
+                throw std::runtime_error{"RFB server closed the connection or timed out"};
+            }
+            done += received;
+        }
+        return result;
+    }
+
+    auto u8() -> uint8_t { return bytes(1)[0]; }
+    auto u16() -> uint16_t { auto const b = bytes(2); return b[0] << 8 | b[1]; }
+    auto u32() -> uint32_t { auto const b = bytes(4); return uint32_t(b[0]) << 24 | b[1] << 16 | b[2] << 8 | b[3]; }
+
+    void send(std::vector<uint8_t> const& data)
+    {
+        ASSERT_THAT(::send(socket, data.data(), data.size(), MSG_NOSIGNAL), Eq(static_cast<ssize_t>(data.size())));
+    }
+
+    void request_update(bool incremental, geom::Rectangle const& area)
+    {
+        auto const x = area.left().as_int(), y = area.top().as_int();
+        auto const w = area.size.width.as_int(), h = area.size.height.as_int();
+        send({3, uint8_t(incremental),
+            uint8_t(x >> 8), uint8_t(x), uint8_t(y >> 8), uint8_t(y),
+            uint8_t(w >> 8), uint8_t(w), uint8_t(h >> 8), uint8_t(h)});
+    }
+
+    struct Rect
+    {
+        geom::Rectangle area;
+        std::vector<uint32_t> pixels;
+    };
+
+    /// Read a FramebufferUpdate of raw rectangles, in the default pixel format
+    auto read_update() -> std::vector<Rect>
+    {
+        EXPECT_THAT(u8(), Eq(0));
+        u8();
+        std::vector<Rect> rects(u16());
+        for (auto& rect : rects)
+        {
+            int const x = u16(), y = u16(), w = u16(), h = u16();
+            rect.area = {{x, y}, {w, h}};
+            EXPECT_THAT(u32(), Eq(0u));
+
+            auto const data = bytes(w * h * 4);
+            rect.pixels.resize(w * h);
+            memcpy(rect.pixels.data(), data.data(), data.size());
+            for (auto& pixel : rect.pixels)
+            {
+                pixel &= 0x00ffffff;
+            }
+        }
+        return rects;
+    }
+
+    mir::Fd const socket;
+};
+
+struct RfbConnector : Test
+{
+    geom::Rectangle const screen{{0, 0}, {200, 100}};
+    std::shared_ptr<ObservedScene> const scene{std::make_shared<ObservedScene>()};
+    std::shared_ptr<FakeScreenShooter> const screen_shooter{std::make_shared<FakeScreenShooter>()};
+    std::shared_ptr<NiceMock<mtd::MockInputDeviceRegistry>> const device_registry{
+        std::make_shared<NiceMock<mtd::MockInputDeviceRegistry>>()};
+    mf::RfbConnector connector{
+        "127.0.0.1",
+        0,
+        std::make_shared<mf::RfbFrameSource>(scene, screen_shooter, [this] { return screen; }),
+        device_registry,
+        mir::immediate_executor};
+
+    void SetUp() override
+    {
+        connector.start();
+    }
+
+    /// Connect a version 3.8 viewer, returning the framebuffer size it is told
+    auto connect_viewer(Viewer& viewer) -> geom::Size
+    {
+        EXPECT_THAT(viewer.bytes(12), ElementsAreArray("RFB 003.008\n", 12));
+        viewer.send({'R', 'F', 'B', ' ', '0', '0', '3', '.', '0', '0', '8', '\n'});
+
+        auto const security_types = viewer.bytes(viewer.u8());
+        EXPECT_THAT(security_types, Contains(1));
+        viewer.send({1});
+        EXPECT_THAT(viewer.u32(), Eq(0u));
+
+        viewer.send({1});
+        int const width = viewer.u16(), height = viewer.u16();
+        viewer.bytes(16);
+        EXPECT_THAT(viewer.bytes(viewer.u32()), ElementsAreArray("Mir", 3));
+
+        // SetEncodings: raw only
+        viewer.send({2, 0, 0, 1, 0, 0, 0, 0});
+        return {width, height};
+    }
+};
+}
+
+TEST_F(RfbConnector, listens_on_a_free_port)
+{
+    EXPECT_THAT(connector.port(), Gt(0));
+    EXPECT_FALSE(connector.socket_name().is_set());
+}
+
+TEST_F(RfbConnector, refuses_addresses_other_machines_can_reach)
+{
+    for (auto const address : {"0.0.0.0", "::", "192.0.2.1", "::ffff:192.0.2.1"})
+    {
+        EXPECT_THROW(
+            (mf::RfbConnector{
+                address,
+                0,
+                std::make_shared<mf::RfbFrameSource>(scene, screen_shooter, [this] { return screen; }),
+                device_registry,
+                mir::immediate_executor}),
+            std::runtime_error) << address;
+    }
+}
+
+TEST_F(RfbConnector, accepts_loopback_addresses)
+{
+    for (auto const address : {"127.0.0.1", "127.1.2.3", "::1"})
+    {
+        EXPECT_NO_THROW(
+            (mf::RfbConnector{
+                address,
+                0,
+                std::make_shared<mf::RfbFrameSource>(scene, screen_shooter, [this] { return screen; }),
+                device_registry,
+                mir::immediate_executor})) << address;
+    }
+}
+
+TEST_F(RfbConnector, viewer_is_told_the_screen_size)
+{
+    Viewer viewer{connector.port()};
+
+    EXPECT_THAT(connect_viewer(viewer), Eq(screen.size));
+}
+
+TEST_F(RfbConnector, first_update_covers_the_requested_area)
+{
+    Viewer viewer{connector.port()};
+    connect_viewer(viewer);
+
+    geom::Rectangle const requested{{10, 20}, {150, 50}};
+    viewer.request_update(false, requested);
+    auto const rects = viewer.read_update();
+
+    // Whole tiles are sent, so the update may cover more than was requested
+    int covered{0};
+    for (auto const& rect : rects)
+    {
+        EXPECT_THAT(intersection_of(rect.area, screen), Eq(rect.area));
+        EXPECT_THAT(rect.pixels, Each(background & 0x00ffffff));
+        auto const requested_part = intersection_of(rect.area, requested);
+        covered += requested_part.size.width.as_int() * requested_part.size.height.as_int();
+    }
+    EXPECT_THAT(covered, Eq(150 * 50));
+}
+
+TEST_F(RfbConnector, incremental_update_sends_only_changed_tiles)
+{
+    Viewer viewer{connector.port()};
+    connect_viewer(viewer);
+    viewer.request_update(false, screen);
+    viewer.read_update();
+
+    geom::Rectangle const changed{{70, 10}, {5, 5}};
+    screen_shooter->highlight_area(changed);
+    viewer.request_update(true, screen);
+    ASSERT_THAT(scene->observer, NotNull());
+    scene->observer->scene_changed();
+    auto const rects = viewer.read_update();
+
+    ASSERT_THAT(rects.size(), Eq(1u));
+    EXPECT_THAT(rects[0].area, Eq(geom::Rectangle{{64, 0}, {64, 64}}));
+    auto const& pixels = rects[0].pixels;
+    EXPECT_THAT(std::count(pixels.begin(), pixels.end(), highlight & 0x00ffffff), Eq(25));
+    EXPECT_THAT(pixels[10 * 64 + 6], Eq(highlight & 0x00ffffff));
+}
+
+TEST_F(RfbConnector, viewer_asking_for_an_unusable_pixel_format_is_disconnected)
+{
+    Viewer viewer{connector.port()};
+    connect_viewer(viewer);
+
+    // SetPixelFormat: 32bpp, depth 24, little-endian, true colour, red shifted past the pixel
+    viewer.send({0, 0, 0, 0, 32, 24, 0, 1, 0, 255, 0, 255, 0, 255, 40, 8, 0, 0, 0, 0});
+    viewer.request_update(false, screen);
+
+    EXPECT_THROW(viewer.bytes(1), std::runtime_error);
+}
+
+TEST_F(RfbConnector, stopping_disconnects_viewers)
+{
+    Viewer viewer{connector.port()};
+    connect_viewer(viewer);
+
+    connector.stop();
+
+    EXPECT_THROW(viewer.bytes(1), std::runtime_error);
+}
@@ -0,0 +1,297 @@
+/*
+ * Copyright © 2022 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/frontend_rfb/rfb_encoder.h"
+#include "src/server/frontend_rfb/rfb_framebuffer.h"
+#include "mir/executor.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <zlib.h>
+
+#include <stdexcept>
+
+namespace mf = mir::frontend;
+namespace geom = mir::geometry;
+
+using namespace testing;
+
+namespace
+{
+/// Reads the big-endian fields of an encoded update
+struct Reader
+{
+    std::vector<uint8_t> const& data;
+    size_t offset{0};
+
+    auto u8() -> uint8_t { return data.at(offset++); }
+    auto u16() -> uint16_t { auto const high = u8(); return high << 8 | u8(); }
+    auto u32() -> uint32_t { auto const high = u16(); return uint32_t{high} << 16 | u16(); }
+
+    auto bytes(size_t count) -> std::vector<uint8_t>
+    {
+        if (offset + count > data.size())
+        {
+            throw std::out_of_range{"Read past the end of the update"};
+        }
+        std::vector<uint8_t> result(data.begin() + offset, data.begin() + offset + count);
+        offset += count;
+        return result;
+    }
+
+    auto rect_header() -> std::pair<geom::Rectangle, int32_t>
+    {
+        int const x = u16(), y = u16(), width = u16(), height = u16();
+        return {{{x, y}, {width, height}}, static_cast<int32_t>(u32())};
+    }
+
+    auto compact_length() -> size_t
+    {
+        size_t length{0};
+        for (auto i = 0; i != 3; ++i)
+        {
+            auto const byte = u8();
+            length |= size_t{i == 2 ? byte : uint8_t(byte & 0x7fu)} << (7 * i);
+            if (i == 2 || !(byte & 0x80))
+            {
+                break;
+            }
+        }
+        return length;
+    }
+};
+
+/// One of the client's persistent inflate streams
+struct Inflater
+{
+    Inflater() { inflateInit(&stream); }
+    ~Inflater() { inflateEnd(&stream); }
+
+    auto inflate(std::vector<uint8_t> input, size_t expected) -> std::vector<uint8_t>
+    {
+        std::vector<uint8_t> output(expected);
+        stream.next_in = input.data();
+        stream.avail_in = input.size();
+        stream.next_out = output.data();
+        stream.avail_out = output.size();
+        ::inflate(&stream, Z_SYNC_FLUSH);
+        output.resize(expected - stream.avail_out);
+        return output;
+    }
+
+    z_stream stream{};
+};
+
+auto patterned_frame(geom::Size size) -> std::unique_ptr<mf::RfbFramebuffer>
+{
+    auto frame = std::make_unique<mf::RfbFramebuffer>(size);
+    auto const mapping = frame->map_writeable();
+    auto const pixels = reinterpret_cast<uint32_t*>(mapping->data());
+    for (auto i = 0u; i != mapping->len() / sizeof(uint32_t); ++i)
+    {
+        pixels[i] = 0xff000000 | (i * 0x010203);
+    }
+    return frame;
+}
+
+/// The pixels of \a rect as the client sees them: top-down rows of little-endian xRGB
+auto expected_pixels(mf::RfbFramebuffer const& frame, geom::Rectangle const& rect, bool compact) -> std::vector<uint8_t>
+{
+    std::vector<uint8_t> result;
+    for (auto y = rect.top().as_int(); y != rect.bottom().as_int(); ++y)
+    {
+        for (auto x = rect.left().as_int(); x != rect.right().as_int(); ++x)
+        {
+            auto const pixel = frame.row(y)[x];
+            if (compact)
+            {
+                result.insert(result.end(), {uint8_t(pixel >> 16), uint8_t(pixel >> 8), uint8_t(pixel)});
+            }
+            else
+            {
+                result.insert(result.end(), {uint8_t(pixel), uint8_t(pixel >> 8), uint8_t(pixel >> 16), uint8_t(pixel >> 24)});
+            }
+        }
+    }
+    return result;
+}
+
+struct RfbEncoder : Test
+{
+    mf::RfbEncoder encoder{mir::immediate_executor};
+    std::unique_ptr<mf::RfbFramebuffer> const frame_ptr{patterned_frame({64, 48})};
+    mf::RfbFramebuffer const& frame{*frame_ptr};
+    std::vector<uint8_t> out;
+};
+}
+
+TEST_F(RfbEncoder, uses_the_first_supported_encoding)
+{
+    encoder.set_encodings({16, mf::rfb_encoding::desktop_size, mf::rfb_encoding::tight, mf::rfb_encoding::zlib});
+
+    EXPECT_THAT(encoder.encoding(), Eq(mf::rfb_encoding::tight));
+    EXPECT_TRUE(encoder.supports_desktop_size());
+}
+
+TEST_F(RfbEncoder, falls_back_to_raw)
+{
+    encoder.set_encodings({16, 5});
+
+    EXPECT_THAT(encoder.encoding(), Eq(mf::rfb_encoding::raw));
+    EXPECT_FALSE(encoder.supports_desktop_size());
+}
+
+TEST_F(RfbEncoder, rejects_colour_maps)
+{
+    mf::RfbPixelFormat format;
+    format.true_colour = false;
+
+    EXPECT_THROW(encoder.set_pixel_format(format), std::invalid_argument);
+}
+
+TEST_F(RfbEncoder, rejects_channels_that_do_not_fit_in_the_pixel)
+{
+    mf::RfbPixelFormat format;
+    format.red_shift = 40;
+
+    EXPECT_THROW(encoder.set_pixel_format(format), std::invalid_argument);
+
+    format.red_shift = 16;
+    format.bits_per_pixel = 16;
+    format.depth = 16;
+
+    EXPECT_THROW(encoder.set_pixel_format(format), std::invalid_argument);
+}
+
+TEST_F(RfbEncoder, rejects_channels_without_any_levels)
+{
+    mf::RfbPixelFormat format;
+    format.green_max = 0;
+
+    EXPECT_THROW(encoder.set_pixel_format(format), std::invalid_argument);
+}
+
+TEST_F(RfbEncoder, raw_rects_hold_the_pixels)
+{
+    geom::Rectangle const rect{{3, 5}, {10, 7}};
+    encoder.encode(frame, {rect}, out);
+
+    Reader reader{out};
+    EXPECT_THAT(reader.rect_header(), Eq(std::pair{rect, mf::rfb_encoding::raw}));
+    EXPECT_THAT(reader.bytes(4 * 10 * 7), Eq(expected_pixels(frame, rect, false)));
+    EXPECT_THAT(reader.offset, Eq(out.size()));
+}
+
+TEST_F(RfbEncoder, raw_rects_are_converted_to_the_client_format)
+{
+    mf::RfbPixelFormat format;
+    format.bits_per_pixel = 16;
+    format.depth = 16;
+    format.big_endian = true;
+    format.red_max = 31;
+    format.green_max = 63;
+    format.blue_max = 31;
+    format.red_shift = 11;
+    format.green_shift = 5;
+    format.blue_shift = 0;
+    encoder.set_pixel_format(format);
+
+    geom::Rectangle const rect{{0, 0}, {1, 1}};
+    encoder.encode(frame, {rect}, out);
+
+    Reader reader{out};
+    reader.rect_header();
+    auto const pixel = frame.row(0)[0];
+    uint16_t const expected =
+        ((pixel >> 16 & 0xff) * 31 + 127) / 255 << 11 |
+        ((pixel >> 8 & 0xff) * 63 + 127) / 255 << 5 |
+        ((pixel & 0xff) * 31 + 127) / 255;
+    EXPECT_THAT(reader.u16(), Eq(expected));
+}
+
+TEST_F(RfbEncoder, zlib_rects_share_one_stream)
+{
+    encoder.set_encodings({mf::rfb_encoding::zlib});
+    std::vector<geom::Rectangle> const rects{{{0, 0}, {32, 16}}, {{32, 16}, {32, 32}}};
+    encoder.encode(frame, rects, out);
+
+    Reader reader{out};
+    Inflater inflater;
+    for (auto const& rect : rects)
+    {
+        EXPECT_THAT(reader.rect_header(), Eq(std::pair{rect, mf::rfb_encoding::zlib}));
+        auto const expected = expected_pixels(frame, rect, false);
+        EXPECT_THAT(inflater.inflate(reader.bytes(reader.u32()), expected.size()), Eq(expected));
+    }
+    EXPECT_THAT(reader.offset, Eq(out.size()));
+}
+
+TEST_F(RfbEncoder, tight_fills_uniform_rects)
+{
+    mf::RfbFramebuffer uniform{{16, 16}};
+    {
+        auto const mapping = uniform.map_writeable();
+        auto const pixels = reinterpret_cast<uint32_t*>(mapping->data());
+        std::fill(pixels, pixels + 16 * 16, 0xff123456);
+    }
+    encoder.set_encodings({mf::rfb_encoding::tight});
+    encoder.encode(uniform, {{{0, 0}, {16, 16}}}, out);
+
+    Reader reader{out};
+    reader.rect_header();
+    EXPECT_THAT(reader.u8(), Eq(0x80));
+    EXPECT_THAT(reader.bytes(3), ElementsAre(0x12, 0x34, 0x56));
+    EXPECT_THAT(reader.offset, Eq(out.size()));
+}
+
+TEST_F(RfbEncoder, tight_rects_are_spread_over_streams_in_order)
+{
+    encoder.set_encodings({mf::rfb_encoding::tight, mf::rfb_encoding::compress_level_0 + 1});
+    std::vector<geom::Rectangle> const rects{
+        {{0, 0}, {16, 16}}, {{16, 0}, {16, 16}}, {{32, 0}, {16, 16}},
+        {{48, 0}, {16, 16}}, {{0, 16}, {64, 16}}, {{0, 32}, {2, 1}}};
+    encoder.encode(frame, rects, out);
+
+    Reader reader{out};
+    std::array<Inflater, 4> inflaters;
+    for (auto i = 0u; i != rects.size(); ++i)
+    {
+        EXPECT_THAT(reader.rect_header(), Eq(std::pair{rects[i], mf::rfb_encoding::tight}));
+        auto const stream = i % 4;
+        EXPECT_THAT(reader.u8(), Eq(stream << 4));
+
+        auto const expected = expected_pixels(frame, rects[i], true);
+        if (expected.size() < 12)
+        {
+            EXPECT_THAT(reader.bytes(expected.size()), Eq(expected));
+        }
+        else
+        {
+            auto const compressed = reader.bytes(reader.compact_length());
+            EXPECT_THAT(inflaters[stream].inflate(compressed, expected.size()), Eq(expected));
+        }
+    }
+    EXPECT_THAT(reader.offset, Eq(out.size()));
+}
+
+TEST_F(RfbEncoder, desktop_size_is_a_pseudo_rect)
+{
+    mf::RfbEncoder::encode_desktop_size({1280, 1024}, out);
+
+    Reader reader{out};
+    EXPECT_THAT(reader.rect_header(), Eq(std::pair{geom::Rectangle{{0, 0}, {1280, 1024}}, mf::rfb_encoding::desktop_size}));
+}
@@ -0,0 +1,119 @@
+/*
+ * Copyright © 2022 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/frontend_rfb/rfb_framebuffer.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <cstring>
+
+namespace mf = mir::frontend;
+namespace geom = mir::geometry;
+
+using namespace testing;
+
+namespace
+{
+auto const tile = mf::RfbFramebuffer::tile_size;
+
+/// Set a pixel, given in top-down coordinates as the encoders read them
+void set_pixel(mf::RfbFramebuffer& frame, geom::Point point, uint32_t value)
+{
+    auto const mapping = frame.map_writeable();
+    auto const height = frame.size().height.as_int();
+    auto const offset =
+        (height - 1 - point.y.as_int()) * frame.stride().as_int() + point.x.as_int() * sizeof(uint32_t);
+    memcpy(mapping->data() + offset, &value, sizeof value);
+}
+
+auto filled_frame(geom::Size size, uint32_t value) -> std::shared_ptr<mf::RfbFramebuffer>
+{
+    auto const frame = std::make_shared<mf::RfbFramebuffer>(size);
+    auto const mapping = frame->map_writeable();
+    auto const pixels = reinterpret_cast<uint32_t*>(mapping->data());
+    std::fill(pixels, pixels + mapping->len() / sizeof(uint32_t), value);
+    return frame;
+}
+}
+
+TEST(RfbFramebuffer, rows_are_read_top_down)
+{
+    auto const frame = filled_frame({10, 5}, 0);
+    set_pixel(*frame, {3, 0}, 0xff123456);
+    set_pixel(*frame, {7, 4}, 0xff654321);
+
+    EXPECT_THAT(frame->row(0)[3], Eq(0xff123456u));
+    EXPECT_THAT(frame->row(4)[7], Eq(0xff654321u));
+}
+
+TEST(RfbFramebuffer, tiles_cover_the_frame_clipped_at_the_edges)
+{
+    mf::RfbFramebuffer frame{{2 * tile + 10, tile + 1}};
+    frame.hash_tiles(nullptr, std::nullopt);
+
+    EXPECT_THAT(frame.tiles_across(), Eq(3));
+    EXPECT_THAT(frame.tile_hashes().size(), Eq(6u));
+    EXPECT_THAT(frame.tile_area(2), Eq(geom::Rectangle{{2 * tile, 0}, {10, tile}}));
+    EXPECT_THAT(frame.tile_area(5), Eq(geom::Rectangle{{2 * tile, tile}, {10, 1}}));
+}
+
+TEST(RfbFramebuffer, identical_frames_have_no_changed_tiles)
+{
+    auto const first = filled_frame({3 * tile, 2 * tile + 5}, 0xff00ff00);
+    auto const second = filled_frame({3 * tile, 2 * tile + 5}, 0xff00ff00);
+    first->hash_tiles(nullptr, std::nullopt);
+    second->hash_tiles(nullptr, std::nullopt);
+
+    EXPECT_THAT(changed_tiles(first->tile_hashes(), *second), IsEmpty());
+}
+
+TEST(RfbFramebuffer, a_changed_pixel_changes_only_its_tile)
+{
+    geom::Size const size{5 * tile + 3, 2 * tile + 7};
+    auto const first = filled_frame(size, 0xff000000);
+    auto const second = filled_frame(size, 0xff000000);
+    set_pixel(*second, {4 * tile + 2, tile + 6}, 0xff000001);
+    first->hash_tiles(nullptr, std::nullopt);
+    second->hash_tiles(nullptr, std::nullopt);
+
+    EXPECT_THAT(changed_tiles(first->tile_hashes(), *second), ElementsAre(6 + 4));
+}
+
+TEST(RfbFramebuffer, tiles_outside_the_damage_keep_their_previous_hashes)
+{
+    geom::Size const size{4 * tile, 4 * tile};
+    auto const previous = filled_frame(size, 0xff000000);
+    previous->hash_tiles(nullptr, std::nullopt);
+
+    // Outside the damage nothing is rehashed, so even a change there goes unnoticed
+    auto const next = filled_frame(size, 0xff000000);
+    set_pixel(*next, {tile + 1, tile + 1}, 0xffffffff);
+    set_pixel(*next, {3 * tile + 1, 3 * tile + 1}, 0xffffffff);
+    next->hash_tiles(previous.get(), geom::Rectangle{{tile, tile}, {1, 1}});
+
+    EXPECT_THAT(changed_tiles(previous->tile_hashes(), *next), ElementsAre(4 + 1));
+}
+
+TEST(RfbFramebuffer, hashes_from_a_different_size_change_every_tile)
+{
+    auto const previous = filled_frame({tile, tile}, 0xff000000);
+    auto const next = filled_frame({2 * tile, tile}, 0xff000000);
+    previous->hash_tiles(nullptr, std::nullopt);
+    next->hash_tiles(previous.get(), geom::Rectangle{{0, 0}, {1, 1}});
+
+    EXPECT_THAT(changed_tiles(previous->tile_hashes(), *next), ElementsAre(0, 1));
+}
@@ -0,0 +1,112 @@
+/*
+ * Copyright © 2022 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/frontend_wayland/configure_throttle.h"
+
+#include <gtest/gtest.h>
+
+namespace mf = mir::frontend;
+
+using namespace testing;
+
+namespace
+{
+struct ConfigureThrottle : Test
+{
+    mf::ConfigureThrottle throttle;
+};
+}
+
+TEST_F(ConfigureThrottle, a_sent_configure_is_outstanding_until_acked_and_committed)
+{
+    throttle.configure_sent(7);
+    EXPECT_TRUE(throttle.configure_outstanding());
+
+    throttle.configure_acked(7);
+    EXPECT_TRUE(throttle.configure_outstanding()) << "an ack takes effect on the next commit";
+
+    throttle.committed();
+    EXPECT_FALSE(throttle.configure_outstanding());
+}
+
+TEST_F(ConfigureThrottle, a_commit_without_an_ack_leaves_the_configure_outstanding)
+{
+    throttle.configure_sent(7);
+
+    throttle.committed();
+
+    EXPECT_TRUE(throttle.configure_outstanding());
+}
+
+TEST_F(ConfigureThrottle, acking_an_earlier_configure_leaves_the_last_one_outstanding)
+{
+    throttle.configure_sent(7);
+    throttle.configure_sent(8);
+
+    throttle.configure_acked(7);
+    throttle.committed();
+
+    EXPECT_TRUE(throttle.configure_outstanding());
+
+    throttle.configure_acked(8);
+    throttle.committed();
+
+    EXPECT_FALSE(throttle.configure_outstanding());
+}
+
+TEST_F(ConfigureThrottle, resizes_are_not_held_back_outside_an_interactive_resize)
+{
+    throttle.configure_sent(7);
+
+    EXPECT_FALSE(throttle.hold_back_resize(false));
+    EXPECT_FALSE(throttle.resize_due());
+}
+
+TEST_F(ConfigureThrottle, resizes_are_not_held_back_when_the_client_has_caught_up)
+{
+    throttle.configure_sent(7);
+    throttle.configure_acked(7);
+    throttle.committed();
+
+    EXPECT_FALSE(throttle.hold_back_resize(true));
+}
+
+TEST_F(ConfigureThrottle, a_resize_during_an_interactive_resize_is_held_back_until_the_client_acks_and_commits)
+{
+    throttle.configure_sent(7);
+
+    EXPECT_TRUE(throttle.hold_back_resize(true));
+    EXPECT_TRUE(throttle.hold_back_resize(true)) << "further resizes are folded into the one held back";
+    EXPECT_FALSE(throttle.resize_due());
+
+    throttle.configure_acked(7);
+    EXPECT_FALSE(throttle.resize_due());
+
+    throttle.committed();
+    EXPECT_TRUE(throttle.resize_due());
+}
+
+TEST_F(ConfigureThrottle, sending_a_configure_sends_the_held_back_resize)
+{
+    throttle.configure_sent(7);
+    throttle.hold_back_resize(true);
+
+    throttle.configure_sent(8);
+    throttle.configure_acked(8);
+    throttle.committed();
+
+    EXPECT_FALSE(throttle.resize_due());
+}
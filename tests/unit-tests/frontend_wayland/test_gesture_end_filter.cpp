@@ -0,0 +1,188 @@
+/*
+ * Copyright © 2022 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/frontend_wayland/gesture_end_filter.h"
+
+#include "mir/events/event_builders.h"
+#include "mir/executor.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+namespace mf = mir::frontend;
+namespace mev = mir::events;
+
+using namespace testing;
+using namespace std::chrono_literals;
+
+namespace
+{
+MirInputDeviceId const pointer_device{3};
+MirInputDeviceId const touch_device{4};
+MirInputDeviceId const keyboard_device{5};
+
+auto pointer_event(MirInputDeviceId device, MirPointerAction action, MirPointerButtons buttons) -> mir::EventUPtr
+{
+    return mev::make_pointer_event(device, 0ns, {}, mir_input_event_modifier_none, action, buttons, 0, 0, 0, 0, 0, 0);
+}
+
+auto primary_button_down() -> mir::EventUPtr
+{
+    return pointer_event(pointer_device, mir_pointer_action_button_down, mir_pointer_button_primary);
+}
+
+auto touch_event(std::vector<MirTouchAction> const& actions) -> mir::EventUPtr
+{
+    auto ev = mev::make_touch_event(touch_device, 0ns, {}, mir_input_event_modifier_none);
+    MirTouchId id{0};
+    for (auto const action : actions)
+    {
+        mev::add_touch(*ev, id++, action, mir_touch_tooltype_finger, 0, 0, 1, 1, 1, 1);
+    }
+    return ev;
+}
+
+auto key_event(MirKeyboardAction action) -> mir::EventUPtr
+{
+    return mev::make_key_event(keyboard_device, 0ns, {}, action, 0, 0, mir_input_event_modifier_none);
+}
+
+/// Queues spawned work, as the Wayland executor does
+struct QueueingExecutor : mir::Executor
+{
+    void spawn(std::function<void()>&& work) override
+    {
+        queued.push_back(std::move(work));
+    }
+
+    void run()
+    {
+        auto const work = std::move(queued);
+        queued.clear();
+        for (auto const& w : work)
+        {
+            w();
+        }
+    }
+
+    std::vector<std::function<void()>> queued;
+};
+
+struct GestureEndFilter : Test
+{
+    auto filter_for(mir::EventUPtr const& gesture_start) -> std::shared_ptr<mf::GestureEndFilter>
+    {
+        return std::make_shared<mf::GestureEndFilter>(
+            mir_event_get_input_event(gesture_start.get()),
+            executor,
+            [this] { ++ends; });
+    }
+
+    QueueingExecutor executor;
+    int ends{0};
+};
+}
+
+TEST_F(GestureEndFilter, pointer_gesture_ends_when_the_buttons_are_released)
+{
+    auto const filter = filter_for(primary_button_down());
+
+    filter->handle(*pointer_event(pointer_device, mir_pointer_action_motion, mir_pointer_button_primary));
+    executor.run();
+    EXPECT_THAT(ends, Eq(0));
+
+    filter->handle(*pointer_event(pointer_device, mir_pointer_action_button_up, 0));
+    executor.run();
+    EXPECT_THAT(ends, Eq(1));
+}
+
+TEST_F(GestureEndFilter, pointer_gesture_does_not_end_while_any_button_is_held)
+{
+    auto const filter = filter_for(primary_button_down());
+
+    filter->handle(*pointer_event(
+        pointer_device, mir_pointer_action_button_down, mir_pointer_button_primary | mir_pointer_button_secondary));
+    filter->handle(*pointer_event(pointer_device, mir_pointer_action_button_up, mir_pointer_button_secondary));
+    executor.run();
+
+    EXPECT_THAT(ends, Eq(0));
+}
+
+TEST_F(GestureEndFilter, key_presses_and_repeats_do_not_end_a_pointer_gesture)
+{
+    auto const filter = filter_for(primary_button_down());
+
+    filter->handle(*key_event(mir_keyboard_action_down));
+    filter->handle(*key_event(mir_keyboard_action_repeat));
+    filter->handle(*key_event(mir_keyboard_action_up));
+    executor.run();
+
+    EXPECT_THAT(ends, Eq(0));
+}
+
+TEST_F(GestureEndFilter, input_from_other_pointers_does_not_end_a_pointer_gesture)
+{
+    auto const filter = filter_for(primary_button_down());
+
+    filter->handle(*pointer_event(pointer_device + 10, mir_pointer_action_motion, 0));
+    executor.run();
+
+    EXPECT_THAT(ends, Eq(0));
+}
+
+TEST_F(GestureEndFilter, touch_gesture_ends_when_every_touch_is_lifted)
+{
+    auto const filter = filter_for(touch_event({mir_touch_action_down}));
+
+    filter->handle(*touch_event({mir_touch_action_change, mir_touch_action_down}));
+    filter->handle(*touch_event({mir_touch_action_up, mir_touch_action_change}));
+    executor.run();
+    EXPECT_THAT(ends, Eq(0));
+
+    filter->handle(*touch_event({mir_touch_action_up}));
+    executor.run();
+    EXPECT_THAT(ends, Eq(1));
+}
+
+TEST_F(GestureEndFilter, gesture_ends_only_once)
+{
+    auto const filter = filter_for(primary_button_down());
+
+    filter->handle(*pointer_event(pointer_device, mir_pointer_action_button_up, 0));
+    filter->handle(*pointer_event(pointer_device, mir_pointer_action_motion, 0));
+    executor.run();
+
+    EXPECT_THAT(ends, Eq(1));
+}
+
+TEST_F(GestureEndFilter, end_is_dropped_if_the_filter_is_dropped_before_it_runs)
+{
+    auto filter = filter_for(primary_button_down());
+
+    filter->handle(*pointer_event(pointer_device, mir_pointer_action_button_up, 0));
+    filter.reset();
+    executor.run();
+
+    EXPECT_THAT(ends, Eq(0));
+}
+
+TEST_F(GestureEndFilter, does_not_consume_events)
+{
+    auto const filter = filter_for(primary_button_down());
+
+    EXPECT_FALSE(filter->handle(*pointer_event(pointer_device, mir_pointer_action_motion, mir_pointer_button_primary)));
+    EXPECT_FALSE(filter->handle(*pointer_event(pointer_device, mir_pointer_action_button_up, 0)));
+}
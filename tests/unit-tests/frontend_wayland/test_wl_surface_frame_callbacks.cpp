@@ -0,0 +1,142 @@
+/*
+ * Copyright © 2022 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/frontend_wayland/wl_surface.h"
+#include "src/server/frontend_wayland/frame_executor.h"
+#include "mir/test/doubles/fake_alarm_factory.h"
+#include "mir/test/doubles/mock_buffer_stream.h"
+#include "mir/test/doubles/stub_surface.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+namespace mf = mir::frontend;
+namespace mtd = mir::test::doubles;
+
+using namespace testing;
+using namespace std::chrono_literals;
+
+namespace
+{
+struct SceneSurface : mtd::StubSurface
+{
+    bool visible() const override { return shown; }
+    int query(MirWindowAttrib attrib) const override
+    {
+        return attrib == mir_window_attrib_visibility ? visibility : 0;
+    }
+
+    bool shown{true};
+    MirWindowVisibility visibility{mir_window_visibility_exposed};
+};
+
+struct WlSurfaceFrameCallbacks : Test
+{
+    NiceMock<mtd::MockBufferStream> stream;
+    mtd::FakeAlarmFactory alarm_factory;
+    mf::FrameExecutor frame_executor{alarm_factory};
+    std::shared_ptr<SceneSurface> const scene_surface{std::make_shared<SceneSurface>()};
+
+    std::function<void()> repaint;
+    int sends{0};
+
+    void SetUp() override
+    {
+        ON_CALL(stream, on_next_repaint(_)).WillByDefault(SaveArg<0>(&repaint));
+    }
+
+    void commit(bool new_buffer)
+    {
+        mf::pace_frame_callbacks(stream, frame_executor, scene_surface, new_buffer, [this] { ++sends; });
+    }
+};
+}
+
+TEST_F(WlSurfaceFrameCallbacks, callbacks_for_a_new_buffer_are_sent_when_the_surface_is_repainted)
+{
+    commit(true);
+    ASSERT_TRUE(repaint);
+    EXPECT_THAT(sends, Eq(0));
+
+    repaint();
+
+    EXPECT_THAT(sends, Eq(1));
+}
+
+TEST_F(WlSurfaceFrameCallbacks, callbacks_for_a_new_buffer_are_not_sent_early_while_a_repaint_is_pending)
+{
+    commit(true);
+
+    alarm_factory.advance_by(17ms);
+    alarm_factory.advance_by(500ms);
+
+    EXPECT_THAT(sends, Eq(0));
+}
+
+TEST_F(WlSurfaceFrameCallbacks, callbacks_for_a_new_buffer_are_sent_after_a_second_if_no_repaint_comes)
+{
+    commit(true);
+
+    alarm_factory.advance_by(999ms);
+    EXPECT_THAT(sends, Eq(0));
+
+    alarm_factory.advance_by(2ms);
+    EXPECT_THAT(sends, Eq(1));
+}
+
+TEST_F(WlSurfaceFrameCallbacks, callbacks_for_an_occluded_surface_are_throttled_to_once_a_second)
+{
+    scene_surface->visibility = mir_window_visibility_occluded;
+
+    commit(false);
+
+    alarm_factory.advance_by(17ms);
+    EXPECT_THAT(sends, Eq(0));
+
+    alarm_factory.advance_by(984ms);
+    EXPECT_THAT(sends, Eq(1));
+}
+
+TEST_F(WlSurfaceFrameCallbacks, callbacks_for_a_hidden_surface_are_throttled_to_once_a_second)
+{
+    scene_surface->shown = false;
+
+    commit(true);
+
+    alarm_factory.advance_by(500ms);
+    EXPECT_THAT(sends, Eq(0));
+
+    alarm_factory.advance_by(501ms);
+    EXPECT_THAT(sends, Eq(1));
+}
+
+TEST_F(WlSurfaceFrameCallbacks, callbacks_for_a_commit_without_a_buffer_are_sent_after_a_frame)
+{
+    commit(false);
+
+    alarm_factory.advance_by(17ms);
+
+    EXPECT_THAT(sends, Eq(1));
+}
+
+TEST_F(WlSurfaceFrameCallbacks, callbacks_for_a_surface_outside_the_scene_are_sent_after_a_frame)
+{
+    mf::pace_frame_callbacks(stream, frame_executor, std::nullopt, true, [this] { ++sends; });
+
+    alarm_factory.advance_by(17ms);
+
+    EXPECT_THAT(sends, Eq(1));
+}
@@ -0,0 +1,111 @@
+/*
+ * Copyright © 2022 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/frontend_xwayland/xwayland_idle_timeout.h"
+
+#include "mir/test/doubles/fake_alarm_factory.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+namespace mf = mir::frontend;
+namespace mtd = mir::test::doubles;
+
+using namespace testing;
+using namespace std::chrono_literals;
+
+namespace
+{
+struct XWaylandIdleTimeout : Test
+{
+    mtd::FakeAlarmFactory alarm_factory;
+    int idle_count{0};
+    mf::XWaylandIdleTimeout idle_timeout{alarm_factory, 10s, [this]() { ++idle_count; }};
+};
+}
+
+TEST_F(XWaylandIdleTimeout, is_idle_once_there_have_been_no_windows_for_the_timeout)
+{
+    alarm_factory.advance_by(9s);
+    EXPECT_THAT(idle_count, Eq(0));
+    EXPECT_FALSE(idle_timeout.idle());
+
+    alarm_factory.advance_by(2s);
+    EXPECT_THAT(idle_count, Eq(1));
+    EXPECT_TRUE(idle_timeout.idle());
+}
+
+TEST_F(XWaylandIdleTimeout, is_not_idle_while_there_are_windows)
+{
+    idle_timeout.window_count_changed(1);
+    idle_timeout.window_count_changed(2);
+
+    alarm_factory.advance_by(1min);
+    EXPECT_THAT(idle_count, Eq(0));
+    EXPECT_FALSE(idle_timeout.idle());
+}
+
+TEST_F(XWaylandIdleTimeout, timeout_restarts_when_the_last_window_is_closed)
+{
+    alarm_factory.advance_by(5s);
+    idle_timeout.window_count_changed(1);
+    alarm_factory.advance_by(5s);
+    idle_timeout.window_count_changed(0);
+
+    alarm_factory.advance_by(9s);
+    EXPECT_THAT(idle_count, Eq(0));
+
+    alarm_factory.advance_by(2s);
+    EXPECT_THAT(idle_count, Eq(1));
+    EXPECT_TRUE(idle_timeout.idle());
+}
+
+TEST_F(XWaylandIdleTimeout, is_not_idle_if_a_window_is_created_after_the_timeout_expires)
+{
+    alarm_factory.advance_by(11s);
+    ASSERT_THAT(idle_count, Eq(1));
+
+    // As happens if a client creates a window before the connector gets round to checking
+    idle_timeout.window_count_changed(1);
+
+    EXPECT_FALSE(idle_timeout.idle());
+}
+
+TEST_F(XWaylandIdleTimeout, timeout_restarts_when_a_client_connects_after_it_expires)
+{
+    alarm_factory.advance_by(11s);
+    ASSERT_THAT(idle_count, Eq(1));
+
+    idle_timeout.client_connected();
+    EXPECT_FALSE(idle_timeout.idle());
+
+    alarm_factory.advance_by(9s);
+    EXPECT_THAT(idle_count, Eq(1));
+
+    alarm_factory.advance_by(2s);
+    EXPECT_THAT(idle_count, Eq(2));
+    EXPECT_TRUE(idle_timeout.idle());
+}
+
+TEST_F(XWaylandIdleTimeout, a_client_connecting_while_there_are_windows_does_not_start_the_timeout)
+{
+    idle_timeout.window_count_changed(1);
+
+    idle_timeout.client_connected();
+    alarm_factory.advance_by(1min);
+
+    EXPECT_THAT(idle_count, Eq(0));
+}
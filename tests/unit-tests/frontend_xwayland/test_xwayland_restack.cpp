@@ -0,0 +1,164 @@
+/*
+ * Copyright © 2022 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/frontend_xwayland/xwayland_restack.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <algorithm>
+#include <numeric>
+#include <random>
+
+namespace mf = mir::frontend;
+
+using namespace testing;
+
+namespace
+{
+/// Applies restack operations to a stack of windows (bottom to top) the way the X server would
+void apply(std::vector<mf::RestackOperation> const& operations, std::vector<xcb_window_t>& stack)
+{
+    for (auto const& operation : operations)
+    {
+        std::erase(stack, operation.window);
+        auto sibling = std::find(stack.begin(), stack.end(), operation.sibling);
+        ASSERT_THAT(sibling, Ne(stack.end()));
+        if (operation.mode == XCB_STACK_MODE_ABOVE)
+        {
+            ++sibling;
+        }
+        stack.insert(sibling, operation.window);
+    }
+}
+
+/// The windows of \a stack that are in \a windows, in stacking order
+auto order_of(std::vector<xcb_window_t> const& windows, std::vector<xcb_window_t> const& stack)
+    -> std::vector<xcb_window_t>
+{
+    std::vector<xcb_window_t> result;
+    for (auto const window : stack)
+    {
+        if (std::find(windows.begin(), windows.end(), window) != windows.end())
+        {
+            result.push_back(window);
+        }
+    }
+    return result;
+}
+}
+
+TEST(XWaylandRestack, nothing_is_restacked_when_the_order_is_unchanged)
+{
+    std::vector<xcb_window_t> const order{1, 2, 3, 4};
+
+    EXPECT_THAT(mf::restack_operations(order, order), IsEmpty());
+}
+
+TEST(XWaylandRestack, raising_one_window_restacks_only_that_window)
+{
+    std::vector<xcb_window_t> const old_order{1, 2, 3, 4, 5};
+    std::vector<xcb_window_t> const new_order{1, 3, 4, 5, 2};
+
+    EXPECT_THAT(
+        mf::restack_operations(old_order, new_order),
+        ElementsAre(mf::RestackOperation{2, 5, XCB_STACK_MODE_ABOVE}));
+}
+
+TEST(XWaylandRestack, lowering_the_bottom_window_of_the_rest_restacks_it_below)
+{
+    std::vector<xcb_window_t> const old_order{1, 2, 3, 4};
+    std::vector<xcb_window_t> const new_order{4, 1, 2, 3};
+
+    EXPECT_THAT(
+        mf::restack_operations(old_order, new_order),
+        ElementsAre(mf::RestackOperation{4, 1, XCB_STACK_MODE_BELOW}));
+}
+
+TEST(XWaylandRestack, everything_is_stacked_when_there_is_no_previous_order)
+{
+    std::vector<xcb_window_t> const new_order{7, 8, 9};
+
+    EXPECT_THAT(
+        mf::restack_operations({}, new_order),
+        ElementsAre(
+            mf::RestackOperation{8, 7, XCB_STACK_MODE_ABOVE},
+            mf::RestackOperation{9, 8, XCB_STACK_MODE_ABOVE}));
+}
+
+TEST(XWaylandRestack, new_windows_are_stacked_next_to_their_neighbours)
+{
+    std::vector<xcb_window_t> const old_order{1, 2, 3};
+    std::vector<xcb_window_t> const new_order{10, 1, 2, 11, 3, 12};
+
+    EXPECT_THAT(
+        mf::restack_operations(old_order, new_order),
+        ElementsAre(
+            mf::RestackOperation{10, 1, XCB_STACK_MODE_BELOW},
+            mf::RestackOperation{11, 2, XCB_STACK_MODE_ABOVE},
+            mf::RestackOperation{12, 3, XCB_STACK_MODE_ABOVE}));
+}
+
+TEST(XWaylandRestack, random_reorderings_are_applied_with_few_operations)
+{
+    std::mt19937 generator{7};
+
+    for (auto round = 0; round != 200; ++round)
+    {
+        // Our windows, interleaved with windows we don't manage (which have IDs from 1000)
+        std::vector<xcb_window_t> old_order(30);
+        std::iota(old_order.begin(), old_order.end(), 1);
+        std::shuffle(old_order.begin(), old_order.end(), generator);
+        std::vector<xcb_window_t> stack;
+        for (auto const window : old_order)
+        {
+            stack.push_back(window);
+            stack.push_back(window + 1000);
+        }
+
+        // Move a few of them, as raising windows and opening menus do
+        auto new_order = old_order;
+        std::uniform_int_distribution<size_t> position{0, new_order.size() - 1};
+        auto const moves = round % 4;
+        for (auto i = 0; i != moves; ++i)
+        {
+            auto const from = position(generator);
+            auto const window = new_order[from];
+            new_order.erase(new_order.begin() + from);
+            new_order.insert(new_order.begin() + position(generator), window);
+        }
+
+        auto const operations = mf::restack_operations(old_order, new_order);
+        apply(operations, stack);
+
+        EXPECT_THAT(order_of(new_order, stack), Eq(new_order));
+        EXPECT_THAT(operations.size(), Le(static_cast<size_t>(moves)));
+    }
+}
+
+TEST(XWaylandRestack, a_restack_we_did_not_send_is_detected)
+{
+    std::vector<xcb_window_t> const order{1, 2, 3, 4};
+
+    EXPECT_TRUE(mf::stacking_consistent_with(order, 3, 2));
+    EXPECT_TRUE(mf::stacking_consistent_with(order, 3, 1));
+    EXPECT_TRUE(mf::stacking_consistent_with(order, 3, 1000));
+    EXPECT_TRUE(mf::stacking_consistent_with(order, 1, XCB_WINDOW_NONE));
+    EXPECT_TRUE(mf::stacking_consistent_with(order, 1000, 4));
+
+    EXPECT_FALSE(mf::stacking_consistent_with(order, 2, 4));
+    EXPECT_FALSE(mf::stacking_consistent_with(order, 3, XCB_WINDOW_NONE));
+}
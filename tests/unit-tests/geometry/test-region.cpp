@@ -0,0 +1,324 @@
+/*
+ * Copyright © 2022 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/geometry/region.h"
+#include "mir/geometry/rectangles.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <bitset>
+#include <functional>
+#include <random>
+
+using namespace mir::geometry;
+using namespace testing;
+
+namespace
+{
+/// The grid the random regions are drawn from, with a margin so that they are also tested off its edges
+int const grid{32};
+int const margin{4};
+int const span{grid + 2 * margin};
+
+/// A region as a plain set of pixels, to check the Region operations against
+using Pixels = std::bitset<span * span>;
+
+auto index(int x, int y) -> size_t
+{
+    return (y + margin) * span + x + margin;
+}
+
+auto pixels_of(Region const& region) -> Pixels
+{
+    Pixels result;
+    for (auto const& rect : region)
+    {
+        for (auto y = rect.top().as_int(); y != rect.bottom().as_int(); ++y)
+        {
+            for (auto x = rect.left().as_int(); x != rect.right().as_int(); ++x)
+            {
+                result.set(index(x, y));
+            }
+        }
+    }
+    return result;
+}
+
+auto pixels_of(Rectangle const& rect) -> Pixels
+{
+    Pixels result;
+    for (auto y = rect.top().as_int(); y < rect.bottom().as_int(); ++y)
+    {
+        for (auto x = rect.left().as_int(); x < rect.right().as_int(); ++x)
+        {
+            result.set(index(x, y));
+        }
+    }
+    return result;
+}
+
+/// Checks the rectangles are in canonical y-x banded form
+void expect_banded(Region const& region)
+{
+    std::vector<Rectangle> const rects(region.begin(), region.end());
+    for (auto i = 0u; i != rects.size(); ++i)
+    {
+        EXPECT_THAT(rects[i].size.width, Gt(Width{0})) << region;
+        EXPECT_THAT(rects[i].size.height, Gt(Height{0})) << region;
+
+        if (i == 0)
+        {
+            continue;
+        }
+
+        auto const& previous = rects[i - 1];
+        if (rects[i].top() == previous.top())
+        {
+            EXPECT_THAT(rects[i].bottom(), Eq(previous.bottom())) << "band with ragged bottom: " << region;
+            EXPECT_THAT(rects[i].left(), Gt(previous.right())) << "touching or unsorted spans: " << region;
+        }
+        else
+        {
+            EXPECT_THAT(rects[i].top(), Ge(previous.bottom())) << "overlapping bands: " << region;
+        }
+    }
+
+    // Bands that meet must differ in their spans, or they should have been merged
+    for (auto band = 0u, next = 0u; band != rects.size(); band = next)
+    {
+        next = band;
+        while (next != rects.size() && rects[next].top() == rects[band].top()) ++next;
+
+        auto after = next;
+        while (after != rects.size() && rects[after].top() == rects[next].top()) ++after;
+
+        if (next != rects.size() && rects[next].top() == rects[band].bottom() && after - next == next - band)
+        {
+            bool same_spans{true};
+            for (auto i = 0u; i != next - band; ++i)
+            {
+                same_spans = same_spans &&
+                    rects[band + i].left() == rects[next + i].left() &&
+                    rects[band + i].right() == rects[next + i].right();
+            }
+            EXPECT_FALSE(same_spans) << "uncoalesced bands: " << region;
+        }
+    }
+}
+
+struct RandomRegions : Test
+{
+    std::mt19937 generator{20221019};
+
+    auto random_rect() -> Rectangle
+    {
+        std::uniform_int_distribution<int> position{-margin, grid};
+        std::uniform_int_distribution<int> length{0, 12};
+        auto const x = position(generator), y = position(generator);
+        return {
+            {x, y},
+            {std::min(length(generator), grid + margin - x), std::min(length(generator), grid + margin - y)}};
+    }
+
+    auto random_region() -> Region
+    {
+        Region result;
+        std::uniform_int_distribution<int> count{0, 8};
+        for (auto n = count(generator); n != 0; --n)
+        {
+            result = union_of(result, random_rect());
+        }
+        return result;
+    }
+
+    int const iterations{500};
+};
+}
+
+TEST(Region, is_empty_by_default)
+{
+    Region const region;
+
+    EXPECT_TRUE(region.empty());
+    EXPECT_THAT(region.size(), Eq(0u));
+    EXPECT_THAT(region.bounding_rectangle(), Eq(Rectangle{}));
+}
+
+TEST(Region, ignores_empty_rectangles)
+{
+    Region const region{Rectangle{{1, 2}, {0, 5}}, Rectangle{{1, 2}, {5, 0}}};
+
+    EXPECT_TRUE(region.empty());
+}
+
+TEST(Region, union_of_overlapping_rectangles_is_banded)
+{
+    Region const region{Rectangle{{0, 0}, {10, 10}}, Rectangle{{5, 5}, {10, 10}}};
+
+    EXPECT_THAT(region, ElementsAre(
+        Rectangle{{0, 0}, {10, 5}},
+        Rectangle{{0, 5}, {15, 5}},
+        Rectangle{{5, 10}, {10, 5}}));
+}
+
+TEST(Region, adjacent_rectangles_are_merged)
+{
+    Region const side_by_side{Rectangle{{0, 0}, {10, 10}}, Rectangle{{10, 0}, {10, 10}}};
+    Region const stacked{Rectangle{{0, 0}, {10, 10}}, Rectangle{{0, 10}, {10, 10}}};
+
+    EXPECT_THAT(side_by_side, ElementsAre(Rectangle{{0, 0}, {20, 10}}));
+    EXPECT_THAT(stacked, ElementsAre(Rectangle{{0, 0}, {10, 20}}));
+}
+
+TEST(Region, difference_can_leave_a_hole)
+{
+    auto const frame = difference_of(Rectangle{{0, 0}, {30, 30}}, Rectangle{{10, 10}, {10, 10}});
+
+    EXPECT_THAT(frame, ElementsAre(
+        Rectangle{{0, 0}, {30, 10}},
+        Rectangle{{0, 10}, {10, 10}},
+        Rectangle{{20, 10}, {10, 10}},
+        Rectangle{{0, 20}, {30, 10}}));
+    EXPECT_FALSE(frame.contains(Point{15, 15}));
+    EXPECT_TRUE(frame.contains(Point{5, 15}));
+    EXPECT_FALSE(frame.contains(Rectangle{{5, 5}, {10, 10}}));
+    EXPECT_TRUE(frame.overlaps(Rectangle{{5, 5}, {10, 10}}));
+    EXPECT_FALSE(frame.overlaps(Rectangle{{12, 12}, {5, 5}}));
+}
+
+TEST(Region, intersection_of_disjoint_regions_is_empty)
+{
+    EXPECT_TRUE(intersection_of(Region{Rectangle{{0, 0}, {10, 10}}}, Region{Rectangle{{10, 0}, {10, 10}}}).empty());
+}
+
+TEST(Region, can_be_made_from_rectangles)
+{
+    Rectangles const rects{{{0, 0}, {10, 10}}, {{5, 5}, {10, 10}}};
+
+    EXPECT_THAT(Region{rects}, Eq(Region{Rectangle{{0, 0}, {10, 10}}, Rectangle{{5, 5}, {10, 10}}}));
+    EXPECT_THAT(Region{rects}.bounding_rectangle(), Eq(rects.bounding_rectangle()));
+}
+
+TEST_F(RandomRegions, union_has_the_pixels_of_either)
+{
+    for (auto i = 0; i != iterations; ++i)
+    {
+        auto const a = random_region(), b = random_region();
+        auto const result = union_of(a, b);
+
+        expect_banded(result);
+        EXPECT_THAT(pixels_of(result), Eq(pixels_of(a) | pixels_of(b))) << a << " | " << b;
+        EXPECT_THAT(result, Eq(union_of(b, a)));
+    }
+}
+
+TEST_F(RandomRegions, intersection_has_the_pixels_of_both)
+{
+    for (auto i = 0; i != iterations; ++i)
+    {
+        auto const a = random_region(), b = random_region();
+        auto const result = intersection_of(a, b);
+
+        expect_banded(result);
+        EXPECT_THAT(pixels_of(result), Eq(pixels_of(a) & pixels_of(b))) << a << " & " << b;
+        EXPECT_THAT(result, Eq(intersection_of(b, a)));
+    }
+}
+
+TEST_F(RandomRegions, difference_has_the_pixels_of_only_the_first)
+{
+    for (auto i = 0; i != iterations; ++i)
+    {
+        auto const a = random_region(), b = random_region();
+        auto const result = difference_of(a, b);
+
+        expect_banded(result);
+        EXPECT_THAT(pixels_of(result), Eq(pixels_of(a) & ~pixels_of(b))) << a << " - " << b;
+        EXPECT_THAT(union_of(result, intersection_of(a, b)), Eq(a));
+    }
+}
+
+TEST_F(RandomRegions, equal_pixels_make_equal_regions)
+{
+    for (auto i = 0; i != iterations; ++i)
+    {
+        std::vector<Rectangle> rects(4);
+        std::generate(rects.begin(), rects.end(), [this] { return random_rect(); });
+
+        Region forwards, backwards;
+        for (auto const& rect : rects) forwards = union_of(forwards, rect);
+        for (auto rect = rects.rbegin(); rect != rects.rend(); ++rect) backwards = union_of(backwards, *rect);
+
+        EXPECT_THAT(forwards, Eq(backwards));
+        EXPECT_THAT(forwards, Eq(Region{rects[0], rects[1], rects[2], rects[3]}));
+    }
+}
+
+TEST_F(RandomRegions, containment_matches_pixels)
+{
+    for (auto i = 0; i != iterations; ++i)
+    {
+        auto const region = random_region();
+        auto const pixels = pixels_of(region);
+        auto const rect = random_rect();
+        auto const rect_pixels = pixels_of(rect);
+
+        EXPECT_THAT(region.contains(rect), Eq((rect_pixels & ~pixels).none())) << region << " contains " << rect;
+        EXPECT_THAT(region.overlaps(rect), Eq((rect_pixels & pixels).any())) << region << " overlaps " << rect;
+
+        for (auto y = -margin; y != grid + margin; ++y)
+        {
+            for (auto x = -margin; x != grid + margin; ++x)
+            {
+                ASSERT_THAT(region.contains(Point{x, y}), Eq(pixels.test(index(x, y))))
+                    << region << " contains " << Point{x, y};
+            }
+        }
+    }
+}
+
+TEST_F(RandomRegions, translation_moves_every_pixel)
+{
+    for (auto i = 0; i != iterations; ++i)
+    {
+        auto region = random_region();
+        auto const original = region;
+        Displacement const offset{3, -2};
+        region.translate(offset);
+
+        expect_banded(region);
+        EXPECT_THAT(region.size(), Eq(original.size()));
+        for (auto const& rect : original)
+        {
+            EXPECT_TRUE(region.contains(Rectangle{rect.top_left + offset, rect.size}));
+        }
+        region.translate(-offset);
+        EXPECT_THAT(region, Eq(original));
+    }
+}
+
+TEST_F(RandomRegions, bounding_rectangle_encloses_exactly)
+{
+    for (auto i = 0; i != iterations; ++i)
+    {
+        auto const region = random_region();
+        Rectangles rects;
+        for (auto const& rect : region) rects.add(rect);
+
+        EXPECT_THAT(region.bounding_rectangle(), Eq(rects.bounding_rectangle()));
+    }
+}
@@ -0,0 +1,147 @@
+/*
+ * Copyright © 2022 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/graphics/animated_cursor.h"
+#include "mir/graphics/cursor_image.h"
+
+#include "mir/test/doubles/fake_alarm_factory.h"
+#include "mir/test/fake_shared.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+namespace mg = mir::graphics;
+namespace mtd = mir::test::doubles;
+namespace mt = mir::test;
+namespace geom = mir::geometry;
+
+using namespace std::chrono_literals;
+using namespace testing;
+
+namespace
+{
+struct MockCursor : mg::Cursor
+{
+    MOCK_METHOD(void, show, (mg::CursorImage const&), (override));
+    MOCK_METHOD(void, hide, (), (override));
+    MOCK_METHOD(void, move_to, (geom::Point), (override));
+};
+
+struct StubCursorImage : mg::CursorImage
+{
+    void const* as_argb_8888() const override { return &pixel; }
+    geom::Size size() const override { return {1, 1}; }
+    geom::Displacement hotspot() const override { return {}; }
+
+    uint32_t pixel{0};
+};
+
+struct StubAnimatedCursorImage : mg::AnimatedCursorImage
+{
+    explicit StubAnimatedCursorImage(std::vector<std::chrono::milliseconds> const& delays)
+    {
+        for (auto delay : delays)
+        {
+            frames_.push_back({std::make_shared<StubCursorImage>(), delay});
+        }
+    }
+
+    auto frames() const -> std::vector<Frame> const& override { return frames_; }
+
+    auto frame(size_t i) const -> mg::CursorImage const* { return frames_[i].image.get(); }
+
+    std::vector<Frame> frames_;
+};
+
+struct AnimatedCursor : Test
+{
+    NiceMock<MockCursor> wrapped;
+    mtd::FakeAlarmFactory alarm_factory;
+    mg::AnimatedCursor cursor{mt::fake_shared(wrapped), alarm_factory};
+    StubAnimatedCursorImage const animation{{50ms, 100ms, 50ms}};
+};
+}
+
+TEST_F(AnimatedCursor, passes_plain_images_through)
+{
+    StubCursorImage const image;
+
+    EXPECT_CALL(wrapped, show(Ref(image)));
+    cursor.show(image);
+
+    Mock::VerifyAndClearExpectations(&wrapped);
+    EXPECT_CALL(wrapped, show(_)).Times(0);
+    alarm_factory.advance_by(1s);
+}
+
+TEST_F(AnimatedCursor, passes_whole_animation_to_wrapped_cursor_first)
+{
+    EXPECT_CALL(wrapped, show(Ref(animation)));
+    cursor.show(animation);
+}
+
+TEST_F(AnimatedCursor, shows_each_frame_after_the_delay_of_the_one_before)
+{
+    cursor.show(animation);
+
+    EXPECT_CALL(wrapped, show(_)).Times(0);
+    alarm_factory.advance_by(49ms);
+    Mock::VerifyAndClearExpectations(&wrapped);
+
+    EXPECT_CALL(wrapped, show(Address(animation.frame(1))));
+    alarm_factory.advance_by(2ms);
+    Mock::VerifyAndClearExpectations(&wrapped);
+
+    EXPECT_CALL(wrapped, show(_)).Times(0);
+    alarm_factory.advance_by(99ms);
+    Mock::VerifyAndClearExpectations(&wrapped);
+
+    EXPECT_CALL(wrapped, show(Address(animation.frame(2))));
+    alarm_factory.advance_by(2ms);
+    Mock::VerifyAndClearExpectations(&wrapped);
+
+    EXPECT_CALL(wrapped, show(Address(animation.frame(0))));
+    alarm_factory.advance_by(51ms);
+}
+
+TEST_F(AnimatedCursor, stops_animating_when_hidden)
+{
+    cursor.show(animation);
+
+    EXPECT_CALL(wrapped, hide());
+    EXPECT_CALL(wrapped, show(_)).Times(0);
+
+    cursor.hide();
+    alarm_factory.advance_by(1s);
+}
+
+TEST_F(AnimatedCursor, stops_animating_when_another_image_is_shown)
+{
+    StubCursorImage const image;
+    cursor.show(animation);
+    cursor.show(image);
+
+    EXPECT_CALL(wrapped, show(_)).Times(0);
+    alarm_factory.advance_by(1s);
+}
+
+TEST_F(AnimatedCursor, forwards_movement)
+{
+    geom::Point const position{12, 34};
+
+    EXPECT_CALL(wrapped, move_to(position));
+    cursor.move_to(position);
+}
@@ -0,0 +1,150 @@
+/*
+ * Copyright © 2022 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/platforms/common/server/frame_damage.h"
+
+#include "mir/test/doubles/stub_buffer.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+namespace mg = mir::graphics;
+namespace mgc = mir::graphics::common;
+namespace mtd = mir::test::doubles;
+namespace geom = mir::geometry;
+using namespace testing;
+
+namespace
+{
+struct MovableRenderable : mg::Renderable
+{
+    explicit MovableRenderable(geom::Rectangle const& position)
+        : position{position}
+    {
+    }
+
+    ID id() const override { return this; }
+    std::shared_ptr<mg::Buffer> buffer() const override { return buf; }
+    geom::Rectangle screen_position() const override { return position; }
+    std::optional<geom::Rectangle> clip_area() const override { return {}; }
+    float alpha() const override { return 1.0f; }
+    glm::mat4 transformation() const override { return glm::mat4{1}; }
+    bool shaped() const override { return false; }
+
+    std::shared_ptr<mg::Buffer> buf{std::make_shared<mtd::StubBuffer>()};
+    geom::Rectangle position;
+};
+
+struct FrameDamage : Test
+{
+    geom::Rectangle const view_area{{0, 0}, {640, 480}};
+    std::shared_ptr<MovableRenderable> const background{
+        std::make_shared<MovableRenderable>(geom::Rectangle{{0, 0}, {640, 480}})};
+    std::shared_ptr<MovableRenderable> const window{
+        std::make_shared<MovableRenderable>(geom::Rectangle{{10, 20}, {100, 50}})};
+
+    mgc::FrameDamage damage;
+};
+}
+
+TEST_F(FrameDamage, first_frame_is_fully_damaged)
+{
+    EXPECT_THAT(damage.update({background, window}, view_area), Eq(std::nullopt));
+}
+
+TEST_F(FrameDamage, unchanged_frame_has_no_damage)
+{
+    damage.update({background, window}, view_area);
+
+    EXPECT_THAT(damage.update({background, window}, view_area), Optional(Eq(geom::Rectangles{})));
+}
+
+TEST_F(FrameDamage, new_buffer_damages_renderable)
+{
+    damage.update({background, window}, view_area);
+
+    window->buf = std::make_shared<mtd::StubBuffer>();
+
+    EXPECT_THAT(damage.update({background, window}, view_area), Optional(Eq(geom::Rectangles{window->position})));
+}
+
+TEST_F(FrameDamage, moved_renderable_damages_old_and_new_positions)
+{
+    damage.update({background, window}, view_area);
+
+    auto const old_position = window->position;
+    window->position = geom::Rectangle{{200, 200}, {100, 50}};
+
+    EXPECT_THAT(
+        damage.update({background, window}, view_area),
+        Optional(Eq(geom::Rectangles{old_position, window->position})));
+}
+
+TEST_F(FrameDamage, removed_renderable_damages_its_position)
+{
+    damage.update({background, window}, view_area);
+
+    EXPECT_THAT(damage.update({background}, view_area), Optional(Eq(geom::Rectangles{window->position})));
+}
+
+TEST_F(FrameDamage, raised_renderable_is_damaged)
+{
+    damage.update({background, window}, view_area);
+
+    EXPECT_THAT(
+        damage.update({window, background}, view_area),
+        Optional(Eq(geom::Rectangles{background->position})));
+}
+
+TEST_F(FrameDamage, damage_is_clipped_to_view_area)
+{
+    damage.update({background, window}, view_area);
+
+    window->position = geom::Rectangle{{600, 460}, {100, 50}};
+
+    EXPECT_THAT(
+        damage.update({background, window}, view_area),
+        Optional(Eq(geom::Rectangles{geom::Rectangle{{10, 20}, {100, 50}}, geom::Rectangle{{600, 460}, {40, 20}}})));
+}
+
+TEST_F(FrameDamage, changed_view_area_is_fully_damaged)
+{
+    damage.update({background, window}, view_area);
+
+    EXPECT_THAT(damage.update({background, window}, geom::Rectangle{{0, 0}, {800, 600}}), Eq(std::nullopt));
+}
+
+TEST_F(FrameDamage, invalidated_frame_is_fully_damaged)
+{
+    damage.update({background, window}, view_area);
+
+    damage.invalidate();
+
+    EXPECT_THAT(damage.update({background, window}, view_area), Eq(std::nullopt));
+}
+
+TEST(EGLDamageRects, are_in_buffer_pixels_with_bottom_left_origin)
+{
+    geom::Rectangle const view_area{{100, 100}, {640, 480}};
+    geom::Size const buffer_size{1280, 960};
+
+    auto const rects = mgc::egl_damage_rects(
+        geom::Rectangles{geom::Rectangle{{110, 120}, {100, 50}}},
+        view_area,
+        buffer_size);
+
+    EXPECT_THAT(rects, ElementsAre(20, 960 - 140, 200, 100));
+}
@@ -0,0 +1,54 @@
+/*
+ * Copyright © 2022 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/graphics/linux_dmabuf_layout.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+namespace mg = mir::graphics;
+
+using namespace testing;
+using Layout = mg::gl::Texture::Layout;
+
+namespace
+{
+// zwp_linux_buffer_params_v1.flags
+uint32_t const y_invert = 1;
+uint32_t const interlaced = 2;
+}
+
+TEST(LinuxDmaBufLayout, y_invert_flag_is_top_row_first)
+{
+    EXPECT_THAT(mg::layout_from_linux_dmabuf_flags(y_invert), Eq(Layout::TopRowFirst));
+    EXPECT_THAT(mg::layout_from_linux_dmabuf_flags(0), Eq(Layout::GL));
+}
+
+TEST(LinuxDmaBufLayout, only_top_row_first_is_forwarded_with_y_invert)
+{
+    EXPECT_THAT(mg::linux_dmabuf_flags_from_layout(Layout::TopRowFirst), Eq(y_invert));
+    EXPECT_THAT(mg::linux_dmabuf_flags_from_layout(Layout::GL), Eq(0u));
+}
+
+TEST(LinuxDmaBufLayout, client_y_invert_flag_round_trips)
+{
+    for (uint32_t const client_flags : {0u, y_invert, interlaced, y_invert | interlaced})
+    {
+        auto const forwarded = mg::linux_dmabuf_flags_from_layout(mg::layout_from_linux_dmabuf_flags(client_flags));
+
+        EXPECT_THAT(forwarded & y_invert, Eq(client_flags & y_invert)) << "client flags: " << client_flags;
+    }
+}
@@ -16,8 +16,11 @@
 
 #include <gtest/gtest.h>
 #include <fcntl.h>
+#include <unistd.h>
 #include <boost/throw_exception.hpp>
 
+#include <filesystem>
+
 #include "mir/graphics/platform.h"
 #include "src/server/graphics/platform_probe.h"
 #include "mir/options/program_option.h"
@@ -162,6 +165,28 @@ public:
 #endif
 };
 
+struct PlatformProbeCache : public ::testing::Test
+{
+    std::string const file{
+        (std::filesystem::temp_directory_path() / ("mir-platform-probe-cache-" + std::to_string(getpid()))).string()};
+    std::string const identity{"module graphics-dummy.so 1 2\ndevice /sys/devices/drm/card0\n"};
+
+    void TearDown() override
+    {
+        std::filesystem::remove(file);
+    }
+
+    auto chosen_names(std::vector<std::pair<mir::graphics::SupportedDevice, std::shared_ptr<mir::SharedLibrary>>> const& chosen)
+        -> std::vector<std::string>
+    {
+        std::vector<std::string> names;
+        for (auto const& [device, module] : chosen)
+        {
+            names.emplace_back(module->load_function<mir::graphics::DescribeModule>(describe_module)()->name);
+        }
+        return names;
+    }
+};
 }
 
 TEST(ServerPlatformProbe, ConstructingWithNoModulesIsAnError)
@@ -280,3 +305,57 @@ TEST(ServerPlatformProbe, IgnoresNonPlatformModules)
         std::make_shared<StubConsoleServices>());
     EXPECT_THAT(selected_modules, Not(IsEmpty()));
 }
+
+TEST_F(PlatformProbeCache, returns_the_modules_stored_for_the_same_system)
+{
+    using namespace testing;
+    mir::graphics::PlatformProbeCache{file, identity}.store({"mir:gbm-kms", "mir:x11"});
+
+    EXPECT_THAT(mir::graphics::PlatformProbeCache(file, identity).chosen_modules(), ElementsAre("mir:gbm-kms", "mir:x11"));
+}
+
+TEST_F(PlatformProbeCache, returns_nothing_for_a_different_system)
+{
+    using namespace testing;
+    mir::graphics::PlatformProbeCache{file, identity}.store({"mir:gbm-kms"});
+
+    EXPECT_THAT(mir::graphics::PlatformProbeCache(file, identity + "device /sys/devices/drm/card1\n").chosen_modules(), IsEmpty());
+    EXPECT_THAT(mir::graphics::PlatformProbeCache(file + ".missing", identity).chosen_modules(), IsEmpty());
+}
+
+TEST_F(PlatformProbeCache, stores_the_modules_chosen_by_probing)
+{
+    using namespace testing;
+    mir::options::ProgramOption options;
+    mir::graphics::PlatformProbeCache const cache{file, identity};
+
+    std::vector<std::shared_ptr<mir::SharedLibrary>> modules;
+    add_dummy_platform(modules);
+    add_broken_platform(modules);
+
+    mir::graphics::display_modules_for_device(modules, options, std::make_shared<StubConsoleServices>(), &cache);
+
+    EXPECT_THAT(cache.chosen_modules(), ElementsAre("mir:stub-graphics"));
+}
+
+TEST_F(PlatformProbeCache, probes_every_module_when_the_cached_choice_no_longer_applies)
+{
+    using namespace testing;
+    mir::options::ProgramOption options;
+    mir::graphics::PlatformProbeCache const cache{file, identity};
+    // The broken platform does not claim to support anything
+    cache.store({"throw-on-creation"});
+
+    std::vector<std::shared_ptr<mir::SharedLibrary>> modules;
+    add_dummy_platform(modules);
+    add_broken_platform(modules);
+
+    auto const chosen = mir::graphics::display_modules_for_device(
+        modules,
+        options,
+        std::make_shared<StubConsoleServices>(),
+        &cache);
+
+    EXPECT_THAT(chosen_names(chosen), ElementsAre("mir:stub-graphics"));
+    EXPECT_THAT(cache.chosen_modules(), ElementsAre("mir:stub-graphics"));
+}
@@ -134,6 +134,21 @@ TEST_F(ShmBufferTest, cant_upload_bgr_888)
     buf.bind();
 }
 
+TEST_F(ShmBufferTest, uploads_again_only_after_being_written)
+{
+    PlatformlessShmBuffer buf(size, mir_pixel_format_argb_8888, egl_delegate);
+    EXPECT_CALL(mock_gl, glTexImage2D(GL_TEXTURE_2D, _, _, _, _, _, _, _, _))
+        .Times(2);
+
+    buf.bind();
+    buf.bind();
+    buf.map_readable();
+    buf.bind();
+    buf.map_writeable();
+    buf.bind();
+    buf.bind();
+}
+
 struct BufferUploadDesc
 {
     geom::Size size;
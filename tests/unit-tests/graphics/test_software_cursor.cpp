@@ -379,20 +379,75 @@ TEST_F(SoftwareCursor, places_new_cursor_renderable_at_correct_position)
     cursor.show(another_stub_cursor_image);
 }
 
-//lp: #1413211
-TEST_F(SoftwareCursor, new_buffer_on_each_show)
+TEST_F(SoftwareCursor, reuses_buffer_for_image_shown_before)
 {
-    EXPECT_CALL(mock_buffer_allocator, alloc_software_buffer(testing::_, testing::_))
-        .Times(3);
+    using namespace testing;
+
+    StubCursorImage different_image{{3,4}};
+    different_image.fill_with(0x11, 0x22, 0x33, 0x44);
+
+    EXPECT_CALL(mock_buffer_allocator, alloc_software_buffer(_, _))
+        .Times(2);
     mg::SoftwareCursor cursor{
         mt::fake_shared(mock_buffer_allocator),
         mt::fake_shared(executor),
         mt::fake_shared(mock_input_scene)};
     cursor.show(another_stub_cursor_image);
     cursor.show(another_stub_cursor_image);
+    cursor.show(different_image);
+    // The same pixels, with a different hotspot
     cursor.show(stub_cursor_image);
 }
 
+//lp: #1413211
+TEST_F(SoftwareCursor, new_buffer_when_image_content_changes)
+{
+    using namespace testing;
+
+    StubCursorImage image{{3,4}};
+
+    EXPECT_CALL(mock_buffer_allocator, alloc_software_buffer(_, _))
+        .Times(2);
+    mg::SoftwareCursor cursor{
+        mt::fake_shared(mock_buffer_allocator),
+        mt::fake_shared(executor),
+        mt::fake_shared(mock_input_scene)};
+    cursor.show(image);
+    image.fill_with(0x11, 0x22, 0x33, 0x44);
+    cursor.show(image);
+}
+
+TEST_F(SoftwareCursor, uploads_every_frame_of_an_animated_image_when_it_is_shown)
+{
+    using namespace testing;
+
+    struct StubAnimatedCursorImage : mg::AnimatedCursorImage
+    {
+        auto frames() const -> std::vector<Frame> const& override { return frames_; }
+
+        std::vector<Frame> frames_;
+    } animated_image;
+
+    for (unsigned char i = 0; i != 3; ++i)
+    {
+        auto const frame = std::make_shared<StubCursorImage>(geom::Displacement{3,4});
+        frame->fill_with(i, i, i, 0xff);
+        animated_image.frames_.push_back({frame, std::chrono::milliseconds{50}});
+    }
+
+    EXPECT_CALL(mock_buffer_allocator, alloc_software_buffer(_, _))
+        .Times(3);
+    mg::SoftwareCursor cursor{
+        mt::fake_shared(mock_buffer_allocator),
+        mt::fake_shared(executor),
+        mt::fake_shared(mock_input_scene)};
+    cursor.show(animated_image);
+    for (auto const& frame : animated_image.frames_)
+    {
+        cursor.show(*frame.image);
+    }
+}
+
 //lp: 1483779
 TEST_F(SoftwareCursor, doesnt_try_to_remove_after_hiding)
 {
@@ -0,0 +1,50 @@
+/*
+ * Copyright © 2022 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/graphics/solid_color_buffer.h"
+#include "mir/graphics/pixel_format_utils.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+namespace mg = mir::graphics;
+namespace geom = mir::geometry;
+
+using namespace testing;
+
+TEST(SolidColorBuffer, opaque_color_has_no_alpha_channel)
+{
+    mg::SolidColorBuffer buffer{geom::Size{1, 1}, {0.1f, 0.2f, 0.3f, 1.0f}};
+
+    EXPECT_TRUE(buffer.opaque());
+    EXPECT_FALSE(mg::contains_alpha(buffer.pixel_format()));
+}
+
+TEST(SolidColorBuffer, translucent_color_has_an_alpha_channel)
+{
+    mg::SolidColorBuffer buffer{geom::Size{1, 1}, {0.1f, 0.2f, 0.3f, 0.5f}};
+
+    EXPECT_FALSE(buffer.opaque());
+    EXPECT_TRUE(mg::contains_alpha(buffer.pixel_format()));
+}
+
+TEST(SolidColorBuffer, is_its_own_native_buffer)
+{
+    mg::SolidColorBuffer buffer{geom::Size{20, 30}, {0.0f, 0.0f, 0.0f, 1.0f}};
+
+    EXPECT_THAT(buffer.size(), Eq(geom::Size{20, 30}));
+    EXPECT_THAT(dynamic_cast<mg::SolidColorBuffer*>(buffer.native_buffer_base()), Eq(&buffer));
+}
@@ -0,0 +1,153 @@
+/*
+ * Copyright © 2022 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/logging/async_logger.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ml = mir::logging;
+using namespace testing;
+
+namespace
+{
+/// Records what it is asked to log, optionally holding up the writer until released
+class RecordingLogger : public ml::Logger
+{
+public:
+    void log(ml::Severity, std::string const& message, std::string const& component) override
+    {
+        std::unique_lock lock{mutex};
+        messages.push_back(component + ": " + message);
+        changed.notify_all();
+        changed.wait(lock, [this] { return !blocked; });
+    }
+
+    void block()
+    {
+        std::lock_guard lock{mutex};
+        blocked = true;
+    }
+
+    void unblock()
+    {
+        std::lock_guard lock{mutex};
+        blocked = false;
+        changed.notify_all();
+    }
+
+    void wait_for_messages(size_t count)
+    {
+        std::unique_lock lock{mutex};
+        changed.wait(lock, [&] { return messages.size() >= count; });
+    }
+
+    std::mutex mutex;
+    std::condition_variable changed;
+    bool blocked{false};
+    std::vector<std::string> messages;
+};
+
+struct AsyncLogger : Test
+{
+    std::shared_ptr<RecordingLogger> const downstream{std::make_shared<RecordingLogger>()};
+};
+}
+
+TEST_F(AsyncLogger, writes_messages_in_the_order_they_were_logged)
+{
+    {
+        ml::AsyncLogger logger{downstream};
+        ml::Logger& base = logger;
+
+        base.log(ml::Severity::informational, "first", "test");
+        logger.log("test", ml::Severity::informational, "second: %d", 2);
+        base.log(ml::Severity::informational, "third", "test");
+    }
+
+    EXPECT_THAT(downstream->messages, ElementsAre("test: first", "test: second: 2", "test: third"));
+}
+
+TEST_F(AsyncLogger, writes_every_message_from_many_threads)
+{
+    int const thread_count{8};
+    int const messages_per_thread{100};
+    {
+        ml::AsyncLogger logger{downstream, thread_count * messages_per_thread};
+
+        std::vector<std::thread> threads;
+        for (auto t = 0; t != thread_count; ++t)
+        {
+            threads.emplace_back([&, t]
+                {
+                    for (auto i = 0; i != messages_per_thread; ++i)
+                    {
+                        logger.log("test", ml::Severity::debug, "%d:%d", t, i);
+                    }
+                });
+        }
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+
+        EXPECT_THAT(logger.dropped(), Eq(0u));
+    }
+
+    EXPECT_THAT(downstream->messages.size(), Eq(static_cast<size_t>(thread_count * messages_per_thread)));
+}
+
+TEST_F(AsyncLogger, drops_and_counts_messages_when_the_ring_is_full)
+{
+    size_t const capacity{4};
+    {
+        ml::AsyncLogger logger{downstream, capacity};
+
+        // Hold the writer up on the first message, so the ring fills behind it
+        downstream->block();
+        logger.log("test", ml::Severity::informational, "blocking");
+        downstream->wait_for_messages(1);
+
+        for (size_t i = 0; i != capacity + 3; ++i)
+        {
+            logger.log("test", ml::Severity::informational, "%zu", i);
+        }
+
+        EXPECT_THAT(logger.dropped(), Eq(3u));
+        downstream->unblock();
+    }
+
+    EXPECT_THAT(downstream->messages.size(), Eq(1 + capacity + 1));
+    EXPECT_THAT(downstream->messages.back(), StartsWith("logging: 3 log messages dropped"));
+}
+
+TEST_F(AsyncLogger, truncates_long_messages)
+{
+    std::string const long_message(2 * ml::AsyncLogger::max_message_size, 'x');
+    {
+        ml::AsyncLogger logger{downstream};
+        logger.log("test", ml::Severity::informational, "%s", long_message.c_str());
+    }
+
+    ASSERT_THAT(downstream->messages.size(), Eq(1u));
+    EXPECT_THAT(downstream->messages[0], Eq("test: " + long_message.substr(0, ml::AsyncLogger::max_message_size - 1)));
+}
@@ -49,6 +49,37 @@ struct MockKMSOutput : public graphics::gbm::KMSOutput
     MOCK_METHOD1(schedule_page_flip_thunk, bool(graphics::gbm::FBHandle const*));
     MOCK_METHOD0(wait_for_page_flip, void());
 
+    bool test_overlays(
+        graphics::gbm::FBHandle const& fb,
+        std::vector<graphics::gbm::OverlayPlane> const& overlays) override
+    {
+        return test_overlays_thunk(&fb, overlays);
+    }
+    MOCK_METHOD2(test_overlays_thunk, bool(
+        graphics::gbm::FBHandle const*,
+        std::vector<graphics::gbm::OverlayPlane> const&));
+
+    bool schedule_page_flip(
+        graphics::gbm::FBHandle const& fb,
+        std::vector<graphics::gbm::OverlayPlane> const& overlays) override
+    {
+        return schedule_overlay_flip_thunk(&fb, overlays);
+    }
+    MOCK_METHOD2(schedule_overlay_flip_thunk, bool(
+        graphics::gbm::FBHandle const*,
+        std::vector<graphics::gbm::OverlayPlane> const&));
+
+    auto queue_page_flip(
+        graphics::gbm::FBHandle const& fb,
+        std::vector<graphics::gbm::OverlayPlane> const& overlays) -> graphics::gbm::QueuedFlip override
+    {
+        return queue_page_flip_thunk(&fb, overlays);
+    }
+    MOCK_METHOD2(queue_page_flip_thunk, graphics::gbm::QueuedFlip(
+        graphics::gbm::FBHandle const*,
+        std::vector<graphics::gbm::OverlayPlane> const&));
+    MOCK_METHOD0(presented_flip, uint64_t());
+
     MOCK_CONST_METHOD0(last_frame, graphics::Frame());
 
     MOCK_METHOD1(set_cursor, bool(gbm_bo*));
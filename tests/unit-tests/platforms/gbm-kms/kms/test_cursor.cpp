@@ -413,6 +413,31 @@ TEST_F(MesaCursorTest, show_cursor_writes_to_bo)
     cursor.show(image);
 }
 
+TEST_F(MesaCursorTest, showing_the_same_image_again_does_not_rewrite_bo)
+{
+    using namespace testing;
+
+    StubCursorImage image;
+
+    EXPECT_CALL(mock_gbm, gbm_bo_write(mock_gbm.fake_gbm.bo, NotNull(), _)).Times(1);
+
+    cursor.show(image);
+    cursor.show(image);
+}
+
+TEST_F(MesaCursorTest, showing_a_different_image_rewrites_bo)
+{
+    using namespace testing;
+
+    StubCursorImage image;
+
+    EXPECT_CALL(mock_gbm, gbm_bo_write(mock_gbm.fake_gbm.bo, NotNull(), _)).Times(3);
+
+    cursor.show(image);
+    cursor.show(SinglePixelCursorImage());
+    cursor.show(image);
+}
+
 // When we upload our 1x1 cursor we should upload a single white pixel and then transparency filling a 64x64 buffer.
 MATCHER_P(ContainsASingleWhitePixel, buffersize, "")
 {
@@ -85,6 +85,10 @@ public:
         drm_fd{open(drm_device, 0, 0)}
     {
         using namespace testing;
+
+        /* These tests drive page flip events by hand, through the legacy (non-threaded) page flipper */
+        ON_CALL(mock_drm, drmSetClientCap(_, DRM_CLIENT_CAP_ATOMIC, _))
+            .WillByDefault(Return(-1));
         ON_CALL(mock_egl, eglChooseConfig(_,_,_,1,_))
         .WillByDefault(DoAll(SetArgPointee<2>(mock_egl.fake_configs[0]),
                              SetArgPointee<4>(1),
@@ -113,6 +113,10 @@ public:
     {
         using namespace testing;
 
+        /* These tests drive page flip events by hand, through the legacy (non-threaded) page flipper */
+        ON_CALL(mock_drm, drmSetClientCap(_, DRM_CLIENT_CAP_ATOMIC, _))
+            .WillByDefault(Return(-1));
+
         /* Needed for display start-up */
         ON_CALL(mock_egl, eglChooseConfig(_,_,_,1,_))
             .WillByDefault(DoAll(SetArgPointee<2>(mock_egl.fake_configs[0]),
@@ -0,0 +1,453 @@
+/*
+ * Copyright © 2022 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/platforms/gbm-kms/server/kms/kms_planes.h"
+
+#include "mir/test/doubles/mock_drm.h"
+
+#include <drm_fourcc.h>
+
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <optional>
+#include <system_error>
+#include <unordered_map>
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <fcntl.h>
+
+namespace mgg = mir::graphics::gbm;
+namespace mtd = mir::test::doubles;
+namespace geom = mir::geometry;
+
+using namespace testing;
+
+namespace
+{
+// The property IDs every fake plane shares
+std::vector<std::pair<uint32_t, char const*>> const plane_properties{
+    {1, "type"},
+    {2, "FB_ID"}, {3, "CRTC_ID"},
+    {4, "SRC_X"}, {5, "SRC_Y"}, {6, "SRC_W"}, {7, "SRC_H"},
+    {8, "CRTC_X"}, {9, "CRTC_Y"}, {10, "CRTC_W"}, {11, "CRTC_H"},
+    {12, "zpos"}};
+uint32_t const fb_id_property{2};
+uint32_t const crtc_id_property{3};
+uint32_t const zpos_property{12};
+
+// The atomic modesetting properties of the fake CRTC and connector
+std::vector<std::pair<uint32_t, char const*>> const modeset_properties{
+    {20, "MODE_ID"}, {21, "ACTIVE"}, {22, "GAMMA_LUT"}, {23, "GAMMA_LUT_SIZE"}, {24, "CRTC_ID"}};
+uint32_t const mode_id_property{20};
+uint32_t const active_property{21};
+uint32_t const gamma_lut_property{22};
+uint32_t const gamma_lut_size_property{23};
+uint32_t const connector_crtc_id_property{24};
+
+bool commits_property(
+    std::vector<mtd::AtomicProperty> const& committed,
+    uint32_t object,
+    uint32_t property,
+    uint64_t value)
+{
+    return std::any_of(committed.begin(), committed.end(), [&](auto const& p)
+        {
+            return p.object_id == object && p.property_id == property && p.value == value;
+        });
+}
+
+class FakePlanes
+{
+public:
+    auto add_plane(
+        uint64_t type,
+        uint32_t possible_crtcs,
+        std::optional<uint64_t> zpos = std::nullopt,
+        std::vector<uint32_t> formats = {DRM_FORMAT_XRGB8888, DRM_FORMAT_ARGB8888}) -> uint32_t
+    {
+        auto const id = next_id++;
+
+        auto& plane_formats = formats_storage.emplace_back(std::move(formats));
+
+        drmModePlane plane;
+        memset(&plane, 0, sizeof(plane));
+        plane.plane_id = id;
+        plane.possible_crtcs = possible_crtcs;
+        plane.count_formats = plane_formats.size();
+        plane.formats = plane_formats.data();
+        planes[id] = plane;
+        plane_ids.push_back(id);
+
+        auto& object = objects[id];
+        for (auto const& property : plane_properties)
+        {
+            if (property.first == zpos_property && !zpos)
+            {
+                continue;
+            }
+            object.ids.push_back(property.first);
+            object.values.push_back(property.first == 1 ? type : property.first == zpos_property ? *zpos : 0);
+        }
+
+        return id;
+    }
+
+    /// Give a CRTC or connector properties (of modeset_properties)
+    void add_object(uint32_t id, std::vector<std::pair<uint32_t, uint64_t>> const& properties)
+    {
+        auto& object = objects[id];
+        for (auto const& property : properties)
+        {
+            object.ids.push_back(property.first);
+            object.values.push_back(property.second);
+        }
+    }
+
+    void setup_mock_drm(mtd::MockDRM& mock)
+    {
+        ON_CALL(mock, drmModeGetPlaneResources(_))
+            .WillByDefault(InvokeWithoutArgs(
+                [this]()
+                {
+                    resources.count_planes = plane_ids.size();
+                    resources.planes = plane_ids.data();
+                    return &resources;
+                }));
+        ON_CALL(mock, drmModeGetPlane(_, _))
+            .WillByDefault(WithArg<1>(Invoke([this](uint32_t id) { return &planes.at(id); })));
+        ON_CALL(mock, drmModeObjectGetProperties(_, _, _))
+            .WillByDefault(WithArg<1>(Invoke(
+                [this](uint32_t id)
+                {
+                    auto& object = objects[id];
+                    object.props.count_props = object.ids.size();
+                    object.props.props = object.ids.data();
+                    object.props.prop_values = object.values.data();
+                    return &object.props;
+                })));
+        ON_CALL(mock, drmModeGetProperty(_, _))
+            .WillByDefault(WithArg<1>(Invoke(
+                [this](uint32_t id)
+                {
+                    auto& property = properties[id];
+                    memset(&property, 0, sizeof(property));
+                    property.prop_id = id;
+                    for (auto const& table : {plane_properties, modeset_properties})
+                    {
+                        for (auto const& known : table)
+                        {
+                            if (known.first == id)
+                            {
+                                strncpy(property.name, known.second, sizeof(property.name) - 1);
+                            }
+                        }
+                    }
+                    return &property;
+                })));
+    }
+
+private:
+    struct Object
+    {
+        std::vector<uint32_t> ids;
+        std::vector<uint64_t> values;
+        drmModeObjectProperties props;
+    };
+
+    uint32_t next_id{40};
+    std::deque<std::vector<uint32_t>> formats_storage;
+    std::vector<uint32_t> plane_ids;
+    std::unordered_map<uint32_t, drmModePlane> planes;
+    std::unordered_map<uint32_t, Object> objects;
+    std::unordered_map<uint32_t, drmModePropertyRes> properties;
+    drmModePlaneRes resources;
+};
+
+class KMSPlanesTest : public Test
+{
+public:
+    KMSPlanesTest()
+    {
+        fake_planes.setup_mock_drm(mock_drm);
+    }
+
+    mgg::KMSPlanes::Content content(uint32_t fb_id, uint32_t format = DRM_FORMAT_XRGB8888)
+    {
+        return {fb_id, format, {{0, 0}, {100, 100}}, {{10, 10}, {100, 100}}};
+    }
+
+    char const* const drm_device = "/dev/dri/card0";
+    NiceMock<mtd::MockDRM> mock_drm;
+    FakePlanes fake_planes;
+    int const drm_fd{open(drm_device, 0, 0)};
+    uint32_t const crtc_id{10};           // The first CRTC of the default fake resources
+    uint32_t const connector_id{30};
+    uint32_t const this_crtc_mask{0x1};
+    uint32_t const other_crtc_mask{0x2};
+    mgg::KMSPlanes::Content const primary{1, DRM_FORMAT_XRGB8888, {{0, 0}, {1920, 1080}}, {{0, 0}, {1920, 1080}}};
+};
+}
+
+TEST_F(KMSPlanesTest, uses_only_overlay_planes_exclusive_to_the_crtc)
+{
+    fake_planes.add_plane(DRM_PLANE_TYPE_PRIMARY, this_crtc_mask);
+    fake_planes.add_plane(DRM_PLANE_TYPE_CURSOR, this_crtc_mask);
+    fake_planes.add_plane(DRM_PLANE_TYPE_OVERLAY, this_crtc_mask);
+    fake_planes.add_plane(DRM_PLANE_TYPE_OVERLAY, this_crtc_mask | other_crtc_mask);
+    fake_planes.add_plane(DRM_PLANE_TYPE_OVERLAY, other_crtc_mask);
+
+    mgg::KMSPlanes planes{drm_fd, crtc_id};
+
+    EXPECT_THAT(planes.overlay_count(), Eq(1u));
+}
+
+TEST_F(KMSPlanesTest, does_not_use_planes_stacked_below_the_primary)
+{
+    fake_planes.add_plane(DRM_PLANE_TYPE_PRIMARY, this_crtc_mask, 1);
+    fake_planes.add_plane(DRM_PLANE_TYPE_OVERLAY, this_crtc_mask, 0);
+    fake_planes.add_plane(DRM_PLANE_TYPE_OVERLAY, this_crtc_mask, 2);
+
+    mgg::KMSPlanes planes{drm_fd, crtc_id};
+
+    EXPECT_THAT(planes.overlay_count(), Eq(1u));
+}
+
+TEST_F(KMSPlanesTest, throws_without_atomic_modesetting)
+{
+    fake_planes.add_plane(DRM_PLANE_TYPE_PRIMARY, this_crtc_mask);
+
+    ON_CALL(mock_drm, drmSetClientCap(_, DRM_CLIENT_CAP_ATOMIC, _))
+        .WillByDefault(InvokeWithoutArgs([]() { errno = EOPNOTSUPP; return -1; }));
+
+    EXPECT_THROW((mgg::KMSPlanes{drm_fd, crtc_id}), std::system_error);
+}
+
+TEST_F(KMSPlanesTest, throws_without_primary_plane)
+{
+    fake_planes.add_plane(DRM_PLANE_TYPE_OVERLAY, this_crtc_mask);
+
+    EXPECT_THROW((mgg::KMSPlanes{drm_fd, crtc_id}), std::runtime_error);
+}
+
+TEST_F(KMSPlanesTest, test_makes_test_only_commit)
+{
+    fake_planes.add_plane(DRM_PLANE_TYPE_PRIMARY, this_crtc_mask);
+    fake_planes.add_plane(DRM_PLANE_TYPE_OVERLAY, this_crtc_mask);
+
+    mgg::KMSPlanes planes{drm_fd, crtc_id};
+
+    EXPECT_CALL(mock_drm, drmModeAtomicCommit(drm_fd, _, DRM_MODE_ATOMIC_TEST_ONLY, _))
+        .WillOnce(Return(0))
+        .WillOnce(Return(-EINVAL));
+
+    EXPECT_TRUE(planes.test(primary, {content(2)}));
+    EXPECT_FALSE(planes.test(primary, {content(2)}));
+    EXPECT_FALSE(planes.overlays_active());
+}
+
+TEST_F(KMSPlanesTest, test_fails_without_commit_when_format_is_unsupported)
+{
+    fake_planes.add_plane(DRM_PLANE_TYPE_PRIMARY, this_crtc_mask);
+    fake_planes.add_plane(DRM_PLANE_TYPE_OVERLAY, this_crtc_mask, std::nullopt, {DRM_FORMAT_XRGB8888});
+
+    mgg::KMSPlanes planes{drm_fd, crtc_id};
+
+    EXPECT_CALL(mock_drm, drmModeAtomicCommit(_, _, _, _)).Times(0);
+
+    EXPECT_FALSE(planes.test(primary, {content(2, DRM_FORMAT_NV12)}));
+}
+
+TEST_F(KMSPlanesTest, test_fails_without_commit_when_there_are_too_many_overlays)
+{
+    fake_planes.add_plane(DRM_PLANE_TYPE_PRIMARY, this_crtc_mask);
+    fake_planes.add_plane(DRM_PLANE_TYPE_OVERLAY, this_crtc_mask);
+
+    mgg::KMSPlanes planes{drm_fd, crtc_id};
+
+    EXPECT_CALL(mock_drm, drmModeAtomicCommit(_, _, _, _)).Times(0);
+
+    EXPECT_FALSE(planes.test(primary, {content(2), content(3)}));
+}
+
+TEST_F(KMSPlanesTest, commit_shows_framebuffers_on_planes)
+{
+    auto const primary_id = fake_planes.add_plane(DRM_PLANE_TYPE_PRIMARY, this_crtc_mask);
+    auto const overlay_id = fake_planes.add_plane(DRM_PLANE_TYPE_OVERLAY, this_crtc_mask);
+
+    mgg::KMSPlanes planes{drm_fd, crtc_id};
+
+    std::vector<mtd::AtomicProperty> committed;
+    EXPECT_CALL(mock_drm, drmModeAtomicCommit(drm_fd, _, DRM_MODE_ATOMIC_NONBLOCK, _))
+        .WillOnce(WithArg<1>(Invoke(
+            [&](drmModeAtomicReqPtr request)
+            {
+                committed = mtd::atomic_request_properties(request);
+                return 0;
+            })));
+
+    EXPECT_THAT(planes.commit(primary, {content(2)}, DRM_MODE_ATOMIC_NONBLOCK, nullptr), Eq(0));
+
+    auto const has = [&](uint32_t object, uint32_t property, uint64_t value)
+        {
+            return std::any_of(committed.begin(), committed.end(), [&](auto const& p)
+                {
+                    return p.object_id == object && p.property_id == property && p.value == value;
+                });
+        };
+    EXPECT_TRUE(has(primary_id, fb_id_property, 1));
+    EXPECT_TRUE(has(primary_id, crtc_id_property, crtc_id));
+    EXPECT_TRUE(has(overlay_id, fb_id_property, 2));
+    EXPECT_TRUE(has(overlay_id, crtc_id_property, crtc_id));
+    EXPECT_TRUE(planes.overlays_active());
+}
+
+TEST_F(KMSPlanesTest, commit_disables_overlays_no_longer_used)
+{
+    fake_planes.add_plane(DRM_PLANE_TYPE_PRIMARY, this_crtc_mask);
+    auto const overlay_id = fake_planes.add_plane(DRM_PLANE_TYPE_OVERLAY, this_crtc_mask);
+
+    mgg::KMSPlanes planes{drm_fd, crtc_id};
+    planes.commit(primary, {content(2)}, 0, nullptr);
+
+    std::vector<mtd::AtomicProperty> committed;
+    EXPECT_CALL(mock_drm, drmModeAtomicCommit(_, _, _, _))
+        .WillOnce(WithArg<1>(Invoke(
+            [&](drmModeAtomicReqPtr request)
+            {
+                committed = mtd::atomic_request_properties(request);
+                return 0;
+            })));
+
+    planes.commit(primary, {}, 0, nullptr);
+
+    auto const disabled = [&](uint32_t property)
+        {
+            return std::any_of(committed.begin(), committed.end(), [&](auto const& p)
+                {
+                    return p.object_id == overlay_id && p.property_id == property && p.value == 0;
+                });
+        };
+    EXPECT_TRUE(disabled(fb_id_property));
+    EXPECT_TRUE(disabled(crtc_id_property));
+    EXPECT_FALSE(planes.overlays_active());
+}
+
+TEST_F(KMSPlanesTest, failed_commit_leaves_planes_as_they_were)
+{
+    fake_planes.add_plane(DRM_PLANE_TYPE_PRIMARY, this_crtc_mask);
+    fake_planes.add_plane(DRM_PLANE_TYPE_OVERLAY, this_crtc_mask);
+
+    mgg::KMSPlanes planes{drm_fd, crtc_id};
+
+    ON_CALL(mock_drm, drmModeAtomicCommit(_, _, _, _))
+        .WillByDefault(Return(-EBUSY));
+
+    EXPECT_THAT(planes.commit(primary, {content(2)}, 0, nullptr), Eq(-EBUSY));
+    EXPECT_FALSE(planes.overlays_active());
+}
+
+TEST_F(KMSPlanesTest, modeset_sets_mode_connector_and_primary_in_one_commit)
+{
+    auto const primary_id = fake_planes.add_plane(DRM_PLANE_TYPE_PRIMARY, this_crtc_mask);
+    fake_planes.add_object(crtc_id, {{mode_id_property, 0}, {active_property, 0}});
+    fake_planes.add_object(connector_id, {{connector_crtc_id_property, 0}});
+
+    mgg::KMSPlanes planes{drm_fd, crtc_id};
+
+    uint32_t const mode_blob{77};
+    EXPECT_CALL(mock_drm, drmModeCreatePropertyBlob(drm_fd, _, sizeof(drmModeModeInfo), _))
+        .WillOnce(DoAll(SetArgPointee<3>(mode_blob), Return(0)));
+    EXPECT_CALL(mock_drm, drmModeDestroyPropertyBlob(drm_fd, mode_blob));
+
+    std::vector<mtd::AtomicProperty> committed;
+    EXPECT_CALL(mock_drm, drmModeAtomicCommit(drm_fd, _, DRM_MODE_ATOMIC_ALLOW_MODESET, _))
+        .WillOnce(WithArg<1>(Invoke(
+            [&](drmModeAtomicReqPtr request)
+            {
+                committed = mtd::atomic_request_properties(request);
+                return 0;
+            })));
+
+    drmModeModeInfo mode;
+    memset(&mode, 0, sizeof(mode));
+    EXPECT_THAT(planes.modeset(connector_id, mode, primary), Eq(0));
+
+    EXPECT_TRUE(commits_property(committed, crtc_id, mode_id_property, mode_blob));
+    EXPECT_TRUE(commits_property(committed, crtc_id, active_property, 1));
+    EXPECT_TRUE(commits_property(committed, connector_id, connector_crtc_id_property, crtc_id));
+    EXPECT_TRUE(commits_property(committed, primary_id, fb_id_property, primary.fb_id));
+}
+
+TEST_F(KMSPlanesTest, modeset_is_not_supported_without_crtc_mode_properties)
+{
+    fake_planes.add_plane(DRM_PLANE_TYPE_PRIMARY, this_crtc_mask);
+    fake_planes.add_object(connector_id, {{connector_crtc_id_property, 0}});
+
+    mgg::KMSPlanes planes{drm_fd, crtc_id};
+
+    EXPECT_CALL(mock_drm, drmModeAtomicCommit(_, _, _, _)).Times(0);
+
+    drmModeModeInfo mode;
+    memset(&mode, 0, sizeof(mode));
+    EXPECT_THAT(planes.modeset(connector_id, mode, primary), Eq(-ENOTSUP));
+}
+
+TEST_F(KMSPlanesTest, gamma_is_applied_by_the_next_commit)
+{
+    fake_planes.add_plane(DRM_PLANE_TYPE_PRIMARY, this_crtc_mask);
+    fake_planes.add_object(crtc_id, {{gamma_lut_property, 0}, {gamma_lut_size_property, 3}});
+
+    mgg::KMSPlanes planes{drm_fd, crtc_id};
+
+    uint32_t const gamma_blob{78};
+    EXPECT_CALL(mock_drm, drmModeCreatePropertyBlob(drm_fd, _, 3 * sizeof(drm_color_lut), _))
+        .WillOnce(DoAll(SetArgPointee<3>(gamma_blob), Return(0)));
+
+    mir::graphics::GammaCurve const ramp{0, 0x8000, 0xffff};
+    EXPECT_TRUE(planes.set_gamma({ramp, ramp, ramp}));
+    EXPECT_TRUE(planes.needs_atomic_commit());
+
+    std::vector<mtd::AtomicProperty> committed;
+    EXPECT_CALL(mock_drm, drmModeAtomicCommit(_, _, _, _))
+        .WillOnce(WithArg<1>(Invoke(
+            [&](drmModeAtomicReqPtr request)
+            {
+                committed = mtd::atomic_request_properties(request);
+                return 0;
+            })));
+    EXPECT_CALL(mock_drm, drmModeDestroyPropertyBlob(drm_fd, gamma_blob));
+
+    planes.commit(primary, {}, 0, nullptr);
+
+    EXPECT_TRUE(commits_property(committed, crtc_id, gamma_lut_property, gamma_blob));
+    EXPECT_FALSE(planes.needs_atomic_commit());
+}
+
+TEST_F(KMSPlanesTest, set_gamma_rejects_ramps_not_matching_the_lut_size)
+{
+    fake_planes.add_plane(DRM_PLANE_TYPE_PRIMARY, this_crtc_mask);
+    fake_planes.add_object(crtc_id, {{gamma_lut_property, 0}, {gamma_lut_size_property, 256}});
+
+    mgg::KMSPlanes planes{drm_fd, crtc_id};
+
+    EXPECT_CALL(mock_drm, drmModeCreatePropertyBlob(_, _, _, _)).Times(0);
+
+    mir::graphics::GammaCurve const ramp{0, 0x8000, 0xffff};
+    EXPECT_FALSE(planes.set_gamma({ramp, ramp, ramp}));
+    EXPECT_FALSE(planes.needs_atomic_commit());
+}
@@ -44,6 +44,9 @@ class NullPageFlipper : public mgg::PageFlipper
 {
 public:
     bool schedule_flip(uint32_t,uint32_t,uint32_t) override { return true; }
+    bool schedule_atomic_flip(uint32_t, uint32_t, std::function<int(void*)> const&) override { return true; }
+    auto queue_atomic_flip(uint32_t, uint32_t, std::function<int(void*)>) -> mgg::QueuedFlip override { return {}; }
+    auto presented_flip(uint32_t) -> mgg::PresentedFlip override { return {}; }
     mg::Frame wait_for_flip(uint32_t) override { return {}; }
 };
 
@@ -51,6 +54,9 @@ class MockPageFlipper : public mgg::PageFlipper
 {
 public:
     MOCK_METHOD3(schedule_flip, bool(uint32_t,uint32_t,uint32_t));
+    MOCK_METHOD3(schedule_atomic_flip, bool(uint32_t, uint32_t, std::function<int(void*)> const&));
+    MOCK_METHOD3(queue_atomic_flip, mgg::QueuedFlip(uint32_t, uint32_t, std::function<int(void*)>));
+    MOCK_METHOD1(presented_flip, mgg::PresentedFlip(uint32_t));
     MOCK_METHOD1(wait_for_flip, mg::Frame(uint32_t));
 };
 
@@ -546,3 +552,30 @@ TEST_F(RealKMSOutputTest, drm_set_gamma_failure_does_not_throw)
 
     EXPECT_NO_THROW(output.set_gamma(gamma););
 }
+
+TEST_F(RealKMSOutputTest, overlays_fail_test_while_output_is_powered_off)
+{
+    using namespace testing;
+
+    uint32_t const fb_id{67};
+
+    setup_outputs_connected_crtc();
+
+    mgg::RealKMSOutput output{
+        drm_fd,
+        mg::kms::get_connector(drm_fd, connector_ids[0]),
+        mt::fake_shared(mock_page_flipper)};
+
+    append_fb_id(fb_id);
+
+    auto fb = output.fb_for(fake_bo);
+
+    EXPECT_TRUE(output.set_crtc(*fb));
+
+    output.set_power_mode(mir_power_mode_off);
+
+    EXPECT_CALL(mock_drm, drmModeGetPlaneResources(_)).Times(0);
+    EXPECT_CALL(mock_drm, drmModeAtomicCommit(_, _, _, _)).Times(0);
+
+    EXPECT_FALSE(output.test_overlays(*fb, {}));
+}
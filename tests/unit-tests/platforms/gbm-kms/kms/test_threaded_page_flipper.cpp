@@ -0,0 +1,195 @@
+/*
+ * Copyright © 2022 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/platforms/gbm-kms/server/kms/threaded_page_flipper.h"
+
+#include "mir/test/doubles/mock_drm.h"
+#include "mir/test/doubles/mock_display_report.h"
+#include "mir/test/fake_shared.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+#include <fcntl.h>
+
+namespace mg  = mir::graphics;
+namespace mgg = mir::graphics::gbm;
+namespace mt  = mir::test;
+namespace mtd = mir::test::doubles;
+
+using namespace testing;
+
+namespace
+{
+
+ACTION_P(InvokePageFlipHandler, param)
+{
+    int const dont_care{0};
+    char dummy;
+
+    arg1->page_flip_handler(dont_care, dont_care, dont_care, dont_care, *param);
+    ASSERT_EQ(1, read(arg0, &dummy, 1));
+}
+
+class ThreadedPageFlipperTest : public ::testing::Test
+{
+public:
+    ThreadedPageFlipperTest()
+        : drm_fd{open(drm_device, 0, 0)}
+    {
+        ON_CALL(mock_drm, drmHandleEvent(drm_fd, _))
+            .WillByDefault(DoAll(InvokePageFlipHandler(&user_data), Return(0)));
+    }
+
+    /// A commit recording which flip it submitted, and the event data to complete it with
+    auto commit_for(int id) -> std::function<int(void*)>
+    {
+        return [this, id](void* event_data)
+            {
+                user_data = event_data;
+                committed.push_back(id);
+                return 0;
+            };
+    }
+
+    NiceMock<mtd::MockDisplayReport> report;
+    NiceMock<mtd::MockDRM> mock_drm;
+
+    char const* const drm_device = "/dev/dri/card0";
+    int const drm_fd;
+
+    uint32_t const crtc_id{10};
+    uint32_t const connector_id{345};
+
+    // Written by commits, which are called with the flipper's lock held
+    void* user_data{nullptr};
+    std::vector<int> committed;
+
+    mgg::ThreadedPageFlipper page_flipper{drm_fd, mt::fake_shared(report)};
+};
+
+}
+
+TEST_F(ThreadedPageFlipperTest, wait_for_flip_returns_after_event_is_handled_on_event_thread)
+{
+    EXPECT_CALL(mock_drm, drmModePageFlip(drm_fd, crtc_id, _, _, _))
+        .WillOnce(DoAll(SaveArg<4>(&user_data), Return(0)));
+    EXPECT_CALL(report, report_vsync(connector_id, _));
+
+    EXPECT_TRUE(page_flipper.schedule_flip(crtc_id, 101, connector_id));
+    mock_drm.generate_event_on(drm_device);
+
+    page_flipper.wait_for_flip(crtc_id);
+}
+
+TEST_F(ThreadedPageFlipperTest, double_schedule_flip_throws)
+{
+    EXPECT_CALL(mock_drm, drmModePageFlip(drm_fd, crtc_id, _, _, _))
+        .WillOnce(Return(0));
+
+    page_flipper.schedule_flip(crtc_id, 101, connector_id);
+
+    EXPECT_THROW({
+        page_flipper.schedule_flip(crtc_id, 101, connector_id);
+    }, std::logic_error);
+}
+
+TEST_F(ThreadedPageFlipperTest, failed_schedule_is_not_pending)
+{
+    EXPECT_CALL(mock_drm, drmModePageFlip(drm_fd, crtc_id, _, _, _))
+        .WillOnce(Return(-EBUSY));
+
+    EXPECT_FALSE(page_flipper.schedule_flip(crtc_id, 101, connector_id));
+
+    // Doesn't block
+    page_flipper.wait_for_flip(crtc_id);
+}
+
+TEST_F(ThreadedPageFlipperTest, queued_flip_is_submitted_immediately_when_idle)
+{
+    auto const queued = page_flipper.queue_atomic_flip(crtc_id, connector_id, commit_for(1));
+
+    EXPECT_TRUE(queued.id);
+    EXPECT_THAT(queued.discarded, IsEmpty());
+    EXPECT_THAT(committed, ElementsAre(1));
+}
+
+TEST_F(ThreadedPageFlipperTest, queued_flip_is_held_until_pending_flip_completes)
+{
+    auto const first = page_flipper.queue_atomic_flip(crtc_id, connector_id, commit_for(1));
+    auto const second = page_flipper.queue_atomic_flip(crtc_id, connector_id, commit_for(2));
+
+    ASSERT_TRUE(first.id);
+    ASSERT_TRUE(second.id);
+    EXPECT_LT(*first.id, *second.id);
+    EXPECT_THAT(committed, ElementsAre(1));
+
+    // The first completing submits the second; then that completes
+    mock_drm.generate_event_on(drm_device);
+    mock_drm.generate_event_on(drm_device);
+    page_flipper.wait_for_flip(crtc_id);
+
+    EXPECT_THAT(committed, ElementsAre(1, 2));
+    EXPECT_THAT(page_flipper.presented_flip(crtc_id).id, Eq(*second.id));
+}
+
+TEST_F(ThreadedPageFlipperTest, replacing_a_held_flip_discards_it)
+{
+    auto const first = page_flipper.queue_atomic_flip(crtc_id, connector_id, commit_for(1));
+    auto const second = page_flipper.queue_atomic_flip(crtc_id, connector_id, commit_for(2));
+    auto const third = page_flipper.queue_atomic_flip(crtc_id, connector_id, commit_for(3));
+
+    ASSERT_TRUE(second.id);
+    ASSERT_TRUE(third.id);
+    EXPECT_THAT(third.discarded, ElementsAre(*second.id));
+
+    mock_drm.generate_event_on(drm_device);
+    mock_drm.generate_event_on(drm_device);
+    page_flipper.wait_for_flip(crtc_id);
+
+    EXPECT_THAT(committed, ElementsAre(1, 3));
+    EXPECT_THAT(page_flipper.presented_flip(crtc_id).id, Eq(*third.id));
+}
+
+TEST_F(ThreadedPageFlipperTest, held_flip_failing_to_submit_is_reported_discarded)
+{
+    page_flipper.queue_atomic_flip(crtc_id, connector_id, commit_for(1));
+    auto const failing = page_flipper.queue_atomic_flip(
+        crtc_id,
+        connector_id,
+        [](void*) { return -EINVAL; });
+    ASSERT_TRUE(failing.id);
+
+    mock_drm.generate_event_on(drm_device);
+    page_flipper.wait_for_flip(crtc_id);
+
+    auto const next = page_flipper.queue_atomic_flip(crtc_id, connector_id, commit_for(3));
+    EXPECT_THAT(next.discarded, ElementsAre(*failing.id));
+}
+
+TEST_F(ThreadedPageFlipperTest, scheduling_while_a_flip_is_held_throws)
+{
+    page_flipper.queue_atomic_flip(crtc_id, connector_id, commit_for(1));
+    page_flipper.queue_atomic_flip(crtc_id, connector_id, commit_for(2));
+
+    EXPECT_THROW({
+        page_flipper.schedule_atomic_flip(crtc_id, connector_id, commit_for(3));
+    }, std::logic_error);
+}
@@ -0,0 +1,173 @@
+/*
+ * Copyright © 2022 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include "src/platforms/virtual/display.h"
+#include "src/platforms/virtual/display_buffer.h"
+#include "src/platforms/virtual/platform.h"
+#include "src/server/report/null/display_report.h"
+
+#include "mir/graphics/display_configuration.h"
+
+#include "mir/test/doubles/null_display_configuration_policy.h"
+#include "mir/test/doubles/mock_egl.h"
+#include "mir/test/doubles/mock_gl.h"
+#include "mir/test/doubles/mock_gl_config.h"
+#include "mir/test/fake_shared.h"
+
+#include <GLES2/gl2ext.h>
+
+#include <chrono>
+
+namespace mg = mir::graphics;
+namespace mgv = mg::virt;
+namespace mt = mir::test;
+namespace mtd = mt::doubles;
+namespace geom = mir::geometry;
+using namespace testing;
+using namespace std::chrono_literals;
+
+namespace
+{
+class VirtualDisplayTest : public Test
+{
+public:
+    VirtualDisplayTest()
+    {
+        ON_CALL(mock_egl, eglQueryString(_, EGL_EXTENSIONS))
+            .WillByDefault(Return("EGL_EXT_platform_base EGL_MESA_platform_surfaceless EGL_KHR_surfaceless_context"));
+    }
+
+    auto create_display(std::vector<mgv::VirtualOutputConfig> const& outputs) -> std::unique_ptr<mgv::Display>
+    {
+        return std::make_unique<mgv::Display>(
+            outputs,
+            mt::fake_shared(null_display_configuration_policy),
+            mt::fake_shared(mock_gl_config),
+            std::make_shared<mir::report::null::DisplayReport>());
+    }
+
+    static auto output_ids(mg::Display const& display) -> std::vector<mg::DisplayConfigurationOutputId>
+    {
+        std::vector<mg::DisplayConfigurationOutputId> ids;
+        display.configuration()->for_each_output(
+            [&](mg::DisplayConfigurationOutput const& output) { ids.push_back(output.id); });
+        return ids;
+    }
+
+    mtd::NullDisplayConfigurationPolicy null_display_configuration_policy;
+    NiceMock<mtd::MockEGL> mock_egl;
+    NiceMock<mtd::MockGL> mock_gl;
+    NiceMock<mtd::MockGLConfig> mock_gl_config;
+};
+}
+
+TEST_F(VirtualDisplayTest, configuration_has_an_output_per_requested_output_placed_side_by_side)
+{
+    auto const display = create_display({
+        mgv::VirtualOutputConfig{{1280, 1024}, 60.0, 1.0f},
+        mgv::VirtualOutputConfig{{800, 600}, 30.0, 2.0f}});
+
+    std::vector<mg::DisplayConfigurationOutput> outputs;
+    display->configuration()->for_each_output(
+        [&](mg::DisplayConfigurationOutput const& output) { outputs.push_back(output); });
+
+    ASSERT_THAT(outputs.size(), Eq(2u));
+
+    EXPECT_THAT(outputs[0].type, Eq(mg::DisplayConfigurationOutputType::virt));
+    EXPECT_TRUE(outputs[0].connected);
+    EXPECT_TRUE(outputs[0].used);
+    EXPECT_THAT(outputs[0].power_mode, Eq(mir_power_mode_on));
+    EXPECT_THAT(outputs[0].extents(), Eq(geom::Rectangle{{0, 0}, {1280, 1024}}));
+    ASSERT_THAT(outputs[0].modes.size(), Eq(1u));
+    EXPECT_THAT(outputs[0].modes[0].vrefresh_hz, DoubleEq(60.0));
+
+    EXPECT_THAT(outputs[1].top_left, Eq(geom::Point{1280, 0}));
+    EXPECT_THAT(outputs[1].scale, FloatEq(2.0f));
+    ASSERT_THAT(outputs[1].modes.size(), Eq(1u));
+    EXPECT_THAT(outputs[1].modes[0].size, Eq(geom::Size{800, 600}));
+    EXPECT_THAT(outputs[1].modes[0].vrefresh_hz, DoubleEq(30.0));
+}
+
+TEST_F(VirtualDisplayTest, has_a_display_buffer_of_the_output_size_for_each_output)
+{
+    auto const display = create_display({
+        mgv::VirtualOutputConfig{{1280, 1024}, 60.0, 1.0f},
+        mgv::VirtualOutputConfig{{800, 600}, 60.0, 1.0f}});
+
+    std::vector<geom::Rectangle> view_areas;
+    std::vector<geom::Size> sizes;
+    display->for_each_display_sync_group(
+        [&](mg::DisplaySyncGroup& group)
+        {
+            group.for_each_display_buffer(
+                [&](mg::DisplayBuffer& db)
+                {
+                    view_areas.push_back(db.view_area());
+                    sizes.push_back(dynamic_cast<mir::renderer::gl::RenderTarget&>(db).size());
+                });
+        });
+
+    EXPECT_THAT(view_areas, ElementsAre(
+        geom::Rectangle{{0, 0}, {1280, 1024}},
+        geom::Rectangle{{1280, 0}, {800, 600}}));
+    EXPECT_THAT(sizes, ElementsAre(geom::Size{1280, 1024}, geom::Size{800, 600}));
+}
+
+TEST_F(VirtualDisplayTest, swap_buffers_reads_the_whole_output_back_into_the_framebuffer)
+{
+    auto const display = create_display({mgv::VirtualOutputConfig{{640, 480}, 60.0, 1.0f}});
+
+    EXPECT_CALL(mock_gl, glReadPixels(0, 0, 640, 480, GL_BGRA_EXT, GL_UNSIGNED_BYTE, NotNull()));
+
+    display->for_each_display_sync_group(
+        [](mg::DisplaySyncGroup& group)
+        {
+            group.for_each_display_buffer(
+                [](mg::DisplayBuffer& db)
+                {
+                    auto& target = dynamic_cast<mir::renderer::gl::RenderTarget&>(db);
+                    target.make_current();
+                    target.bind();
+                    target.swap_buffers();
+                });
+        });
+}
+
+TEST_F(VirtualDisplayTest, post_waits_for_vblank_and_timestamps_frames_on_the_refresh_period)
+{
+    auto const refresh_rate = 200.0;
+    auto const period = 5ms;
+    auto const display = create_display({mgv::VirtualOutputConfig{{640, 480}, refresh_rate, 1.0f}});
+    auto const id = output_ids(*display).at(0);
+
+    display->for_each_display_sync_group([](mg::DisplaySyncGroup& group) { group.post(); });
+    auto const first = display->last_frame_on(id.as_value());
+
+    display->for_each_display_sync_group([](mg::DisplaySyncGroup& group) { group.post(); });
+    auto const second = display->last_frame_on(id.as_value());
+
+    EXPECT_THAT(first.msc, Ge(1));
+    EXPECT_THAT(second.msc, Gt(first.msc));
+    EXPECT_THAT(first.ust.clock_id, Eq(CLOCK_MONOTONIC));
+
+    // Vblank times come from the tick count, not the wakeup time, so they are exactly a number of periods apart
+    EXPECT_THAT(second.ust - first.ust, Eq(std::chrono::nanoseconds{period} * (second.msc - first.msc)));
+    EXPECT_THAT(mg::Frame::Timestamp::now(CLOCK_MONOTONIC).nanoseconds, Ge(second.ust.nanoseconds))
+        << "post() returns once the vblank has happened";
+}
@@ -0,0 +1,123 @@
+/*
+ * Copyright © 2022 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include "mir/options/program_option.h"
+#include "src/platforms/virtual/platform.h"
+#include "src/server/report/null/display_report.h"
+
+#include "mir/shared_library.h"
+#include "mir_test_framework/executable_path.h"
+
+namespace mir
+{
+namespace graphics
+{
+namespace virt
+{
+auto operator==(VirtualOutputConfig const& a, VirtualOutputConfig const& b) -> bool
+{
+    return a.size == b.size &&
+           testing::Value(a.refresh_rate, testing::DoubleEq(b.refresh_rate)) &&
+           testing::Value(a.scale, testing::FloatEq(b.scale));
+}
+
+auto operator<<(std::ostream& os, VirtualOutputConfig const& config) -> std::ostream&
+{
+    return os << "size: " << config.size << ", refresh rate: " << config.refresh_rate << ", scale: " << config.scale;
+}
+}
+}
+}
+
+namespace mg = mir::graphics;
+namespace mgv = mir::graphics::virt;
+namespace mtf = mir_test_framework;
+
+namespace
+{
+const char probe_platform[] = "probe_display_platform";
+}
+
+TEST(VirtualGraphicsPlatformTest, probe_returns_nothing_when_no_virtual_outputs_requested)
+{
+    using namespace ::testing;
+
+    mir::options::ProgramOption options;
+
+    mir::SharedLibrary platform_lib{mtf::server_platform("graphics-virtual")};
+    auto probe = platform_lib.load_function<mg::PlatformProbe>(probe_platform);
+
+    EXPECT_THAT(probe(nullptr, nullptr, options), IsEmpty());
+}
+
+TEST(VirtualGraphicsPlatformTest, construction_with_no_outputs_throws)
+{
+    EXPECT_THROW(
+        {
+            mgv::Platform(
+                std::vector<mgv::VirtualOutputConfig>{},
+                std::make_shared<mir::report::null::DisplayReport>());
+        }, std::runtime_error);
+}
+
+TEST(VirtualGraphicsPlatformTest, parses_simple_output_size_with_default_refresh_rate)
+{
+    using namespace ::testing;
+
+    auto parsed = mgv::Platform::parse_output_configs("1280x720", 60.0);
+
+    EXPECT_THAT(parsed, ElementsAre(mgv::VirtualOutputConfig{{1280, 720}, 60.0, 1.0f}));
+}
+
+TEST(VirtualGraphicsPlatformTest, parses_output_refresh_rate_and_scale)
+{
+    using namespace ::testing;
+
+    auto parsed = mgv::Platform::parse_output_configs("1920x1080@144^1.5", 60.0);
+
+    EXPECT_THAT(parsed, ElementsAre(mgv::VirtualOutputConfig{{1920, 1080}, 144.0, 1.5f}));
+}
+
+TEST(VirtualGraphicsPlatformTest, parses_multiple_outputs)
+{
+    using namespace ::testing;
+
+    auto parsed = mgv::Platform::parse_output_configs("1280x1024:800x600@59.94:640x480^2", 30.0);
+
+    EXPECT_THAT(parsed, ElementsAre(
+        mgv::VirtualOutputConfig{{1280, 1024}, 30.0, 1.0f},
+        mgv::VirtualOutputConfig{{800, 600}, 59.94, 1.0f},
+        mgv::VirtualOutputConfig{{640, 480}, 30.0, 2.0f}));
+}
+
+TEST(VirtualGraphicsPlatformTest, output_parsing_throws_on_bad_input)
+{
+    EXPECT_THROW(mgv::Platform::parse_output_configs("1280", 60), std::runtime_error) << "No height or 'x'";
+    EXPECT_THROW(mgv::Platform::parse_output_configs("1280x", 60), std::runtime_error) << "No height";
+    EXPECT_THROW(mgv::Platform::parse_output_configs("x1280", 60), std::runtime_error) << "No width";
+    EXPECT_THROW(mgv::Platform::parse_output_configs("1280x720:", 60), std::runtime_error) << "Ends with delim";
+    EXPECT_THROW(mgv::Platform::parse_output_configs(":1280x720", 60), std::runtime_error) << "Starts with delim";
+    EXPECT_THROW(mgv::Platform::parse_output_configs("0x200", 60), std::runtime_error) << "Zero width";
+    EXPECT_THROW(mgv::Platform::parse_output_configs("200x300@", 60), std::runtime_error) << "Ends with @";
+    EXPECT_THROW(mgv::Platform::parse_output_configs("200x300@0", 60), std::runtime_error) << "Zero refresh rate";
+    EXPECT_THROW(mgv::Platform::parse_output_configs("200x300@-60", 60), std::runtime_error) << "Negative refresh rate";
+    EXPECT_THROW(mgv::Platform::parse_output_configs("200x300^", 60), std::runtime_error) << "Ends with ^";
+    EXPECT_THROW(mgv::Platform::parse_output_configs("200x300^2@60", 60), std::runtime_error) << "Scale before refresh rate";
+    EXPECT_THROW(mgv::Platform::parse_output_configs("200x300", 0), std::runtime_error) << "Zero default refresh rate";
+}
@@ -0,0 +1,213 @@
+/*
+ * Copyright © 2022 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/platforms/wayland/host_passthrough.h"
+
+#include "mir/graphics/dmabuf_buffer.h"
+#include "mir/test/doubles/mock_renderable.h"
+#include "mir/test/doubles/stub_buffer.h"
+
+#include <drm_fourcc.h>
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+namespace mg = mir::graphics;
+namespace mgw = mir::graphics::wayland;
+namespace mtd = mir::test::doubles;
+namespace geom = mir::geometry;
+
+using namespace testing;
+
+namespace
+{
+class StubDMABuf : public mg::DMABufBuffer
+{
+public:
+    StubDMABuf(geom::Size size, uint32_t format, std::optional<uint64_t> modifier)
+        : size_{size},
+          format{format},
+          modifier_{modifier}
+    {
+    }
+
+    auto drm_fourcc() const -> uint32_t override { return format; }
+    auto modifier() const -> std::optional<uint64_t> override { return modifier_; }
+    auto planes() const -> std::vector<PlaneDescriptor> const& override { return planes_; }
+    auto size() const -> geom::Size override { return size_; }
+
+private:
+    geom::Size const size_;
+    uint32_t const format;
+    std::optional<uint64_t> const modifier_;
+    std::vector<PlaneDescriptor> const planes_;
+};
+
+/// A client buffer backed by a dmabuf
+class StubDMABufBuffer : public mtd::StubBuffer
+{
+public:
+    StubDMABufBuffer(geom::Size size, uint32_t format, std::optional<uint64_t> modifier)
+        : StubBuffer{size},
+          dmabuf{size, format, modifier}
+    {
+    }
+
+    auto native_buffer_base() -> mg::NativeBufferBase* override
+    {
+        return &dmabuf;
+    }
+
+private:
+    StubDMABuf dmabuf;
+};
+
+struct HostPassthrough : Test
+{
+    HostPassthrough()
+    {
+        ON_CALL(*renderable, screen_position()).WillByDefault(Return(view_area));
+        ON_CALL(*renderable, buffer()).WillByDefault(Return(buffer));
+        ON_CALL(*renderable, transformation()).WillByDefault(Return(glm::mat4{1}));
+        ON_CALL(*renderable, shaped()).WillByDefault(Return(false));
+
+        ON_CALL(host, supports(_, _)).WillByDefault(Return(false));
+        ON_CALL(host, supports(DRM_FORMAT_XRGB8888, DRM_FORMAT_MOD_LINEAR)).WillByDefault(Return(true));
+    }
+
+    auto passthrough_buffer(mg::RenderableList const& renderlist) -> std::shared_ptr<mg::Buffer>
+    {
+        return mgw::host_passthrough_buffer(
+            renderlist,
+            view_area,
+            output_size,
+            [this](uint32_t format, uint64_t modifier) { return host.supports(format, modifier); });
+    }
+
+    struct MockHost
+    {
+        MOCK_METHOD(bool, supports, (uint32_t format, uint64_t modifier));
+    };
+
+    geom::Rectangle const view_area{{100, 0}, {960, 540}};
+    geom::Size const output_size{1920, 1080};
+    std::shared_ptr<mg::Buffer> const buffer{
+        std::make_shared<StubDMABufBuffer>(output_size, DRM_FORMAT_XRGB8888, DRM_FORMAT_MOD_LINEAR)};
+    std::shared_ptr<NiceMock<mtd::MockRenderable>> const renderable{std::make_shared<NiceMock<mtd::MockRenderable>>()};
+    NiceMock<MockHost> host;
+};
+}
+
+TEST_F(HostPassthrough, opaque_dmabuf_covering_the_output_is_passed_to_the_host)
+{
+    EXPECT_THAT(passthrough_buffer({renderable}), Eq(buffer));
+}
+
+TEST_F(HostPassthrough, empty_output_is_composited)
+{
+    EXPECT_THAT(passthrough_buffer({}), IsNull());
+}
+
+TEST_F(HostPassthrough, only_the_topmost_renderable_on_the_output_is_considered)
+{
+    auto const off_output = std::make_shared<NiceMock<mtd::MockRenderable>>();
+    ON_CALL(*off_output, screen_position()).WillByDefault(Return(geom::Rectangle{{2000, 0}, {10, 10}}));
+    auto const on_top = std::make_shared<NiceMock<mtd::MockRenderable>>();
+    ON_CALL(*on_top, screen_position()).WillByDefault(Return(geom::Rectangle{{110, 10}, {10, 10}}));
+
+    EXPECT_THAT(passthrough_buffer({renderable, off_output}), Eq(buffer));
+    EXPECT_THAT(passthrough_buffer({renderable, on_top}), IsNull());
+}
+
+TEST_F(HostPassthrough, translucent_renderable_is_composited)
+{
+    ON_CALL(*renderable, alpha()).WillByDefault(Return(0.5f));
+
+    EXPECT_THAT(passthrough_buffer({renderable}), IsNull());
+}
+
+TEST_F(HostPassthrough, shaped_renderable_is_composited)
+{
+    ON_CALL(*renderable, shaped()).WillByDefault(Return(true));
+
+    EXPECT_THAT(passthrough_buffer({renderable}), IsNull());
+}
+
+TEST_F(HostPassthrough, renderable_not_exactly_covering_the_output_is_composited)
+{
+    ON_CALL(*renderable, screen_position()).WillByDefault(Return(geom::Rectangle{{101, 0}, {960, 540}}));
+    EXPECT_THAT(passthrough_buffer({renderable}), IsNull());
+
+    ON_CALL(*renderable, screen_position()).WillByDefault(Return(geom::Rectangle{{0, 0}, {1920, 1080}}));
+    EXPECT_THAT(passthrough_buffer({renderable}), IsNull());
+}
+
+TEST_F(HostPassthrough, renderable_clipped_within_the_output_is_composited)
+{
+    ON_CALL(*renderable, clip_area()).WillByDefault(Return(geom::Rectangle{{100, 0}, {960, 500}}));
+
+    EXPECT_THAT(passthrough_buffer({renderable}), IsNull());
+}
+
+TEST_F(HostPassthrough, renderable_clipped_outside_the_output_is_passed_to_the_host)
+{
+    ON_CALL(*renderable, clip_area()).WillByDefault(Return(geom::Rectangle{{0, 0}, {1920, 1080}}));
+
+    EXPECT_THAT(passthrough_buffer({renderable}), Eq(buffer));
+}
+
+TEST_F(HostPassthrough, transformed_renderable_is_composited)
+{
+    ON_CALL(*renderable, transformation()).WillByDefault(Return(glm::mat4{2}));
+
+    EXPECT_THAT(passthrough_buffer({renderable}), IsNull());
+}
+
+TEST_F(HostPassthrough, buffer_of_a_different_size_to_the_output_is_composited)
+{
+    ON_CALL(*renderable, buffer()).WillByDefault(Return(
+        std::make_shared<StubDMABufBuffer>(view_area.size, DRM_FORMAT_XRGB8888, DRM_FORMAT_MOD_LINEAR)));
+
+    EXPECT_THAT(passthrough_buffer({renderable}), IsNull());
+}
+
+TEST_F(HostPassthrough, buffer_without_a_dmabuf_is_composited)
+{
+    ON_CALL(*renderable, buffer()).WillByDefault(Return(std::make_shared<mtd::StubBuffer>(output_size)));
+
+    EXPECT_THAT(passthrough_buffer({renderable}), IsNull());
+}
+
+TEST_F(HostPassthrough, dmabuf_the_host_cannot_import_is_composited)
+{
+    ON_CALL(*renderable, buffer()).WillByDefault(Return(
+        std::make_shared<StubDMABufBuffer>(output_size, DRM_FORMAT_ARGB8888, DRM_FORMAT_MOD_LINEAR)));
+    EXPECT_THAT(passthrough_buffer({renderable}), IsNull());
+
+    ON_CALL(*renderable, buffer()).WillByDefault(Return(
+        std::make_shared<StubDMABufBuffer>(output_size, DRM_FORMAT_XRGB8888, I915_FORMAT_MOD_X_TILED)));
+    EXPECT_THAT(passthrough_buffer({renderable}), IsNull());
+}
+
+TEST_F(HostPassthrough, host_is_asked_about_implicit_modifiers_as_invalid)
+{
+    ON_CALL(*renderable, buffer()).WillByDefault(Return(
+        std::make_shared<StubDMABufBuffer>(output_size, DRM_FORMAT_XRGB8888, std::nullopt)));
+
+    EXPECT_CALL(host, supports(DRM_FORMAT_XRGB8888, DRM_FORMAT_MOD_INVALID)).WillOnce(Return(true));
+
+    EXPECT_THAT(passthrough_buffer({renderable}), NotNull());
+}
@@ -142,9 +142,66 @@ TEST_F(BasicBufferRenderTarget, throws_on_invalid_buffer)
     EXPECT_THROW({
         mtd::StubBuffer buffer({
             reasonable_size,
-            mir_pixel_format_abgr_8888, // wrong format
+            mir_pixel_format_rgb_565, // wrong format
             mg::BufferUsage::software});
         render_target.set_buffer(mt::fake_shared(buffer));
         render_target.swap_buffers();
     }, std::logic_error);
 }
+
+TEST_F(BasicBufferRenderTarget, accepts_buffer_with_padded_rows)
+{
+    mrg::BasicBufferRenderTarget render_target{mt::fake_shared(ctx)};
+    mtd::StubBuffer padded_buffer{
+        nullptr,
+        {reasonable_size, reasonable_pixel_format, mg::BufferUsage::software},
+        geom::Stride{reasonable_width * 4 + 64}};
+    render_target.set_buffer(mt::fake_shared(padded_buffer));
+    EXPECT_CALL(mock_gl, glReadPixels(0, 0, reasonable_width, reasonable_height, _, _, _));
+    EXPECT_NO_THROW(render_target.swap_buffers());
+}
+
+TEST_F(BasicBufferRenderTarget, reads_rgba_buffers_without_swizzling)
+{
+    mrg::BasicBufferRenderTarget render_target{mt::fake_shared(ctx)};
+    mtd::StubBuffer abgr_buffer{{reasonable_size, mir_pixel_format_abgr_8888, mg::BufferUsage::software}};
+    render_target.set_buffer(mt::fake_shared(abgr_buffer));
+    EXPECT_CALL(mock_gl, glReadPixels(_, _, _, _, GL_RGBA, GL_UNSIGNED_BYTE, _));
+    render_target.swap_buffers();
+}
+
+TEST_F(BasicBufferRenderTarget, only_reads_damaged_rows_counted_from_the_bottom)
+{
+    mrg::BasicBufferRenderTarget render_target{mt::fake_shared(ctx)};
+    render_target.set_buffer(mt::fake_shared(reasonable_buffer));
+    render_target.set_damage({{4, 2}, {8, 6}});
+    EXPECT_CALL(mock_gl, glReadPixels(4, reasonable_height - 8, 8, 6, _, _, _));
+    render_target.swap_buffers();
+}
+
+TEST_F(BasicBufferRenderTarget, damage_only_applies_to_the_next_frame)
+{
+    mrg::BasicBufferRenderTarget render_target{mt::fake_shared(ctx)};
+    render_target.set_buffer(mt::fake_shared(reasonable_buffer));
+    render_target.set_damage({{4, 2}, {8, 6}});
+    render_target.swap_buffers();
+    EXPECT_CALL(mock_gl, glReadPixels(0, 0, reasonable_width, reasonable_height, _, _, _));
+    render_target.swap_buffers();
+}
+
+TEST_F(BasicBufferRenderTarget, does_not_read_back_if_nothing_is_damaged)
+{
+    mrg::BasicBufferRenderTarget render_target{mt::fake_shared(ctx)};
+    render_target.set_buffer(mt::fake_shared(reasonable_buffer));
+    render_target.set_damage({});
+    EXPECT_CALL(mock_gl, glReadPixels(_, _, _, _, _, _, _)).Times(0);
+    render_target.swap_buffers();
+}
+
+TEST_F(BasicBufferRenderTarget, copies_synchronously_without_pixel_pack_buffers)
+{
+    mrg::BasicBufferRenderTarget render_target{mt::fake_shared(ctx)};
+    render_target.set_buffer(mt::fake_shared(reasonable_buffer));
+    render_target.swap_buffers();
+    EXPECT_FALSE(render_target.take_pending_copy());
+}
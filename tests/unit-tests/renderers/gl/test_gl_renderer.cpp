@@ -22,6 +22,7 @@
 #include <mir/test/doubles/mock_gl_buffer.h>
 #include <mir/test/doubles/mock_renderable.h>
 #include <mir/compositor/buffer_stream.h>
+#include <mir/graphics/solid_color_buffer.h>
 #include <mir/test/doubles/mock_gl.h>
 #include <mir/test/doubles/mock_egl.h>
 #include <src/renderers/gl/renderer.h>
@@ -36,6 +37,7 @@ using testing::Pointee;
 using testing::AnyNumber;
 using testing::AtLeast;
 using testing::DoAll;
+using testing::FloatEq;
 using testing::_;
 
 namespace mt=mir::test;
@@ -110,6 +112,7 @@ public:
             .Times(AnyNumber());
         EXPECT_CALL(mock_gl, glUniform1f(_, _)).Times(AnyNumber());
         EXPECT_CALL(mock_gl, glUniform2f(_, _, _)).Times(AnyNumber());
+        EXPECT_CALL(mock_gl, glUniform4f(_, _, _, _, _)).Times(AnyNumber());
         EXPECT_CALL(mock_gl, glBindBuffer(_, _)).Times(AnyNumber());
         EXPECT_CALL(mock_gl, glVertexAttribPointer(_, _, _, _, _, _))
             .Times(AnyNumber());
@@ -226,6 +229,41 @@ TEST_F(GLRenderer, avoids_src_alpha_for_rgbx_blending)  // LP: #1423462
     renderer.render(renderable_list);
 }
 
+TEST_F(GLRenderer, fills_solid_color_buffers_without_a_texture)
+{
+    auto const solid_color = std::make_shared<mg::SolidColorBuffer>(
+        mir::geometry::Size{1, 1},
+        glm::vec4{0.25f, 0.5f, 0.75f, 1.0f});
+    EXPECT_CALL(*renderable, buffer()).WillRepeatedly(Return(solid_color));
+
+    EXPECT_CALL(*mock_buffer, bind()).Times(0);
+    EXPECT_CALL(mock_gl, glBindTexture(_, _)).Times(0);
+    EXPECT_CALL(mock_gl, glUniform4f(_, FloatEq(0.25f), FloatEq(0.5f), FloatEq(0.75f), FloatEq(1.0f)));
+    EXPECT_CALL(mock_gl, glDisable(GL_BLEND));
+    EXPECT_CALL(mock_gl, glDrawArrays(_, _, _)).Times(AtLeast(1));
+
+    mrg::Renderer renderer(display_buffer);
+    renderer.render(renderable_list);
+}
+
+TEST_F(GLRenderer, blends_solid_colors_premultiplied_by_renderable_alpha)
+{
+    auto const solid_color = std::make_shared<mg::SolidColorBuffer>(
+        mir::geometry::Size{1, 1},
+        glm::vec4{0.2f, 0.4f, 0.6f, 1.0f});
+    EXPECT_CALL(*renderable, buffer()).WillRepeatedly(Return(solid_color));
+    EXPECT_CALL(*renderable, alpha()).WillRepeatedly(Return(0.5f));
+
+    EXPECT_CALL(mock_gl, glUniform4f(_, FloatEq(0.1f), FloatEq(0.2f), FloatEq(0.3f), FloatEq(0.5f)));
+    EXPECT_CALL(mock_gl, glDisable(GL_BLEND)).Times(0);
+    EXPECT_CALL(mock_gl, glEnable(GL_BLEND));
+    EXPECT_CALL(mock_gl, glBlendFuncSeparate(GL_ONE, GL_ONE_MINUS_SRC_ALPHA,
+                                             GL_ONE, GL_ONE_MINUS_SRC_ALPHA));
+
+    mrg::Renderer renderer(display_buffer);
+    renderer.render(renderable_list);
+}
+
 TEST_F(GLRenderer, clears_to_opaque_black)
 {
     InSequence seq;
@@ -18,7 +18,6 @@
 #include "mir/executor.h"
 #include "mir/test/doubles/mock_idle_hub.h"
 #include "mir/test/doubles/stub_input_scene.h"
-#include "mir/test/doubles/stub_buffer_allocator.h"
 #include "mir/shell/display_configuration_controller.h"
 #include "mir/test/fake_shared.h"
 
@@ -50,12 +49,10 @@ struct BasicIdleHandler: Test
 {
     NiceMock<mtd::MockIdleHub> idle_hub;
     mtd::StubInputScene input_scene;
-    mtd::StubBufferAllocator allocator;
     NiceMock<MockDisplayConfigurationController> display;
     msh::BasicIdleHandler handler{
         mt::fake_shared(idle_hub),
         mt::fake_shared(input_scene),
-        mt::fake_shared(allocator),
         mt::fake_shared(display)};
     std::map<mir::time::Duration, std::weak_ptr<ms::IdleStateObserver>> observers;
 
@@ -94,7 +91,6 @@ TEST_F(BasicIdleHandler, does_not_register_observers_by_default)
     msh::BasicIdleHandler local_handler{
         mt::fake_shared(idle_hub),
         mt::fake_shared(input_scene),
-        mt::fake_shared(allocator),
         mt::fake_shared(display)};
 }
 
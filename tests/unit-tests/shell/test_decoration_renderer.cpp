@@ -0,0 +1,422 @@
+/*
+ * Copyright © 2022 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/shell/decoration/renderer.h"
+#include "src/server/shell/decoration/glyph_cache.h"
+#include "src/server/shell/decoration/pixel_blend.h"
+#include "src/server/shell/decoration/window.h"
+#include "src/server/shell/decoration/input.h"
+
+#include "mir/graphics/buffer.h"
+#include "mir/renderer/sw/pixel_source.h"
+#include "mir/test/doubles/stub_buffer_allocator.h"
+#include "mir/test/doubles/stub_surface.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cstring>
+#include <stdexcept>
+
+namespace mg = mir::graphics;
+namespace mrs = mir::renderer::software;
+namespace geom = mir::geometry;
+namespace msd = mir::shell::decoration;
+namespace mtd = mir::test::doubles;
+
+using namespace testing;
+
+namespace
+{
+/// Rounds a value of at most 255 * 255 divided by 255 to the nearest integer
+auto rounded_div255(uint32_t value) -> uint32_t
+{
+    return (value + 127) / 255;
+}
+
+/// What blend_row() should make of one pixel, worked out a channel at a time
+auto expected_blend(uint32_t dest, unsigned char coverage, uint32_t color) -> uint32_t
+{
+    uint32_t const alpha = rounded_div255(coverage * (color >> 24));
+    uint32_t result = dest & 0xff000000;
+    for (auto const shift : {0, 8, 16})
+    {
+        uint32_t const color_channel = (color >> shift) & 0xff;
+        uint32_t const dest_channel = (dest >> shift) & 0xff;
+        result |= rounded_div255(color_channel * alpha + dest_channel * (255 - alpha)) << shift;
+    }
+    return result;
+}
+
+/// Long enough to blend a group of four pixels as PixelLanes and the rest one at a time
+int const row_length{7};
+using Row = std::array<uint32_t, row_length>;
+using Coverage = std::array<unsigned char, row_length>;
+
+Row const mixed_pixels{0xff000000, 0xffffffff, 0x80123456, 0x00fedcba, 0xff808080, 0x7f010203, 0xfffefdfc};
+
+auto blended(Row row, Coverage const& coverage, uint32_t color) -> Row
+{
+    msd::blend_row(row.data(), coverage.data(), row_length, color);
+    return row;
+}
+
+auto expected_row(Row const& row, Coverage const& coverage, uint32_t color) -> Row
+{
+    Row result;
+    for (auto i = 0; i < row_length; i++)
+    {
+        result[i] = expected_blend(row[i], coverage[i], color);
+    }
+    return result;
+}
+}
+
+TEST(DecorationPixelBlend, div255_pairs_rounds_both_halves_to_nearest)
+{
+    for (uint32_t value = 0; value <= 255 * 255; value++)
+    {
+        auto const result = msd::div255_pairs<uint32_t>(value | (255 * 255 - value) << 16);
+        ASSERT_THAT(result & 0xffff, Eq(rounded_div255(value))) << "value " << value;
+        ASSERT_THAT(result >> 16, Eq(rounded_div255(255 * 255 - value))) << "value " << value;
+    }
+}
+
+TEST(DecorationPixelBlend, zero_coverage_leaves_pixels_unchanged)
+{
+    Coverage const coverage{};
+
+    EXPECT_THAT(blended(mixed_pixels, coverage, 0xff123456), Eq(mixed_pixels));
+}
+
+TEST(DecorationPixelBlend, transparent_color_leaves_pixels_unchanged)
+{
+    Coverage coverage;
+    coverage.fill(255);
+
+    EXPECT_THAT(blended(mixed_pixels, coverage, 0x00123456), Eq(mixed_pixels));
+}
+
+TEST(DecorationPixelBlend, full_coverage_of_an_opaque_color_replaces_the_color_but_keeps_the_alpha)
+{
+    Coverage coverage;
+    coverage.fill(255);
+
+    Row expected;
+    for (auto i = 0; i < row_length; i++)
+    {
+        expected[i] = (mixed_pixels[i] & 0xff000000) | 0x123456;
+    }
+
+    EXPECT_THAT(blended(mixed_pixels, coverage, 0xff123456), Eq(expected));
+}
+
+TEST(DecorationPixelBlend, partial_coverage_is_rounded_to_nearest)
+{
+    Coverage const coverage{1, 64, 127, 128, 191, 254, 100};
+
+    for (auto const color : {0xff123456u, 0x80fedcbau, 0x01ffffffu, 0xfe000000u})
+    {
+        EXPECT_THAT(blended(mixed_pixels, coverage, color), Eq(expected_row(mixed_pixels, coverage, color)))
+            << "color " << std::hex << color;
+    }
+}
+
+TEST(DecorationPixelBlend, lanes_blend_the_same_as_single_pixels)
+{
+    Coverage const coverage{0, 255, 1, 128, 77, 200, 33};
+    uint32_t const color{0xc0a05010};
+
+    for (auto length = 0; length <= row_length; length++)
+    {
+        Row lanes = mixed_pixels;
+        msd::blend_row(lanes.data(), coverage.data(), length, color);
+
+        Row single_pixels = mixed_pixels;
+        for (auto x = 0; x < length; x++)
+        {
+            msd::blend_row(single_pixels.data() + x, coverage.data() + x, 1, color);
+        }
+
+        EXPECT_THAT(lanes, Eq(single_pixels)) << "length " << length;
+    }
+}
+
+namespace
+{
+struct DecorationGlyphCache : Test
+{
+    DecorationGlyphCache()
+    {
+        ON_CALL(rasterizer, rasterize(_, _)).WillByDefault(Invoke([](char32_t, geom::Height height)
+            {
+                auto const glyph = std::make_shared<msd::Glyph>();
+                glyph->size = {height.as_int() / 2, height.as_int()};
+                return glyph;
+            }));
+    }
+
+    struct MockRasterizer
+    {
+        MOCK_METHOD(std::shared_ptr<msd::Glyph const>, rasterize, (char32_t character, geom::Height height));
+    };
+
+    auto make_cache(size_t max_size) -> std::unique_ptr<msd::GlyphCache>
+    {
+        return std::make_unique<msd::GlyphCache>(
+            [this](char32_t character, geom::Height height) { return rasterizer.rasterize(character, height); },
+            max_size);
+    }
+
+    NiceMock<MockRasterizer> rasterizer;
+    geom::Height const height{14};
+};
+}
+
+TEST_F(DecorationGlyphCache, glyph_is_rasterized_once)
+{
+    auto const cache = make_cache(16);
+
+    EXPECT_CALL(rasterizer, rasterize(U'a', height)).Times(1);
+
+    auto const first = cache->glyph(U'a', height);
+    auto const second = cache->glyph(U'a', height);
+
+    EXPECT_THAT(second, Eq(first));
+}
+
+TEST_F(DecorationGlyphCache, each_character_is_rasterized)
+{
+    auto const cache = make_cache(16);
+
+    EXPECT_CALL(rasterizer, rasterize(U'a', height)).Times(1);
+    EXPECT_CALL(rasterizer, rasterize(U'é', height)).Times(1);
+
+    EXPECT_THAT(cache->glyph(U'é', height), Ne(cache->glyph(U'a', height)));
+}
+
+TEST_F(DecorationGlyphCache, glyph_is_rasterized_again_when_the_height_changes)
+{
+    auto const cache = make_cache(16);
+    geom::Height const scaled_height{28};
+
+    EXPECT_CALL(rasterizer, rasterize(U'a', height)).Times(1);
+    EXPECT_CALL(rasterizer, rasterize(U'a', scaled_height)).Times(1);
+
+    auto const original = cache->glyph(U'a', height);
+    auto const scaled = cache->glyph(U'a', scaled_height);
+
+    EXPECT_THAT(scaled, Ne(original));
+    EXPECT_THAT(scaled->size, Eq(geom::Size{14, 28}));
+    EXPECT_THAT(cache->glyph(U'a', height), Eq(original));
+    EXPECT_THAT(cache->glyph(U'a', scaled_height), Eq(scaled));
+}
+
+TEST_F(DecorationGlyphCache, full_cache_is_emptied)
+{
+    auto const cache = make_cache(2);
+
+    EXPECT_CALL(rasterizer, rasterize(U'a', height)).Times(2);
+    EXPECT_CALL(rasterizer, rasterize(U'b', height)).Times(1);
+    EXPECT_CALL(rasterizer, rasterize(U'c', height)).Times(1);
+
+    cache->glyph(U'a', height);
+    cache->glyph(U'b', height);
+    cache->glyph(U'c', height);
+    cache->glyph(U'c', height);
+    cache->glyph(U'a', height);
+}
+
+TEST_F(DecorationGlyphCache, failed_rasterization_is_not_cached)
+{
+    auto const cache = make_cache(16);
+
+    EXPECT_CALL(rasterizer, rasterize(U'a', height))
+        .WillOnce(Throw(std::runtime_error{"Failed to load glyph"}))
+        .WillOnce(Return(std::make_shared<msd::Glyph>()));
+
+    EXPECT_THROW(cache->glyph(U'a', height), std::runtime_error);
+    EXPECT_THAT(cache->glyph(U'a', height), NotNull());
+}
+
+namespace
+{
+// Matches the decorations BasicDecoration draws
+msd::StaticGeometry const geometry{
+    geom::Height{24},   // titlebar_height
+    geom::Width{6},     // side_border_width
+    geom::Height{6},    // bottom_border_height
+    geom::Size{16, 16}, // resize_corner_input_size
+    geom::Width{24},    // button_width
+    geom::Width{6},     // padding_between_buttons
+    geom::Height{14},   // title_font_height
+    geom::Point{8, 2},  // title_font_top_left
+    geom::Displacement{5, 5}, // icon_padding
+    geom::Width{1},     // detail_line_width
+};
+
+uint32_t const focused_background{0xff323232};
+uint32_t const unfocused_background{0xff808080};
+
+struct StubWindow : mtd::StubSurface
+{
+    auto window_size() const -> geom::Size override { return {240, 120}; }
+    auto state() const -> MirWindowState override { return mir_window_state_restored; }
+    auto focus_state() const -> MirWindowFocusState override { return focus; }
+
+    MirWindowFocusState focus{mir_window_focus_state_focused};
+};
+
+struct DecorationRenderer : Test
+{
+    void update_state()
+    {
+        msd::WindowState const window_state{static_geometry, window};
+        msd::InputState const input_state{{}, {}};
+        renderer.update_state(window_state, input_state);
+    }
+
+    auto render_titlebar() -> std::shared_ptr<mg::Buffer>
+    {
+        auto const buffer = renderer.render_titlebar();
+        if (!buffer)
+        {
+            return nullptr;
+        }
+        return *buffer;
+    }
+
+    /// A pixel in the bottom right corner of the titlebar, clear of the title
+    static auto background_of(mg::Buffer& buffer) -> uint32_t
+    {
+        auto const readable = dynamic_cast<mrs::ReadMappableBuffer*>(buffer.native_buffer_base());
+        if (!readable)
+        {
+            ADD_FAILURE() << "Titlebar buffer is not readable";
+            return 0;
+        }
+        auto const mapping = readable->map_readable();
+        auto const size = mapping->size();
+        uint32_t pixel;
+        memcpy(
+            &pixel,
+            mapping->data() +
+                mapping->stride().as_uint32_t() * (size.height.as_uint32_t() - 1) +
+                (size.width.as_uint32_t() - 1) * sizeof pixel,
+            sizeof pixel);
+        return pixel;
+    }
+
+    std::shared_ptr<msd::StaticGeometry const> const static_geometry{std::make_shared<msd::StaticGeometry>(geometry)};
+    std::shared_ptr<StubWindow> const window{std::make_shared<StubWindow>()};
+    msd::Renderer renderer{std::make_shared<mtd::StubBufferAllocator>(), static_geometry};
+};
+}
+
+TEST_F(DecorationRenderer, titlebar_is_drawn_in_the_focused_theme)
+{
+    update_state();
+
+    auto const buffer = render_titlebar();
+
+    ASSERT_THAT(buffer, NotNull());
+    EXPECT_THAT(buffer->size(), Eq(geom::Size{240, 24}));
+    EXPECT_THAT(background_of(*buffer), Eq(focused_background));
+}
+
+TEST_F(DecorationRenderer, titlebar_is_redrawn_when_the_theme_changes)
+{
+    update_state();
+    render_titlebar();
+
+    window->focus = mir_window_focus_state_unfocused;
+    update_state();
+    auto const buffer = render_titlebar();
+
+    ASSERT_THAT(buffer, NotNull());
+    EXPECT_THAT(background_of(*buffer), Eq(unfocused_background));
+}
+
+TEST_F(DecorationRenderer, buffer_held_by_the_compositor_is_not_written_again)
+{
+    update_state();
+    auto const held = render_titlebar();
+    ASSERT_THAT(held, NotNull());
+
+    window->focus = mir_window_focus_state_unfocused;
+    update_state();
+    auto const next = render_titlebar();
+
+    ASSERT_THAT(next, NotNull());
+    EXPECT_THAT(next->id(), Ne(held->id()));
+    EXPECT_THAT(background_of(*held), Eq(focused_background));
+    EXPECT_THAT(background_of(*next), Eq(unfocused_background));
+}
+
+TEST_F(DecorationRenderer, new_buffer_is_allocated_while_the_compositor_holds_every_recent_buffer)
+{
+    update_state();
+    auto const first = render_titlebar();
+    auto const second = render_titlebar();
+    auto const third = render_titlebar();
+
+    ASSERT_THAT(first, NotNull());
+    ASSERT_THAT(second, NotNull());
+    ASSERT_THAT(third, NotNull());
+    EXPECT_THAT(second->id(), Ne(first->id()));
+    EXPECT_THAT(third->id(), Ne(first->id()));
+    EXPECT_THAT(third->id(), Ne(second->id()));
+}
+
+TEST_F(DecorationRenderer, buffer_released_by_the_compositor_is_written_again)
+{
+    update_state();
+    auto released = render_titlebar();
+    ASSERT_THAT(released, NotNull());
+    auto const released_id = released->id();
+    released.reset();
+
+    window->focus = mir_window_focus_state_unfocused;
+    update_state();
+    auto const buffer = render_titlebar();
+
+    ASSERT_THAT(buffer, NotNull());
+    EXPECT_THAT(buffer->id(), Eq(released_id));
+    EXPECT_THAT(background_of(*buffer), Eq(unfocused_background));
+}
+
+TEST_F(DecorationRenderer, released_buffer_of_the_wrong_size_is_not_written_again)
+{
+    update_state();
+    auto released = render_titlebar();
+    ASSERT_THAT(released, NotNull());
+    auto const released_id = released->id();
+    released.reset();
+
+    struct WiderWindow : StubWindow
+    {
+        auto window_size() const -> geom::Size override { return {300, 120}; }
+    };
+    msd::WindowState const window_state{static_geometry, std::make_shared<WiderWindow>()};
+    msd::InputState const input_state{{}, {}};
+    renderer.update_state(window_state, input_state);
+    auto const buffer = render_titlebar();
+
+    ASSERT_THAT(buffer, NotNull());
+    EXPECT_THAT(buffer->size(), Eq(geom::Size{300, 24}));
+    EXPECT_THAT(buffer->id(), Ne(released_id));
+}